@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal self-registering benchmark harness, the counterpart of
+// tests/test.h. BENCH() bodies run in declaration order and print one line
+// per Report(). `--quick` shrinks every workload to a smoke run (ctest runs
+// the benches that way); `--filter=text` runs benches whose name contains
+// `text`.
+
+namespace optiscaler::bench {
+
+struct BenchCase {
+  const char* name;
+  std::function<void()> body;
+};
+
+std::vector<BenchCase>& Registry();
+
+struct Registrar {
+  Registrar(const char* name, std::function<void()> body) { Registry().push_back({name, std::move(body)}); }
+};
+
+bool Quick();
+// `full` normally, `quick` under --quick.
+size_t Size(size_t full, size_t quick);
+// Prints "<bench>: <metric> = <value> <unit>".
+void Report(const std::string& metric, double value, const std::string& unit);
+
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+  void Restart() { start_ = std::chrono::steady_clock::now(); }
+  double Seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+  double Millis() const { return Seconds() * 1000.0; }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Nearest-rank percentile; `fraction` in [0, 1].
+inline double Percentile(std::vector<double> samples, double fraction) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  std::sort(samples.begin(), samples.end());
+  const size_t rank = static_cast<size_t>(fraction * static_cast<double>(samples.size()) + 0.999999);
+  return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+// Keeps the optimizer from discarding a result.
+void Consume(const void* value);
+
+// Fresh directory under the system temp path, removed with its contents.
+class TempDir {
+ public:
+  TempDir();
+  ~TempDir();
+  TempDir(const TempDir&) = delete;
+  TempDir& operator=(const TempDir&) = delete;
+
+  const std::filesystem::path& path() const { return path_; }
+  // Creates `relative` (and its parents) with `contents`; returns the full path.
+  std::filesystem::path Write(const std::filesystem::path& relative, const std::string& contents = {}) const;
+
+ private:
+  std::filesystem::path path_;
+};
+
+}  // namespace optiscaler::bench
+
+#define OPTISCALER_BENCH_CONCAT2(a, b) a##b
+#define OPTISCALER_BENCH_CONCAT(a, b) OPTISCALER_BENCH_CONCAT2(a, b)
+
+#define BENCH(name)                                                                                     \
+  static void name();                                                                                   \
+  static const ::optiscaler::bench::Registrar OPTISCALER_BENCH_CONCAT(name, _registrar)(#name, &name); \
+  static void name()
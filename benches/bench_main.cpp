@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace optiscaler::bench {
+namespace {
+
+bool g_quick = false;
+const char* g_current = "";
+
+}  // namespace
+
+std::vector<BenchCase>& Registry() {
+  static std::vector<BenchCase> benches;
+  return benches;
+}
+
+bool Quick() {
+  return g_quick;
+}
+
+size_t Size(size_t full, size_t quick) {
+  return g_quick ? quick : full;
+}
+
+void Report(const std::string& metric, double value, const std::string& unit) {
+  std::printf("%s: %s = %.4g %s\n", g_current, metric.c_str(), value, unit.c_str());
+  std::fflush(stdout);
+}
+
+void Consume(const void* value) {
+  static std::atomic<const void*> sink{nullptr};
+  sink.store(value, std::memory_order_relaxed);
+}
+
+TempDir::TempDir() {
+  static std::atomic<unsigned> counter{0};
+  const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+  path_ = std::filesystem::temp_directory_path() /
+          ("optiscaler_bench_" + std::to_string(stamp) + "_" + std::to_string(counter++));
+  std::filesystem::create_directories(path_);
+}
+
+TempDir::~TempDir() {
+  std::error_code ec;
+  std::filesystem::remove_all(path_, ec);
+}
+
+std::filesystem::path TempDir::Write(const std::filesystem::path& relative, const std::string& contents) const {
+  const std::filesystem::path full = path_ / relative;
+  std::filesystem::create_directories(full.parent_path());
+  std::ofstream(full, std::ios::binary) << contents;
+  return full;
+}
+
+}  // namespace optiscaler::bench
+
+int main(int argc, char** argv) {
+  using namespace optiscaler::bench;
+  const char* filter = "";
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--quick") == 0) {
+      g_quick = true;
+    } else if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    }
+  }
+  for (const auto& bench : Registry()) {
+    if (std::strstr(bench.name, filter)) {
+      g_current = bench.name;
+      bench.body();
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "cover_atlas.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// One mid mip level, the size most grid tiles are served from.
+constexpr int kTileWidth = 200;
+constexpr int kTileHeight = 300;
+
+CoverImage Tile(uint8_t seed) {
+  CoverImage image;
+  image.width = kTileWidth;
+  image.height = kTileHeight;
+  image.pixels.resize(image.stride() * kTileHeight);
+  for (size_t i = 0; i < image.pixels.size(); ++i) {
+    image.pixels[i] = static_cast<uint8_t>(seed + i);
+  }
+  return image;
+}
+
+// Reads every 64th byte so each page of the tile is faulted in.
+uint64_t Touch(const uint8_t* pixels, size_t bytes) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < bytes; i += 64) {
+    sum += pixels[i];
+  }
+  return sum;
+}
+
+}  // namespace
+
+// Startup with a warm page cache: every cover at one level, read once.
+BENCH(AtlasColdLoad) {
+  const size_t covers = bench::Size(1000, 50);
+  bench::TempDir dir;
+  const std::wstring path = (dir.path() / "atlas.bin").wstring();
+  {
+    CoverAtlas atlas;
+    atlas.Open(path);
+    std::vector<CoverImage> images;
+    std::vector<AtlasWrite> tiles;
+    images.reserve(covers);
+    for (size_t i = 0; i < covers; ++i) {
+      images.push_back(Tile(static_cast<uint8_t>(i)));
+    }
+    for (size_t i = 0; i < covers; ++i) {
+      tiles.push_back({i + 1, &images[i]});
+    }
+    atlas.Append(tiles);
+    // Baseline: one raw BGRA file per cover, as a per-file cache would keep them.
+    for (size_t i = 0; i < covers; ++i) {
+      std::ofstream out(dir.path() / (std::to_string(i) + ".bgra"), std::ios::binary);
+      out.write(reinterpret_cast<const char*>(images[i].pixels.data()),
+                static_cast<std::streamsize>(images[i].pixels.size()));
+    }
+  }
+
+  uint64_t sum = 0;
+  bench::Timer timer;
+  std::vector<uint8_t> buffer(static_cast<size_t>(kTileWidth) * kTileHeight * 4);
+  for (size_t i = 0; i < covers; ++i) {
+    std::ifstream in(dir.path() / (std::to_string(i) + ".bgra"), std::ios::binary);
+    in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    sum += Touch(buffer.data(), buffer.size());
+  }
+  bench::Report("per-file reads", timer.Millis(), "ms");
+
+  timer.Restart();
+  CoverAtlas atlas;
+  atlas.Open(path);
+  bench::Report("atlas open", timer.Millis(), "ms");
+
+  timer.Restart();
+  for (size_t i = 0; i < covers; ++i) {
+    CoverImage image;
+    atlas.Load(i + 1, image);
+    sum += Touch(image.data(), image.bytes());
+  }
+  const double copied = timer.Millis();
+  bench::Report("atlas copies", copied, "ms");
+
+  timer.Restart();
+  for (size_t i = 0; i < covers; ++i) {
+    AtlasTile tile;
+    atlas.Find(i + 1, tile);
+    const CoverImage image = tile.AsImage();
+    sum += Touch(image.data(), image.bytes());
+  }
+  const double viewed = timer.Millis();
+  bench::Report("atlas views", viewed, "ms");
+  bench::Report("view speedup", copied / viewed, "x");
+  bench::Consume(&sum);
+}
@@ -0,0 +1,80 @@
+#include "cover_blob_store.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// Roughly an IGDB t_cover_big JPEG.
+constexpr size_t kCoverBytes = 48 * 1024;
+
+std::string Image(uint32_t seed, size_t bytes) {
+  std::string image(bytes, '\0');
+  uint32_t state = seed * 2654435761u + 1;
+  for (char& ch : image) {
+    state = state * 1664525u + 1013904223u;
+    ch = static_cast<char>(state >> 24);
+  }
+  return image;
+}
+
+}  // namespace
+
+// A library where duplication is the norm: each title has several exes
+// (launcher, editions, 32/64-bit builds) showing the same IGDB cover, and
+// one game in five only has the shared placeholder.
+BENCH(DuplicatedLibraryDedup) {
+  const size_t titles = bench::Size(2000, 100);
+  const size_t exes_per_title = 3;
+  const std::string placeholder = Image(0, kCoverBytes);
+  std::vector<std::string> covers;
+  covers.reserve(titles);
+  for (size_t i = 0; i < titles; ++i) {
+    covers.push_back(i % 5 == 0 ? std::string() : Image(static_cast<uint32_t>(i + 1), kCoverBytes));
+  }
+
+  bench::TempDir dir;
+  CoverBlobStore store;
+  store.Open(dir.path().wstring());
+  size_t downloads = 0;
+  size_t requests = 0;
+  uint64_t per_exe_bytes = 0;
+  bench::Timer timer;
+  for (size_t title = 0; title < titles; ++title) {
+    const std::string& image = covers[title].empty() ? placeholder : covers[title];
+    const std::wstring url = covers[title].empty() ? std::wstring() : L"https://images.example.com/" +
+                                                                          std::to_wstring(title) + L".jpg";
+    for (size_t exe = 0; exe < exes_per_title; ++exe) {
+      const uint64_t key = title * exes_per_title + exe + 1;
+      per_exe_bytes += image.size();
+      if (url.empty()) {
+        store.Put(key, image.data(), image.size());
+        continue;
+      }
+      // Same order as IGDB::CacheImage: a known URL is linked, not fetched.
+      ++requests;
+      if (!store.LinkSource(key, url)) {
+        ++downloads;
+        store.Put(key, image.data(), image.size(), url);
+      }
+    }
+  }
+  const double seconds = timer.Seconds();
+  store.Save();
+
+  const CoverBlobStats stats = store.Stats();
+  bench::Report("exe covers", static_cast<double>(stats.links), "links");
+  bench::Report("blobs on disk", static_cast<double>(stats.blobs), "files");
+  bench::Report("per-exe layout", static_cast<double>(per_exe_bytes) / (1024.0 * 1024.0), "MiB");
+  bench::Report("blob store", static_cast<double>(stats.blobBytes) / (1024.0 * 1024.0), "MiB");
+  bench::Report("disk saved", 100.0 * static_cast<double>(stats.savedBytes) / static_cast<double>(per_exe_bytes),
+                "%");
+  bench::Report("downloads skipped", 100.0 * static_cast<double>(requests - downloads) / static_cast<double>(requests),
+                "%");
+  bench::Report("store rate", static_cast<double>(stats.links) / seconds, "covers/s");
+}
@@ -0,0 +1,98 @@
+#include "game_catalog.h"
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+const wchar_t* const kSources[] = {L"steam", L"epic", L"xbox", L"custom"};
+
+// Steam-style installs spread over four library folders, with the files an
+// OptiScaler install plans per game.
+std::vector<GameEntry> Library(size_t count) {
+  std::vector<GameEntry> games(count);
+  for (size_t i = 0; i < count; ++i) {
+    GameEntry& game = games[i];
+    const std::wstring n = std::to_wstring(i);
+    game.name = L"Game Title Number " + n;
+    game.source = kSources[i % 4 == 3 ? 3 : i % 7 % 3];
+    game.folder = L"D:\\SteamLibrary" + std::to_wstring(i % 4) + L"\\steamapps\\common\\Game Title Number " + n;
+    game.exe = game.folder + L"\\Binaries\\Win64\\Game" + n + L"-Win64-Shipping.exe";
+    if (game.source == L"steam") {
+      game.steamAppId = static_cast<uint32_t>(200000 + i);
+    }
+    game.installSize = (i % 100 + 1) * 1000000000ull;
+    game.lastPlayed = i % 5 == 0 ? 0 : 1700000000 + static_cast<int64_t>(i);
+    game.coverKey = i % 3 == 0 ? 0 : i * 0x9E3779B97F4A7C15ull | 1;
+    game.injectEnabled = i % 10 == 0;
+    const std::wstring bin = game.folder + L"\\Binaries\\Win64\\";
+    game.plannedFiles = {bin + L"OptiScaler.dll", bin + L"OptiScaler.ini", bin + L"nvngx.dll"};
+  }
+  return games;
+}
+
+size_t StringBytes(const std::wstring& text) {
+  static const size_t kInline = std::wstring().capacity();
+  return text.capacity() > kInline ? (text.capacity() + 1) * sizeof(wchar_t) : 0;
+}
+
+// Heap and element bytes of the old vector-of-GameEntry list.
+size_t EntryBytes(const std::vector<GameEntry>& games) {
+  size_t bytes = games.capacity() * sizeof(GameEntry);
+  for (const GameEntry& game : games) {
+    bytes += StringBytes(game.name) + StringBytes(game.exe) + StringBytes(game.folder) + StringBytes(game.source) +
+             StringBytes(game.sortKey) + game.plannedFiles.capacity() * sizeof(std::wstring);
+    for (const std::wstring& file : game.plannedFiles) {
+      bytes += StringBytes(file);
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+// 100k games: bytes per game as GameEntry rows versus the catalog, and a
+// Steam-with-cover filter over each.
+BENCH(Catalog) {
+  const size_t count = bench::Size(100000, 2000);
+  const size_t rounds = bench::Size(50, 3);
+  const std::vector<GameEntry> games = Library(count);
+
+  bench::Timer timer;
+  GameCatalog catalog;
+  catalog.Sync(games);
+  bench::Report("sync", timer.Millis(), "ms");
+
+  const double per_game = 1.0 / static_cast<double>(count);
+  bench::Report("entries memory", static_cast<double>(EntryBytes(games)) * per_game, "bytes/game");
+  bench::Report("catalog memory", static_cast<double>(catalog.MemoryUsage()) * per_game, "bytes/game");
+
+  GameFilter filter;
+  filter.sources = 1 << static_cast<unsigned>(GameSource::kSteam);
+  filter.required = kGameHasCover;
+  size_t matched = 0;
+  timer.Restart();
+  for (size_t round = 0; round < rounds; ++round) {
+    matched = catalog.Filter(filter).size();
+  }
+  bench::Report("catalog filter", timer.Millis() / static_cast<double>(rounds), "ms");
+
+  size_t entry_matched = 0;
+  timer.Restart();
+  for (size_t round = 0; round < rounds; ++round) {
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < games.size(); ++i) {
+      if (games[i].source == L"steam" && games[i].coverKey != 0) {
+        indices.push_back(i);
+      }
+    }
+    entry_matched = indices.size();
+  }
+  bench::Report("entries filter", timer.Millis() / static_cast<double>(rounds), "ms");
+  bench::Report("matched", static_cast<double>(matched), "games");
+  bench::Consume(&entry_matched);
+}
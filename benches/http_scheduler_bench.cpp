@@ -0,0 +1,95 @@
+#include "http_scheduler.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Fake server with a fixed service time per request.
+class SlowServer : public IHttpClient {
+ public:
+  explicit SlowServer(std::chrono::microseconds service_time) : service_time_(service_time) {}
+
+  bool Send(const HttpRequest&, HttpResponse& response_out) override {
+    std::this_thread::sleep_for(service_time_);
+    response_out = HttpResponse{};
+    response_out.status = 200;
+    response_out.body = "ok";
+    return true;
+  }
+
+ private:
+  std::chrono::microseconds service_time_;
+};
+
+// Submit-to-callback latencies per lane.
+class Latencies {
+ public:
+  HttpScheduler::Callback Track(size_t lane) {
+    const auto submitted = Clock::now();
+    return [this, lane, submitted](const HttpResponse&) {
+      const double ms = std::chrono::duration<double, std::milli>(Clock::now() - submitted).count();
+      std::lock_guard<std::mutex> lock(mutex_);
+      samples_[lane].push_back(ms);
+    };
+  }
+
+  std::vector<double> Samples(size_t lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samples_[lane];
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<double> samples_[2];
+};
+
+}  // namespace
+
+// A library prefetch floods the background lane while clicks arrive every
+// few milliseconds; interactive latency should stay near one service time
+// regardless of the backlog.
+BENCH(PrefetchBacklogWithClicks) {
+  const size_t background = bench::Size(2000, 100);
+  const size_t clicks = bench::Size(100, 10);
+  SlowServer server(std::chrono::microseconds(2000));
+  HttpSchedulerOptions options;
+  options.workerCount = 8;
+  HttpScheduler scheduler(server, options);
+  HostLimits limits;
+  limits.requestsPerSecond = 1e6;
+  limits.burst = 1e6;
+  limits.maxInFlight = 8;
+  scheduler.SetHostLimits(L"images.example.com", limits);
+
+  HttpRequest request;
+  request.host = L"images.example.com";
+  request.path = L"/cover.jpg";
+  Latencies latencies;
+  bench::Timer timer;
+  for (size_t i = 0; i < background; ++i) {
+    scheduler.Submit(request, HttpPriority::kBackground, latencies.Track(1));
+  }
+  for (size_t i = 0; i < clicks; ++i) {
+    scheduler.Submit(request, HttpPriority::kInteractive, latencies.Track(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  scheduler.Wait();
+  const double seconds = timer.Seconds();
+
+  bench::Report("throughput", static_cast<double>(background + clicks) / seconds, "req/s");
+  const auto interactive = latencies.Samples(0);
+  const auto queued = latencies.Samples(1);
+  bench::Report("interactive p50", bench::Percentile(interactive, 0.50), "ms");
+  bench::Report("interactive p99", bench::Percentile(interactive, 0.99), "ms");
+  bench::Report("background p50", bench::Percentile(queued, 0.50), "ms");
+  bench::Report("background p99", bench::Percentile(queued, 0.99), "ms");
+}
@@ -0,0 +1,82 @@
+#include "igdb.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// Stand-in for api.igdb.com: answers every query of a multiquery body with
+// one recorded game after a fixed round trip.
+class ReplayIgdb : public IHttpClient {
+ public:
+  explicit ReplayIgdb(std::chrono::microseconds round_trip) : round_trip_(round_trip) {}
+
+  bool Send(const HttpRequest& request, HttpResponse& response_out) override {
+    ++requests;
+    std::this_thread::sleep_for(round_trip_);
+    response_out = HttpResponse{};
+    response_out.status = 200;
+    std::string& body = response_out.body;
+    body = "[";
+    const std::string marker = "query games \"";
+    for (size_t at = request.body.find(marker); at != std::string::npos; at = request.body.find(marker, at)) {
+      at += marker.size();
+      const std::string label = request.body.substr(at, request.body.find('"', at) - at);
+      body += body.size() > 1 ? "," : "";
+      body += R"({"name":")" + label + R"(","result":[{"id":1,"name":"Game )" + label +
+              R"(","cover":{"id":2,"image_id":"co)" + label + R"("}}]})";
+    }
+    body += "]";
+    return true;
+  }
+
+  size_t requests = 0;
+
+ private:
+  std::chrono::microseconds round_trip_;
+};
+
+std::vector<std::wstring> Names(size_t count) {
+  std::vector<std::wstring> names;
+  names.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(L"Synthetic Title " + std::to_wstring(i));
+  }
+  return names;
+}
+
+}  // namespace
+
+// Lookups per second for one search per request (what SearchOne sends)
+// versus full multiquery batches, against a server with a fixed round
+// trip. IGDB also caps a client at about 4 requests/s, so the request
+// count, not the round trip, bounds a real library scan.
+BENCH(MultiqueryVsSingleLookups) {
+  const auto names = Names(bench::Size(200, 20));
+  const auto round_trip = std::chrono::microseconds(bench::Quick() ? 200 : 5000);
+  const double limit_per_second = 4.0;
+
+  for (size_t batch : {size_t{1}, IGDB::kMultiqueryLimit}) {
+    ReplayIgdb http(round_trip);
+    bench::Timer timer;
+    const auto results = IGDB::SearchMany(http, L"client", L"token", names, nullptr, batch);
+    const double seconds = timer.Seconds();
+    size_t found = 0;
+    for (const auto& result : results) {
+      found += result ? 1 : 0;
+    }
+    const std::string label = batch == 1 ? "single" : "multiquery";
+    bench::Report(label + " lookups", static_cast<double>(found), "found");
+    bench::Report(label + " requests", static_cast<double>(http.requests), "requests");
+    bench::Report(label + " rate", static_cast<double>(names.size()) / seconds, "lookups/s");
+    bench::Report(label + " at 4 req/s",
+                  limit_per_second * static_cast<double>(names.size()) / static_cast<double>(http.requests),
+                  "lookups/s");
+  }
+}
@@ -0,0 +1,56 @@
+#include "igdb_cache.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+std::wstring Title(size_t i) {
+  return L"Synthetic Game Title " + std::to_wstring(i) + L": Definitive Edition";
+}
+
+}  // namespace
+
+// Startup cost of the metadata cache: Open maps the log and rebuilds the
+// index, then a library scan looks up every title once.
+BENCH(WarmStartWith50kEntries) {
+  const size_t entries = bench::Size(50000, 2000);
+  const int64_t now = 1700000000;
+  bench::TempDir dir;
+  const std::wstring path = (dir.path() / "igdb.bin").wstring();
+  {
+    IgdbCache cache;
+    cache.Open(path, now);
+    bench::Timer timer;
+    for (size_t i = 0; i < entries; ++i) {
+      std::optional<IgdbGame> game;
+      if (i % 4 != 0) {  // one in four is a negative entry
+        game = IgdbGame{Title(i), L"co" + std::to_wstring(i)};
+      }
+      cache.Store(Title(i), game, now);
+    }
+    bench::Report("store", static_cast<double>(entries) / timer.Seconds(), "entries/s");
+  }
+
+  bench::Timer timer;
+  IgdbCache cache;
+  cache.Open(path, now + 60);
+  const double open_ms = timer.Millis();
+  bench::Report("open", open_ms, "ms");
+  bench::Report("entries loaded", static_cast<double>(cache.size()), "entries");
+
+  timer.Restart();
+  size_t hits = 0;
+  for (size_t i = 0; i < entries; ++i) {
+    std::optional<IgdbGame> game;
+    hits += cache.Find(Title(i), game, now + 60) ? 1 : 0;
+  }
+  const double seconds = timer.Seconds();
+  bench::Report("lookups", static_cast<double>(entries) / seconds / 1e6, "M/s");
+  bench::Report("network calls avoided", 100.0 * static_cast<double>(hits) / static_cast<double>(entries), "%");
+}
@@ -0,0 +1,92 @@
+#include "name_matcher.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// The scanner's built-in skip lists.
+constexpr std::wstring_view kPrefixes[] = {
+    L"unins",      L"uninstall",  L"setup",        L"dxsetup",   L"vc_redist",
+    L"vcredist",   L"helper",     L"crashreport",  L"readme",    L"support",
+    L"patch",      L"update",     L"redistributable"};
+constexpr std::wstring_view kSubstrings[] = {
+    L"crashhandler", L"crashreporter", L"unitycrash", L"eac_launcher", L"unrealcefsubprocess"};
+
+constexpr auto kPrefixMatcher = BuildMatcher<128>(kPrefixes);
+constexpr auto kSubstringMatcher = BuildMatcher<128>(kSubstrings);
+
+std::vector<std::wstring> Names(size_t count) {
+  static const wchar_t* const kStems[] = {
+      L"Game",     L"unins000",     L"Launcher", L"UnityCrashHandler64", L"SB-Win64-Shipping",
+      L"vcredist", L"EAC_Launcher", L"Setup",    L"witcher3",            L"CrashReportClient"};
+  std::vector<std::wstring> names;
+  names.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(std::wstring(kStems[i % std::size(kStems)]) + std::to_wstring(i) + L".exe");
+  }
+  return names;
+}
+
+// What the scanner did before the automata: lower a copy, then test each
+// pattern in turn.
+bool NaiveSkip(const std::wstring& name) {
+  std::wstring lower(name);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](wchar_t ch) {
+    return static_cast<wchar_t>(std::towlower(ch));
+  });
+  for (std::wstring_view prefix : kPrefixes) {
+    if (std::wstring_view(lower).substr(0, prefix.size()) == prefix) {
+      return true;
+    }
+  }
+  for (std::wstring_view substring : kSubstrings) {
+    if (lower.find(substring) != std::wstring::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Fn>
+void Measure(const char* metric, const std::vector<std::wstring>& names, size_t rounds, Fn&& skip) {
+  size_t skipped = 0;
+  bench::Timer timer;
+  for (size_t round = 0; round < rounds; ++round) {
+    for (const auto& name : names) {
+      skipped += skip(name) ? 1 : 0;
+    }
+  }
+  const double seconds = timer.Seconds();
+  bench::Consume(&skipped);
+  bench::Report(metric, static_cast<double>(names.size() * rounds) / seconds / 1e6, "M names/s");
+}
+
+}  // namespace
+
+BENCH(SkipListMatching) {
+  const auto names = Names(10000);
+  const size_t rounds = bench::Size(200, 2);
+  Measure("naive lower+find", names, rounds, NaiveSkip);
+  Measure("compiled automata", names, rounds, [](const std::wstring& name) {
+    return kPrefixMatcher.MatchesPrefix(name) || kSubstringMatcher.Contains(name);
+  });
+
+  // User patterns from settings go through the same automaton, built at
+  // runtime.
+  auto user = std::make_unique<PatternMatcher<1024>>();
+  user->Add(L"launcher", 0);
+  user->Add(L"benchmark", 1);
+  user->Build();
+  Measure("compiled + user patterns", names, rounds, [&user](const std::wstring& name) {
+    return kPrefixMatcher.MatchesPrefix(name) || kSubstringMatcher.Contains(name) || user->Contains(name);
+  });
+}
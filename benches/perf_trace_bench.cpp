@@ -0,0 +1,65 @@
+#include "perf_trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// One paint-path-shaped iteration: a scope around a counter bump.
+void Instrumented(PerfTrace& trace, uint64_t& work) {
+  PerfScope scope("Tile", trace);
+  trace.Add(PerfCounter::kTilesRedrawn, 1);
+  work = work * 6364136223846793005ull + 1;
+}
+
+void Bare(uint64_t& work) { work = work * 6364136223846793005ull + 1; }
+
+double NsPerIteration(const bench::Timer& timer, size_t iterations) {
+  return timer.Seconds() * 1e9 / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+// What a PerfScope plus an Add costs per use, off (the default) and on,
+// over the same loop with no instrumentation.
+BENCH(ScopeOverhead) {
+  const size_t iterations = bench::Size(20000000, 200000);
+  uint64_t work = 1;
+
+  bench::Timer timer;
+  for (size_t i = 0; i < iterations; ++i) {
+    Bare(work);
+  }
+  const double bare_ns = NsPerIteration(timer, iterations);
+  bench::Report("bare", bare_ns, "ns/op");
+
+  PerfTrace trace;
+  timer.Restart();
+  for (size_t i = 0; i < iterations; ++i) {
+    Instrumented(trace, work);
+  }
+  const double disabled_ns = NsPerIteration(timer, iterations);
+  bench::Report("disabled", disabled_ns, "ns/op");
+  bench::Report("disabled overhead", disabled_ns - bare_ns, "ns/op");
+
+  trace.SetEnabled(true);
+  timer.Restart();
+  for (size_t i = 0; i < iterations; ++i) {
+    if (i % 1000 == 0) {
+      trace.BeginFrame();
+    }
+    Instrumented(trace, work);
+    if (i % 1000 == 999) {
+      trace.EndFrame();
+    }
+  }
+  const double enabled_ns = NsPerIteration(timer, iterations);
+  bench::Report("enabled", enabled_ns, "ns/op");
+  bench::Report("enabled overhead", enabled_ns - bare_ns, "ns/op");
+  bench::Consume(&work);
+}
@@ -0,0 +1,100 @@
+#include "search_index.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+const wchar_t* const kWords[] = {
+    L"Dark",   L"Souls",    L"Half",     L"Life",   L"Portal",  L"Legend", L"Kingdom", L"Rising", L"Shadow",
+    L"Empire", L"Frontier", L"Chronicles", L"Star", L"Wars",    L"Battle", L"Field",   L"Space",  L"Ranger",
+    L"Night",  L"City",     L"Racing",   L"Tales",  L"Dragon",  L"Hunter", L"Forza",   L"Horizon", L"Dead",
+    L"Storm",  L"Final",    L"Fantasy",  L"Cyber",  L"Punk",    L"Metro",  L"Exodus",  L"Witcher", L"Hollow",
+    L"Knight", L"Stellar",  L"Blade",    L"Ghost",  L"Tactics", L"Island", L"Escape",  L"Zero",   L"Ace"};
+constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+std::vector<GameEntry> Library(size_t count) {
+  std::vector<GameEntry> games(count);
+  uint32_t seed = 11;
+  for (size_t i = 0; i < count; ++i) {
+    GameEntry& game = games[i];
+    const size_t words = 2 + i % 3;
+    std::wstring stem;
+    for (size_t w = 0; w < words; ++w) {
+      seed = seed * 1103515245u + 12345u;
+      const std::wstring word = kWords[(seed >> 16) % kWordCount];
+      game.name += (w ? L" " : L"") + word;
+      stem += word;
+    }
+    game.name += L" " + std::to_wstring(i % 97);
+    game.source = i % 3 == 0 ? L"steam" : (i % 3 == 1 ? L"epic" : L"custom");
+    game.folder = L"D:\\Games\\" + game.name + L" " + std::to_wstring(i);
+    game.exe = game.folder + L"\\" + stem + L".exe";
+    game.injectEnabled = i % 10 == 0;
+  }
+  return games;
+}
+
+// What a user types: every prefix of a few titles keystroke by keystroke,
+// each single letter, and a few typos.
+std::vector<std::wstring> Queries(const std::vector<GameEntry>& games) {
+  std::vector<std::wstring> queries;
+  for (size_t i = 0; i < games.size(); i += games.size() / 8) {
+    const std::wstring& name = games[i].name;
+    for (size_t length = 1; length <= name.size(); ++length) {
+      queries.push_back(name.substr(0, length));
+    }
+  }
+  for (wchar_t letter = L'a'; letter <= L'z'; ++letter) {
+    queries.push_back(std::wstring(1, letter));
+  }
+  for (const wchar_t* typo : {L"witchr", L"hollw knight", L"fnal fantsy", L"cyberpnuk", L"drak souls"}) {
+    queries.push_back(typo);
+  }
+  return queries;
+}
+
+void Run(const std::string& label, const SearchIndex& index, const std::vector<std::wstring>& queries,
+         const GameFilter& filter, size_t limit) {
+  const size_t rounds = bench::Size(5, 1);
+  std::vector<double> samples;
+  size_t results = 0;
+  for (size_t round = 0; round < rounds; ++round) {
+    for (const std::wstring& query : queries) {
+      bench::Timer timer;
+      results += index.Search(query, filter, limit).size();
+      samples.push_back(timer.Millis());
+    }
+  }
+  bench::Report(label + " p50", bench::Percentile(samples, 0.50), "ms");
+  bench::Report(label + " p99", bench::Percentile(samples, 0.99), "ms");
+  bench::Report(label + " max", bench::Percentile(samples, 1.0), "ms");
+  bench::Report(label + " results", static_cast<double>(results) / static_cast<double>(samples.size()),
+                "games/query");
+}
+
+}  // namespace
+
+// Incremental search over 100k games, one query per keystroke.
+BENCH(Keystrokes) {
+  const std::vector<GameEntry> games = Library(bench::Size(100000, 2000));
+  GameCatalog catalog;
+  catalog.Sync(games);
+  bench::Timer timer;
+  SearchIndex index(catalog);
+  index.Rebuild();
+  bench::Report("build", timer.Millis(), "ms");
+
+  const std::vector<std::wstring> queries = Queries(games);
+  GameFilter steam;
+  steam.sources = 1 << static_cast<unsigned>(GameSource::kSteam);
+  steam.required = kGameInjectEnabled;
+  Run("unlimited", index, queries, {}, SIZE_MAX);
+  Run("top 500", index, queries, {}, 500);
+  Run("top 500 steam injected", index, queries, steam, 500);
+}
@@ -0,0 +1,79 @@
+#include "single_flight.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr size_t kThreads = 8;
+
+// Runs `calls_per_thread` calls on each of kThreads threads; returns seconds.
+template <typename Call>
+double RunThreads(size_t calls_per_thread, Call&& call) {
+  std::vector<std::thread> threads;
+  bench::Timer timer;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < calls_per_thread; ++i) {
+        call(t, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return timer.Seconds();
+}
+
+}  // namespace
+
+// Prefetch workers and clicks asking for the same few covers: every call
+// is a 1 ms "download" of one of 16 hot URLs.
+BENCH(HotUrlsFromEightThreads) {
+  const size_t calls = bench::Size(200, 20);
+  const auto download = [] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return std::wstring(L"blob");
+  };
+  std::vector<std::wstring> urls;
+  for (int i = 0; i < 16; ++i) {
+    urls.push_back(L"https://images.example.com/" + std::to_wstring(i) + L".jpg");
+  }
+
+  std::atomic<size_t> direct{0};
+  const double direct_seconds = RunThreads(calls, [&](size_t, size_t) {
+    download();
+    ++direct;
+  });
+  SingleFlight<std::wstring, std::wstring> flights;
+  const double shared_seconds = RunThreads(calls, [&](size_t t, size_t i) {
+    flights.Run(urls[(t + i) % urls.size()], download);
+  });
+  const SingleFlightStats stats = flights.Stats();
+  bench::Report("downloads without", static_cast<double>(direct.load()), "downloads");
+  bench::Report("downloads with", static_cast<double>(stats.executions), "downloads");
+  bench::Report("coalesced", 100.0 * static_cast<double>(stats.calls - stats.executions) /
+                                 static_cast<double>(stats.calls), "%");
+  bench::Report("wall time without", direct_seconds * 1000.0, "ms");
+  bench::Report("wall time with", shared_seconds * 1000.0, "ms");
+}
+
+// Bookkeeping cost with no work to share: one key hammered by every
+// thread, and distinct keys per thread.
+BENCH(EmptyWorkOverhead) {
+  const size_t calls = bench::Size(100000, 2000);
+  SingleFlight<uint64_t, uint64_t> same;
+  const double same_seconds = RunThreads(calls, [&](size_t, size_t i) { same.Run(1, [i] { return i; }); });
+  bench::Report("one key", static_cast<double>(calls * kThreads) / same_seconds / 1e6, "M calls/s");
+  SingleFlight<uint64_t, uint64_t> distinct;
+  const double distinct_seconds =
+      RunThreads(calls, [&](size_t t, size_t i) { distinct.Run(t * calls + i, [i] { return i; }); });
+  bench::Report("distinct keys", static_cast<double>(calls * kThreads) / distinct_seconds / 1e6, "M calls/s");
+}
@@ -0,0 +1,82 @@
+#include "text_layout.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "glyph_atlas.h"
+#include "headless_surface.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr int kLabelWidth = 192;
+
+std::vector<std::wstring> Titles(size_t count) {
+  static const wchar_t* const kWords[] = {
+      L"Dark",    L"Souls",  L"Half-Life", L"Portal", L"Legend", L"of",       L"the",        L"Lost",
+      L"Kingdom", L"Rising", L"Edition",   L"II",     L"Shadow", L"Frontier", L"Remastered", L"Chronicles"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+  std::vector<std::wstring> titles;
+  uint32_t seed = 7;
+  for (size_t i = 0; i < count; ++i) {
+    std::wstring title;
+    const size_t words = 2 + i % 4;
+    for (size_t w = 0; w < words; ++w) {
+      seed = seed * 1103515245u + 12345u;
+      title += (w ? L" " : L"") + std::wstring(kWords[(seed >> 16) % kWordCount]);
+    }
+    title += L" " + std::to_wstring(i);
+    titles.push_back(std::move(title));
+  }
+  return titles;
+}
+
+}  // namespace
+
+// Labels of a 1080p grid: laying every title out from scratch versus the
+// cached runs later frames reuse, and blitting those runs.
+BENCH(Labels) {
+  const std::vector<std::wstring> titles = Titles(bench::Size(4000, 200));
+  const size_t rounds = bench::Size(20, 2);
+  GlyphAtlas atlas;
+  const FontId font = atlas.AddFont(std::make_unique<BitmapFont>());
+  TextLayoutCache layouts(atlas);
+
+  bench::Timer timer;
+  for (size_t round = 0; round < rounds; ++round) {
+    layouts.Clear();
+    for (const std::wstring& title : titles) {
+      bench::Consume(layouts.Layout(font, title, kLabelWidth).get());
+    }
+  }
+  const double strings = static_cast<double>(titles.size() * rounds);
+  bench::Report("layout cold", strings / timer.Seconds(), "strings/s");
+
+  timer.Restart();
+  for (size_t round = 0; round < rounds; ++round) {
+    for (const std::wstring& title : titles) {
+      bench::Consume(layouts.Layout(font, title, kLabelWidth).get());
+    }
+  }
+  bench::Report("layout cached", strings / timer.Seconds(), "strings/s");
+
+  HeadlessSurface surface(1920, 1080);
+  TileCompositor& compositor = surface.compositor();
+  timer.Restart();
+  for (size_t round = 0; round < rounds; ++round) {
+    compositor.Invalidate({0, 0, surface.width(), surface.height()});
+    compositor.Begin(OpaqueColor(0x202020));
+    for (size_t i = 0; i < titles.size(); ++i) {
+      const auto layout = layouts.Layout(font, titles[i], kLabelWidth);
+      const int x = static_cast<int>(i % 8) * (kLabelWidth + 16);
+      const int y = static_cast<int>(i / 8 % 60) * 18;
+      DrawTextLayout(compositor, atlas, *layout, x, y, OpaqueColor(0xFFFFFF));
+    }
+    surface.Present();
+  }
+  bench::Report("layout+draw cached", strings / timer.Seconds(), "strings/s");
+  bench::Report("atlas resets", static_cast<double>(atlas.Stats().resets), "resets");
+}
@@ -0,0 +1,102 @@
+#include "tile_compositor.h"
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "headless_surface.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+constexpr int kCoverWidth = 200;
+constexpr int kCoverHeight = 300;
+constexpr int kGap = 16;
+
+CoverImage Cover(uint8_t shade) {
+  CoverImage image;
+  image.width = kCoverWidth;
+  image.height = kCoverHeight;
+  image.pixels.assign(image.stride() * kCoverHeight, shade);
+  // A translucent border exercises the blend path; the rest is copied.
+  for (int y = 0; y < kCoverHeight; ++y) {
+    for (int x = 0; x < kCoverWidth; ++x) {
+      uint8_t* pixel = &image.pixels[image.stride() * y + static_cast<size_t>(x) * 4];
+      const bool edge = x < 4 || y < 4 || x >= kCoverWidth - 4 || y >= kCoverHeight - 4;
+      pixel[3] = edge ? 128 : 255;
+      pixel[0] = pixel[1] = pixel[2] = edge ? 64 : shade;
+    }
+  }
+  return image;
+}
+
+// Draws every cover of a grid scrolled to `offset` that meets `area`;
+// returns how many were drawn.
+size_t DrawGrid(TileCompositor& compositor, const GridRect& area, int offset, const std::vector<CoverImage>& covers) {
+  const int pitch_x = kCoverWidth + kGap;
+  const int pitch_y = kCoverHeight + kGap;
+  const int columns = kWidth / pitch_x;
+  size_t drawn = 0;
+  for (int row = (area.top + offset) / pitch_y; row * pitch_y - offset < area.bottom; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      const GridRect tile{kGap + column * pitch_x, kGap + row * pitch_y - offset,
+                          kGap + column * pitch_x + kCoverWidth, kGap + row * pitch_y - offset + kCoverHeight};
+      if (tile.Intersects(area)) {
+        compositor.Blend(covers[static_cast<size_t>(row * columns + column) % covers.size()], tile.left, tile.top);
+        ++drawn;
+      }
+    }
+  }
+  return drawn;
+}
+
+void Run(const std::string& label, BlendKernel kernel, int scroll_step, const std::vector<CoverImage>& covers) {
+  const size_t frames = bench::Size(300, 10);
+  HeadlessSurface surface(kWidth, kHeight, kernel);
+  TileCompositor& compositor = surface.compositor();
+  int offset = 0;
+  size_t covers_drawn = 0;
+  compositor.Begin(OpaqueColor(0x202020));
+  DrawGrid(compositor, {0, 0, kWidth, kHeight}, offset, covers);
+  surface.Present();
+  const CompositorStats before = compositor.Stats();
+
+  bench::Timer timer;
+  for (size_t frame = 0; frame < frames; ++frame) {
+    if (scroll_step == 0) {
+      compositor.Invalidate({0, 0, kWidth, kHeight});
+    } else {
+      offset += scroll_step;
+      compositor.Scroll({0, 0, kWidth, kHeight}, -scroll_step);
+    }
+    const GridRect area = compositor.Begin(OpaqueColor(0x202020));
+    covers_drawn += DrawGrid(compositor, area, offset, covers);
+    surface.Present();
+  }
+  const double seconds = timer.Seconds();
+  const CompositorStats stats = compositor.Stats();
+  const double per_frame = 1.0 / static_cast<double>(frames);
+  bench::Report(label + " frame", seconds * 1000.0 * per_frame, "ms");
+  bench::Report(label + " covers", static_cast<double>(covers_drawn) * per_frame, "tiles/frame");
+  bench::Report(label + " composed",
+                static_cast<double>(stats.tilesComposed - before.tilesComposed) * per_frame, "64px tiles/frame");
+  bench::Report(label + " blended",
+                static_cast<double>(stats.pixelsBlended - before.pixelsBlended) * per_frame / 1e6, "Mpx/frame");
+}
+
+}  // namespace
+
+// A 1080p grid of 200x300 covers: full redraws versus 24 px scroll steps,
+// which only recompose the band that scrolled in.
+BENCH(GridFrames) {
+  std::vector<CoverImage> covers;
+  for (int i = 0; i < 8; ++i) {
+    covers.push_back(Cover(static_cast<uint8_t>(40 + i * 20)));
+  }
+  Run("full scalar", BlendKernel::kScalar, 0, covers);
+  Run("full best", TileCompositor::BestKernel(), 0, covers);
+  Run("scroll best", TileCompositor::BestKernel(), 24, covers);
+}
@@ -1,38 +1,23 @@
 #include "cache.h"
 
+#ifdef _WIN32
 #include <shlobj.h>
 #include <windows.h>
+#else
+#include <cstdlib>
+#endif
 
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <string>
-#include <vector>
 
-namespace optiscaler {
-namespace {
-
-std::wstring WideFromUtf8(const std::string& input) {
-  if (input.empty()) {
-    return {};
-  }
-  int count = MultiByteToWideChar(CP_UTF8, 0, input.data(), static_cast<int>(input.size()), nullptr, 0);
-  std::wstring wide(count, L'\0');
-  MultiByteToWideChar(CP_UTF8, 0, input.data(), static_cast<int>(input.size()), wide.data(), count);
-  return wide;
-}
+#include "text_util.h"
 
-std::string Utf8FromWide(const std::wstring& input) {
-  if (input.empty()) {
-    return {};
-  }
-  int count = WideCharToMultiByte(CP_UTF8, 0, input.data(), static_cast<int>(input.size()), nullptr, 0, nullptr, nullptr);
-  std::string utf8(count, '\0');
-  WideCharToMultiByte(CP_UTF8, 0, input.data(), static_cast<int>(input.size()), utf8.data(), count, nullptr, nullptr);
-  return utf8;
-}
-
-}  // namespace
+namespace optiscaler {
 
 std::wstring Cache::AppDataRoot() {
+#ifdef _WIN32
   PWSTR path = nullptr;
   if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_RoamingAppData, KF_FLAG_CREATE, nullptr, &path))) {
     std::wstring result(path);
@@ -41,6 +26,16 @@ std::wstring Cache::AppDataRoot() {
     return result;
   }
   return L"";
+#else
+  // XDG layout, so the portable modules (and their tests) have somewhere to write.
+  if (const char* data_home = std::getenv("XDG_DATA_HOME"); data_home && *data_home) {
+    return WideFromUtf8(data_home) + L"/OptiScalerMgrLite";
+  }
+  if (const char* home = std::getenv("HOME"); home && *home) {
+    return WideFromUtf8(home) + L"/.local/share/OptiScalerMgrLite";
+  }
+  return L"";
+#endif
 }
 
 bool Cache::EnsureDirectory(const std::wstring& path) {
@@ -56,18 +51,13 @@ bool Cache::WriteText(const std::wstring& path, const std::wstring& text) {
   if (path.empty()) {
     return false;
   }
-  HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-  if (file == INVALID_HANDLE_VALUE) {
+  std::ofstream file(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+  if (!file) {
     return false;
   }
   const std::string utf8 = Utf8FromWide(text);
-  DWORD written = 0;
-  BOOL ok = TRUE;
-  if (!utf8.empty()) {
-    ok = WriteFile(file, utf8.data(), static_cast<DWORD>(utf8.size()), &written, nullptr);
-  }
-  CloseHandle(file);
-  return ok == TRUE;
+  file.write(utf8.data(), static_cast<std::streamsize>(utf8.size()));
+  return static_cast<bool>(file.flush());
 }
 
 bool Cache::ReadText(const std::wstring& path, std::wstring& text_out) {
@@ -75,26 +65,15 @@ bool Cache::ReadText(const std::wstring& path, std::wstring& text_out) {
   if (path.empty()) {
     return false;
   }
-  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-  if (file == INVALID_HANDLE_VALUE) {
+  std::ifstream file(std::filesystem::path(path), std::ios::binary);
+  if (!file) {
     return false;
   }
-  LARGE_INTEGER size = {};
-  if (!GetFileSizeEx(file, &size)) {
-    CloseHandle(file);
-    return false;
-  }
-  std::vector<char> buffer(static_cast<size_t>(size.QuadPart));
-  DWORD read = 0;
-  BOOL ok = TRUE;
-  if (!buffer.empty()) {
-    ok = ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr);
-  }
-  CloseHandle(file);
-  if (ok != TRUE) {
+  const std::string utf8((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (file.bad()) {
     return false;
   }
-  text_out = WideFromUtf8(std::string(buffer.begin(), buffer.begin() + read));
+  text_out = WideFromUtf8(utf8);
   return true;
 }
 
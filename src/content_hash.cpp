@@ -0,0 +1,178 @@
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr size_t kHashHexChars = 64;
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+uint32_t RotateRight(uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+int HexDigit(wchar_t c) {
+  if (c >= L'0' && c <= L'9') {
+    return c - L'0';
+  }
+  if (c >= L'a' && c <= L'f') {
+    return c - L'a' + 10;
+  }
+  if (c >= L'A' && c <= L'F') {
+    return c - L'A' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+std::wstring ContentHash::Hex() const {
+  static constexpr wchar_t kDigits[] = L"0123456789abcdef";
+  std::wstring hex(kHashHexChars, L'0');
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    hex[i * 2] = kDigits[bytes[i] >> 4];
+    hex[i * 2 + 1] = kDigits[bytes[i] & 0xF];
+  }
+  return hex;
+}
+
+std::optional<ContentHash> ContentHash::FromHex(std::wstring_view hex) {
+  if (hex.size() != kHashHexChars) {
+    return std::nullopt;
+  }
+  ContentHash hash;
+  for (size_t i = 0; i < hash.bytes.size(); ++i) {
+    const int high = HexDigit(hex[i * 2]);
+    const int low = HexDigit(hex[i * 2 + 1]);
+    if (high < 0 || low < 0) {
+      return std::nullopt;
+    }
+    hash.bytes[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+  return hash;
+}
+
+size_t ContentHashHasher::operator()(const ContentHash& hash) const {
+  // The digest is already uniformly distributed.
+  uint64_t value = 0;
+  std::memcpy(&value, hash.bytes.data(), sizeof(value));
+  return static_cast<size_t>(value);
+}
+
+ContentHash Sha256::Of(const void* data, size_t size) {
+  Sha256 hasher;
+  hasher.Update(data, size);
+  return hasher.Finish();
+}
+
+void Sha256::Update(const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  total_bytes_ += size;
+  if (block_used_ > 0) {
+    const size_t take = std::min(size, block_.size() - block_used_);
+    std::memcpy(block_.data() + block_used_, bytes, take);
+    block_used_ += take;
+    bytes += take;
+    size -= take;
+    if (block_used_ < block_.size()) {
+      return;
+    }
+    Compress(block_.data());
+    block_used_ = 0;
+  }
+  for (; size >= block_.size(); bytes += block_.size(), size -= block_.size()) {
+    Compress(bytes);
+  }
+  if (size > 0) {
+    std::memcpy(block_.data(), bytes, size);
+    block_used_ = size;
+  }
+}
+
+ContentHash Sha256::Finish() {
+  const uint64_t bit_length = total_bytes_ * 8;
+  block_[block_used_++] = 0x80;
+  if (block_used_ > block_.size() - 8) {
+    std::memset(block_.data() + block_used_, 0, block_.size() - block_used_);
+    Compress(block_.data());
+    block_used_ = 0;
+  }
+  std::memset(block_.data() + block_used_, 0, block_.size() - 8 - block_used_);
+  for (int i = 0; i < 8; ++i) {
+    block_[block_.size() - 1 - i] = static_cast<uint8_t>(bit_length >> (8 * i));
+  }
+  Compress(block_.data());
+
+  ContentHash hash;
+  for (size_t i = 0; i < state_.size(); ++i) {
+    for (int j = 0; j < 4; ++j) {
+      hash.bytes[i * 4 + j] = static_cast<uint8_t>(state_[i] >> (24 - 8 * j));
+    }
+  }
+  Reset();
+  return hash;
+}
+
+void Sha256::Reset() {
+  std::memcpy(state_.data(), kInitialState, sizeof(kInitialState));
+  block_used_ = 0;
+  total_bytes_ = 0;
+}
+
+void Sha256::Compress(const uint8_t* block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+           static_cast<uint32_t>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; ++i) {
+    const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+  uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+  for (int i = 0; i < 64; ++i) {
+    const uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+    const uint32_t choose = (e & f) ^ (~e & g);
+    const uint32_t t1 = h + s1 + choose + kRoundConstants[i] + w[i];
+    const uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+    const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+    const uint32_t t2 = s0 + majority;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state_[0] += a;
+  state_[1] += b;
+  state_[2] += c;
+  state_[3] += d;
+  state_[4] += e;
+  state_[5] += f;
+  state_[6] += g;
+  state_[7] += h;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace optiscaler {
+
+struct ContentHash {
+  std::array<uint8_t, 32> bytes{};
+
+  std::wstring Hex() const;
+  static std::optional<ContentHash> FromHex(std::wstring_view hex);
+  bool operator==(const ContentHash& other) const { return bytes == other.bytes; }
+  bool operator!=(const ContentHash& other) const { return bytes != other.bytes; }
+};
+
+struct ContentHashHasher {
+  size_t operator()(const ContentHash& hash) const;
+};
+
+// Incremental SHA-256 (FIPS 180-4), for content that arrives in chunks.
+// Platform-neutral, so the blob store and downloads build on any host.
+class Sha256 {
+ public:
+  Sha256() { Reset(); }
+
+  static ContentHash Of(const void* data, size_t size);
+
+  void Update(const void* data, size_t size);
+  // Finishes the digest and starts over for the next message.
+  ContentHash Finish();
+
+ private:
+  void Reset();
+  void Compress(const uint8_t* block);
+
+  std::array<uint32_t, 8> state_{};
+  std::array<uint8_t, 64> block_{};
+  size_t block_used_ = 0;
+  uint64_t total_bytes_ = 0;
+};
+
+}  // namespace optiscaler
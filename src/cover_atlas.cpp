@@ -0,0 +1,394 @@
+#include "cover_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "cache.h"
+
+namespace optiscaler {
+
+struct AtlasIndexEntry {
+  uint64_t key;
+  uint64_t offset;
+  uint32_t size;
+  uint16_t width;
+  uint16_t height;
+  uint32_t format;
+  uint32_t tag;  // written as 0 before tags existed
+};
+static_assert(sizeof(AtlasIndexEntry) == 32, "atlas index layout");
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'S', 'M', 'A', 'T', 'L', 'A', 'S'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kFormatBgra = 0;
+constexpr uint64_t kTileAlignment = 64;
+constexpr uint64_t kIndexAlignment = 8;
+// Compaction rewrites every live tile, so it only pays off once a good
+// share of the file is garbage.
+constexpr uint64_t kMinDeadBytes = 16ull * 1024 * 1024;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t entryCount;
+  uint64_t indexOffset;
+  uint64_t generation;  // bumped by every append; guards compaction swaps
+  uint64_t liveBytes;   // tile bytes referenced by the index
+  uint64_t reserved;
+};
+static_assert(sizeof(Header) == 48, "atlas header layout");
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void WritePadding(std::ostream& out, uint64_t from, uint64_t to) {
+  static const char kZeros[kTileAlignment] = {};
+  while (from < to) {
+    const uint64_t count = std::min<uint64_t>(to - from, sizeof(kZeros));
+    out.write(kZeros, static_cast<std::streamsize>(count));
+    from += count;
+  }
+}
+
+Header MakeHeader(uint32_t entry_count, uint64_t index_offset, uint64_t generation, uint64_t live_bytes) {
+  Header header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.entryCount = entry_count;
+  header.indexOffset = index_offset;
+  header.generation = generation;
+  header.liveBytes = live_bytes;
+  return header;
+}
+
+bool ReadHeader(std::string_view data, Header& header_out) {
+  if (data.size() < sizeof(Header)) {
+    return false;
+  }
+  std::memcpy(&header_out, data.data(), sizeof(Header));
+  if (std::memcmp(header_out.magic, kMagic, sizeof(kMagic)) != 0 || header_out.version != kVersion) {
+    return false;
+  }
+  const uint64_t index_bytes = static_cast<uint64_t>(header_out.entryCount) * sizeof(AtlasIndexEntry);
+  return header_out.indexOffset % kIndexAlignment == 0 && header_out.indexOffset >= sizeof(Header) &&
+         header_out.indexOffset <= data.size() && index_bytes <= data.size() - header_out.indexOffset;
+}
+
+}  // namespace
+
+// One mapping of the file plus the header it was read with. Immutable once
+// published, so readers need no lock after taking a reference.
+struct CoverAtlas::Mapping {
+  MappedFile file;
+  size_t entryCount = 0;
+  uint64_t generation = 0;
+  uint64_t liveBytes = 0;
+  uint64_t indexOffset = 0;
+
+  const AtlasIndexEntry* entries() const {
+    return reinterpret_cast<const AtlasIndexEntry*>(file.data() + indexOffset);
+  }
+};
+
+CoverAtlas::~CoverAtlas() {
+  JoinCompactor();
+}
+
+std::wstring CoverAtlas::DefaultPath() {
+  const std::wstring root = Cache::AppDataRoot();
+  if (root.empty()) {
+    return {};
+  }
+  std::filesystem::path path(root);
+  path /= L"cache";
+  path /= L"covers";
+  Cache::EnsureDirectory(path.wstring());
+  path /= L"atlas.bin";
+  return path.wstring();
+}
+
+bool CoverAtlas::Open(const std::wstring& path) {
+  Close();
+  path_ = path;
+  if (!Map()) {
+    return false;
+  }
+  ApplyCompaction();
+  return true;
+}
+
+void CoverAtlas::Close() {
+  JoinCompactor();
+  SetCurrent(nullptr);
+}
+
+std::shared_ptr<const CoverAtlas::Mapping> CoverAtlas::Current() const {
+  std::lock_guard<std::mutex> lock(mapping_mutex_);
+  return current_;
+}
+
+void CoverAtlas::SetCurrent(std::shared_ptr<const Mapping> mapping) {
+  std::lock_guard<std::mutex> lock(mapping_mutex_);
+  current_ = std::move(mapping);
+}
+
+// Publishes a fresh mapping; readers keep whichever one they already hold.
+bool CoverAtlas::Map() {
+  std::error_code ec;
+  if (!std::filesystem::exists(path_, ec)) {
+    SetCurrent(nullptr);
+    return true;
+  }
+  auto mapping = std::make_shared<Mapping>();
+  Header header;
+  if (!mapping->file.Open(path_) || !ReadHeader(mapping->file.view(), header)) {
+    SetCurrent(nullptr);
+    return false;
+  }
+  mapping->entryCount = header.entryCount;
+  mapping->generation = header.generation;
+  mapping->liveBytes = header.liveBytes;
+  mapping->indexOffset = header.indexOffset;
+  SetCurrent(std::move(mapping));
+  return true;
+}
+
+size_t CoverAtlas::size() const {
+  const auto mapping = Current();
+  return mapping ? mapping->entryCount : 0;
+}
+
+bool CoverAtlas::Find(uint64_t key, AtlasTile& tile_out) const {
+  tile_out = AtlasTile{};
+  auto mapping = Current();
+  if (!mapping || mapping->entryCount == 0) {
+    return false;
+  }
+  const AtlasIndexEntry* begin = mapping->entries();
+  const AtlasIndexEntry* end = begin + mapping->entryCount;
+  const AtlasIndexEntry* it = std::lower_bound(
+      begin, end, key, [](const AtlasIndexEntry& entry, uint64_t value) { return entry.key < value; });
+  if (it == end || it->key != key || it->format != kFormatBgra) {
+    return false;
+  }
+  // The index is trusted for order only; every tile is bounds-checked.
+  const MappedFile& file = mapping->file;
+  const uint64_t expected = static_cast<uint64_t>(it->width) * it->height * 4;
+  if (it->size != expected || it->offset > file.size() || it->size > file.size() - it->offset) {
+    return false;
+  }
+  tile_out.pixels = reinterpret_cast<const uint8_t*>(file.data() + it->offset);
+  tile_out.width = it->width;
+  tile_out.height = it->height;
+  tile_out.tag = it->tag;
+  tile_out.mapping = std::move(mapping);
+  return true;
+}
+
+bool CoverAtlas::Load(uint64_t key, CoverImage& image_out) const {
+  image_out = CoverImage{};
+  AtlasTile tile;
+  if (!Find(key, tile)) {
+    return false;
+  }
+  image_out.width = tile.width;
+  image_out.height = tile.height;
+  image_out.pixels.assign(tile.pixels, tile.pixels + tile.stride() * tile.height);
+  return true;
+}
+
+bool CoverAtlas::Append(const std::vector<AtlasWrite>& tiles) {
+  if (path_.empty()) {
+    return false;
+  }
+  // The current mapping stays live for readers: tiles and the new index go
+  // past its end, and only the header, which was copied at Map time, is
+  // rewritten in place.
+  const auto current = Current();
+  std::vector<AtlasIndexEntry> index;
+  if (current && current->entryCount != 0) {
+    index.assign(current->entries(), current->entries() + current->entryCount);
+  }
+  const uint64_t generation = (current ? current->generation : 0) + 1;
+
+  std::error_code ec;
+  const bool exists = std::filesystem::exists(path_, ec) && std::filesystem::file_size(path_, ec) >= sizeof(Header);
+  const auto mode = std::ios::binary | std::ios::in | std::ios::out | (exists ? std::ios::openmode{} : std::ios::trunc);
+  std::fstream out(std::filesystem::path(path_), mode);
+  if (!out) {
+    return false;
+  }
+  if (!exists) {
+    const Header empty = MakeHeader(0, sizeof(Header), 0, 0);
+    out.write(reinterpret_cast<const char*>(&empty), sizeof(empty));
+  }
+  out.seekp(0, std::ios::end);
+  uint64_t offset = static_cast<uint64_t>(out.tellp());
+
+  std::vector<AtlasIndexEntry> added;
+  added.reserve(tiles.size());
+  for (const auto& [key, image, tag] : tiles) {
+    if (!image || image->empty() || image->width > 0xFFFF || image->height > 0xFFFF) {
+      continue;
+    }
+    const uint64_t aligned = AlignUp(offset, kTileAlignment);
+    WritePadding(out, offset, aligned);
+    const uint32_t size = static_cast<uint32_t>(image->stride() * image->height);
+    out.write(reinterpret_cast<const char*>(image->data()), size);
+    added.push_back(AtlasIndexEntry{key, aligned, size, static_cast<uint16_t>(image->width),
+                                    static_cast<uint16_t>(image->height), kFormatBgra, tag});
+    offset = aligned + size;
+  }
+
+  // Later tiles in the batch win, then batch tiles win over existing ones.
+  std::stable_sort(added.begin(), added.end(),
+                   [](const AtlasIndexEntry& a, const AtlasIndexEntry& b) { return a.key < b.key; });
+  std::vector<AtlasIndexEntry> merged;
+  merged.reserve(index.size() + added.size());
+  size_t old_pos = 0;
+  for (size_t i = 0; i < added.size(); ++i) {
+    if (i + 1 < added.size() && added[i + 1].key == added[i].key) {
+      continue;
+    }
+    while (old_pos < index.size() && index[old_pos].key < added[i].key) {
+      merged.push_back(index[old_pos++]);
+    }
+    if (old_pos < index.size() && index[old_pos].key == added[i].key) {
+      ++old_pos;
+    }
+    merged.push_back(added[i]);
+  }
+  merged.insert(merged.end(), index.begin() + old_pos, index.end());
+
+  uint64_t live_bytes = 0;
+  for (const auto& entry : merged) {
+    live_bytes += entry.size;
+  }
+  const uint64_t index_offset = AlignUp(offset, kIndexAlignment);
+  WritePadding(out, offset, index_offset);
+  out.write(reinterpret_cast<const char*>(merged.data()),
+            static_cast<std::streamsize>(merged.size() * sizeof(AtlasIndexEntry)));
+  out.flush();
+  // The header is repointed last; until then readers see the old index.
+  const Header header = MakeHeader(static_cast<uint32_t>(merged.size()), index_offset, generation, live_bytes);
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.flush();
+  const bool ok = static_cast<bool>(out);
+  out.close();
+  return Map() && ok;
+}
+
+uint64_t CoverAtlas::deadBytes() const {
+  const auto mapping = Current();
+  if (!mapping) {
+    return 0;
+  }
+  const uint64_t used = sizeof(Header) + mapping->liveBytes + mapping->entryCount * sizeof(AtlasIndexEntry);
+  return mapping->file.size() > used ? mapping->file.size() - used : 0;
+}
+
+bool CoverAtlas::NeedsCompaction() const {
+  const auto mapping = Current();
+  const uint64_t dead = deadBytes();
+  return mapping && dead >= kMinDeadBytes && dead > mapping->liveBytes / 2;
+}
+
+void CoverAtlas::CompactInBackground() {
+  if (path_.empty() || compacting_ || !NeedsCompaction()) {
+    return;
+  }
+  JoinCompactor();  // a finished earlier run
+  // The worker maps the file itself; the live mapping stays untouched.
+  compacting_ = true;
+  compactor_ = std::thread([this, source = path_] {
+    Compact(source, source + L".compact");
+    compacting_ = false;
+  });
+}
+
+bool CoverAtlas::ApplyCompaction() {
+  JoinCompactor();
+  if (path_.empty()) {
+    return false;
+  }
+  const std::wstring compact_path = path_ + L".compact";
+  std::error_code ec;
+  if (!std::filesystem::exists(compact_path, ec)) {
+    return false;
+  }
+  Header header = {};
+  bool current = false;
+  {
+    const auto mapping = Current();
+    MappedFile compact;
+    current = compact.Open(compact_path) && ReadHeader(compact.view(), header) && mapping &&
+              header.generation == mapping->generation;
+  }
+  if (!current) {
+    std::filesystem::remove(compact_path, ec);
+    return false;
+  }
+  // Windows refuses to replace a file that is still mapped, e.g. by a tile
+  // a worker holds; the copy is then kept for the next Open.
+  SetCurrent(nullptr);
+  std::filesystem::rename(compact_path, path_, ec);
+  return Map() && !ec;
+}
+
+bool CoverAtlas::Compact(const std::wstring& source, const std::wstring& target) {
+  MappedFile file;
+  Header header;
+  if (!file.Open(source) || !ReadHeader(file.view(), header)) {
+    return false;
+  }
+  std::ofstream out(std::filesystem::path(target), std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  // A zero header marks the copy invalid until the final rewrite below.
+  const Header placeholder = {};
+  out.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+
+  const auto* index = reinterpret_cast<const AtlasIndexEntry*>(file.data() + header.indexOffset);
+  std::vector<AtlasIndexEntry> kept;
+  kept.reserve(header.entryCount);
+  uint64_t offset = sizeof(Header);
+  uint64_t live_bytes = 0;
+  for (uint32_t i = 0; i < header.entryCount; ++i) {
+    AtlasIndexEntry entry = index[i];
+    if (entry.offset > file.size() || entry.size > file.size() - entry.offset) {
+      continue;
+    }
+    const uint64_t aligned = AlignUp(offset, kTileAlignment);
+    WritePadding(out, offset, aligned);
+    out.write(file.data() + entry.offset, entry.size);
+    entry.offset = aligned;
+    offset = aligned + entry.size;
+    live_bytes += entry.size;
+    kept.push_back(entry);
+  }
+  const uint64_t index_offset = AlignUp(offset, kIndexAlignment);
+  WritePadding(out, offset, index_offset);
+  out.write(reinterpret_cast<const char*>(kept.data()),
+            static_cast<std::streamsize>(kept.size() * sizeof(AtlasIndexEntry)));
+  out.flush();
+  const Header compacted = MakeHeader(static_cast<uint32_t>(kept.size()), index_offset, header.generation, live_bytes);
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&compacted), sizeof(compacted));
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+void CoverAtlas::JoinCompactor() {
+  if (compactor_.joinable()) {
+    compactor_.join();
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cover_image.h"
+#include "mapped_file.h"
+
+namespace optiscaler {
+
+struct AtlasIndexEntry;
+
+// Zero-copy view of one tile inside the mapped atlas. The tile holds the
+// mapping it points into, so it stays valid across later appends.
+struct AtlasTile {
+  const uint8_t* pixels = nullptr;  // premultiplied BGRA, rows packed
+  int width = 0;
+  int height = 0;
+  uint32_t tag = 0;  // as given to Append
+  std::shared_ptr<const void> mapping;
+
+  size_t stride() const { return static_cast<size_t>(width) * 4; }
+  // A CoverImage reading the tile in place; it keeps the mapping alive.
+  CoverImage AsImage() const { return CoverImage::View(pixels, width, height, mapping); }
+};
+
+// One tile for CoverAtlas::Append. The tag is kept in the index next to
+// the tile, e.g. to record which source image it was built from.
+struct AtlasWrite {
+  uint64_t key = 0;
+  const CoverImage* image = nullptr;
+  uint32_t tag = 0;
+};
+
+// All covers in one file: a fixed header, pre-decoded BGRA tiles, and a
+// key-sorted index (HashPath(exe) -> offset, size, dimensions, tag) that is
+// binary-searched straight out of the mapping, so opening costs one map
+// and no per-cover I/O or decoding.
+//
+// Appends write new tiles and a fresh index after the current end of file,
+// then repoint the header, so a torn append leaves the previous index
+// intact. Replaced tiles and old indexes become dead bytes that a
+// background compaction drops into "<path>.compact"; the copy is swapped
+// in by ApplyCompaction (or the next Open) only if no append happened in
+// the meantime.
+//
+// Lookups (Find, Load, size, deadBytes, NeedsCompaction) may run on any
+// thread: they read an immutable snapshot of the mapping, which an append
+// replaces without blocking them. Open, Close, Append and the compaction
+// calls belong to the owning thread. The file is only ever extended in
+// place, so appends never wait for a running compaction.
+class CoverAtlas {
+ public:
+  CoverAtlas() = default;
+  ~CoverAtlas();
+
+  CoverAtlas(const CoverAtlas&) = delete;
+  CoverAtlas& operator=(const CoverAtlas&) = delete;
+
+  static std::wstring DefaultPath();
+
+  // A missing file opens as an empty atlas; the first Append creates it.
+  bool Open(const std::wstring& path);
+  void Close();
+
+  bool Find(uint64_t key, AtlasTile& tile_out) const;
+  bool Load(uint64_t key, CoverImage& image_out) const;
+  // One write per batch. Images replace existing tiles with the same key.
+  bool Append(const std::vector<AtlasWrite>& tiles);
+
+  size_t size() const;
+  uint64_t deadBytes() const;
+  bool NeedsCompaction() const;
+
+  void CompactInBackground();
+  bool ApplyCompaction();
+  // Writes the live tiles of `source` to `target`.
+  static bool Compact(const std::wstring& source, const std::wstring& target);
+
+ private:
+  struct Mapping;
+
+  std::shared_ptr<const Mapping> Current() const;
+  void SetCurrent(std::shared_ptr<const Mapping> mapping);
+  bool Map();
+  void JoinCompactor();
+
+  std::wstring path_;
+  mutable std::mutex mapping_mutex_;  // guards current_ only
+  std::shared_ptr<const Mapping> current_;
+  std::thread compactor_;
+  std::atomic<bool> compacting_{false};
+};
+
+}  // namespace optiscaler
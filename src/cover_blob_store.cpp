@@ -0,0 +1,377 @@
+#include "cover_blob_store.h"
+
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+
+#include "cache.h"
+#include "path_key.h"
+
+namespace optiscaler {
+
+namespace {
+
+// One record per line, tab separated:
+//   L <exe key, 16 hex> <content hash, 64 hex>
+//   U <content hash, 64 hex> <source URL>
+constexpr wchar_t kHeader[] = L"OSMBLOB 1";
+constexpr wchar_t kIndexName[] = L"index.txt";
+constexpr wchar_t kBlobExtension[] = L".blob";
+constexpr wchar_t kTempExtension[] = L".tmp";
+constexpr wchar_t kStagingDirectory[] = L"incoming";
+
+bool WriteBytes(const std::wstring& path, const void* data, size_t size) {
+  std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+  out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+  out.close();
+  return !out.fail();
+}
+
+}  // namespace
+
+std::wstring CoverBlobStore::DefaultRoot() {
+  const std::wstring root = Cache::AppDataRoot();
+  if (root.empty()) {
+    return {};
+  }
+  std::filesystem::path path(root);
+  path /= L"cache";
+  path /= L"covers";
+  path /= L"blobs";
+  return path.wstring();
+}
+
+CoverBlobStore& CoverBlobStore::Default() {
+  // Never destroyed: mip workers and downloads may still use it at exit.
+  static CoverBlobStore* store = [] {
+    auto* opened = new CoverBlobStore();
+    opened->Open(DefaultRoot());
+    return opened;
+  }();
+  return *store;
+}
+
+ContentHash CoverBlobStore::Hash(const void* data, size_t size) {
+  return Sha256::Of(data, size);
+}
+
+bool CoverBlobStore::Open(const std::wstring& root) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  root_ = root;
+  links_.clear();
+  blobs_.clear();
+  sources_.clear();
+  dirty_ = false;
+  if (root_.empty() || !Cache::EnsureDirectory(root_)) {
+    return false;
+  }
+  std::wstring text;
+  if (!Cache::ReadText((std::filesystem::path(root_) / kIndexName).wstring(), text)) {
+    return true;
+  }
+  size_t pos = text.find(L'\n');
+  if (text.compare(0, pos, kHeader) != 0) {
+    dirty_ = true;
+    return true;
+  }
+  // Index lines naming blobs that vanished from disk are dropped.
+  auto known_blob = [this](const ContentHash& hash) {
+    if (blobs_.count(hash)) {
+      return true;
+    }
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(BlobPath(hash), ec);
+    if (ec) {
+      dirty_ = true;
+      return false;
+    }
+    blobs_[hash].size = size;
+    return true;
+  };
+  while (pos != std::wstring::npos && pos + 1 < text.size()) {
+    const size_t begin = pos + 1;
+    pos = text.find(L'\n', begin);
+    const size_t end = pos == std::wstring::npos ? text.size() : pos;
+    const std::wstring_view line(text.data() + begin, end - begin);
+    if (line.size() < 2 || line[1] != L'\t') {
+      continue;
+    }
+    const size_t tab = line.find(L'\t', 2);
+    if (tab == std::wstring_view::npos) {
+      continue;
+    }
+    const std::wstring_view first = line.substr(2, tab - 2);
+    const std::wstring_view second = line.substr(tab + 1);
+    if (line[0] == L'L') {
+      wchar_t* cursor = nullptr;
+      const std::wstring key_text(first);
+      const uint64_t exe_key = std::wcstoull(key_text.c_str(), &cursor, 16);
+      const auto hash = ContentHash::FromHex(second);
+      if (*cursor == L'\0' && hash && known_blob(*hash) && links_.emplace(exe_key, *hash).second) {
+        ++blobs_[*hash].refs;
+      }
+    } else if (line[0] == L'U') {
+      const auto hash = ContentHash::FromHex(first);
+      if (hash && !second.empty() && known_blob(*hash)) {
+        sources_[std::wstring(second)] = *hash;
+      }
+    }
+  }
+  return true;
+}
+
+bool CoverBlobStore::Save() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (root_.empty()) {
+    return false;
+  }
+  if (!dirty_) {
+    return true;
+  }
+  std::wstring text(kHeader);
+  text += L'\n';
+  wchar_t key_text[17];
+  for (const auto& [exe_key, hash] : links_) {
+    swprintf(key_text, 17, L"%016llx", static_cast<unsigned long long>(exe_key));
+    text += L"L\t";
+    text += key_text;
+    text += L'\t';
+    text += hash.Hex();
+    text += L'\n';
+  }
+  for (const auto& [source, hash] : sources_) {
+    text += L"U\t";
+    text += hash.Hex();
+    text += L'\t';
+    text += source;
+    text += L'\n';
+  }
+  if (!Cache::WriteText((std::filesystem::path(root_) / kIndexName).wstring(), text)) {
+    return false;
+  }
+  dirty_ = false;
+  return true;
+}
+
+std::optional<ContentHash> CoverBlobStore::Put(uint64_t exe_key, const void* data, size_t size,
+                                               const std::wstring& source) {
+  if (!data || size == 0) {
+    return std::nullopt;
+  }
+  const ContentHash hash = Hash(data, size);
+  std::wstring temp_path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_.empty()) {
+      return std::nullopt;
+    }
+    if (blobs_.count(hash)) {
+      LinkLocked(exe_key, hash);
+      if (!source.empty()) {
+        sources_[source] = hash;
+      }
+      dirty_ = true;
+      return hash;
+    }
+    temp_path = BlobPath(hash) + L"." + std::to_wstring(++temp_serial_) + kTempExtension;
+    writing_.insert(temp_path);
+  }
+  const bool written = WriteBytes(temp_path, data, size);
+  std::lock_guard<std::mutex> lock(mutex_);
+  writing_.erase(temp_path);
+  if (!written) {
+    std::error_code ec;
+    std::filesystem::remove(temp_path, ec);
+    return std::nullopt;
+  }
+  if (!PublishLocked(exe_key, temp_path, hash, size, source)) {
+    return std::nullopt;
+  }
+  return hash;
+}
+
+std::wstring CoverBlobStore::StagingPath(const std::wstring& source) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (root_.empty()) {
+    return {};
+  }
+  const std::filesystem::path directory = std::filesystem::path(root_) / kStagingDirectory;
+  if (!Cache::EnsureDirectory(directory.wstring())) {
+    return {};
+  }
+  wchar_t name[32];
+  swprintf(name, 32, L"%016llx", static_cast<unsigned long long>(HashPath(source)));
+  return (directory / name).wstring();
+}
+
+std::optional<ContentHash> CoverBlobStore::Adopt(uint64_t exe_key, const std::wstring& file, const ContentHash& hash,
+                                                 uint64_t size, const std::wstring& source) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (root_.empty() || !PublishLocked(exe_key, file, hash, size, source)) {
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+    return std::nullopt;
+  }
+  return hash;
+}
+
+bool CoverBlobStore::Link(uint64_t exe_key, const ContentHash& hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return LinkLocked(exe_key, hash);
+}
+
+bool CoverBlobStore::LinkSource(uint64_t exe_key, const std::wstring& source) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sources_.find(source);
+  return it != sources_.end() && LinkLocked(exe_key, it->second);
+}
+
+void CoverBlobStore::Unlink(uint64_t exe_key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = links_.find(exe_key);
+  if (it == links_.end()) {
+    return;
+  }
+  ReleaseLocked(it->second);
+  links_.erase(it);
+  dirty_ = true;
+}
+
+std::optional<ContentHash> CoverBlobStore::Lookup(uint64_t exe_key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = links_.find(exe_key);
+  if (it == links_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::wstring CoverBlobStore::PathFor(uint64_t exe_key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = links_.find(exe_key);
+  if (it == links_.end()) {
+    return {};
+  }
+  return BlobPath(it->second);
+}
+
+std::wstring CoverBlobStore::BlobPath(const ContentHash& hash) const {
+  if (root_.empty()) {
+    return {};
+  }
+  return (std::filesystem::path(root_) / (hash.Hex() + kBlobExtension)).wstring();
+}
+
+// Moves a finished file to BlobPath(hash) unless the blob already exists;
+// either way `file` is gone afterwards. A rename, so cheap under the lock.
+bool CoverBlobStore::PublishLocked(uint64_t exe_key, const std::wstring& file, const ContentHash& hash,
+                                   uint64_t size, const std::wstring& source) {
+  std::error_code ec;
+  if (!blobs_.count(hash)) {
+    // A file left by an earlier run with the same digest is reused as is.
+    const std::wstring path = BlobPath(hash);
+    if (std::filesystem::file_size(path, ec) != size || ec) {
+      std::filesystem::rename(file, path, ec);
+      if (ec) {
+        std::filesystem::remove(file, ec);
+        return false;
+      }
+    }
+    blobs_[hash].size = size;
+  }
+  std::filesystem::remove(file, ec);
+  LinkLocked(exe_key, hash);
+  if (!source.empty()) {
+    sources_[source] = hash;
+  }
+  dirty_ = true;
+  return true;
+}
+
+size_t CoverBlobStore::CollectGarbage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (root_.empty()) {
+    return 0;
+  }
+  size_t removed = 0;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(root_, ec), end; !ec && it != end; it.increment(ec)) {
+    const std::filesystem::path& path = it->path();
+    const std::wstring extension = path.extension().wstring();
+    if (extension == kTempExtension) {
+      if (writing_.count(path.wstring())) {
+        continue;
+      }
+      std::error_code remove_ec;
+      removed += std::filesystem::remove(path, remove_ec) ? 1 : 0;
+      continue;
+    }
+    if (extension != kBlobExtension) {
+      continue;
+    }
+    const auto hash = ContentHash::FromHex(path.stem().wstring());
+    auto blob = hash ? blobs_.find(*hash) : blobs_.end();
+    if (blob != blobs_.end() && blob->second.refs > 0) {
+      continue;
+    }
+    std::error_code remove_ec;
+    if (!std::filesystem::remove(path, remove_ec)) {
+      continue;
+    }
+    ++removed;
+    if (blob != blobs_.end()) {
+      blobs_.erase(blob);
+    }
+  }
+  for (auto it = sources_.begin(); it != sources_.end();) {
+    if (blobs_.count(it->second)) {
+      ++it;
+    } else {
+      it = sources_.erase(it);
+      dirty_ = true;
+    }
+  }
+  return removed;
+}
+
+CoverBlobStats CoverBlobStore::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CoverBlobStats stats;
+  stats.links = links_.size();
+  stats.blobs = blobs_.size();
+  stats.sources = sources_.size();
+  for (const auto& [hash, blob] : blobs_) {
+    stats.blobBytes += blob.size;
+    if (blob.refs > 1) {
+      stats.savedBytes += blob.size * (blob.refs - 1);
+    }
+  }
+  return stats;
+}
+
+bool CoverBlobStore::LinkLocked(uint64_t exe_key, const ContentHash& hash) {
+  auto blob = blobs_.find(hash);
+  if (blob == blobs_.end()) {
+    return false;
+  }
+  auto [it, inserted] = links_.emplace(exe_key, hash);
+  if (!inserted) {
+    if (it->second == hash) {
+      return true;
+    }
+    ReleaseLocked(it->second);
+    it->second = hash;
+  }
+  ++blob->second.refs;
+  dirty_ = true;
+  return true;
+}
+
+void CoverBlobStore::ReleaseLocked(const ContentHash& hash) {
+  auto blob = blobs_.find(hash);
+  if (blob != blobs_.end() && blob->second.refs > 0) {
+    --blob->second.refs;
+  }
+}
+
+}  // namespace optiscaler
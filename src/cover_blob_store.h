@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "content_hash.h"
+
+namespace optiscaler {
+
+struct CoverBlobStats {
+  size_t links = 0;    // exe keys with a cover
+  size_t blobs = 0;    // distinct images on disk
+  size_t sources = 0;  // remembered download URLs
+  uint64_t blobBytes = 0;
+  uint64_t savedBytes = 0;  // bytes a per-exe layout would have duplicated
+};
+
+// Content-addressed cover files under cache\covers\blobs, named by the
+// SHA-256 of the encoded image. A text index maps exe keys
+// (GameEntry::coverKey) and download URLs to content hashes; a blob's
+// reference count is the number of exe keys linked to it, and blobs left at
+// zero are deleted by CollectGarbage. Thread-safe; file contents are
+// written outside the lock, which only covers the rename into place.
+class CoverBlobStore {
+ public:
+  static std::wstring DefaultRoot();
+  // Process-wide store at DefaultRoot(), opened on first use.
+  static CoverBlobStore& Default();
+  static ContentHash Hash(const void* data, size_t size);
+
+  // Loads `root`\index.txt; a missing index opens an empty store.
+  bool Open(const std::wstring& root);
+  bool Save();
+
+  // Writes the blob unless an identical one exists, then links `exe_key`.
+  std::optional<ContentHash> Put(uint64_t exe_key, const void* data, size_t size, const std::wstring& source = {});
+  // Where a download of `source` should be written before Adopt; empty if
+  // the store is not open.
+  std::wstring StagingPath(const std::wstring& source) const;
+  // Moves `file`, whose digest and size the caller already knows (e.g.
+  // DownloadResult), into the store and links `exe_key` to it. The file is
+  // consumed either way.
+  std::optional<ContentHash> Adopt(uint64_t exe_key, const std::wstring& file, const ContentHash& hash,
+                                   uint64_t size, const std::wstring& source = {});
+  // Links `exe_key` to an existing blob, releasing whatever it linked before.
+  bool Link(uint64_t exe_key, const ContentHash& hash);
+  // Links `exe_key` to the blob previously downloaded from `source`, so the
+  // same URL is never fetched twice.
+  bool LinkSource(uint64_t exe_key, const std::wstring& source);
+  void Unlink(uint64_t exe_key);
+
+  std::optional<ContentHash> Lookup(uint64_t exe_key) const;
+  // Empty if `exe_key` has no blob.
+  std::wstring PathFor(uint64_t exe_key) const;
+  std::wstring BlobPath(const ContentHash& hash) const;
+
+  // Deletes unreferenced blobs, including files the index no longer knows.
+  // Returns the number of files removed.
+  size_t CollectGarbage();
+  CoverBlobStats Stats() const;
+
+ private:
+  struct Blob {
+    uint32_t refs = 0;
+    uint64_t size = 0;
+  };
+
+  bool PublishLocked(uint64_t exe_key, const std::wstring& file, const ContentHash& hash, uint64_t size,
+                     const std::wstring& source);
+  bool LinkLocked(uint64_t exe_key, const ContentHash& hash);
+  void ReleaseLocked(const ContentHash& hash);
+
+  mutable std::mutex mutex_;
+  std::wstring root_;
+  std::unordered_set<std::wstring> writing_;  // temp files of Puts in progress; CollectGarbage skips them
+  uint64_t temp_serial_ = 0;
+  std::unordered_map<uint64_t, ContentHash> links_;
+  std::unordered_map<ContentHash, Blob, ContentHashHasher> blobs_;
+  std::unordered_map<std::wstring, ContentHash> sources_;
+  bool dirty_ = false;
+};
+
+}  // namespace optiscaler
@@ -1,30 +1,70 @@
 #include "cover_cache.h"
 
 #include <filesystem>
-#include <cwctype>
 #include <cstdint>
+#include <vector>
 
 #include <wincodec.h>
+#include <wrl/client.h>
 
 #include "cache.h"
+#include "cover_mips.h"
+#include "path_key.h"
+#include "perf_trace.h"
+#include "resampler.h"
+
+#pragma comment(lib, "windowscodecs.lib")
 
 namespace optiscaler {
 
 namespace {
-constexpr uint64_t kHashOffset = 1469598103934665603ull;
-constexpr uint64_t kHashPrime = 1099511628211ull;
 
-uint64_t HashPath(const std::wstring& path) {
-  uint64_t hash = kHashOffset;
-  for (wchar_t ch : path) {
-    hash ^= static_cast<uint64_t>(towlower(ch));
-    hash *= kHashPrime;
+using Microsoft::WRL::ComPtr;
+
+// Covers are decoded on worker threads as well as the UI thread, so COM is
+// joined on demand; threads already in an STA keep their apartment.
+class ComScope {
+ public:
+  ComScope() : hr_(CoInitializeEx(nullptr, COINIT_MULTITHREADED)) {}
+  ~ComScope() {
+    if (SUCCEEDED(hr_)) {
+      CoUninitialize();
+    }
+  }
+  bool ok() const { return SUCCEEDED(hr_) || hr_ == RPC_E_CHANGED_MODE; }
+
+ private:
+  HRESULT hr_;
+};
+
+ComPtr<IWICImagingFactory> CreateFactory() {
+  thread_local ComScope com;
+  ComPtr<IWICImagingFactory> factory;
+  if (!com.ok() || FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                           IID_PPV_ARGS(&factory)))) {
+    return nullptr;
   }
-  return hash;
+  return factory;
+}
+
+bool ReadStream(IStream* stream, std::vector<uint8_t>& bytes_out) {
+  STATSTG stat = {};
+  const LARGE_INTEGER start = {};
+  if (FAILED(stream->Stat(&stat, STATFLAG_NONAME)) || FAILED(stream->Seek(start, STREAM_SEEK_SET, nullptr))) {
+    return false;
+  }
+  bytes_out.resize(static_cast<size_t>(stat.cbSize.QuadPart));
+  ULONG read = 0;
+  return SUCCEEDED(stream->Read(bytes_out.data(), static_cast<ULONG>(bytes_out.size()), &read)) &&
+         read == bytes_out.size();
 }
 
 }  // namespace
 
+uint64_t CoverCache::KeyForExe(const std::wstring& exe_path) {
+  return HashPath(exe_path);
+}
+
 std::wstring CoverCache::PathForExe(const std::wstring& exe_path) {
   const std::wstring root = Cache::AppDataRoot();
   if (root.empty()) {
@@ -36,19 +76,155 @@ std::wstring CoverCache::PathForExe(const std::wstring& exe_path) {
   path /= L"by_game";
   Cache::EnsureDirectory(path.wstring());
   wchar_t buffer[32];
-  swprintf(buffer, 32, L"%016llx.png", static_cast<unsigned long long>(HashPath(exe_path)));
+  swprintf(buffer, 32, L"%016llx.png", static_cast<unsigned long long>(KeyForExe(exe_path)));
   path /= buffer;
   return path.wstring();
 }
 
-HBITMAP CoverCache::LoadForExe(const std::wstring& /*exe_path*/, int /*width*/, int /*height*/) {
-  // TODO: Implement WIC decoding for cached bitmaps.
-  return nullptr;
+CoverBlobStore& CoverCache::Blobs() {
+  return CoverBlobStore::Default();
+}
+
+bool CoverCache::LoadForExe(const std::wstring& exe_path, int width, int height, CoverImage& image_out) {
+  image_out = CoverImage{};
+  std::wstring path = Blobs().PathFor(KeyForExe(exe_path));
+  if (path.empty()) {
+    path = PathForExe(exe_path);
+  }
+  std::error_code ec;
+  if (path.empty() || !std::filesystem::is_regular_file(path, ec)) {
+    return false;
+  }
+  ComPtr<IWICImagingFactory> factory = CreateFactory();
+  ComPtr<IWICBitmapDecoder> decoder;
+  ComPtr<IWICBitmapFrameDecode> frame;
+  if (!factory ||
+      FAILED(factory->CreateDecoderFromFilename(path.c_str(), nullptr, GENERIC_READ,
+                                                WICDecodeMetadataCacheOnDemand, &decoder)) ||
+      FAILED(decoder->GetFrame(0, &frame))) {
+    return false;
+  }
+  UINT source_width = 0;
+  UINT source_height = 0;
+  if (FAILED(frame->GetSize(&source_width, &source_height)) || source_width == 0 || source_height == 0) {
+    return false;
+  }
+
+  ComPtr<IWICFormatConverter> converter;
+  if (FAILED(factory->CreateFormatConverter(&converter)) ||
+      FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr,
+                                   0.0, WICBitmapPaletteTypeCustom))) {
+    return false;
+  }
+
+  CoverImage image;
+  image.width = static_cast<int>(source_width);
+  image.height = static_cast<int>(source_height);
+  image.pixels.resize(image.stride() * source_height);
+  if (FAILED(converter->CopyPixels(nullptr, static_cast<UINT>(image.stride()), static_cast<UINT>(image.bytes()),
+                                   image.pixels.data()))) {
+    return false;
+  }
+  if (width > 0 && height > 0 && (image.width != width || image.height != height)) {
+    return Resampler::Resize(image, width, height, ResampleFilter::kLanczos3, image_out);
+  }
+  image_out = std::move(image);
+  return true;
+}
+
+bool CoverCache::SaveForExe(const CoverImage& image, const std::wstring& exe_path) {
+  if (image.empty()) {
+    return false;
+  }
+  ComPtr<IWICImagingFactory> factory = CreateFactory();
+  ComPtr<IWICBitmap> bitmap;
+  if (!factory ||
+      FAILED(factory->CreateBitmapFromMemory(image.width, image.height, GUID_WICPixelFormat32bppPBGRA,
+                                             static_cast<UINT>(image.stride()), static_cast<UINT>(image.bytes()),
+                                             const_cast<BYTE*>(image.data()), &bitmap))) {
+    return false;
+  }
+
+  ComPtr<IStream> memory;
+  ComPtr<IWICStream> stream;
+  ComPtr<IWICBitmapEncoder> encoder;
+  ComPtr<IWICBitmapFrameEncode> frame;
+  std::vector<uint8_t> encoded;
+  const bool ok = SUCCEEDED(CreateStreamOnHGlobal(nullptr, TRUE, &memory)) &&
+                  SUCCEEDED(factory->CreateStream(&stream)) && SUCCEEDED(stream->InitializeFromIStream(memory.Get())) &&
+                  SUCCEEDED(factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder)) &&
+                  SUCCEEDED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache)) &&
+                  SUCCEEDED(encoder->CreateNewFrame(&frame, nullptr)) && SUCCEEDED(frame->Initialize(nullptr)) &&
+                  SUCCEEDED(frame->SetSize(image.width, image.height)) &&
+                  SUCCEEDED(frame->WriteSource(bitmap.Get(), nullptr)) && SUCCEEDED(frame->Commit()) &&
+                  SUCCEEDED(encoder->Commit()) && ReadStream(memory.Get(), encoded);
+  return ok && SaveEncodedForExe(encoded.data(), encoded.size(), exe_path);
+}
+
+bool CoverCache::SaveEncodedForExe(const void* data, size_t size, const std::wstring& exe_path,
+                                   const std::wstring& source) {
+  if (!Blobs().Put(KeyForExe(exe_path), data, size, source)) {
+    return false;
+  }
+  // The blob now shadows any per-exe PNG from older versions.
+  const std::wstring legacy_path = PathForExe(exe_path);
+  if (!legacy_path.empty()) {
+    DeleteFileW(legacy_path.c_str());
+  }
+  return true;
+}
+
+std::shared_ptr<const CoverImage> CoverCache::Acquire(DecodedCoverCache& decoded, const CoverAtlas* atlas,
+                                                      const GameEntry& game, int tile_width, int tile_height) {
+  return Acquire(decoded, atlas, game.coverKey, game.exe, tile_width, tile_height);
 }
 
-bool CoverCache::SaveForExe(HBITMAP /*bitmap*/, const std::wstring& /*exe_path*/) {
-  // TODO: Implement WIC encoding for cached bitmaps.
-  return false;
+uint64_t CoverCache::DecodedKey(uint64_t cover_key, int tile_width, int tile_height) {
+  return CoverMips::LevelKey(cover_key, CoverMips::LevelForTile(tile_width, tile_height));
+}
+
+uint32_t CoverCache::SourceTag(uint64_t cover_key) {
+  const auto hash = Blobs().Lookup(cover_key);
+  return hash ? CoverMips::SourceTag(*hash) : 0;
+}
+
+void CoverCache::Evict(DecodedCoverCache& decoded, uint64_t cover_key) {
+  for (int level = 0; level < CoverMips::kLevels; ++level) {
+    decoded.Erase(CoverMips::LevelKey(cover_key, level));
+  }
+}
+
+std::shared_ptr<const CoverImage> CoverCache::Acquire(DecodedCoverCache& decoded, const CoverAtlas* atlas,
+                                                      uint64_t cover_key, const std::wstring& exe_path,
+                                                      int tile_width, int tile_height) {
+  if (cover_key == 0) {
+    return nullptr;
+  }
+  const uint64_t key = DecodedKey(cover_key, tile_width, tile_height);
+  if (auto image = decoded.Find(key)) {
+    return image;
+  }
+  PerfScope scope("CoverCache::Load");
+  const int level = CoverMips::LevelForTile(tile_width, tile_height);
+  const int width = CoverMips::LevelWidth(level);
+  const int height = CoverMips::LevelHeight(level);
+  CoverImage image;
+  AtlasTile tile;
+  if (atlas && CoverMips::FindTile(*atlas, cover_key, SourceTag(cover_key), tile_width, tile_height, tile)) {
+    if (tile.width == width && tile.height == height) {
+      // Served straight from the mapping; the view pins it until evicted.
+      image = tile.AsImage();
+    } else {
+      // Only while the chain is incomplete: a neighbouring level stands in.
+      const ResampleFilter filter = tile.width > width ? ResampleFilter::kBox : ResampleFilter::kBilinear;
+      if (!Resampler::Resize(tile.AsImage(), width, height, filter, image)) {
+        return nullptr;
+      }
+    }
+  } else if (!LoadForExe(exe_path, width, height, image)) {
+    return nullptr;
+  }
+  return decoded.Insert(key, std::move(image));
 }
 
 }  // namespace optiscaler
@@ -1,16 +1,54 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
-#include <windows.h>
+#include "cover_atlas.h"
+#include "cover_blob_store.h"
+#include "cover_image.h"
+#include "decoded_cover_cache.h"
+#include "game_types.h"
 
 namespace optiscaler {
 
+// On-disk covers keyed by HashPath(exe), which is also GameEntry::coverKey
+// and the DecodedCoverCache key. Images live in the content-addressed
+// CoverBlobStore, so games sharing a cover share one file; the older
+// per-exe PNGs under cache\covers\by_game are still read and are removed
+// once a cover is saved again.
 class CoverCache {
  public:
+  static uint64_t KeyForExe(const std::wstring& exe_path);
+  // Legacy per-exe location.
   static std::wstring PathForExe(const std::wstring& exe_path);
-  static HBITMAP LoadForExe(const std::wstring& exe_path, int width, int height);
-  static bool SaveForExe(HBITMAP bitmap, const std::wstring& exe_path);
+  // CoverBlobStore::Default().
+  static CoverBlobStore& Blobs();
+  // Decodes to premultiplied BGRA, scaled to width x height unless either
+  // is 0. WIC needs COM; it is initialized for the calling thread if needed.
+  static bool LoadForExe(const std::wstring& exe_path, int width, int height, CoverImage& image_out);
+  static bool SaveForExe(const CoverImage& image, const std::wstring& exe_path);
+  // Stores an already encoded image (e.g. a downloaded JPEG) as is.
+  static bool SaveEncodedForExe(const void* data, size_t size, const std::wstring& exe_path,
+                                const std::wstring& source = {});
+  // Cover for a tile_width x tile_height grid tile, at the mip level
+  // CoverMips::LevelForTile picks: memory hit under DecodedKey(), else the
+  // nearest atlas level built from the current blob (served in place if it
+  // is the wanted one, resized otherwise), else the decoded PNG. Misses are
+  // inserted into `decoded`. Null if there is no cover. The second form
+  // takes GameEntry::coverKey and exe directly.
+  static std::shared_ptr<const CoverImage> Acquire(DecodedCoverCache& decoded, const CoverAtlas* atlas,
+                                                   const GameEntry& game, int tile_width, int tile_height);
+  static std::shared_ptr<const CoverImage> Acquire(DecodedCoverCache& decoded, const CoverAtlas* atlas,
+                                                   uint64_t cover_key, const std::wstring& exe_path,
+                                                   int tile_width, int tile_height);
+  // The DecodedCoverCache key Acquire uses for that tile size.
+  static uint64_t DecodedKey(uint64_t cover_key, int tile_width, int tile_height);
+  // CoverMips::SourceTag of the blob `cover_key` links to; 0 without one.
+  static uint32_t SourceTag(uint64_t cover_key);
+  // Drops every level of `cover_key` from `decoded`, e.g. after its cover
+  // was replaced.
+  static void Evict(DecodedCoverCache& decoded, uint64_t cover_key);
 };
 
 }  // namespace optiscaler
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace optiscaler {
+
+// Decoded cover art: 8-bit BGRA, premultiplied alpha, rows packed
+// top-down with no padding. This matches the DIB layout GDI and D3D
+// consume, so no conversion is needed at draw time.
+//
+// Pixels are either owned (`pixels`) or a read-only view of memory kept
+// alive by `backing`, e.g. a tile in the mapped CoverAtlas. Readers go
+// through data(); only producers write `pixels`.
+struct CoverImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+  const uint8_t* view = nullptr;
+  std::shared_ptr<const void> backing;
+
+  static CoverImage View(const uint8_t* pixels, int width, int height, std::shared_ptr<const void> backing) {
+    CoverImage image;
+    image.width = width;
+    image.height = height;
+    image.view = pixels;
+    image.backing = std::move(backing);
+    return image;
+  }
+
+  const uint8_t* data() const { return view ? view : pixels.data(); }
+  bool isView() const { return view != nullptr; }
+  size_t stride() const { return static_cast<size_t>(width) * 4; }
+  // Pixel bytes, owned or viewed.
+  size_t bytes() const { return view ? stride() * static_cast<size_t>(height) : pixels.size(); }
+  bool empty() const {
+    return width <= 0 || height <= 0 || (!view && pixels.size() < stride() * static_cast<size_t>(height));
+  }
+};
+
+}  // namespace optiscaler
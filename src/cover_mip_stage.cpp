@@ -0,0 +1,96 @@
+#include "cover_mip_stage.h"
+
+#include <iterator>
+
+#include "cover_cache.h"
+#include "cover_mips.h"
+
+namespace optiscaler {
+
+CoverMipStage::CoverMipStage(size_t worker_count, size_t batch_size)
+    : batch_size_(batch_size == 0 ? 1 : batch_size), pool_(worker_count) {}
+
+CoverMipStage::~CoverMipStage() {
+  stopping_ = true;
+  pool_.Wait();
+}
+
+void CoverMipStage::Start(const std::vector<GameEntry>& games, const CoverAtlas& atlas, ReadyCallback ready) {
+  std::vector<std::pair<uint64_t, std::wstring>> batch;
+  auto flush = [&] {
+    if (batch.empty()) {
+      return;
+    }
+    pending_ += batch.size();
+    pool_.Submit([this, batch = std::move(batch), ready] { RunBatch(batch, ready); });
+    batch.clear();
+  };
+  for (const auto& game : games) {
+    if (game.coverKey == 0 || CoverMips::HasChain(atlas, game.coverKey, CoverCache::SourceTag(game.coverKey))) {
+      continue;
+    }
+    batch.emplace_back(game.coverKey, game.exe);
+    if (batch.size() >= batch_size_) {
+      flush();
+    }
+  }
+  flush();
+}
+
+void CoverMipStage::RunBatch(const std::vector<std::pair<uint64_t, std::wstring>>& batch,
+                             const ReadyCallback& ready) {
+  std::vector<Chain> built;
+  built.reserve(batch.size());
+  for (const auto& [key, exe] : batch) {
+    if (stopping_) {
+      return;  // nobody drains or waits for ready any more
+    }
+    // Tag before decoding: if the cover is replaced in between, the chain
+    // carries the older tag and is rebuilt, never the other way round.
+    const uint32_t tag = CoverCache::SourceTag(key);
+    CoverImage source;
+    if (CoverCache::LoadForExe(exe, 0, 0, source)) {
+      auto levels = CoverMips::Build(source);
+      if (!levels.empty()) {
+        built.push_back({key, tag, std::move(levels)});
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::move(built.begin(), built.end(), std::back_inserter(done_));
+  }
+  pending_ -= batch.size();
+  if (ready) {
+    ready();
+  }
+}
+
+size_t CoverMipStage::Drain(CoverAtlas& atlas, DecodedCoverCache* decoded) {
+  std::vector<Chain> done;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done.swap(done_);
+  }
+  if (done.empty()) {
+    return 0;
+  }
+  std::vector<AtlasWrite> tiles;
+  for (const auto& chain : done) {
+    for (size_t level = 0; level < chain.levels.size(); ++level) {
+      tiles.push_back({CoverMips::LevelKey(chain.coverKey, static_cast<int>(level)), &chain.levels[level],
+                       chain.sourceTag});
+    }
+  }
+  if (!atlas.Append(tiles)) {
+    return 0;
+  }
+  if (decoded) {
+    for (const auto& chain : done) {
+      CoverCache::Evict(*decoded, chain.coverKey);
+    }
+  }
+  return done.size();
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cover_atlas.h"
+#include "cover_image.h"
+#include "decoded_cover_cache.h"
+#include "game_types.h"
+#include "thread_pool.h"
+
+namespace optiscaler {
+
+// Background stage that turns cached covers into CoverMips chains. Decoding
+// and downscaling run on a pool in batches; finished batches wait until the
+// atlas owner calls Drain, which writes each batch with a single append.
+class CoverMipStage {
+ public:
+  using ReadyCallback = std::function<void()>;
+
+  explicit CoverMipStage(size_t worker_count = 0, size_t batch_size = 32);
+  ~CoverMipStage();
+
+  CoverMipStage(const CoverMipStage&) = delete;
+  CoverMipStage& operator=(const CoverMipStage&) = delete;
+
+  // Queues every game whose chain is missing from `atlas` or was built from
+  // a blob the cover no longer links to. `ready` runs on a worker thread
+  // after each batch completes.
+  void Start(const std::vector<GameEntry>& games, const CoverAtlas& atlas, ReadyCallback ready);
+  // Returns the number of covers appended to `atlas`. Their entries in
+  // `decoded`, which may still show the previous image, are evicted.
+  size_t Drain(CoverAtlas& atlas, DecodedCoverCache* decoded = nullptr);
+  size_t pending() const { return pending_.load(); }
+
+ private:
+  struct Chain {
+    uint64_t coverKey = 0;
+    uint32_t sourceTag = 0;
+    std::vector<CoverImage> levels;
+  };
+
+  void RunBatch(const std::vector<std::pair<uint64_t, std::wstring>>& batch, const ReadyCallback& ready);
+
+  const size_t batch_size_;
+  std::mutex mutex_;
+  std::vector<Chain> done_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<bool> stopping_{false};  // set by the destructor; batches stop at the next cover
+  WorkStealingPool pool_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,84 @@
+#include "cover_mips.h"
+
+#include "resampler.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr uint64_t kLevelKeyStride = 0x9E3779B97F4A7C15ull;
+
+bool FindLevel(const CoverAtlas& atlas, uint64_t cover_key, uint32_t source_tag, int level, AtlasTile& tile_out) {
+  return atlas.Find(CoverMips::LevelKey(cover_key, level), tile_out) && tile_out.tag == source_tag;
+}
+
+}  // namespace
+
+uint64_t CoverMips::LevelKey(uint64_t cover_key, int level) {
+  return cover_key + static_cast<uint64_t>(level) * kLevelKeyStride;
+}
+
+int CoverMips::LevelForTile(int tile_width, int tile_height) {
+  for (int level = kLevels - 1; level > 0; --level) {
+    if (LevelWidth(level) >= tile_width && LevelHeight(level) >= tile_height) {
+      return level;
+    }
+  }
+  return 0;
+}
+
+uint32_t CoverMips::SourceTag(const ContentHash& hash) {
+  const uint32_t tag = static_cast<uint32_t>(hash.bytes[0]) | static_cast<uint32_t>(hash.bytes[1]) << 8 |
+                       static_cast<uint32_t>(hash.bytes[2]) << 16 | static_cast<uint32_t>(hash.bytes[3]) << 24;
+  return tag == 0 ? 1 : tag;
+}
+
+std::vector<CoverImage> CoverMips::Build(const CoverImage& source) {
+  std::vector<CoverImage> levels;
+  CoverImage base;
+  if (source.width == kBaseWidth && source.height == kBaseHeight) {
+    base = source;
+  } else if (!Resampler::Resize(source, kBaseWidth, kBaseHeight, ResampleFilter::kLanczos3, base)) {
+    return levels;
+  }
+  levels.reserve(kLevels);
+  levels.emplace_back(std::move(base));
+  for (int level = 1; level < kLevels; ++level) {
+    CoverImage next;
+    if (!Resampler::Resize(levels.back(), LevelWidth(level), LevelHeight(level), ResampleFilter::kBox, next)) {
+      break;
+    }
+    levels.emplace_back(std::move(next));
+  }
+  return levels;
+}
+
+bool CoverMips::HasChain(const CoverAtlas& atlas, uint64_t cover_key, uint32_t source_tag) {
+  AtlasTile tile;
+  for (int level = 0; level < kLevels; ++level) {
+    if (!FindLevel(atlas, cover_key, source_tag, level, tile)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CoverMips::FindTile(const CoverAtlas& atlas, uint64_t cover_key, uint32_t source_tag, int tile_width,
+                         int tile_height, AtlasTile& tile_out) {
+  const int wanted = LevelForTile(tile_width, tile_height);
+  // Prefer finer levels (downscaled at draw time) over coarser ones.
+  for (int level = wanted; level >= 0; --level) {
+    if (FindLevel(atlas, cover_key, source_tag, level, tile_out)) {
+      return true;
+    }
+  }
+  for (int level = wanted + 1; level < kLevels; ++level) {
+    if (FindLevel(atlas, cover_key, source_tag, level, tile_out)) {
+      return true;
+    }
+  }
+  tile_out = AtlasTile{};
+  return false;
+}
+
+}  // namespace optiscaler
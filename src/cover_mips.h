@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "content_hash.h"
+#include "cover_atlas.h"
+#include "cover_image.h"
+
+namespace optiscaler {
+
+// Fixed mip chain per cover: 200x300, 100x150, 50x75. Every level lives in
+// the CoverAtlas under a key derived from GameEntry::coverKey, so dense
+// views read a quarter or a sixteenth of the bytes per tile. Each level is
+// tagged with SourceTag() of the blob it was built from; levels whose tag
+// no longer matches the cover's blob are stale and treated as missing.
+class CoverMips {
+ public:
+  static constexpr int kLevels = 3;
+  static constexpr int kBaseWidth = 200;
+  static constexpr int kBaseHeight = 300;
+
+  static int LevelWidth(int level) { return kBaseWidth >> level; }
+  static int LevelHeight(int level) { return kBaseHeight >> level; }
+  static uint64_t LevelKey(uint64_t cover_key, int level);
+  // Smallest level still at least as large as the tile, so nothing is
+  // upscaled; level 0 if the tile is larger than the base size.
+  static int LevelForTile(int tile_width, int tile_height);
+  // Atlas tag for levels built from the blob with `hash`; never 0, which
+  // stands for covers without a blob (legacy per-exe PNGs).
+  static uint32_t SourceTag(const ContentHash& hash);
+
+  // Level 0 is a Lanczos resize of `source`; each further level is a 2x2
+  // box average of the previous one.
+  static std::vector<CoverImage> Build(const CoverImage& source);
+  static bool HasChain(const CoverAtlas& atlas, uint64_t cover_key, uint32_t source_tag);
+  // The level for the tile size, else the nearest level that exists, finer
+  // ones first. Levels with another tag are skipped.
+  static bool FindTile(const CoverAtlas& atlas, uint64_t cover_key, uint32_t source_tag, int tile_width,
+                       int tile_height, AtlasTile& tile_out);
+};
+
+}  // namespace optiscaler
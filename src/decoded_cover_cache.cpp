@@ -0,0 +1,132 @@
+#include "decoded_cover_cache.h"
+
+namespace optiscaler {
+
+DecodedCoverCache::DecodedCoverCache(size_t budget_bytes) : budget_(budget_bytes) {}
+
+std::shared_ptr<const CoverImage> DecodedCoverCache::Find(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second.lru);
+  return it->second.image;
+}
+
+std::shared_ptr<const CoverImage> DecodedCoverCache::Peek(uint64_t key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  return it == entries_.end() ? nullptr : it->second.image;
+}
+
+std::shared_ptr<const CoverImage> DecodedCoverCache::Insert(uint64_t key, CoverImage image) {
+  auto shared = std::make_shared<const CoverImage>(std::move(image));
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    bytes_ -= it->second.image->bytes();
+    it->second.image = shared;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+  } else {
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{shared, lru_.begin(), 0});
+  }
+  bytes_ += shared->bytes();
+  EvictLocked();
+  return shared;
+}
+
+bool DecodedCoverCache::Contains(uint64_t key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.count(key) != 0;
+}
+
+void DecodedCoverCache::Erase(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return;
+  }
+  bytes_ -= it->second.image->bytes();
+  if (it->second.pins != 0) {
+    --pinned_;
+  }
+  lru_.erase(it->second.lru);
+  entries_.erase(it);
+}
+
+void DecodedCoverCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  bytes_ = 0;
+  pinned_ = 0;
+}
+
+bool DecodedCoverCache::Pin(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  if (it->second.pins++ == 0) {
+    ++pinned_;
+  }
+  return true;
+}
+
+void DecodedCoverCache::Unpin(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second.pins == 0) {
+    return;
+  }
+  if (--it->second.pins == 0) {
+    --pinned_;
+    EvictLocked();
+  }
+}
+
+void DecodedCoverCache::SetBudget(size_t budget_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  budget_ = budget_bytes;
+  EvictLocked();
+}
+
+size_t DecodedCoverCache::budget() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return budget_;
+}
+
+CoverCacheStats DecodedCoverCache::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CoverCacheStats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  stats.bytes = bytes_;
+  stats.entries = entries_.size();
+  stats.pinned = pinned_;
+  return stats;
+}
+
+// Walks from the cold end, skipping pinned entries.
+void DecodedCoverCache::EvictLocked() {
+  auto it = lru_.end();
+  while (bytes_ > budget_ && it != lru_.begin()) {
+    --it;
+    auto entry = entries_.find(*it);
+    if (entry->second.pins != 0) {
+      continue;
+    }
+    bytes_ -= entry->second.image->bytes();
+    entries_.erase(entry);
+    it = lru_.erase(it);
+    ++evictions_;
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "cover_image.h"
+
+namespace optiscaler {
+
+struct CoverCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t bytes = 0;
+  size_t entries = 0;
+  size_t pinned = 0;
+};
+
+// In-memory LRU of decoded covers keyed by HashPath(exe) (GameEntry::coverKey).
+// Unpinned entries are evicted oldest-first once the byte budget is
+// exceeded; pinned entries (visible tiles) never are, so the budget is soft
+// while many tiles are on screen. Images are handed out as shared_ptr, so an
+// eviction never frees pixels a renderer is still reading. Thread-safe.
+class DecodedCoverCache {
+ public:
+  static constexpr size_t kDefaultBudgetBytes = 64 * 1024 * 1024;
+
+  explicit DecodedCoverCache(size_t budget_bytes = kDefaultBudgetBytes);
+
+  DecodedCoverCache(const DecodedCoverCache&) = delete;
+  DecodedCoverCache& operator=(const DecodedCoverCache&) = delete;
+
+  // Null on a miss. A hit makes the entry most recently used.
+  std::shared_ptr<const CoverImage> Find(uint64_t key);
+  // Like Find, but neither counted in Stats() nor touching recency. For
+  // painting, where the visible covers are pinned instead.
+  std::shared_ptr<const CoverImage> Peek(uint64_t key) const;
+  // Replaces any existing image for `key`, keeping its pin count.
+  std::shared_ptr<const CoverImage> Insert(uint64_t key, CoverImage image);
+  bool Contains(uint64_t key) const;
+  void Erase(uint64_t key);
+  void Clear();
+
+  // Pins nest; returns false if `key` is not cached.
+  bool Pin(uint64_t key);
+  void Unpin(uint64_t key);
+
+  void SetBudget(size_t budget_bytes);
+  size_t budget() const;
+  CoverCacheStats Stats() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const CoverImage> image;
+    std::list<uint64_t>::iterator lru;
+    size_t pins = 0;
+  };
+
+  void EvictLocked();
+
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, Entry> entries_;
+  std::list<uint64_t> lru_;  // front = most recently used
+  size_t budget_ = 0;
+  size_t bytes_ = 0;
+  size_t pinned_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+};
+
+}  // namespace optiscaler
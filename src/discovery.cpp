@@ -0,0 +1,250 @@
+#include "discovery.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "bounded_queue.h"
+#include "exe_ranker.h"
+#include "game_sort.h"
+#include "mapped_file.h"
+#include "path_key.h"
+#include "steam_library.h"
+#include "text_util.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr size_t kMaxManifestWorkers = 8;
+
+bool HasExtension(const std::filesystem::path& path, std::wstring_view extension) {
+  const std::wstring actual = path.extension().wstring();
+  return std::equal(actual.begin(), actual.end(), extension.begin(), extension.end(),
+                    [](wchar_t a, wchar_t b) { return std::towlower(a) == std::towlower(b); });
+}
+
+std::string_view JsonString(const nlohmann::json& object, const char* key) {
+  auto it = object.find(key);
+  if (it == object.end() || !it->is_string()) {
+    return {};
+  }
+  return it->get_ref<const std::string&>();
+}
+
+bool JsonBool(const nlohmann::json& object, const char* key) {
+  auto it = object.find(key);
+  return it != object.end() && it->is_boolean() && it->get<bool>();
+}
+
+uint64_t JsonUint64(const nlohmann::json& object, const char* key) {
+  auto it = object.find(key);
+  return it != object.end() && it->is_number_unsigned() ? it->get<uint64_t>() : 0;
+}
+
+}  // namespace
+
+SteamManifestProvider::SteamManifestProvider(std::vector<std::wstring> libraries)
+    : libraries_(std::move(libraries)) {}
+
+void SteamManifestProvider::EnumerateManifests(const std::function<void(std::wstring)>& emit) {
+  for (const auto& library : libraries_) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(std::filesystem::path(library) / L"steamapps",
+                                           std::filesystem::directory_options::skip_permission_denied, ec);
+    const std::filesystem::directory_iterator end;
+    for (; !ec && it != end; it.increment(ec)) {
+      if (SteamLibrary::IsAppManifestName(it->path().filename().wstring())) {
+        emit(it->path().wstring());
+      }
+    }
+  }
+}
+
+void SteamManifestProvider::ParseManifest(const std::wstring& path, ManifestResult& result) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    return;
+  }
+  // <library>\steamapps\appmanifest_<id>.acf
+  const std::wstring library = std::filesystem::path(path).parent_path().parent_path().wstring();
+  SteamApp app;
+  if (!SteamLibrary::ParseAppManifest(file.view(), library, app)) {
+    return;
+  }
+  std::error_code ec;
+  if (!std::filesystem::is_directory(app.installDir, ec)) {
+    return;
+  }
+  // ACF files do not name the executable, so the install dir is crawled;
+  // that walk is confined to a single game instead of all of steamapps.
+  result.roots.push_back(ScanRoot{std::move(app.installDir), L"steam", app.appId, std::move(app.name), true,
+                                  app.sizeOnDisk, app.lastPlayed});
+}
+
+EpicManifestProvider::EpicManifestProvider(std::wstring manifest_dir) : manifest_dir_(std::move(manifest_dir)) {}
+
+void EpicManifestProvider::EnumerateManifests(const std::function<void(std::wstring)>& emit) {
+  if (manifest_dir_.empty()) {
+    return;
+  }
+  std::error_code ec;
+  std::filesystem::directory_iterator it(manifest_dir_, std::filesystem::directory_options::skip_permission_denied,
+                                         ec);
+  const std::filesystem::directory_iterator end;
+  for (; !ec && it != end; it.increment(ec)) {
+    if (HasExtension(it->path(), L".item")) {
+      emit(it->path().wstring());
+    }
+  }
+}
+
+void EpicManifestProvider::ParseManifest(const std::wstring& path, ManifestResult& result) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    return;
+  }
+  const auto json = nlohmann::json::parse(file.data(), file.data() + file.size(), nullptr, false);
+  if (json.is_discarded() || !json.is_object() || JsonBool(json, "bIsIncompleteInstall")) {
+    return;
+  }
+  const std::string_view install_location = JsonString(json, "InstallLocation");
+  const std::string_view launch_executable = JsonString(json, "LaunchExecutable");
+  if (install_location.empty() || launch_executable.empty()) {
+    return;
+  }
+  // DLC items point at their base game's install; only keep main apps.
+  const std::string_view app_name = JsonString(json, "AppName");
+  const std::string_view main_app_name = JsonString(json, "MainGameAppName");
+  if (!main_app_name.empty() && app_name != main_app_name) {
+    return;
+  }
+
+  const std::filesystem::path folder = std::filesystem::path(WideFromUtf8(install_location)).lexically_normal();
+  const std::filesystem::path exe = (folder / WideFromUtf8(launch_executable)).lexically_normal();
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(exe, ec)) {
+    return;
+  }
+  GameEntry game;
+  game.exe = exe.wstring();
+  game.coverKey = HashPath(game.exe);
+  game.folder = folder.wstring();
+  game.name = WideFromUtf8(JsonString(json, "DisplayName"));
+  if (game.name.empty()) {
+    game.name = exe.stem().wstring();
+  }
+  game.source = L"epic";
+  game.installSize = JsonUint64(json, "InstallSize");
+  result.games.emplace_back(std::move(game));
+}
+
+CustomFolderProvider::CustomFolderProvider(std::vector<std::wstring> folders) : folders_(std::move(folders)) {}
+
+std::vector<ScanRoot> CustomFolderProvider::CrawlRoots() {
+  std::vector<ScanRoot> roots;
+  roots.reserve(folders_.size());
+  for (const auto& folder : folders_) {
+    roots.push_back(ScanRoot{folder, {}, std::nullopt, {}, false, 0, 0});
+  }
+  return roots;
+}
+
+void DiscoveryPipeline::AddProvider(std::unique_ptr<IDiscoveryProvider> provider) {
+  if (provider) {
+    providers_.emplace_back(std::move(provider));
+  }
+}
+
+std::vector<GameEntry> DiscoveryPipeline::Run(const DiscoveryOptions& options) const {
+  struct Job {
+    size_t provider = 0;
+    std::wstring path;
+  };
+  size_t worker_count = options.manifestWorkers;
+  if (worker_count == 0) {
+    worker_count = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, kMaxManifestWorkers);
+  }
+
+  BoundedQueue<Job> queue(options.queueCapacity);
+  std::mutex merged_mutex;
+  ManifestResult merged;
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers.emplace_back([&] {
+      ManifestResult local;
+      Job job;
+      while (queue.Pop(job)) {
+        providers_[job.provider]->ParseManifest(job.path, local);
+      }
+      std::lock_guard<std::mutex> lock(merged_mutex);
+      std::move(local.games.begin(), local.games.end(), std::back_inserter(merged.games));
+      std::move(local.roots.begin(), local.roots.end(), std::back_inserter(merged.roots));
+    });
+  }
+  for (size_t i = 0; i < providers_.size(); ++i) {
+    providers_[i]->EnumerateManifests([&](std::wstring path) { queue.Push(Job{i, std::move(path)}); });
+  }
+  queue.Close();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  // Parse order is nondeterministic; fix the root order before crawling
+  // because the earliest root wins when two roots reach the same exe.
+  std::sort(merged.roots.begin(), merged.roots.end(),
+            [](const ScanRoot& a, const ScanRoot& b) { return a.path < b.path; });
+  std::vector<ScanRoot> roots = std::move(merged.roots);
+  for (const auto& provider : providers_) {
+    auto crawl = provider->CrawlRoots();
+    std::move(crawl.begin(), crawl.end(), std::back_inserter(roots));
+  }
+
+  std::vector<GameEntry> games = std::move(merged.games);
+  std::sort(games.begin(), games.end(), [](const GameEntry& a, const GameEntry& b) { return a.exe < b.exe; });
+  PathKeySet seen_exes(games.size());
+  PathKeySet seen_folders(games.size());
+  games.erase(std::remove_if(games.begin(), games.end(),
+                             [&](const GameEntry& game) {
+                               seen_folders.Insert(game.folder);
+                               return !seen_exes.Insert(game.exe);
+                             }),
+              games.end());
+  if (!roots.empty()) {
+    // A crawl yields every exe of a game; keep one per game root, and none
+    // for roots a manifest already resolved.
+    for (auto& game : ExeRanker::SelectPrimary(Scanner::ScanAll(roots, options.scan), options.scan.workerCount)) {
+      if (!seen_folders.Contains(game.folder) && seen_exes.Insert(game.exe)) {
+        games.emplace_back(std::move(game));
+      }
+    }
+  }
+  SortGames(games);
+  return games;
+}
+
+DiscoveryPipeline DiscoveryPipeline::Default(const std::vector<std::wstring>& custom_folders) {
+  DiscoveryPipeline pipeline;
+  pipeline.AddProvider(std::make_unique<SteamManifestProvider>(SteamLibrary::LibraryFolders(Scanner::SteamRoot())));
+  pipeline.AddProvider(std::make_unique<EpicManifestProvider>(Scanner::EpicManifestDir()));
+
+  // Store folders are fully described by their manifests above.
+  std::vector<std::wstring> folders;
+  for (auto& folder : Scanner::DefaultFolders()) {
+    const std::wstring source = Scanner::GuessSource(folder);
+    if (source != L"steam" && source != L"epic") {
+      folders.emplace_back(std::move(folder));
+    }
+  }
+  folders.insert(folders.end(), custom_folders.begin(), custom_folders.end());
+  pipeline.AddProvider(std::make_unique<CustomFolderProvider>(std::move(folders)));
+  return pipeline;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game_types.h"
+#include "scanner.h"
+
+namespace optiscaler {
+
+struct ManifestResult {
+  std::vector<GameEntry> games;  // fully resolved by the manifest
+  std::vector<ScanRoot> roots;   // install dirs whose exe still has to be located
+};
+
+// One store's source of games. Manifest files are enumerated on the calling
+// thread and parsed concurrently, so ParseManifest must not touch shared
+// state. Providers without manifests only contribute CrawlRoots().
+class IDiscoveryProvider {
+ public:
+  virtual ~IDiscoveryProvider() = default;
+  virtual const wchar_t* Name() const = 0;
+  virtual void EnumerateManifests(const std::function<void(std::wstring)>& emit) = 0;
+  virtual void ParseManifest(const std::wstring& path, ManifestResult& result) = 0;
+  virtual std::vector<ScanRoot> CrawlRoots() { return {}; }
+};
+
+// Reads <library>\steamapps\appmanifest_*.acf; every app becomes an install
+// root carrying its AppID and store name.
+class SteamManifestProvider : public IDiscoveryProvider {
+ public:
+  explicit SteamManifestProvider(std::vector<std::wstring> libraries);
+  const wchar_t* Name() const override { return L"steam"; }
+  void EnumerateManifests(const std::function<void(std::wstring)>& emit) override;
+  void ParseManifest(const std::wstring& path, ManifestResult& result) override;
+
+ private:
+  std::vector<std::wstring> libraries_;
+};
+
+// Reads Epic Games Launcher *.item JSON manifests, which name the install
+// location and launch executable directly.
+class EpicManifestProvider : public IDiscoveryProvider {
+ public:
+  explicit EpicManifestProvider(std::wstring manifest_dir);
+  const wchar_t* Name() const override { return L"epic"; }
+  void EnumerateManifests(const std::function<void(std::wstring)>& emit) override;
+  void ParseManifest(const std::wstring& path, ManifestResult& result) override;
+
+ private:
+  std::wstring manifest_dir_;
+};
+
+// User-added or well-known folders without manifests; these fall back to a
+// recursive crawl.
+class CustomFolderProvider : public IDiscoveryProvider {
+ public:
+  explicit CustomFolderProvider(std::vector<std::wstring> folders);
+  const wchar_t* Name() const override { return L"custom"; }
+  void EnumerateManifests(const std::function<void(std::wstring)>& /*emit*/) override {}
+  void ParseManifest(const std::wstring& /*path*/, ManifestResult& /*result*/) override {}
+  std::vector<ScanRoot> CrawlRoots() override;
+
+ private:
+  std::vector<std::wstring> folders_;
+};
+
+struct DiscoveryOptions {
+  size_t manifestWorkers = 0;  // 0 = one per hardware thread, capped at 8
+  size_t queueCapacity = 64;   // manifests enumerated but not yet parsed
+  ScanOptions scan;            // used for install-dir and custom-root crawls
+};
+
+// Resolves games from store manifests first; only the roots the manifests
+// cannot resolve are handed to Scanner::ScanAll and narrowed to one exe per
+// game by ExeRanker. Output is de-duplicated by exe path and sorted like
+// ScanAll.
+class DiscoveryPipeline {
+ public:
+  void AddProvider(std::unique_ptr<IDiscoveryProvider> provider);
+  std::vector<GameEntry> Run(const DiscoveryOptions& options) const;
+
+  // Steam libraries, Epic manifests, then the non-store default folders
+  // plus `custom_folders` as crawl roots.
+  static DiscoveryPipeline Default(const std::vector<std::wstring>& custom_folders);
+
+ private:
+  std::vector<std::unique_ptr<IDiscoveryProvider>> providers_;
+};
+
+}  // namespace optiscaler
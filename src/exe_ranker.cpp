@@ -0,0 +1,232 @@
+#include "exe_ranker.h"
+
+#include <algorithm>
+#include <array>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+
+#include "thread_pool.h"
+
+namespace optiscaler {
+
+namespace {
+
+// The DOS stub plus NT headers fit comfortably in the first page; the
+// ranker never reads further into a candidate.
+constexpr size_t kPeProbeBytes = 4096;
+constexpr uint16_t kMachineAmd64 = 0x8664;
+constexpr uint16_t kMachineArm64 = 0xAA64;
+constexpr uint16_t kSubsystemGui = 2;
+constexpr uint16_t kSubsystemConsole = 3;
+constexpr uint16_t kFileDll = 0x2000;
+
+struct NamePenalty {
+  const wchar_t* token;
+  int score;
+};
+
+constexpr NamePenalty kNamePenalties[] = {
+    {L"launcher", -20},  {L"server", -30},   {L"dedicated", -30}, {L"editor", -30},   {L"benchmark", -15},
+    {L"config", -20},    {L"settings", -20}, {L"_be", -25},       {L"_eac", -25},     {L"crash", -40},
+    {L"report", -20},    {L"redist", -40},   {L"installer", -40}, {L"cefprocess", -40}};
+
+uint16_t ReadU16(const unsigned char* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadU32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+std::wstring FoldPath(const std::wstring& value) {
+  std::wstring folded(value);
+  for (auto& ch : folded) {
+    ch = ch == L'/' ? L'\\' : static_cast<wchar_t>(std::towlower(ch));
+  }
+  return folded;
+}
+
+std::wstring AlphaNumeric(const std::wstring& value) {
+  std::wstring result;
+  for (wchar_t ch : value) {
+    if (std::iswalnum(ch)) {
+      result += static_cast<wchar_t>(std::towlower(ch));
+    }
+  }
+  return result;
+}
+
+bool EndsWith(const std::wstring& value, const std::wstring& suffix) {
+  return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int SizeScore(const std::wstring& exe_path) {
+  std::error_code ec;
+  uintmax_t size = std::filesystem::file_size(exe_path, ec);
+  if (ec || size == 0) {
+    return 0;
+  }
+  int bits = 0;
+  while (size >>= 1) {
+    ++bits;
+  }
+  // 1 MiB and below scores nothing; every doubling up to 1 GiB adds 3.
+  return std::clamp(bits - 20, 0, 10) * 3;
+}
+
+}  // namespace
+
+PeHeaderInfo ExeRanker::ReadPeHeader(const std::wstring& exe_path) {
+  PeHeaderInfo info;
+  std::ifstream file(std::filesystem::path(exe_path), std::ios::binary);
+  if (!file) {
+    return info;
+  }
+  std::array<unsigned char, kPeProbeBytes> buffer = {};
+  file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+  const size_t read = static_cast<size_t>(file.gcount());
+  if (read < 0x40 || buffer[0] != 'M' || buffer[1] != 'Z') {
+    return info;
+  }
+  // IMAGE_NT_HEADERS: signature (4), IMAGE_FILE_HEADER (20), then the
+  // optional header whose Subsystem sits at offset 68 for PE32 and PE32+.
+  const size_t nt = ReadU32(buffer.data() + 0x3C);
+  if (nt > read || read - nt < 24 + 70) {
+    return info;
+  }
+  if (buffer[nt] != 'P' || buffer[nt + 1] != 'E' || buffer[nt + 2] != 0 || buffer[nt + 3] != 0) {
+    return info;
+  }
+  info.valid = true;
+  info.machine = ReadU16(buffer.data() + nt + 4);
+  info.isDll = (ReadU16(buffer.data() + nt + 22) & kFileDll) != 0;
+  info.subsystem = ReadU16(buffer.data() + nt + 24 + 68);
+  return info;
+}
+
+int ExeRanker::Score(const GameEntry& candidate) {
+  const std::wstring exe = FoldPath(candidate.exe);
+  const std::wstring folder = FoldPath(candidate.folder);
+  std::wstring relative = exe;
+  if (!folder.empty() && exe.compare(0, folder.size(), folder) == 0) {
+    relative = exe.substr(folder.size());
+  }
+  if (relative.empty() || relative.front() != L'\\') {
+    relative.insert(relative.begin(), L'\\');
+  }
+  const size_t name_start = relative.find_last_of(L'\\') + 1;
+  std::wstring stem = relative.substr(name_start);
+  if (EndsWith(stem, L".exe")) {
+    stem.resize(stem.size() - 4);
+  }
+
+  int score = 0;
+  if (relative.find(L"\\binaries\\win64\\") != std::wstring::npos) {
+    score += 30;
+  } else if (relative.find(L"\\win64\\") != std::wstring::npos || relative.find(L"\\x64\\") != std::wstring::npos) {
+    score += 10;
+  }
+  if (EndsWith(stem, L"-shipping")) {
+    score += 40;
+  }
+
+  const std::wstring stem_key = AlphaNumeric(stem);
+  const std::wstring folder_key = AlphaNumeric(std::filesystem::path(candidate.folder).filename().wstring());
+  if (!stem_key.empty() && !folder_key.empty()) {
+    if (stem_key == folder_key) {
+      score += 25;
+    } else if (stem_key.find(folder_key) != std::wstring::npos || folder_key.find(stem_key) != std::wstring::npos) {
+      score += 10;
+    }
+  }
+  for (const auto& penalty : kNamePenalties) {
+    if (stem.find(penalty.token) != std::wstring::npos) {
+      score += penalty.score;
+    }
+  }
+  score -= 2 * static_cast<int>(std::count(relative.begin(), relative.end(), L'\\') - 1);
+  score += SizeScore(candidate.exe);
+
+  const PeHeaderInfo pe = ReadPeHeader(candidate.exe);
+  if (!pe.valid || pe.isDll) {
+    return score - 100;
+  }
+  if (pe.machine == kMachineAmd64) {
+    score += 15;
+  } else if (pe.machine == kMachineArm64) {
+    score += 10;
+  }
+  if (pe.subsystem == kSubsystemGui) {
+    score += 10;
+  } else if (pe.subsystem == kSubsystemConsole) {
+    score -= 20;
+  }
+  return score;
+}
+
+std::vector<GameEntry> ExeRanker::SelectPrimary(std::vector<GameEntry> candidates, size_t worker_count) {
+  struct Ranked {
+    std::wstring groupKey;
+    int score = 0;
+    size_t index = 0;
+  };
+  // Exes loose in a library root all have the root as their folder but
+  // keep their own stem-derived names, so the name keeps them apart.
+  std::vector<Ranked> ranked(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    ranked[i].groupKey = FoldPath(candidates[i].folder);
+    ranked[i].groupKey += L'\0';
+    ranked[i].groupKey += candidates[i].name;
+    ranked[i].index = i;
+  }
+  std::sort(ranked.begin(), ranked.end(), [&](const Ranked& a, const Ranked& b) {
+    if (a.groupKey != b.groupKey) {
+      return a.groupKey < b.groupKey;
+    }
+    return candidates[a.index].exe < candidates[b.index].exe;
+  });
+
+  // Only groups with competing candidates pay for file I/O; each group is
+  // one pool task so slow disks overlap.
+  {
+    WorkStealingPool pool(worker_count);
+    size_t begin = 0;
+    while (begin < ranked.size()) {
+      size_t end = begin + 1;
+      while (end < ranked.size() && ranked[end].groupKey == ranked[begin].groupKey) {
+        ++end;
+      }
+      if (end - begin > 1) {
+        pool.Submit([&ranked, &candidates, begin, end] {
+          for (size_t i = begin; i < end; ++i) {
+            ranked[i].score = Score(candidates[ranked[i].index]);
+          }
+        });
+      }
+      begin = end;
+    }
+    pool.Wait();
+  }
+
+  std::vector<GameEntry> primaries;
+  size_t begin = 0;
+  while (begin < ranked.size()) {
+    size_t best = begin;
+    size_t end = begin + 1;
+    for (; end < ranked.size() && ranked[end].groupKey == ranked[begin].groupKey; ++end) {
+      const GameEntry& current = candidates[ranked[end].index];
+      const GameEntry& leader = candidates[ranked[best].index];
+      if (ranked[end].score > ranked[best].score ||
+          (ranked[end].score == ranked[best].score && current.exe.size() < leader.exe.size())) {
+        best = end;
+      }
+    }
+    primaries.emplace_back(std::move(candidates[ranked[best].index]));
+    begin = end;
+  }
+  return primaries;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game_types.h"
+
+namespace optiscaler {
+
+struct PeHeaderInfo {
+  bool valid = false;
+  bool isDll = false;
+  uint16_t machine = 0;    // IMAGE_FILE_MACHINE_*
+  uint16_t subsystem = 0;  // IMAGE_SUBSYSTEM_*
+};
+
+// Collapses crawl results to one entry per game. Candidates are grouped by
+// GameEntry::folder (the game root) and name, and scored on path layout,
+// file name, size and a header-only PE read; the best-scoring exe
+// represents the game.
+class ExeRanker {
+ public:
+  static std::vector<GameEntry> SelectPrimary(std::vector<GameEntry> candidates, size_t worker_count = 0);
+  static int Score(const GameEntry& candidate);
+  static PeHeaderInfo ReadPeHeader(const std::wstring& exe_path);
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,323 @@
+#include "game_catalog.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr const wchar_t* kSourceNames[] = {L"custom", L"epic", L"steam", L"xbox"};
+static_assert(std::size(kSourceNames) == static_cast<size_t>(GameSource::kCount), "one name per source");
+
+// The first four code units, saturated to 16 bits each. Saturation keeps
+// the order: a smaller prefix always means a smaller key.
+uint64_t KeyPrefix(std::wstring_view key) {
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    const uint64_t unit = i < key.size() ? std::min<uint64_t>(static_cast<uint64_t>(key[i]), 0xFFFF) : 0;
+    prefix = prefix << 16 | unit;
+  }
+  return prefix;
+}
+
+uint8_t FlagsFor(const GameEntry& game) {
+  uint8_t flags = 0;
+  if (game.injectEnabled) {
+    flags |= kGameInjectEnabled;
+  }
+  if (game.steamAppId) {
+    flags |= kGameHasSteamAppId;
+  }
+  if (game.coverKey != 0) {
+    flags |= kGameHasCover;
+  }
+  return flags;
+}
+
+template <typename T>
+void SetIfChanged(T& field, const T& value, bool& changed) {
+  if (!(field == value)) {
+    field = value;
+    changed = true;
+  }
+}
+
+}  // namespace
+
+GameSource ParseGameSource(std::wstring_view name) {
+  for (size_t i = 0; i < std::size(kSourceNames); ++i) {
+    if (name == kSourceNames[i]) {
+      return static_cast<GameSource>(i);
+    }
+  }
+  return GameSource::kCustom;
+}
+
+const wchar_t* GameSourceName(GameSource source) {
+  const size_t index = static_cast<size_t>(source);
+  return index < std::size(kSourceNames) ? kSourceNames[index] : kSourceNames[0];
+}
+
+CatalogDelta GameCatalog::Sync(const std::vector<GameEntry>& games) {
+  CatalogDelta delta;
+  // 0 = not in `games`, 1 = matched, 2 = matched and reported as changed.
+  std::vector<uint8_t> seen(slots_.size());
+  for (const auto& game : games) {
+    const PathId exe = paths_.Intern(game.exe);
+    const GameId id = ByExe(exe);
+    if (id == kInvalidGameId) {
+      delta.added.push_back(AddRow(exe, game));
+      continue;
+    }
+    // A repeated exe overwrites the earlier entry and is reported once.
+    const bool changed = Assign(slots_[id], game);
+    if (id >= seen.size()) {
+      continue;  // added above
+    }
+    if (changed && seen[id] != 2) {
+      delta.changed.push_back(id);
+      seen[id] = 2;
+    } else if (seen[id] == 0) {
+      seen[id] = 1;
+    }
+  }
+  // Added rows are appended past every existing slot, so walking down from
+  // the old end only ever moves rows that were already checked.
+  for (size_t slot = size(); slot-- > 0;) {
+    const GameId id = ids_[slot];
+    if (id < seen.size() && !seen[id]) {
+      delta.removed.push_back(id);
+      RemoveSlot(static_cast<uint32_t>(slot));
+    }
+  }
+  if (dead_chars_ > live_chars_ || dead_planned_ * 2 > planned_.size()) {
+    Compact();
+  }
+  return delta;
+}
+
+GameId GameCatalog::Add(const GameEntry& game) {
+  const PathId exe = paths_.Intern(game.exe);
+  const GameId id = ByExe(exe);
+  if (id != kInvalidGameId) {
+    Assign(slots_[id], game);
+    return id;
+  }
+  return AddRow(exe, game);
+}
+
+bool GameCatalog::Remove(GameId id) {
+  const uint32_t slot = Slot(id);
+  if (slot == kNoSlot) {
+    return false;
+  }
+  RemoveSlot(slot);
+  return true;
+}
+
+void GameCatalog::Clear() {
+  for (GameId id : ids_) {
+    slots_[id] = kNoSlot;
+  }
+  ForEachColumn(*this, [](auto& column) { column.clear(); });
+  planned_.clear();
+  by_exe_.clear();
+  strings_ = PathArena();
+  paths_ = PathTable();
+  live_chars_ = 0;
+  dead_chars_ = 0;
+  dead_planned_ = 0;
+}
+
+GameEntry GameCatalog::Entry(GameId id) const {
+  const uint32_t slot = Slot(id);
+  GameEntry game;
+  game.name = names_[slot];
+  game.exe = paths_.Resolve(exes_[slot]);
+  game.folder = paths_.Resolve(folders_[slot]);
+  game.source = GameSourceName(sources_[slot]);
+  if (flags_[slot] & kGameHasSteamAppId) {
+    game.steamAppId = app_ids_[slot];
+  }
+  game.installSize = install_sizes_[slot];
+  game.lastPlayed = last_played_[slot];
+  game.sortKey = sort_keys_[slot];
+  game.coverKey = cover_keys_[slot];
+  game.injectEnabled = (flags_[slot] & kGameInjectEnabled) != 0;
+  game.plannedFiles.reserve(planned_count_[slot]);
+  for (uint32_t i = 0; i < planned_count_[slot]; ++i) {
+    game.plannedFiles.push_back(paths_.Resolve(planned_[planned_begin_[slot] + i]));
+  }
+  return game;
+}
+
+std::vector<GameId> GameCatalog::Filter(const GameFilter& filter) const {
+  std::vector<GameId> matches;
+  for (size_t slot = 0; slot < size(); ++slot) {
+    if (filter.Matches(sources_[slot], flags_[slot])) {
+      matches.push_back(ids_[slot]);
+    }
+  }
+  return matches;
+}
+
+// Sorts slots rather than ids so comparisons read the columns directly.
+void GameCatalog::Sort(std::vector<GameId>& ids, GameSortField field, size_t worker_count) const {
+  std::vector<uint32_t> order;
+  order.reserve(ids.size());
+  for (GameId id : ids) {
+    const uint32_t slot = Slot(id);
+    if (slot != kNoSlot) {
+      order.push_back(slot);
+    }
+  }
+  auto less = [this, field](uint32_t a, uint32_t b) { return Less(a, b, field); };
+  if (order.size() < kParallelSortThreshold) {
+    std::sort(order.begin(), order.end(), less);
+  } else {
+    WorkStealingPool pool(worker_count);
+    ParallelSortOrder(order, less, pool);
+  }
+  ids.resize(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    ids[i] = ids_[order[i]];
+  }
+}
+
+size_t GameCatalog::MemoryUsage() const {
+  size_t bytes = 0;
+  ForEachColumn(*this, [&bytes](const auto& column) { bytes += column.capacity() * sizeof(column[0]); });
+  bytes += planned_.capacity() * sizeof(PathId) + slots_.capacity() * sizeof(uint32_t) +
+           by_exe_.capacity() * sizeof(GameId);
+  return bytes + strings_.bytes() + paths_.MemoryUsage();
+}
+
+GameId& GameCatalog::ByExe(PathId exe) {
+  if (exe >= by_exe_.size()) {
+    by_exe_.resize(std::max<size_t>(exe + 1, paths_.size() + 1), kInvalidGameId);
+  }
+  return by_exe_[exe];
+}
+
+GameId GameCatalog::AddRow(PathId exe, const GameEntry& game) {
+  const GameId id = static_cast<GameId>(slots_.size());
+  const uint32_t slot = static_cast<uint32_t>(size());
+  slots_.push_back(slot);
+  ForEachColumn(*this, [](auto& column) { column.emplace_back(); });
+  ids_[slot] = id;
+  exes_[slot] = exe;
+  ByExe(exe) = id;
+  Assign(slot, game);
+  return id;
+}
+
+bool GameCatalog::Assign(uint32_t slot, const GameEntry& game) {
+  bool changed = false;
+  if (names_[slot] != game.name) {
+    const std::wstring key = game.sortKey.empty() ? CollationKey(game.name) : game.sortKey;
+    dead_chars_ += names_[slot].size() + sort_keys_[slot].size();
+    live_chars_ -= names_[slot].size() + sort_keys_[slot].size();
+    names_[slot] = strings_.Store(game.name);
+    sort_keys_[slot] = strings_.Store(key);
+    live_chars_ += names_[slot].size() + sort_keys_[slot].size();
+    key_prefixes_[slot] = KeyPrefix(sort_keys_[slot]);
+    changed = true;
+  }
+  SetIfChanged(sources_[slot], ParseGameSource(game.source), changed);
+  SetIfChanged(flags_[slot], FlagsFor(game), changed);
+  SetIfChanged(app_ids_[slot], game.steamAppId.value_or(0), changed);
+  SetIfChanged(cover_keys_[slot], game.coverKey, changed);
+  SetIfChanged(last_played_[slot], game.lastPlayed, changed);
+  SetIfChanged(install_sizes_[slot], game.installSize, changed);
+  SetIfChanged(folders_[slot], paths_.Intern(game.folder), changed);
+
+  std::vector<PathId> planned;
+  planned.reserve(game.plannedFiles.size());
+  for (const auto& file : game.plannedFiles) {
+    planned.push_back(paths_.Intern(file));
+  }
+  const auto current = planned_.begin() + planned_begin_[slot];
+  if (planned.size() != planned_count_[slot] || !std::equal(planned.begin(), planned.end(), current)) {
+    dead_planned_ += planned_count_[slot];
+    planned_begin_[slot] = static_cast<uint32_t>(planned_.size());
+    planned_count_[slot] = static_cast<uint32_t>(planned.size());
+    planned_.insert(planned_.end(), planned.begin(), planned.end());
+    changed = true;
+  }
+  return changed;
+}
+
+void GameCatalog::RemoveSlot(uint32_t slot) {
+  const GameId id = ids_[slot];
+  const size_t chars = names_[slot].size() + sort_keys_[slot].size();
+  dead_chars_ += chars;
+  live_chars_ -= chars;
+  dead_planned_ += planned_count_[slot];
+  by_exe_[exes_[slot]] = kInvalidGameId;
+  slots_[id] = kNoSlot;
+  const uint32_t last = static_cast<uint32_t>(size() - 1);
+  ForEachColumn(*this, [slot, last](auto& column) {
+    if (slot != last) {
+      column[slot] = column[last];
+    }
+    column.pop_back();
+  });
+  if (slot != last) {
+    slots_[ids_[slot]] = slot;
+  }
+}
+
+bool GameCatalog::Less(uint32_t a, uint32_t b, GameSortField field) const {
+  switch (field) {
+    case GameSortField::kSource:
+      if (sources_[a] != sources_[b]) {
+        return sources_[a] < sources_[b];
+      }
+      break;
+    case GameSortField::kLastPlayed:
+      if (last_played_[a] != last_played_[b]) {
+        return last_played_[a] > last_played_[b];
+      }
+      break;
+    case GameSortField::kSize:
+      if (install_sizes_[a] != install_sizes_[b]) {
+        return install_sizes_[a] > install_sizes_[b];
+      }
+      break;
+    case GameSortField::kName:
+      break;
+  }
+  if (key_prefixes_[a] != key_prefixes_[b]) {
+    return key_prefixes_[a] < key_prefixes_[b];
+  }
+  const int order = sort_keys_[a].compare(sort_keys_[b]);
+  return order != 0 ? order < 0 : ids_[a] < ids_[b];
+}
+
+void GameCatalog::Compact() {
+  PathArena strings;
+  PathTable paths;
+  std::vector<PathId> planned;
+  planned.reserve(planned_.size() - dead_planned_);
+  by_exe_.clear();
+  for (size_t slot = 0; slot < size(); ++slot) {
+    names_[slot] = strings.Store(names_[slot]);
+    sort_keys_[slot] = strings.Store(sort_keys_[slot]);
+    exes_[slot] = paths.Intern(paths_.Resolve(exes_[slot]));
+    folders_[slot] = paths.Intern(paths_.Resolve(folders_[slot]));
+    const uint32_t begin = static_cast<uint32_t>(planned.size());
+    for (uint32_t i = 0; i < planned_count_[slot]; ++i) {
+      planned.push_back(paths.Intern(paths_.Resolve(planned_[planned_begin_[slot] + i])));
+    }
+    planned_begin_[slot] = begin;
+    ByExe(exes_[slot]) = ids_[slot];
+  }
+  strings_ = std::move(strings);
+  paths_ = std::move(paths);
+  planned_ = std::move(planned);
+  dead_chars_ = 0;
+  dead_planned_ = 0;
+}
+
+}  // namespace optiscaler
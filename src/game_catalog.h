@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "game_sort.h"
+#include "game_types.h"
+#include "path_key.h"
+
+namespace optiscaler {
+
+// Stable for the catalog's lifetime: a game keeps its id across rescans as
+// long as its exe path does, and ids of removed games are never reused.
+using GameId = uint32_t;
+constexpr GameId kInvalidGameId = 0;
+
+// Alphabetical by store name, so sorting by source matches the order the
+// GameEntry strings gave.
+enum class GameSource : uint8_t {
+  kCustom,
+  kEpic,
+  kSteam,
+  kXbox,
+  kCount,
+};
+
+// Unknown names map to kCustom.
+GameSource ParseGameSource(std::wstring_view name);
+const wchar_t* GameSourceName(GameSource source);
+
+enum GameFlags : uint8_t {
+  kGameInjectEnabled = 1 << 0,
+  kGameHasSteamAppId = 1 << 1,
+  kGameHasCover = 1 << 2,
+};
+
+// Matches games whose source bit is set in `sources` (bit = 1 << source)
+// and whose flags contain all of `required` and none of `excluded`.
+struct GameFilter {
+  uint8_t sources = 0xFF;
+  uint8_t required = 0;
+  uint8_t excluded = 0;
+
+  bool Matches(GameSource source, uint8_t flags) const {
+    return (sources >> static_cast<unsigned>(source) & 1) != 0 && (flags & required) == required &&
+           (flags & excluded) == 0;
+  }
+};
+
+struct CatalogDelta {
+  std::vector<GameId> added;
+  std::vector<GameId> removed;
+  std::vector<GameId> changed;
+};
+
+// The game list as parallel columns. Filtering and sorting only read the
+// small hot columns (source, flags, app id, cover key, name key prefix);
+// names and sort keys live in one string arena, and exe, folder and
+// planned-file paths are PathTable ids, so games in one library folder
+// share its prefix. Rows are packed: removing a game moves the last row
+// into its slot, and ids map to slots. Not thread-safe.
+class GameCatalog {
+ public:
+  GameCatalog() = default;
+
+  GameCatalog(const GameCatalog&) = delete;
+  GameCatalog& operator=(const GameCatalog&) = delete;
+
+  // Makes the catalog hold exactly `games`, matched to existing rows by exe
+  // path. Matched games keep their ids and are reported as changed when a
+  // field differs.
+  CatalogDelta Sync(const std::vector<GameEntry>& games);
+  GameId Add(const GameEntry& game);
+  bool Remove(GameId id);
+  void Clear();
+
+  size_t size() const { return ids_.size(); }
+  bool empty() const { return ids_.empty(); }
+  bool Contains(GameId id) const { return Slot(id) != kNoSlot; }
+  const std::vector<GameId>& ids() const { return ids_; }  // slot order
+
+  // Accessors take a contained id.
+  std::wstring_view Name(GameId id) const { return names_[Slot(id)]; }
+  GameSource Source(GameId id) const { return sources_[Slot(id)]; }
+  uint8_t Flags(GameId id) const { return flags_[Slot(id)]; }
+  uint64_t CoverKey(GameId id) const { return cover_keys_[Slot(id)]; }
+  std::wstring Exe(GameId id) const { return paths_.Resolve(exes_[Slot(id)]); }
+  std::wstring Folder(GameId id) const { return paths_.Resolve(folders_[Slot(id)]); }
+  PathId ExePath(GameId id) const { return exes_[Slot(id)]; }  // in paths()
+  PathId FolderPath(GameId id) const { return folders_[Slot(id)]; }
+  GameEntry Entry(GameId id) const;
+
+  std::vector<GameId> Filter(const GameFilter& filter) const;
+  // Orders `ids` like SortGames orders entries, with the id as the final
+  // tie-breaker.
+  void Sort(std::vector<GameId>& ids, GameSortField field = GameSortField::kName, size_t worker_count = 0) const;
+
+  const PathTable& paths() const { return paths_; }
+  // Bytes held by columns, strings and the path table.
+  size_t MemoryUsage() const;
+
+ private:
+  static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+  uint32_t Slot(GameId id) const { return id < slots_.size() ? slots_[id] : kNoSlot; }
+  GameId& ByExe(PathId exe);
+  GameId AddRow(PathId exe, const GameEntry& game);
+  bool Assign(uint32_t slot, const GameEntry& game);  // true if anything changed
+  void RemoveSlot(uint32_t slot);
+  bool Less(uint32_t a, uint32_t b, GameSortField field) const;
+  // Rebuilds strings, paths and planned files without the dead parts.
+  void Compact();
+
+  // Calls fn(column) for every per-row vector; `self` may be const.
+  template <typename Self, typename Fn>
+  static void ForEachColumn(Self& self, Fn&& fn) {
+    fn(self.ids_);
+    fn(self.key_prefixes_);
+    fn(self.sources_);
+    fn(self.flags_);
+    fn(self.app_ids_);
+    fn(self.cover_keys_);
+    fn(self.last_played_);
+    fn(self.install_sizes_);
+    fn(self.names_);
+    fn(self.sort_keys_);
+    fn(self.exes_);
+    fn(self.folders_);
+    fn(self.planned_begin_);
+    fn(self.planned_count_);
+  }
+
+  // Hot columns.
+  std::vector<GameId> ids_;
+  std::vector<uint64_t> key_prefixes_;  // first code units of the sort key
+  std::vector<GameSource> sources_;
+  std::vector<uint8_t> flags_;
+  std::vector<uint32_t> app_ids_;
+  std::vector<uint64_t> cover_keys_;
+  std::vector<int64_t> last_played_;
+  std::vector<uint64_t> install_sizes_;
+  // Cold columns.
+  std::vector<std::wstring_view> names_;
+  std::vector<std::wstring_view> sort_keys_;
+  std::vector<PathId> exes_;
+  std::vector<PathId> folders_;
+  std::vector<uint32_t> planned_begin_;  // into planned_
+  std::vector<uint32_t> planned_count_;
+
+  std::vector<PathId> planned_;
+  std::vector<uint32_t> slots_{kNoSlot};  // by id; id 0 is kInvalidGameId
+  std::vector<GameId> by_exe_;  // by exe PathId
+  PathArena strings_;
+  PathTable paths_;
+  size_t live_chars_ = 0;  // in strings_
+  size_t dead_chars_ = 0;  // from removed rows and replaced names
+  size_t dead_planned_ = 0;
+};
+
+}  // namespace optiscaler
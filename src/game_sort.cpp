@@ -0,0 +1,111 @@
+#include "game_sort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cwctype>
+#include <numeric>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr size_t kKeyChunk = 2048;
+
+bool IsDigit(wchar_t ch) {
+  return ch >= L'0' && ch <= L'9';
+}
+
+int CompareKeys(const GameEntry& a, const GameEntry& b) {
+  const int order = a.sortKey.compare(b.sortKey);
+  return order != 0 ? order : a.exe.compare(b.exe);
+}
+
+bool Less(const GameEntry& a, const GameEntry& b, GameSortField field) {
+  switch (field) {
+    case GameSortField::kSource:
+      if (a.source != b.source) {
+        return a.source < b.source;
+      }
+      break;
+    case GameSortField::kLastPlayed:
+      if (a.lastPlayed != b.lastPlayed) {
+        return a.lastPlayed > b.lastPlayed;
+      }
+      break;
+    case GameSortField::kSize:
+      if (a.installSize != b.installSize) {
+        return a.installSize > b.installSize;
+      }
+      break;
+    case GameSortField::kName:
+      break;
+  }
+  return CompareKeys(a, b) < 0;
+}
+
+void FillKeys(std::vector<GameEntry>& games, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    if (games[i].sortKey.empty()) {
+      games[i].sortKey = CollationKey(games[i].name);
+    }
+  }
+}
+
+}  // namespace
+
+std::wstring CollationKey(std::wstring_view text) {
+  std::wstring key;
+  key.reserve(text.size() + 4);
+  size_t i = 0;
+  while (i < text.size()) {
+    if (!IsDigit(text[i])) {
+      key.push_back(static_cast<wchar_t>(std::towlower(text[i])));
+      ++i;
+      continue;
+    }
+    // A digit run becomes '0', its significant length, then its digits, so
+    // shorter numbers order first and equal lengths compare digit-wise.
+    size_t end = i;
+    while (end < text.size() && IsDigit(text[end])) {
+      ++end;
+    }
+    size_t first = i;
+    while (first + 1 < end && text[first] == L'0') {
+      ++first;
+    }
+    key.push_back(L'0');
+    key.push_back(static_cast<wchar_t>(std::min<size_t>(end - first, 0xFFFF)));
+    key.append(text.substr(first, end - first));
+    i = end;
+  }
+  return key;
+}
+
+void SortGames(std::vector<GameEntry>& games, GameSortField field, size_t worker_count) {
+  if (games.size() < kParallelSortThreshold) {
+    FillKeys(games, 0, games.size());
+    std::sort(games.begin(), games.end(),
+              [field](const GameEntry& a, const GameEntry& b) { return Less(a, b, field); });
+    return;
+  }
+
+  // Large lists sort a permutation so workers never move whole entries.
+  WorkStealingPool pool(worker_count);
+  for (size_t begin = 0; begin < games.size(); begin += kKeyChunk) {
+    const size_t end = std::min(begin + kKeyChunk, games.size());
+    pool.Submit([&games, begin, end] { FillKeys(games, begin, end); });
+  }
+  pool.Wait();
+  std::vector<uint32_t> order(games.size());
+  std::iota(order.begin(), order.end(), 0u);
+  ParallelSortOrder(order, [&](uint32_t a, uint32_t b) { return Less(games[a], games[b], field); }, pool);
+
+  std::vector<GameEntry> sorted;
+  sorted.reserve(games.size());
+  for (uint32_t index : order) {
+    sorted.emplace_back(std::move(games[index]));
+  }
+  games = std::move(sorted);
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "game_types.h"
+#include "thread_pool.h"
+
+namespace optiscaler {
+
+enum class GameSortField {
+  kName,
+  kSource,      // grouped by store, then by name
+  kLastPlayed,  // most recent first
+  kSize,        // largest first
+};
+
+// Case-folded key in which digit runs compare by numeric value, so
+// "Part 2" sorts before "Part 10". Plain wstring comparison of two keys
+// gives the collation order.
+std::wstring CollationKey(std::wstring_view text);
+
+// Fills missing GameEntry::sortKey values, then orders by `field` with the
+// name key and exe path as tie-breakers. Large lists are sorted in chunks
+// on a worker pool and merged.
+void SortGames(std::vector<GameEntry>& games, GameSortField field = GameSortField::kName, size_t worker_count = 0);
+
+// Below this a single-threaded sort beats spinning up workers.
+constexpr size_t kParallelSortThreshold = 8192;
+
+// Sorts a permutation by `less(a, b)`. Chunks are sorted independently,
+// then merged pairwise; every round is one batch of pool tasks.
+template <typename Compare>
+void ParallelSortOrder(std::vector<uint32_t>& order, const Compare& less, WorkStealingPool& pool) {
+  const size_t chunks = std::max<size_t>(pool.WorkerCount(), 2);
+  std::vector<size_t> bounds(chunks + 1);
+  for (size_t i = 0; i <= chunks; ++i) {
+    bounds[i] = order.size() * i / chunks;
+  }
+  for (size_t i = 0; i < chunks; ++i) {
+    pool.Submit([&, i] { std::sort(order.begin() + bounds[i], order.begin() + bounds[i + 1], less); });
+  }
+  pool.Wait();
+  for (size_t width = 1; width < chunks; width *= 2) {
+    for (size_t i = 0; i + width < chunks; i += 2 * width) {
+      const size_t begin = bounds[i];
+      const size_t middle = bounds[i + width];
+      const size_t end = bounds[std::min(i + 2 * width, chunks)];
+      pool.Submit([&, begin, middle, end] {
+        std::inplace_merge(order.begin() + begin, order.begin() + middle, order.begin() + end, less);
+      });
+    }
+    pool.Wait();
+  }
+}
+
+}  // namespace optiscaler
@@ -1,11 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
 
-#include <windows.h>
-
 namespace optiscaler {
 
 struct GameEntry {
@@ -14,7 +13,10 @@ struct GameEntry {
   std::wstring folder;
   std::wstring source;
   std::optional<uint32_t> steamAppId;
-  HBITMAP coverBmp = nullptr;
+  uint64_t installSize = 0;  // bytes, 0 = unknown
+  int64_t lastPlayed = 0;    // Unix seconds, 0 = never or unknown
+  std::wstring sortKey;      // cached CollationKey(name); clear when name changes
+  uint64_t coverKey = 0;     // HashPath(exe): DecodedCoverCache key and cover file name, 0 = none
   bool injectEnabled = false;
   std::vector<std::wstring> plannedFiles;
 };
@@ -0,0 +1,82 @@
+#include "gdi_glyph_rasterizer.h"
+
+#include <vector>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr MAT2 kIdentity = {{0, 1}, {0, 0}, {0, 0}, {0, 1}};
+constexpr int kGray8Levels = 64;  // GGO_GRAY8_BITMAP coverage runs 0..64
+
+}  // namespace
+
+GdiGlyphRasterizer::GdiGlyphRasterizer(const wchar_t* face, int pixel_height) {
+  dc_ = CreateCompatibleDC(nullptr);
+  if (!dc_) {
+    return;
+  }
+  font_ = CreateFontW(-pixel_height, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+                      CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, face);
+  if (!font_) {
+    return;
+  }
+  old_font_ = SelectObject(dc_, font_);
+  TEXTMETRICW metrics = {};
+  GetTextMetricsW(dc_, &metrics);
+  metrics_.ascent = metrics.tmAscent;
+  metrics_.lineHeight = metrics.tmHeight + metrics.tmExternalLeading;
+}
+
+GdiGlyphRasterizer::~GdiGlyphRasterizer() {
+  if (dc_) {
+    if (old_font_) {
+      SelectObject(dc_, old_font_);
+    }
+    DeleteDC(dc_);
+  }
+  if (font_) {
+    DeleteObject(font_);
+  }
+}
+
+bool GdiGlyphRasterizer::Rasterize(char32_t code, GlyphBitmap& glyph_out) {
+  if (!font_ || code > 0xFFFF) {
+    return false;
+  }
+  const wchar_t ch = static_cast<wchar_t>(code);
+  WORD index = 0;
+  if (GetGlyphIndicesW(dc_, &ch, 1, &index, GGI_MARK_NONEXISTING_GLYPHS) == GDI_ERROR || index == 0xFFFF) {
+    return false;
+  }
+  GLYPHMETRICS gm = {};
+  const DWORD size = GetGlyphOutlineW(dc_, ch, GGO_GRAY8_BITMAP, &gm, 0, nullptr, &kIdentity);
+  if (size == GDI_ERROR) {
+    return false;
+  }
+  glyph_out = GlyphBitmap{};
+  glyph_out.advance = gm.gmCellIncX;
+  if (size == 0) {
+    return true;  // whitespace
+  }
+  std::vector<uint8_t> buffer(size);
+  if (GetGlyphOutlineW(dc_, ch, GGO_GRAY8_BITMAP, &gm, size, buffer.data(), &kIdentity) == GDI_ERROR) {
+    return false;
+  }
+  glyph_out.width = static_cast<int>(gm.gmBlackBoxX);
+  glyph_out.height = static_cast<int>(gm.gmBlackBoxY);
+  glyph_out.offsetX = gm.gmptGlyphOrigin.x;
+  glyph_out.offsetY = metrics_.ascent - gm.gmptGlyphOrigin.y;
+  const size_t pitch = (gm.gmBlackBoxX + 3) & ~3u;  // rows are DWORD aligned
+  glyph_out.coverage.resize(static_cast<size_t>(glyph_out.width) * glyph_out.height);
+  for (int y = 0; y < glyph_out.height; ++y) {
+    for (int x = 0; x < glyph_out.width; ++x) {
+      const uint8_t level = buffer[y * pitch + x];
+      glyph_out.coverage[static_cast<size_t>(y) * glyph_out.width + x] =
+          static_cast<uint8_t>((level * 255 + kGray8Levels / 2) / kGray8Levels);
+    }
+  }
+  return true;
+}
+
+}  // namespace optiscaler
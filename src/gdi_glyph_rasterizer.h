@@ -0,0 +1,30 @@
+#pragma once
+
+#include <windows.h>
+
+#include "glyph_atlas.h"
+
+namespace optiscaler {
+
+// Antialiased glyphs from a GDI font via GetGlyphOutlineW, for GlyphAtlas.
+// Basic Multilingual Plane only.
+class GdiGlyphRasterizer : public IGlyphRasterizer {
+ public:
+  GdiGlyphRasterizer(const wchar_t* face, int pixel_height);
+  ~GdiGlyphRasterizer() override;
+
+  GdiGlyphRasterizer(const GdiGlyphRasterizer&) = delete;
+  GdiGlyphRasterizer& operator=(const GdiGlyphRasterizer&) = delete;
+
+  bool valid() const { return font_ != nullptr; }
+  FontMetrics Metrics() const override { return metrics_; }
+  bool Rasterize(char32_t code, GlyphBitmap& glyph_out) override;
+
+ private:
+  HDC dc_ = nullptr;
+  HFONT font_ = nullptr;
+  HGDIOBJ old_font_ = nullptr;
+  FontMetrics metrics_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,239 @@
+#include "glyph_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr int kCellWidth = 7;  // advance; rows are 8 bits, MSB = left column
+constexpr int kCellHeight = 13;
+constexpr int kCellAscent = 10;
+constexpr int kCellLineHeight = 15;
+constexpr char32_t kFirstCode = 0x20;
+constexpr char32_t kLastAsciiCode = 0x7E;
+constexpr char32_t kEllipsis = 0x2026;
+constexpr int kPadding = 1;  // between atlas glyphs, so neighbours never bleed
+
+// DejaVu Sans Mono at 12 px, thresholded to 1 bit. Entries run from U+0020
+// to U+007E, then U+2026.
+constexpr uint8_t kCells[][kCellHeight] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+  {0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00},  // '!'
+  {0x00, 0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '"'
+  {0x00, 0x00, 0x14, 0x24, 0x7E, 0x28, 0x28, 0xFC, 0x48, 0x50, 0x00, 0x00, 0x00},  // '#'
+  {0x00, 0x10, 0x38, 0x54, 0x50, 0x70, 0x1C, 0x14, 0x54, 0x38, 0x10, 0x10, 0x00},  // '$'
+  {0x00, 0x60, 0x90, 0x90, 0x64, 0x18, 0x6C, 0x12, 0x12, 0x0C, 0x00, 0x00, 0x00},  // '%'
+  {0x00, 0x1C, 0x20, 0x20, 0x30, 0x30, 0x4A, 0x4E, 0x64, 0x3A, 0x00, 0x00, 0x00},  // '&'
+  {0x00, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '''
+  {0x0C, 0x08, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x08, 0x08, 0x0C, 0x00, 0x00},  // '('
+  {0x30, 0x10, 0x10, 0x08, 0x08, 0x08, 0x08, 0x08, 0x10, 0x10, 0x30, 0x00, 0x00},  // ')'
+  {0x00, 0x10, 0x54, 0x38, 0x38, 0x54, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '*'
+  {0x00, 0x00, 0x00, 0x10, 0x10, 0x10, 0xFE, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00},  // '+'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x20, 0x00, 0x00},  // ','
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '-'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00},  // '.'
+  {0x00, 0x02, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x20, 0x40, 0x00, 0x00},  // '/'
+  {0x00, 0x3C, 0x24, 0x42, 0x42, 0x4A, 0x42, 0x42, 0x24, 0x3C, 0x00, 0x00, 0x00},  // '0'
+  {0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7C, 0x00, 0x00, 0x00},  // '1'
+  {0x00, 0x3C, 0x42, 0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x7E, 0x00, 0x00, 0x00},  // '2'
+  {0x00, 0x3C, 0x42, 0x02, 0x02, 0x1C, 0x02, 0x02, 0x42, 0x3C, 0x00, 0x00, 0x00},  // '3'
+  {0x00, 0x0C, 0x0C, 0x14, 0x34, 0x24, 0x44, 0x7E, 0x04, 0x04, 0x00, 0x00, 0x00},  // '4'
+  {0x00, 0x7C, 0x40, 0x40, 0x7C, 0x06, 0x02, 0x02, 0x46, 0x3C, 0x00, 0x00, 0x00},  // '5'
+  {0x00, 0x1C, 0x22, 0x40, 0x5C, 0x66, 0x42, 0x42, 0x26, 0x3C, 0x00, 0x00, 0x00},  // '6'
+  {0x00, 0x7E, 0x06, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00, 0x00},  // '7'
+  {0x00, 0x3C, 0x42, 0x42, 0x42, 0x3C, 0x42, 0x42, 0x42, 0x3C, 0x00, 0x00, 0x00},  // '8'
+  {0x00, 0x3C, 0x64, 0x42, 0x42, 0x46, 0x3A, 0x02, 0x44, 0x38, 0x00, 0x00, 0x00},  // '9'
+  {0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00},  // ':'
+  {0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x00, 0x10, 0x10, 0x20, 0x00, 0x00},  // ';'
+  {0x00, 0x00, 0x00, 0x02, 0x1C, 0x60, 0x60, 0x1C, 0x02, 0x00, 0x00, 0x00, 0x00},  // '<'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00},  // '='
+  {0x00, 0x00, 0x00, 0x40, 0x38, 0x06, 0x06, 0x38, 0x40, 0x00, 0x00, 0x00, 0x00},  // '>'
+  {0x00, 0x1C, 0x22, 0x02, 0x0C, 0x18, 0x10, 0x00, 0x10, 0x10, 0x00, 0x00, 0x00},  // '?'
+  {0x00, 0x00, 0x1C, 0x26, 0x42, 0x4E, 0x52, 0x52, 0x4E, 0x60, 0x20, 0x1C, 0x00},  // '@'
+  {0x00, 0x18, 0x18, 0x18, 0x24, 0x24, 0x24, 0x3C, 0x42, 0x42, 0x00, 0x00, 0x00},  // 'A'
+  {0x00, 0x7C, 0x42, 0x42, 0x42, 0x7C, 0x42, 0x42, 0x42, 0x7C, 0x00, 0x00, 0x00},  // 'B'
+  {0x00, 0x1C, 0x22, 0x40, 0x40, 0x40, 0x40, 0x40, 0x22, 0x1C, 0x00, 0x00, 0x00},  // 'C'
+  {0x00, 0x78, 0x44, 0x42, 0x42, 0x42, 0x42, 0x42, 0x44, 0x78, 0x00, 0x00, 0x00},  // 'D'
+  {0x00, 0x7E, 0x40, 0x40, 0x40, 0x7E, 0x40, 0x40, 0x40, 0x7E, 0x00, 0x00, 0x00},  // 'E'
+  {0x00, 0x7E, 0x40, 0x40, 0x40, 0x7E, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00},  // 'F'
+  {0x00, 0x1C, 0x22, 0x40, 0x40, 0x46, 0x42, 0x42, 0x22, 0x1C, 0x00, 0x00, 0x00},  // 'G'
+  {0x00, 0x42, 0x42, 0x42, 0x42, 0x7E, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00},  // 'H'
+  {0x00, 0x7C, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7C, 0x00, 0x00, 0x00},  // 'I'
+  {0x00, 0x1C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00},  // 'J'
+  {0x00, 0x42, 0x44, 0x48, 0x50, 0x70, 0x48, 0x4C, 0x44, 0x42, 0x00, 0x00, 0x00},  // 'K'
+  {0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7E, 0x00, 0x00, 0x00},  // 'L'
+  {0x00, 0x42, 0x66, 0x66, 0x5A, 0x5A, 0x5A, 0x42, 0x42, 0x42, 0x00, 0x00, 0x00},  // 'M'
+  {0x00, 0x62, 0x62, 0x52, 0x52, 0x5A, 0x4A, 0x4A, 0x46, 0x46, 0x00, 0x00, 0x00},  // 'N'
+  {0x00, 0x3C, 0x24, 0x42, 0x42, 0x42, 0x42, 0x42, 0x24, 0x3C, 0x00, 0x00, 0x00},  // 'O'
+  {0x00, 0x7C, 0x42, 0x42, 0x42, 0x7C, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00},  // 'P'
+  {0x00, 0x3C, 0x24, 0x42, 0x42, 0x42, 0x42, 0x42, 0x26, 0x3C, 0x04, 0x04, 0x00},  // 'Q'
+  {0x00, 0x7C, 0x42, 0x42, 0x42, 0x7C, 0x44, 0x42, 0x42, 0x41, 0x00, 0x00, 0x00},  // 'R'
+  {0x00, 0x3C, 0x42, 0x40, 0x60, 0x3C, 0x02, 0x02, 0x42, 0x3C, 0x00, 0x00, 0x00},  // 'S'
+  {0x00, 0xFE, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00},  // 'T'
+  {0x00, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3C, 0x00, 0x00, 0x00},  // 'U'
+  {0x00, 0x42, 0x42, 0x24, 0x24, 0x24, 0x24, 0x18, 0x18, 0x18, 0x00, 0x00, 0x00},  // 'V'
+  {0x00, 0x82, 0x92, 0x92, 0xAA, 0xAA, 0xAA, 0x6C, 0x44, 0x44, 0x00, 0x00, 0x00},  // 'W'
+  {0x00, 0x42, 0x24, 0x24, 0x18, 0x18, 0x18, 0x24, 0x24, 0x42, 0x00, 0x00, 0x00},  // 'X'
+  {0x00, 0x82, 0x44, 0x28, 0x28, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00},  // 'Y'
+  {0x00, 0x7E, 0x06, 0x04, 0x08, 0x18, 0x10, 0x20, 0x60, 0x7E, 0x00, 0x00, 0x00},  // 'Z'
+  {0x18, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x18, 0x00, 0x00},  // '['
+  {0x00, 0x40, 0x20, 0x20, 0x10, 0x10, 0x08, 0x08, 0x04, 0x04, 0x02, 0x00, 0x00},  // U+005C
+  {0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x00, 0x00},  // ']'
+  {0x00, 0x30, 0x48, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '^'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE},  // '_'
+  {0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '`'
+  {0x00, 0x00, 0x00, 0x38, 0x44, 0x04, 0x3C, 0x44, 0x44, 0x3C, 0x00, 0x00, 0x00},  // 'a'
+  {0x40, 0x40, 0x40, 0x78, 0x44, 0x44, 0x44, 0x44, 0x44, 0x78, 0x00, 0x00, 0x00},  // 'b'
+  {0x00, 0x00, 0x00, 0x38, 0x64, 0x40, 0x40, 0x40, 0x60, 0x3C, 0x00, 0x00, 0x00},  // 'c'
+  {0x04, 0x04, 0x04, 0x3C, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3C, 0x00, 0x00, 0x00},  // 'd'
+  {0x00, 0x00, 0x00, 0x38, 0x64, 0x44, 0x7C, 0x40, 0x44, 0x38, 0x00, 0x00, 0x00},  // 'e'
+  {0x0C, 0x10, 0x10, 0x7C, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00, 0x00},  // 'f'
+  {0x00, 0x00, 0x00, 0x3C, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3C, 0x04, 0x24, 0x18},  // 'g'
+  {0x40, 0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x44, 0x44, 0x44, 0x00, 0x00, 0x00},  // 'h'
+  {0x10, 0x00, 0x00, 0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7C, 0x00, 0x00, 0x00},  // 'i'
+  {0x08, 0x00, 0x00, 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x30},  // 'j'
+  {0x40, 0x40, 0x40, 0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x00, 0x00, 0x00},  // 'k'
+  {0x70, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x0C, 0x00, 0x00, 0x00},  // 'l'
+  {0x00, 0x00, 0x00, 0x7C, 0x54, 0x54, 0x54, 0x54, 0x54, 0x54, 0x00, 0x00, 0x00},  // 'm'
+  {0x00, 0x00, 0x00, 0x58, 0x64, 0x44, 0x44, 0x44, 0x44, 0x44, 0x00, 0x00, 0x00},  // 'n'
+  {0x00, 0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00, 0x00, 0x00},  // 'o'
+  {0x00, 0x00, 0x00, 0x78, 0x44, 0x44, 0x44, 0x44, 0x44, 0x78, 0x40, 0x40, 0x40},  // 'p'
+  {0x00, 0x00, 0x00, 0x3C, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3C, 0x04, 0x04, 0x04},  // 'q'
+  {0x00, 0x00, 0x00, 0x3C, 0x32, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00},  // 'r'
+  {0x00, 0x00, 0x00, 0x38, 0x44, 0x40, 0x38, 0x04, 0x44, 0x38, 0x00, 0x00, 0x00},  // 's'
+  {0x00, 0x10, 0x10, 0x7C, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1C, 0x00, 0x00, 0x00},  // 't'
+  {0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3C, 0x00, 0x00, 0x00},  // 'u'
+  {0x00, 0x00, 0x00, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x10, 0x00, 0x00, 0x00},  // 'v'
+  {0x00, 0x00, 0x00, 0x82, 0x82, 0x54, 0x54, 0x6C, 0x28, 0x28, 0x00, 0x00, 0x00},  // 'w'
+  {0x00, 0x00, 0x00, 0x44, 0x28, 0x28, 0x10, 0x28, 0x28, 0x44, 0x00, 0x00, 0x00},  // 'x'
+  {0x00, 0x00, 0x00, 0x44, 0x44, 0x28, 0x28, 0x28, 0x30, 0x10, 0x10, 0x20, 0x60},  // 'y'
+  {0x00, 0x00, 0x00, 0x7C, 0x04, 0x08, 0x10, 0x20, 0x40, 0x7C, 0x00, 0x00, 0x00},  // 'z'
+  {0x1C, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x1C, 0x00, 0x00},  // '{'
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00},  // '|'
+  {0x70, 0x10, 0x10, 0x10, 0x10, 0x0C, 0x10, 0x10, 0x10, 0x10, 0x70, 0x00, 0x00},  // '}'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x0E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '~'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA8, 0xA8, 0x00, 0x00, 0x00},  // U+2026
+};
+
+}  // namespace
+
+BitmapFont::BitmapFont(int scale) : scale_(std::max(1, scale)) {}
+
+FontMetrics BitmapFont::Metrics() const {
+  return {kCellAscent * scale_, kCellLineHeight * scale_};
+}
+
+bool BitmapFont::Rasterize(char32_t code, GlyphBitmap& glyph_out) {
+  size_t cell = 0;
+  if (code >= kFirstCode && code <= kLastAsciiCode) {
+    cell = code - kFirstCode;
+  } else if (code == kEllipsis) {
+    cell = kLastAsciiCode - kFirstCode + 1;
+  } else {
+    return false;
+  }
+  glyph_out.width = 8 * scale_;
+  glyph_out.height = kCellHeight * scale_;
+  glyph_out.offsetX = 0;
+  glyph_out.offsetY = 0;
+  glyph_out.advance = kCellWidth * scale_;
+  glyph_out.coverage.assign(static_cast<size_t>(glyph_out.width) * glyph_out.height, 0);
+  for (int y = 0; y < glyph_out.height; ++y) {
+    const uint8_t bits = kCells[cell][y / scale_];
+    for (int x = 0; x < glyph_out.width; ++x) {
+      if (bits & (0x80 >> (x / scale_))) {
+        glyph_out.coverage[static_cast<size_t>(y) * glyph_out.width + x] = 255;
+      }
+    }
+  }
+  return true;
+}
+
+GlyphAtlas::GlyphAtlas(int width, int height)
+    : width_(std::clamp(width, 1, 0xFFFF)),
+      height_(std::clamp(height, 1, 0xFFFF)),
+      pixels_(static_cast<size_t>(width_) * height_, 0) {}
+
+FontId GlyphAtlas::AddFont(std::unique_ptr<IGlyphRasterizer> font) {
+  fonts_.push_back(std::move(font));
+  return static_cast<FontId>(fonts_.size() - 1);
+}
+
+FontMetrics GlyphAtlas::Metrics(FontId font) const {
+  return font < fonts_.size() && fonts_[font] ? fonts_[font]->Metrics() : FontMetrics{};
+}
+
+const AtlasGlyph* GlyphAtlas::Find(FontId font, char32_t code) {
+  ++stats_.lookups;
+  const uint64_t key = static_cast<uint64_t>(font) << 32 | code;
+  auto it = glyphs_.find(key);
+  if (it != glyphs_.end()) {
+    return &it->second;
+  }
+  if (font >= fonts_.size() || !fonts_[font]) {
+    return nullptr;
+  }
+  GlyphBitmap bitmap;
+  if (!fonts_[font]->Rasterize(code, bitmap) && !fonts_[font]->Rasterize(U'?', bitmap)) {
+    bitmap = GlyphBitmap{};
+  }
+  ++stats_.rasterized;
+  AtlasGlyph glyph;
+  if (!Insert(bitmap, glyph)) {
+    Reset();
+    if (!Insert(bitmap, glyph)) {
+      glyph = AtlasGlyph{};  // larger than the whole atlas
+      glyph.advance = static_cast<int16_t>(bitmap.advance);
+    }
+  }
+  return &glyphs_.emplace(key, glyph).first->second;
+}
+
+GlyphAtlasStats GlyphAtlas::Stats() const {
+  GlyphAtlasStats stats = stats_;
+  stats.glyphs = glyphs_.size();
+  return stats;
+}
+
+bool GlyphAtlas::Insert(const GlyphBitmap& bitmap, AtlasGlyph& glyph_out) {
+  glyph_out = AtlasGlyph{};
+  glyph_out.offsetX = static_cast<int16_t>(bitmap.offsetX);
+  glyph_out.offsetY = static_cast<int16_t>(bitmap.offsetY);
+  glyph_out.advance = static_cast<int16_t>(bitmap.advance);
+  if (bitmap.width <= 0 || bitmap.height <= 0) {
+    return true;  // blank, e.g. a space
+  }
+  if (shelf_x_ + bitmap.width > width_) {
+    shelf_x_ = 0;
+    shelf_y_ += shelf_height_ + kPadding;
+    shelf_height_ = 0;
+  }
+  if (bitmap.width > width_ || shelf_y_ + bitmap.height > height_) {
+    return false;
+  }
+  for (int y = 0; y < bitmap.height; ++y) {
+    std::memcpy(&pixels_[static_cast<size_t>(shelf_y_ + y) * width_ + shelf_x_],
+                &bitmap.coverage[static_cast<size_t>(y) * bitmap.width], static_cast<size_t>(bitmap.width));
+  }
+  glyph_out.x = static_cast<uint16_t>(shelf_x_);
+  glyph_out.y = static_cast<uint16_t>(shelf_y_);
+  glyph_out.width = static_cast<uint16_t>(bitmap.width);
+  glyph_out.height = static_cast<uint16_t>(bitmap.height);
+  shelf_x_ += bitmap.width + kPadding;
+  shelf_height_ = std::max(shelf_height_, bitmap.height);
+  return true;
+}
+
+void GlyphAtlas::Reset() {
+  glyphs_.clear();
+  std::fill(pixels_.begin(), pixels_.end(), uint8_t{0});
+  shelf_x_ = 0;
+  shelf_y_ = 0;
+  shelf_height_ = 0;
+  ++generation_;
+  ++stats_.resets;
+}
+
+}  // namespace optiscaler
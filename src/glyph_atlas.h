@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace optiscaler {
+
+using FontId = uint16_t;
+
+struct FontMetrics {
+  int ascent = 0;      // line top to baseline
+  int lineHeight = 0;  // line top to the next line's top
+};
+
+// 8-bit coverage for one glyph. Offsets place the bitmap relative to the
+// pen position on the top edge of the line.
+struct GlyphBitmap {
+  int width = 0;
+  int height = 0;
+  int offsetX = 0;
+  int offsetY = 0;
+  int advance = 0;
+  std::vector<uint8_t> coverage;
+};
+
+// One font at one pixel size.
+class IGlyphRasterizer {
+ public:
+  virtual ~IGlyphRasterizer() = default;
+  virtual FontMetrics Metrics() const = 0;
+  // False if the font has no glyph for `code`.
+  virtual bool Rasterize(char32_t code, GlyphBitmap& glyph_out) = 0;
+};
+
+// Built-in monospaced 1-bit font: printable ASCII plus U+2026 (ellipsis),
+// 7x13 cells, scaled by whole pixels. Always available, so text renders
+// headless and when no system font opens.
+class BitmapFont : public IGlyphRasterizer {
+ public:
+  explicit BitmapFont(int scale = 1);
+
+  FontMetrics Metrics() const override;
+  bool Rasterize(char32_t code, GlyphBitmap& glyph_out) override;
+
+ private:
+  int scale_ = 1;
+};
+
+// Placement of a cached glyph in the atlas.
+struct AtlasGlyph {
+  uint16_t x = 0;
+  uint16_t y = 0;
+  uint16_t width = 0;
+  uint16_t height = 0;
+  int16_t offsetX = 0;
+  int16_t offsetY = 0;
+  int16_t advance = 0;
+};
+
+struct GlyphAtlasStats {
+  uint64_t lookups = 0;
+  uint64_t rasterized = 0;
+  uint64_t resets = 0;  // atlas filled up and was cleared
+  size_t glyphs = 0;
+};
+
+// Glyph coverage for all fonts packed into one 8-bit texture, rasterized
+// on first use and then only looked up. Glyphs are packed on shelves; when
+// the atlas is full it is cleared and `generation` advances, which makes
+// every AtlasGlyph handed out earlier stale. Not thread-safe.
+class GlyphAtlas {
+ public:
+  static constexpr int kDefaultSize = 512;
+
+  explicit GlyphAtlas(int width = kDefaultSize, int height = kDefaultSize);
+
+  GlyphAtlas(const GlyphAtlas&) = delete;
+  GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+  FontId AddFont(std::unique_ptr<IGlyphRasterizer> font);
+  FontMetrics Metrics(FontId font) const;
+  // Falls back to '?' for glyphs the font lacks; null for an unknown font.
+  const AtlasGlyph* Find(FontId font, char32_t code);
+
+  const uint8_t* pixels() const { return pixels_.data(); }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  uint64_t generation() const { return generation_; }
+  GlyphAtlasStats Stats() const;
+
+ private:
+  bool Insert(const GlyphBitmap& bitmap, AtlasGlyph& glyph_out);
+  void Reset();
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint8_t> pixels_;
+  std::vector<std::unique_ptr<IGlyphRasterizer>> fonts_;
+  std::unordered_map<uint64_t, AtlasGlyph> glyphs_;  // key: font << 32 | code
+  int shelf_x_ = 0;
+  int shelf_y_ = 0;
+  int shelf_height_ = 0;
+  uint64_t generation_ = 0;
+  GlyphAtlasStats stats_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,151 @@
+#include "grid_layout.h"
+
+namespace optiscaler {
+
+namespace {
+
+bool Touches(const GridRect& a, const GridRect& b) {
+  return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+}  // namespace
+
+void GridLayout::SetMetrics(const GridMetrics& metrics) {
+  metrics_ = metrics;
+  Relayout();
+}
+
+void GridLayout::SetViewport(int width, int height, int top) {
+  width_ = std::max(0, width);
+  height_ = std::max(0, height);
+  top_ = top;
+  Relayout();
+}
+
+void GridLayout::SetItemCount(size_t count) {
+  count_ = count;
+  Relayout();
+}
+
+bool GridLayout::SetScroll(int offset) {
+  const int clamped = std::clamp(offset, 0, maxScroll());
+  if (clamped == scroll_) {
+    return false;
+  }
+  scroll_ = clamped;
+  return true;
+}
+
+int GridLayout::contentHeight() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return 2 * metrics_.margin + static_cast<int>(rows()) * rowPitch() - metrics_.gap;
+}
+
+int GridLayout::maxScroll() const {
+  return std::max(0, contentHeight() - height_);
+}
+
+GridRect GridLayout::TileRect(size_t index) const {
+  const int col = static_cast<int>(index % columns_);
+  const int row = static_cast<int>(index / columns_);
+  const int x = left_ + col * (metrics_.tileWidth + metrics_.gap);
+  const int y = top_ + metrics_.margin + row * rowPitch() - scroll_;
+  return {x, y, x + metrics_.tileWidth, y + metrics_.tileHeight + metrics_.labelHeight};
+}
+
+GridRect GridLayout::CoverRect(size_t index) const {
+  GridRect rect = TileRect(index);
+  rect.bottom = rect.top + metrics_.tileHeight;
+  return rect;
+}
+
+GridRect GridLayout::LabelRect(size_t index) const {
+  GridRect rect = TileRect(index);
+  rect.top += metrics_.tileHeight;
+  return rect;
+}
+
+std::optional<size_t> GridLayout::HitTest(int x, int y) const {
+  if (!viewport().Contains(x, y)) {
+    return std::nullopt;
+  }
+  const int pitch_x = metrics_.tileWidth + metrics_.gap;
+  const int content_x = x - left_;
+  const int content_y = y - top_ + scroll_ - metrics_.margin;
+  if (content_x < 0 || content_y < 0 || content_x % pitch_x >= metrics_.tileWidth ||
+      content_y % rowPitch() >= metrics_.tileHeight + metrics_.labelHeight) {
+    return std::nullopt;  // margin or gap
+  }
+  const size_t col = static_cast<size_t>(content_x / pitch_x);
+  const size_t index = static_cast<size_t>(content_y / rowPitch()) * columns_ + col;
+  if (col >= columns_ || index >= count_) {
+    return std::nullopt;
+  }
+  return index;
+}
+
+std::pair<size_t, size_t> GridLayout::VisibleRange() const {
+  if (count_ == 0 || height_ == 0) {
+    return {0, 0};
+  }
+  // A row whose gap is the only part showing at the top is not visible.
+  const int top = std::max(0, scroll_ - metrics_.margin) + metrics_.gap;
+  const int bottom = std::max(0, scroll_ + height_ - metrics_.margin - 1);
+  const size_t first = static_cast<size_t>(top / rowPitch()) * columns_;
+  const size_t last = (static_cast<size_t>(bottom / rowPitch()) + 1) * columns_;
+  return {std::min(first, count_), std::min(last, count_)};
+}
+
+bool GridLayout::IsVisible(size_t index) const {
+  return index < count_ && TileRect(index).Intersects(viewport());
+}
+
+void GridLayout::Relayout() {
+  const int pitch_x = metrics_.tileWidth + metrics_.gap;
+  const int available = width_ - 2 * metrics_.margin;
+  columns_ = static_cast<size_t>(std::max(1, (available + metrics_.gap) / pitch_x));
+  const int used = static_cast<int>(columns_) * pitch_x - metrics_.gap;
+  left_ = metrics_.margin + std::max(0, (available - used) / 2);
+  scroll_ = std::clamp(scroll_, 0, maxScroll());
+}
+
+void DirtyRegion::Add(const GridRect& rect) {
+  if (rect.empty()) {
+    return;
+  }
+  GridRect merged = rect;
+  // A merge can make the result touch rectangles it missed before.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = 0; i < rects_.size();) {
+      if (Touches(rects_[i], merged)) {
+        merged = merged.Union(rects_[i]);
+        rects_[i] = rects_.back();
+        rects_.pop_back();
+        changed = true;
+      } else {
+        ++i;
+      }
+    }
+  }
+  rects_.push_back(merged);
+  if (rects_.size() > kMaxRects) {
+    const GridRect bounds = Bounds();
+    rects_.assign(1, bounds);
+  }
+}
+
+GridRect DirtyRegion::Bounds() const {
+  if (rects_.empty()) {
+    return {};
+  }
+  GridRect bounds = rects_.front();
+  for (const auto& rect : rects_) {
+    bounds = bounds.Union(rect);
+  }
+  return bounds;
+}
+
+}  // namespace optiscaler
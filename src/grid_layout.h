@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace optiscaler {
+
+// Client-area rectangle, right/bottom exclusive (same convention as RECT).
+struct GridRect {
+  int left = 0;
+  int top = 0;
+  int right = 0;
+  int bottom = 0;
+
+  int width() const { return right - left; }
+  int height() const { return bottom - top; }
+  bool empty() const { return right <= left || bottom <= top; }
+  bool Contains(int x, int y) const { return x >= left && x < right && y >= top && y < bottom; }
+  bool Intersects(const GridRect& other) const {
+    return !empty() && !other.empty() && left < other.right && other.left < right && top < other.bottom &&
+           other.top < bottom;
+  }
+  GridRect Intersect(const GridRect& other) const {
+    return {std::max(left, other.left), std::max(top, other.top), std::min(right, other.right),
+            std::min(bottom, other.bottom)};
+  }
+  GridRect Union(const GridRect& other) const {
+    return {std::min(left, other.left), std::min(top, other.top), std::max(right, other.right),
+            std::max(bottom, other.bottom)};
+  }
+};
+
+struct GridMetrics {
+  int tileWidth = 200;  // cover size, CoverMips level 0
+  int tileHeight = 300;
+  int labelHeight = 24;
+  int gap = 16;
+  int margin = 16;
+};
+
+// Virtualized grid of equally sized tiles. Every query is O(1) or
+// proportional to the tiles it returns, so the item count only matters
+// through the scroll range. Rectangles are in client coordinates with the
+// scroll offset already applied. Headless; main.cpp feeds it sizes and
+// scroll input.
+class GridLayout {
+ public:
+  void SetMetrics(const GridMetrics& metrics);
+  // The viewport spans the full width and `height` pixels from y = `top`.
+  void SetViewport(int width, int height, int top = 0);
+  void SetItemCount(size_t count);
+  // Clamps to [0, maxScroll()]; returns true if the offset changed.
+  bool SetScroll(int offset);
+  bool ScrollBy(int delta) { return SetScroll(scroll_ + delta); }
+
+  const GridMetrics& metrics() const { return metrics_; }
+  size_t itemCount() const { return count_; }
+  size_t columns() const { return columns_; }
+  size_t rows() const { return (count_ + columns_ - 1) / columns_; }
+  int rowPitch() const { return metrics_.tileHeight + metrics_.labelHeight + metrics_.gap; }
+  int scroll() const { return scroll_; }
+  int contentHeight() const;
+  int maxScroll() const;
+  GridRect viewport() const { return {0, top_, width_, top_ + height_}; }
+
+  // Cover plus label.
+  GridRect TileRect(size_t index) const;
+  GridRect CoverRect(size_t index) const;
+  GridRect LabelRect(size_t index) const;
+  std::optional<size_t> HitTest(int x, int y) const;
+  // Items with any part inside the viewport, as [first, last).
+  std::pair<size_t, size_t> VisibleRange() const;
+  bool IsVisible(size_t index) const;
+
+  // Calls fn(index, tile_rect) for each tile intersecting `clip`, row by row.
+  template <typename Fn>
+  void ForEachTile(const GridRect& clip, Fn&& fn) const {
+    const GridRect area = clip.Intersect(viewport());
+    if (area.empty() || count_ == 0) {
+      return;
+    }
+    const int pitch_x = metrics_.tileWidth + metrics_.gap;
+    const int content_top = area.top - top_ + scroll_ - metrics_.margin;
+    const int content_bottom = area.bottom - top_ + scroll_ - metrics_.margin;
+    const size_t first_row = static_cast<size_t>(std::max(0, content_top) / rowPitch());
+    const size_t last_row = std::min(rows(), static_cast<size_t>(std::max(0, content_bottom - 1) / rowPitch()) + 1);
+    const size_t first_col = static_cast<size_t>(std::max(0, area.left - left_) / pitch_x);
+    const size_t last_col = std::min(columns_, static_cast<size_t>(std::max(0, area.right - 1 - left_) / pitch_x) + 1);
+    for (size_t row = first_row; row < last_row; ++row) {
+      for (size_t col = first_col; col < last_col; ++col) {
+        const size_t index = row * columns_ + col;
+        if (index >= count_) {
+          return;
+        }
+        const GridRect rect = TileRect(index);
+        if (rect.Intersects(area)) {
+          fn(index, rect);
+        }
+      }
+    }
+  }
+
+ private:
+  void Relayout();
+
+  GridMetrics metrics_;
+  int width_ = 0;
+  int height_ = 0;
+  int top_ = 0;
+  size_t count_ = 0;
+  size_t columns_ = 1;
+  int left_ = 0;  // x of the first column, centering the grid
+  int scroll_ = 0;
+};
+
+// Rectangles waiting to be repainted. Overlapping or touching rectangles
+// are merged as they are added, and past kMaxRects everything collapses to
+// the bounding box, so flushing costs at most kMaxRects invalidations.
+class DirtyRegion {
+ public:
+  static constexpr size_t kMaxRects = 16;
+
+  void Add(const GridRect& rect);
+  void Clear() { rects_.clear(); }
+  bool empty() const { return rects_.empty(); }
+  const std::vector<GridRect>& rects() const { return rects_; }
+  GridRect Bounds() const;
+
+ private:
+  std::vector<GridRect> rects_;
+};
+
+}  // namespace optiscaler
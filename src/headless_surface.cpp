@@ -0,0 +1,26 @@
+#include "headless_surface.h"
+
+#include <algorithm>
+
+namespace optiscaler {
+
+HeadlessSurface::HeadlessSurface(int width, int height, BlendKernel kernel) : compositor_(kernel) {
+  Resize(width, height);
+}
+
+void HeadlessSurface::Resize(int width, int height) {
+  width_ = std::max(0, width);
+  height_ = std::max(0, height);
+  pixels_.assign(static_cast<size_t>(width_) * static_cast<size_t>(height_), 0);
+  compositor_.Attach(pixels_.data(), width_, height_, width_);
+}
+
+void HeadlessSurface::Present() {
+  ++stats_.presents;
+  for (const GridRect& rect : compositor_.End()) {
+    ++stats_.rects;
+    stats_.pixels += static_cast<uint64_t>(rect.width()) * static_cast<uint64_t>(rect.height());
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "tile_compositor.h"
+
+namespace optiscaler {
+
+struct PresentStats {
+  uint64_t presents = 0;
+  uint64_t rects = 0;
+  uint64_t pixels = 0;
+};
+
+// A TileCompositor backend that presents to memory instead of a window, so
+// frames can be composed and inspected without a display (pixel checks,
+// benchmarks, non-Windows builds). Present only counts what a window
+// backend would have copied.
+class HeadlessSurface {
+ public:
+  explicit HeadlessSurface(int width, int height, BlendKernel kernel = TileCompositor::BestKernel());
+
+  HeadlessSurface(const HeadlessSurface&) = delete;
+  HeadlessSurface& operator=(const HeadlessSurface&) = delete;
+
+  void Resize(int width, int height);
+  TileCompositor& compositor() { return compositor_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  const uint32_t* pixels() const { return pixels_.data(); }
+  uint32_t Pixel(int x, int y) const { return pixels_[static_cast<size_t>(y) * static_cast<size_t>(width_) + x]; }
+
+  // Ends the compositor frame and records the rectangles it returns.
+  void Present();
+  PresentStats Stats() const { return stats_; }
+
+ private:
+  TileCompositor compositor_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint32_t> pixels_;
+  PresentStats stats_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,182 @@
+#include "http_client.h"
+
+#include <cwchar>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+
+#pragma comment(lib, "winhttp.lib")
+#endif
+
+namespace optiscaler {
+
+bool HttpRequest::FromUrl(const std::wstring& url, HttpRequest& request_out) {
+  size_t host_begin = 0;
+  if (url.compare(0, 8, L"https://") == 0) {
+    request_out.secure = true;
+    request_out.port = 443;
+    host_begin = 8;
+  } else if (url.compare(0, 7, L"http://") == 0) {
+    request_out.secure = false;
+    request_out.port = 80;
+    host_begin = 7;
+  } else {
+    return false;
+  }
+  const size_t path_begin = url.find(L'/', host_begin);
+  std::wstring authority = url.substr(host_begin, path_begin == std::wstring::npos ? std::wstring::npos
+                                                                                    : path_begin - host_begin);
+  const size_t colon = authority.rfind(L':');
+  if (colon != std::wstring::npos) {
+    const unsigned long port = std::wcstoul(authority.c_str() + colon + 1, nullptr, 10);
+    if (port == 0 || port > 0xFFFF) {
+      return false;
+    }
+    request_out.port = static_cast<uint16_t>(port);
+    authority.resize(colon);
+  }
+  if (authority.empty()) {
+    return false;
+  }
+  request_out.host = std::move(authority);
+  request_out.path = path_begin == std::wstring::npos ? L"/" : url.substr(path_begin);
+  return true;
+}
+
+#ifdef _WIN32
+namespace {
+
+class InternetHandle {
+ public:
+  explicit InternetHandle(HINTERNET handle = nullptr) : handle_(handle) {}
+  ~InternetHandle() {
+    if (handle_) {
+      WinHttpCloseHandle(handle_);
+    }
+  }
+  InternetHandle(const InternetHandle&) = delete;
+  InternetHandle& operator=(const InternetHandle&) = delete;
+
+  HINTERNET get() const { return handle_; }
+  explicit operator bool() const { return handle_ != nullptr; }
+
+ private:
+  HINTERNET handle_;
+};
+
+std::wstring ErrorText(const wchar_t* step) {
+  return std::wstring(step) + L" failed (" + std::to_wstring(GetLastError()) + L")";
+}
+
+// Empty if the header is missing or implausibly long.
+std::wstring QueryText(HINTERNET handle, DWORD query) {
+  wchar_t text[256];
+  DWORD size = sizeof(text);
+  if (!WinHttpQueryHeaders(handle, query, WINHTTP_HEADER_NAME_BY_INDEX, text, &size, WINHTTP_NO_HEADER_INDEX)) {
+    return {};
+  }
+  return std::wstring(text, size / sizeof(wchar_t));
+}
+
+}  // namespace
+
+WinHttpClient::WinHttpClient(const std::wstring& user_agent)
+    : session_(WinHttpOpen(user_agent.c_str(), WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, WINHTTP_NO_PROXY_NAME,
+                           WINHTTP_NO_PROXY_BYPASS, 0)) {}
+
+WinHttpClient::~WinHttpClient() {
+  if (session_) {
+    WinHttpCloseHandle(session_);
+  }
+}
+
+bool WinHttpClient::Send(const HttpRequest& request, HttpResponse& response_out) {
+  std::string body;
+  const bool ok = SendStreaming(request, response_out, [&body](const char* data, size_t size) {
+    body.append(data, size);
+    return true;
+  });
+  response_out.body = std::move(body);
+  return ok;
+}
+
+bool WinHttpClient::SendStreaming(const HttpRequest& request, HttpResponse& response_out, const BodySink& sink) {
+  response_out = HttpResponse{};
+  if (!session_) {
+    response_out.error = L"WinHttpOpen failed";
+    return false;
+  }
+  InternetHandle connection(WinHttpConnect(session_, request.host.c_str(), request.port, 0));
+  if (!connection) {
+    response_out.error = ErrorText(L"WinHttpConnect");
+    return false;
+  }
+  InternetHandle handle(WinHttpOpenRequest(connection.get(), request.method.c_str(), request.path.c_str(), nullptr,
+                                           WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                           request.secure ? WINHTTP_FLAG_SECURE : 0));
+  if (!handle) {
+    response_out.error = ErrorText(L"WinHttpOpenRequest");
+    return false;
+  }
+
+  std::wstring headers;
+  for (const auto& [name, value] : request.headers) {
+    headers += name;
+    headers += L": ";
+    headers += value;
+    headers += L"\r\n";
+  }
+  const DWORD body_size = static_cast<DWORD>(request.body.size());
+  if (!WinHttpSendRequest(handle.get(), headers.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : headers.c_str(),
+                          static_cast<DWORD>(-1L), const_cast<char*>(request.body.data()), body_size, body_size,
+                          0) ||
+      !WinHttpReceiveResponse(handle.get(), nullptr)) {
+    response_out.error = ErrorText(L"WinHttpSendRequest");
+    return false;
+  }
+
+  DWORD status = 0;
+  DWORD status_size = sizeof(status);
+  WinHttpQueryHeaders(handle.get(), WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER, WINHTTP_HEADER_NAME_BY_INDEX,
+                      &status, &status_size, WINHTTP_NO_HEADER_INDEX);
+  response_out.status = static_cast<int>(status);
+  uint64_t content_length = 0;
+  DWORD length_size = sizeof(content_length);
+  if (WinHttpQueryHeaders(handle.get(), WINHTTP_QUERY_CONTENT_LENGTH | WINHTTP_QUERY_FLAG_NUMBER64,
+                          WINHTTP_HEADER_NAME_BY_INDEX, &content_length, &length_size, WINHTTP_NO_HEADER_INDEX)) {
+    response_out.contentLength = static_cast<int64_t>(content_length);
+  }
+  wchar_t range[128];
+  DWORD range_size = sizeof(range);
+  if (status == 206 && WinHttpQueryHeaders(handle.get(), WINHTTP_QUERY_CONTENT_RANGE, WINHTTP_HEADER_NAME_BY_INDEX,
+                                           range, &range_size, WINHTTP_NO_HEADER_INDEX)) {
+    // "bytes <first>-<last>/<total>"
+    const wchar_t* first = std::wcschr(range, L' ');
+    if (first) {
+      response_out.rangeStart = static_cast<int64_t>(std::wcstoull(first + 1, nullptr, 10));
+    }
+  }
+  response_out.etag = QueryText(handle.get(), WINHTTP_QUERY_ETAG);
+  response_out.lastModified = QueryText(handle.get(), WINHTTP_QUERY_LAST_MODIFIED);
+
+  std::vector<char> buffer(kChunkBytes);
+  DWORD read = 0;
+  for (;;) {
+    if (!WinHttpReadData(handle.get(), buffer.data(), static_cast<DWORD>(buffer.size()), &read)) {
+      response_out.error = ErrorText(L"WinHttpReadData");
+      return false;
+    }
+    if (read == 0) {
+      return true;
+    }
+    if (!sink(buffer.data(), read)) {
+      response_out.error = L"Transfer aborted";
+      return false;
+    }
+  }
+}
+
+#endif
+
+}  // namespace optiscaler
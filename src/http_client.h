@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace optiscaler {
+
+struct HttpRequest {
+  std::wstring method = L"GET";
+  std::wstring host;
+  uint16_t port = 443;
+  bool secure = true;
+  std::wstring path;  // includes the query string
+  std::vector<std::pair<std::wstring, std::wstring>> headers;
+  std::string body;
+
+  // Fills scheme, host, port and path from an absolute http(s) URL.
+  static bool FromUrl(const std::wstring& url, HttpRequest& request_out);
+};
+
+struct HttpResponse {
+  int status = 0;  // 0 if no response was received
+  int64_t contentLength = -1;  // -1 if the server did not say
+  int64_t rangeStart = -1;     // first byte of a 206 response
+  std::wstring etag;           // validators for If-Range; empty if not sent
+  std::wstring lastModified;
+  std::string body;            // left empty by SendStreaming
+  std::wstring error;
+};
+
+// Blocking transport used by the metadata clients. Kept abstract so
+// batching and scheduling can run against a local stand-in server or a
+// recorded-response fake instead of the network.
+class IHttpClient {
+ public:
+  virtual ~IHttpClient() = default;
+  // Receives body chunks as they arrive; returning false aborts the transfer.
+  using BodySink = std::function<bool(const char* data, size_t size)>;
+
+  // False on transport failure; HTTP error statuses still return true.
+  virtual bool Send(const HttpRequest& request, HttpResponse& response_out) = 0;
+  // Send without buffering the body. False if the transfer was cut short,
+  // including by the sink. The default forwards Send's body in one chunk.
+  virtual bool SendStreaming(const HttpRequest& request, HttpResponse& response_out, const BodySink& sink) {
+    if (!Send(request, response_out)) {
+      return false;
+    }
+    std::string body;
+    body.swap(response_out.body);
+    return body.empty() || sink(body.data(), body.size());
+  }
+};
+
+// WinHTTP implementation. All calls share one session, whose keep-alive
+// pool reuses connections per host. Thread-safe.
+class WinHttpClient : public IHttpClient {
+ public:
+  explicit WinHttpClient(const std::wstring& user_agent = L"OptiScalerMgrLite/1.0");
+  ~WinHttpClient() override;
+
+  WinHttpClient(const WinHttpClient&) = delete;
+  WinHttpClient& operator=(const WinHttpClient&) = delete;
+
+  // Reads at most kChunkBytes at a time, so streaming memory stays fixed.
+  static constexpr size_t kChunkBytes = 64 * 1024;
+
+  bool Send(const HttpRequest& request, HttpResponse& response_out) override;
+  bool SendStreaming(const HttpRequest& request, HttpResponse& response_out, const BodySink& sink) override;
+
+ private:
+  void* session_ = nullptr;  // HINTERNET
+};
+
+}  // namespace optiscaler
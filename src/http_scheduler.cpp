@@ -0,0 +1,288 @@
+#include "http_scheduler.h"
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+
+namespace optiscaler {
+
+namespace {
+
+// The scheduler whose worker is running on this thread, if any.
+thread_local const HttpScheduler* t_worker_of = nullptr;
+
+bool IsRetryable(bool sent, const HttpResponse& response) {
+  return !sent || response.status == 429 || response.status >= 500;
+}
+
+bool IsRetryableStatus(int status) {
+  return status == 429 || status >= 500;
+}
+
+constexpr wchar_t kReentrantError[] = L"ScheduledHttpClient used from a scheduler thread";
+
+}  // namespace
+
+HttpScheduler::HttpScheduler(IHttpClient& http, HttpSchedulerOptions options)
+    : http_(http), options_(options), random_(std::random_device{}()) {
+  const size_t worker_count = std::max<size_t>(1, options_.workerCount);
+  threads_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    threads_.emplace_back([this] { Run(); });
+  }
+}
+
+HttpScheduler::~HttpScheduler() {
+  std::vector<Job> dropped;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    for (auto& lane : lanes_) {
+      std::move(lane.begin(), lane.end(), std::back_inserter(dropped));
+      lane.clear();
+    }
+  }
+  work_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  idle_cv_.notify_all();
+  HttpResponse cancelled;
+  cancelled.error = L"Scheduler shut down";
+  for (auto& job : dropped) {
+    if (job.callback) {
+      job.callback(cancelled);
+    }
+  }
+}
+
+void HttpScheduler::SetHostLimits(const std::wstring& host, const HostLimits& limits) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Host& state = HostLocked(host);
+  state.limits = limits;
+  state.tokens = std::min(state.tokens, limits.burst);
+  work_cv_.notify_all();
+}
+
+uint64_t HttpScheduler::Submit(HttpRequest request, HttpPriority priority, Callback callback) {
+  return SubmitStreaming(std::move(request), priority, nullptr, std::move(callback));
+}
+
+uint64_t HttpScheduler::SubmitStreaming(HttpRequest request, HttpPriority priority, IHttpClient::BodySink sink,
+                                        Callback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Job job;
+  job.id = next_id_++;
+  job.request = std::move(request);
+  job.sink = std::move(sink);
+  job.callback = std::move(callback);
+  job.lane = static_cast<size_t>(priority);
+  HostLocked(job.request.host);
+  const uint64_t id = job.id;
+  lanes_[job.lane].emplace_back(std::move(job));
+  work_cv_.notify_one();
+  return id;
+}
+
+bool HttpScheduler::Reprioritize(uint64_t id, HttpPriority priority) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t target = static_cast<size_t>(priority);
+  for (auto& lane : lanes_) {
+    auto it = std::find_if(lane.begin(), lane.end(), [id](const Job& job) { return job.id == id; });
+    if (it == lane.end()) {
+      continue;
+    }
+    if (it->lane != target) {
+      Job job = std::move(*it);
+      lane.erase(it);
+      job.lane = target;
+      lanes_[target].emplace_back(std::move(job));
+      work_cv_.notify_one();
+    }
+    return true;
+  }
+  return false;
+}
+
+bool HttpScheduler::Cancel(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& lane : lanes_) {
+    auto it = std::find_if(lane.begin(), lane.end(), [id](const Job& job) { return job.id == id; });
+    if (it != lane.end()) {
+      lane.erase(it);
+      idle_cv_.notify_all();
+      return true;
+    }
+  }
+  return false;
+}
+
+void HttpScheduler::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this] {
+    return stopping_ || (in_flight_ == 0 &&
+                         std::all_of(lanes_.begin(), lanes_.end(), [](const auto& lane) { return lane.empty(); }));
+  });
+}
+
+HttpSchedulerStats HttpScheduler::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HttpSchedulerStats stats = stats_;
+  for (const auto& lane : lanes_) {
+    stats.queued += lane.size();
+  }
+  stats.inFlight = in_flight_;
+  return stats;
+}
+
+bool HttpScheduler::OnWorkerThread() const {
+  return t_worker_of == this;
+}
+
+HttpScheduler::Host& HttpScheduler::HostLocked(const std::wstring& name) {
+  auto [it, inserted] = hosts_.try_emplace(name);
+  if (inserted) {
+    it->second.limits = options_.defaultLimits;
+    it->second.tokens = options_.defaultLimits.burst;
+    it->second.refilled = Clock::now();
+  }
+  return it->second;
+}
+
+bool HttpScheduler::TakeLocked(Clock::time_point now, Job& job_out, Clock::time_point& wake_out) {
+  wake_out = Clock::time_point::max();
+  for (auto& lane : lanes_) {
+    for (auto it = lane.begin(); it != lane.end(); ++it) {
+      if (it->notBefore > now) {
+        wake_out = std::min(wake_out, it->notBefore);
+        continue;
+      }
+      Host& host = HostLocked(it->request.host);
+      const double elapsed = std::chrono::duration<double>(now - host.refilled).count();
+      host.tokens = std::min(host.limits.burst, host.tokens + elapsed * host.limits.requestsPerSecond);
+      host.refilled = now;
+      if (host.inFlight >= host.limits.maxInFlight) {
+        continue;  // a completion wakes the workers
+      }
+      if (host.tokens < 1.0) {
+        if (host.limits.requestsPerSecond > 0.0) {
+          const auto refill = std::chrono::duration<double>((1.0 - host.tokens) / host.limits.requestsPerSecond);
+          wake_out = std::min(wake_out, now + std::chrono::duration_cast<Clock::duration>(refill));
+        }
+        continue;
+      }
+      host.tokens -= 1.0;
+      ++host.inFlight;
+      job_out = std::move(*it);
+      lane.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+HttpScheduler::Clock::duration HttpScheduler::BackoffLocked(int attempt) {
+  const int shift = std::min(attempt - 1, 16);
+  const auto cap = std::min<std::chrono::milliseconds>(options_.maxBackoff, options_.baseBackoff * (1LL << shift));
+  std::uniform_int_distribution<long long> jitter(0, cap.count());
+  return std::chrono::milliseconds(jitter(random_));
+}
+
+void HttpScheduler::Run() {
+  t_worker_of = this;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    Job job;
+    Clock::time_point wake;
+    if (!TakeLocked(Clock::now(), job, wake)) {
+      if (wake == Clock::time_point::max()) {
+        work_cv_.wait(lock);
+      } else {
+        work_cv_.wait_until(lock, wake);
+      }
+      continue;
+    }
+    ++in_flight_;
+    ++stats_.sent;
+    lock.unlock();
+    HttpResponse response;
+    bool delivered = false;
+    bool sent = false;
+    if (job.sink) {
+      sent = http_.SendStreaming(job.request, response, [&](const char* data, size_t size) {
+        if (IsRetryableStatus(response.status)) {
+          return true;  // an error page; the request is retried or fails as a whole
+        }
+        delivered = true;
+        return job.sink(data, size);
+      });
+    } else {
+      sent = http_.Send(job.request, response);
+    }
+    lock.lock();
+
+    Host& host = HostLocked(job.request.host);
+    --host.inFlight;
+    ++job.attempts;
+    if (IsRetryable(sent, response) && !delivered && job.attempts <= options_.maxRetries && !stopping_) {
+      if (response.status == 429) {
+        host.tokens = 0.0;
+        host.refilled = Clock::now();
+      }
+      ++stats_.retried;
+      job.notBefore = Clock::now() + BackoffLocked(job.attempts);
+      lanes_[job.lane].emplace_back(std::move(job));
+      --in_flight_;
+      work_cv_.notify_all();
+      continue;
+    }
+
+    if (sent && response.status >= 200 && response.status < 400) {
+      ++stats_.completed;
+    } else {
+      ++stats_.failed;
+    }
+    if (!sent && response.error.empty()) {
+      response.error = L"Transfer failed";
+    }
+    work_cv_.notify_one();
+    if (job.callback) {
+      lock.unlock();
+      job.callback(response);
+      lock.lock();
+    }
+    --in_flight_;
+    idle_cv_.notify_all();
+  }
+}
+
+bool ScheduledHttpClient::Send(const HttpRequest& request, HttpResponse& response_out) {
+  return SendStreaming(request, response_out, nullptr);
+}
+
+// An empty `sink` buffers the body, as Send does.
+bool ScheduledHttpClient::SendStreaming(const HttpRequest& request, HttpResponse& response_out,
+                                        const BodySink& sink) {
+  if (scheduler_.OnWorkerThread()) {
+    response_out = HttpResponse{};
+    response_out.error = kReentrantError;
+    return false;
+  }
+  std::promise<HttpResponse> done;
+  std::future<HttpResponse> result = done.get_future();
+  bool aborted = false;
+  auto finish = [&done](const HttpResponse& response) { done.set_value(response); };
+  if (sink) {
+    scheduler_.SubmitStreaming(request, priority_, [&](const char* data, size_t size) {
+      aborted = !sink(data, size);
+      return !aborted;
+    }, finish);
+  } else {
+    scheduler_.Submit(request, priority_, finish);
+  }
+  response_out = result.get();
+  // A streamed body cut short still has a status; the transport's error says so.
+  return response_out.status != 0 && (!sink || (response_out.error.empty() && !aborted));
+}
+
+}  // namespace optiscaler
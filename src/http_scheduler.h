@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "http_client.h"
+
+namespace optiscaler {
+
+// Lanes are served strictly in order.
+enum class HttpPriority {
+  kInteractive,  // user clicked "Fetch IGDB"
+  kVisible,      // covers for tiles on screen
+  kBackground,   // library prefetch
+};
+
+struct HostLimits {
+  double requestsPerSecond = 10.0;
+  double burst = 10.0;  // bucket capacity
+  size_t maxInFlight = 4;
+};
+
+struct HttpSchedulerOptions {
+  size_t workerCount = 8;  // also the global in-flight limit
+  int maxRetries = 3;
+  std::chrono::milliseconds baseBackoff{250};
+  std::chrono::milliseconds maxBackoff{8000};
+  HostLimits defaultLimits;
+};
+
+struct HttpSchedulerStats {
+  uint64_t sent = 0;
+  uint64_t retried = 0;
+  uint64_t completed = 0;
+  uint64_t failed = 0;  // gave up after retries, or a non-retryable status
+  size_t queued = 0;
+  size_t inFlight = 0;
+};
+
+// Shared front end for metadata and cover requests. Each host has a token
+// bucket and an in-flight cap; 429, 5xx and transport failures are retried
+// with full-jitter exponential backoff, and a 429 also empties the host's
+// bucket. Only needs an IHttpClient, so it runs against a fake transport.
+class HttpScheduler {
+ public:
+  using Callback = std::function<void(const HttpResponse&)>;
+
+  explicit HttpScheduler(IHttpClient& http, HttpSchedulerOptions options = {});
+  // In-flight requests finish; queued ones complete with status 0.
+  ~HttpScheduler();
+
+  HttpScheduler(const HttpScheduler&) = delete;
+  HttpScheduler& operator=(const HttpScheduler&) = delete;
+
+  void SetHostLimits(const std::wstring& host, const HostLimits& limits);
+  // The callback runs on a scheduler thread with the final response.
+  uint64_t Submit(HttpRequest request, HttpPriority priority, Callback callback);
+  // Like Submit, but the body goes to `sink` on the scheduler thread as it
+  // arrives. Retries happen only while no body has reached the sink; the
+  // bodies of retryable responses are dropped.
+  uint64_t SubmitStreaming(HttpRequest request, HttpPriority priority, IHttpClient::BodySink sink,
+                           Callback callback);
+  // Moves a queued request to another lane, e.g. when its tile scrolls off.
+  bool Reprioritize(uint64_t id, HttpPriority priority);
+  // Drops a queued request without running its callback.
+  bool Cancel(uint64_t id);
+  // Blocks until nothing is queued or in flight.
+  void Wait();
+  HttpSchedulerStats Stats() const;
+  // True on this scheduler's worker threads, i.e. inside a callback or sink.
+  bool OnWorkerThread() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    uint64_t id = 0;
+    HttpRequest request;
+    IHttpClient::BodySink sink;  // empty: buffered Send
+    Callback callback;
+    size_t lane = 0;
+    int attempts = 0;
+    Clock::time_point notBefore;
+  };
+
+  struct Host {
+    HostLimits limits;
+    double tokens = 0.0;
+    Clock::time_point refilled;
+    size_t inFlight = 0;
+  };
+
+  static constexpr size_t kLaneCount = 3;
+
+  Host& HostLocked(const std::wstring& name);
+  // Pops the first runnable job, or returns false with the time the next
+  // one could become runnable.
+  bool TakeLocked(Clock::time_point now, Job& job_out, Clock::time_point& wake_out);
+  Clock::duration BackoffLocked(int attempt);
+  void Run();
+
+  IHttpClient& http_;
+  const HttpSchedulerOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::array<std::deque<Job>, kLaneCount> lanes_;
+  std::unordered_map<std::wstring, Host> hosts_;
+  std::mt19937_64 random_;
+  uint64_t next_id_ = 1;
+  size_t in_flight_ = 0;
+  HttpSchedulerStats stats_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+// Blocking IHttpClient that routes every call through a scheduler lane, so
+// batch APIs such as IGDB::SearchMany share its limits. A call waits for a
+// scheduler worker, so calling it from one (a Submit callback) could wait
+// on itself forever; such calls fail at once with an error instead.
+class ScheduledHttpClient : public IHttpClient {
+ public:
+  ScheduledHttpClient(HttpScheduler& scheduler, HttpPriority priority)
+      : scheduler_(scheduler), priority_(priority) {}
+
+  bool Send(const HttpRequest& request, HttpResponse& response_out) override;
+  bool SendStreaming(const HttpRequest& request, HttpResponse& response_out, const BodySink& sink) override;
+
+ private:
+  HttpScheduler& scheduler_;
+  const HttpPriority priority_;
+};
+
+}  // namespace optiscaler
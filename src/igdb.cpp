@@ -1,16 +1,75 @@
 #include "igdb.h"
 
-#include <windows.h>
-#include <winhttp.h>
-
-#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 
-#include "cache.h"
+#include "cover_blob_store.h"
+#include "igdb_cache.h"
+#include "single_flight.h"
+#include "streaming_download.h"
+#include "text_util.h"
 #include <nlohmann/json.hpp>
 
 namespace optiscaler {
 
+namespace {
+
+constexpr wchar_t kApiHost[] = L"api.igdb.com";
+constexpr wchar_t kMultiqueryPath[] = L"/v4/multiquery";
+
+// Apicalypse string literal; control characters cannot appear in a title.
+void AppendQuoted(std::string& out, const std::wstring& text) {
+  out += '"';
+  for (char c : Utf8FromWide(text)) {
+    if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+      continue;
+    }
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  out += '"';
+}
+
+std::optional<IgdbGame> GameFromJson(const nlohmann::json& game) {
+  if (!game.is_object()) {
+    return std::nullopt;
+  }
+  IgdbGame result;
+  auto name = game.find("name");
+  if (name != game.end() && name->is_string()) {
+    result.name = WideFromUtf8(name->get_ref<const std::string&>());
+  }
+  auto cover = game.find("cover");
+  if (cover != game.end() && cover->is_object()) {
+    auto image_id = cover->find("image_id");
+    if (image_id != cover->end() && image_id->is_string()) {
+      result.imageId = WideFromUtf8(image_id->get_ref<const std::string&>());
+    }
+  }
+  return result;
+}
+
+// Streams `url` into the store's staging area and adopts it under the
+// digest computed on the way in, linked to `cover_key`.
+std::optional<ContentHash> DownloadImage(IHttpClient& http, const std::wstring& url, uint64_t cover_key) {
+  CoverBlobStore& blobs = CoverBlobStore::Default();
+  const std::wstring staging = blobs.StagingPath(url);
+  if (staging.empty()) {
+    return std::nullopt;
+  }
+  DownloadResult result;
+  if (!StreamingDownload::Fetch(http, url, staging, result)) {
+    return std::nullopt;
+  }
+  return blobs.Adopt(cover_key, staging, result.hash, result.bytes, url);
+}
+
+}  // namespace
+
 bool IGDB::EnsureAccessToken(const std::wstring& /*client_id*/,
                              const std::wstring& /*client_secret*/,
                              std::wstring& token,
@@ -22,12 +81,128 @@ bool IGDB::EnsureAccessToken(const std::wstring& /*client_id*/,
   return false;
 }
 
-std::optional<IgdbGame> IGDB::SearchOne(const std::wstring& /*client_id*/,
-                                        const std::wstring& /*token*/,
+void IGDB::ConfigureLimits(HttpScheduler& scheduler) {
+  HostLimits limits;
+  limits.requestsPerSecond = 4.0;
+  limits.burst = 4.0;
+  limits.maxInFlight = 8;
+  scheduler.SetHostLimits(kApiHost, limits);
+}
+
+std::optional<IgdbGame> IGDB::SearchOne(IHttpClient& http,
+                                        const std::wstring& client_id,
+                                        const std::wstring& token,
                                         const std::wstring& name) {
-  IgdbGame game;
-  game.name = name;
-  return std::optional<IgdbGame>(std::in_place, std::move(game));
+  // Several exes can resolve to the same title at once; one request serves them.
+  static SingleFlight<std::wstring, std::optional<IgdbGame>> searches;
+  return searches.Run(IgdbCache::NormalizeName(name), [&] {
+    return SearchMany(http, client_id, token, {name}, &IgdbCache::Default(), 1).front();
+  });
+}
+
+std::vector<std::optional<IgdbGame>> IGDB::SearchMany(IHttpClient& http,
+                                                      const std::wstring& client_id,
+                                                      const std::wstring& token,
+                                                      const std::vector<std::wstring>& names,
+                                                      IgdbCache* cache,
+                                                      size_t batch_size) {
+  std::vector<std::optional<IgdbGame>> results(names.size());
+  if (batch_size == 0 || batch_size > kMultiqueryLimit) {
+    batch_size = kMultiqueryLimit;
+  }
+  std::vector<size_t> misses;
+  std::vector<std::wstring> miss_names;
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (!cache || !cache->Find(names[i], results[i])) {
+      misses.push_back(i);
+      miss_names.push_back(names[i]);
+    }
+  }
+  std::vector<std::optional<IgdbGame>> fetched(miss_names.size());
+  std::vector<uint8_t> answered;
+
+  HttpRequest request;
+  request.method = L"POST";
+  request.host = kApiHost;
+  request.path = kMultiqueryPath;
+  request.headers = {{L"Client-ID", client_id}, {L"Authorization", L"Bearer " + token},
+                     {L"Accept", L"application/json"}};
+  HttpResponse response;
+  for (size_t begin = 0; begin < miss_names.size(); begin += batch_size) {
+    const size_t end = std::min(miss_names.size(), begin + batch_size);
+    request.body = BuildMultiquery(miss_names, begin, end);
+    if (http.Send(request, response) && response.status == 200 &&
+        ParseMultiquery(response.body, fetched, &answered) && cache) {
+      for (size_t i = begin; i < end; ++i) {
+        if (answered[i]) {
+          cache->Store(miss_names[i], fetched[i]);
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < misses.size(); ++i) {
+    results[misses[i]] = std::move(fetched[i]);
+  }
+  return results;
+}
+
+std::vector<std::optional<IgdbGame>> IGDB::SearchGames(IHttpClient& http,
+                                                       const std::wstring& client_id,
+                                                       const std::wstring& token,
+                                                       const std::vector<GameEntry>& games,
+                                                       IgdbCache* cache) {
+  std::vector<std::wstring> names;
+  names.reserve(games.size());
+  for (const auto& game : games) {
+    names.push_back(game.name);
+  }
+  return SearchMany(http, client_id, token, names, cache);
+}
+
+std::string IGDB::BuildMultiquery(const std::vector<std::wstring>& names, size_t begin, size_t end) {
+  std::string body;
+  for (size_t i = begin; i < end && i < names.size(); ++i) {
+    body += "query games \"";
+    body += std::to_string(i);
+    body += "\" { fields name,cover.image_id; search ";
+    AppendQuoted(body, names[i]);
+    body += "; limit 1; };\n";
+  }
+  return body;
+}
+
+bool IGDB::ParseMultiquery(const std::string& body, std::vector<std::optional<IgdbGame>>& results,
+                           std::vector<uint8_t>* answered) {
+  const auto json = nlohmann::json::parse(body, nullptr, false);
+  if (!json.is_array()) {
+    return false;
+  }
+  if (answered) {
+    answered->assign(results.size(), 0);
+  }
+  for (const auto& query : json) {
+    if (!query.is_object()) {
+      continue;
+    }
+    auto name = query.find("name");
+    auto result = query.find("result");
+    if (name == query.end() || !name->is_string() || result == query.end() || !result->is_array()) {
+      continue;
+    }
+    const std::string& label = name->get_ref<const std::string&>();
+    char* cursor = nullptr;
+    const unsigned long long index = std::strtoull(label.c_str(), &cursor, 10);
+    if (label.empty() || *cursor != '\0' || index >= results.size()) {
+      continue;
+    }
+    if (answered) {
+      (*answered)[index] = 1;
+    }
+    if (!result->empty()) {
+      results[index] = GameFromJson(result->front());
+    }
+  }
+  return true;
 }
 
 std::wstring IGDB::ImageUrlCoverBig(const std::wstring& image_id) {
@@ -37,9 +212,20 @@ std::wstring IGDB::ImageUrlCoverBig(const std::wstring& image_id) {
   return L"https://images.igdb.com/igdb/image/upload/t_cover_big/" + image_id + L".jpg";
 }
 
-std::wstring IGDB::CacheImage(const std::wstring& /*url*/) {
-  // TODO: Download covers via WinHTTP and persist in cache.
-  return {};
+std::wstring IGDB::CacheImage(IHttpClient& http, const std::wstring& url, uint64_t cover_key) {
+  CoverBlobStore& blobs = CoverBlobStore::Default();
+  if (url.empty() || cover_key == 0) {
+    return {};
+  }
+  if (blobs.LinkSource(cover_key, url)) {
+    return blobs.PathFor(cover_key);
+  }
+  // The prefetch workers and a "Fetch IGDB" click can ask for the same
+  // image together; only the first caller downloads it, the rest link to
+  // the blob it stored.
+  static SingleFlight<std::wstring, std::optional<ContentHash>> downloads;
+  const auto hash = downloads.Run(url, [&] { return DownloadImage(http, url, cover_key); });
+  return hash && blobs.Link(cover_key, *hash) ? blobs.PathFor(cover_key) : std::wstring();
 }
 
 }  // namespace optiscaler
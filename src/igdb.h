@@ -1,10 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
+
+#include "game_types.h"
+#include "http_client.h"
+#include "http_scheduler.h"
 
 namespace optiscaler {
 
+class IgdbCache;
+
 struct IgdbGame {
   std::wstring name;
   std::wstring imageId;
@@ -12,16 +21,53 @@ struct IgdbGame {
 
 class IGDB {
  public:
+  // IGDB accepts at most this many queries per /v4/multiquery request.
+  static constexpr size_t kMultiqueryLimit = 10;
+
+  // IGDB allows about 4 requests/s and 8 open requests per client. Every
+  // call below takes the IHttpClient to use; the app passes one
+  // ScheduledHttpClient over a scheduler configured with these limits.
+  static void ConfigureLimits(HttpScheduler& scheduler);
+
   static bool EnsureAccessToken(const std::wstring& client_id,
                                 const std::wstring& client_secret,
                                 std::wstring& token,
                                 std::wstring& expires_utc_iso,
                                 std::wstring& error_out);
-  static std::optional<IgdbGame> SearchOne(const std::wstring& client_id,
+  static std::optional<IgdbGame> SearchOne(IHttpClient& http,
+                                           const std::wstring& client_id,
                                            const std::wstring& token,
                                            const std::wstring& name);
+  // Packs up to `batch_size` searches into each multiquery request. Returns
+  // one result per name, in order; empty where IGDB had no match or the
+  // request failed. Names with a live `cache` entry are not sent. Queries
+  // the response answered are stored back, as a negative when the answer
+  // was empty; queries it left out are not cached.
+  static std::vector<std::optional<IgdbGame>> SearchMany(IHttpClient& http,
+                                                         const std::wstring& client_id,
+                                                         const std::wstring& token,
+                                                         const std::vector<std::wstring>& names,
+                                                         IgdbCache* cache = nullptr,
+                                                         size_t batch_size = kMultiqueryLimit);
+  // SearchMany over GameEntry::name; results are parallel to `games`.
+  static std::vector<std::optional<IgdbGame>> SearchGames(IHttpClient& http,
+                                                          const std::wstring& client_id,
+                                                          const std::wstring& token,
+                                                          const std::vector<GameEntry>& games,
+                                                          IgdbCache* cache = nullptr);
+  // Request body for names[begin, end); each query is named by its index.
+  static std::string BuildMultiquery(const std::vector<std::wstring>& names, size_t begin, size_t end);
+  // Fills results[i] for every query named i in a multiquery response. When
+  // given, `answered` is resized to match and answered[i] set for every
+  // query whose result block is present, matched or not.
+  static bool ParseMultiquery(const std::string& body, std::vector<std::optional<IgdbGame>>& results,
+                              std::vector<uint8_t>* answered = nullptr);
   static std::wstring ImageUrlCoverBig(const std::wstring& image_id);
-  static std::wstring CacheImage(const std::wstring& url);
+  // Links `cover_key` (GameEntry::coverKey) to the image at `url` in
+  // CoverBlobStore::Default(), downloading it unless the store already has
+  // that URL, and returns the blob path; empty on failure. Concurrent calls
+  // for one URL share a single download.
+  static std::wstring CacheImage(IHttpClient& http, const std::wstring& url, uint64_t cover_key);
 };
 
 }  // namespace optiscaler
@@ -0,0 +1,264 @@
+#include "igdb_cache.h"
+
+#include <chrono>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+#include <iterator>
+
+#include "cache.h"
+#include "mapped_file.h"
+#include "text_util.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'S', 'M', 'I', 'G', 'D', 'B', '1'};
+constexpr uint32_t kFlagFound = 1;
+// Small logs are cheap to replay; only rewrite once the garbage adds up.
+constexpr size_t kMinDeadRecords = 1024;
+
+bool TooManyDead(size_t dead, size_t live) {
+  return dead >= kMinDeadRecords && dead > live;
+}
+
+struct RecordHeader {
+  uint32_t bytes;  // whole record, header included
+  uint32_t flags;
+  int64_t expires;
+  uint16_t keyBytes;
+  uint16_t nameBytes;
+  uint16_t imageIdBytes;
+  uint16_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 24, "igdb cache record layout");
+
+}  // namespace
+
+std::wstring IgdbCache::DefaultPath() {
+  const std::wstring root = Cache::AppDataRoot();
+  if (root.empty()) {
+    return {};
+  }
+  std::filesystem::path path(root);
+  path /= L"cache";
+  Cache::EnsureDirectory(path.wstring());
+  path /= L"igdb_cache.bin";
+  return path.wstring();
+}
+
+IgdbCache& IgdbCache::Default() {
+  // Never destroyed: fetch workers may still be storing results at exit.
+  static IgdbCache* cache = [] {
+    auto* opened = new IgdbCache();
+    opened->Open(DefaultPath());
+    return opened;
+  }();
+  return *cache;
+}
+
+int64_t IgdbCache::Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::wstring IgdbCache::NormalizeName(std::wstring_view name) {
+  std::wstring key;
+  key.reserve(name.size());
+  bool pending_space = false;
+  for (wchar_t ch : name) {
+    if (!std::iswalnum(ch)) {
+      pending_space = !key.empty();
+      continue;
+    }
+    if (pending_space) {
+      key += L' ';
+      pending_space = false;
+    }
+    key += static_cast<wchar_t>(std::towlower(ch));
+  }
+  if (key.empty()) {
+    // Titles made only of symbols ("!!!", "-") still need distinct keys.
+    for (wchar_t ch : name) {
+      key += static_cast<wchar_t>(std::towlower(ch));
+    }
+  }
+  return key;
+}
+
+bool IgdbCache::Open(const std::wstring& path, int64_t now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  log_.close();
+  entries_.clear();
+  dead_records_ = 0;
+  path_ = path;
+  if (path_.empty()) {
+    return false;
+  }
+
+  size_t valid_bytes = 0;
+  {
+    MappedFile file;
+    if (file.Open(path_) && file.size() >= sizeof(kMagic) && std::memcmp(file.data(), kMagic, sizeof(kMagic)) == 0) {
+      const std::string_view data = file.view();
+      size_t offset = sizeof(kMagic);
+      std::wstring key;
+      while (data.size() - offset >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        const size_t payload = static_cast<size_t>(header.keyBytes) + header.nameBytes + header.imageIdBytes;
+        if (header.bytes != sizeof(header) + payload || header.bytes > data.size() - offset) {
+          break;  // torn tail from an interrupted append
+        }
+        const char* text = data.data() + offset + sizeof(header);
+        offset += header.bytes;
+        key = WideFromUtf8(std::string_view(text, header.keyBytes));
+        if (header.expires <= now) {
+          dead_records_ += entries_.erase(key) + 1;
+          continue;
+        }
+        Entry entry;
+        entry.expires = header.expires;
+        if (header.flags & kFlagFound) {
+          entry.game.emplace();
+          entry.game->name = WideFromUtf8(std::string_view(text + header.keyBytes, header.nameBytes));
+          entry.game->imageId =
+              WideFromUtf8(std::string_view(text + header.keyBytes + header.nameBytes, header.imageIdBytes));
+        }
+        auto [it, inserted] = entries_.try_emplace(std::move(key), std::move(entry));
+        if (!inserted) {
+          it->second = std::move(entry);
+          ++dead_records_;
+        }
+      }
+      valid_bytes = offset;
+    }
+  }
+
+  if (valid_bytes == 0 || TooManyDead(dead_records_, entries_.size())) {
+    return RewriteLocked(now);
+  }
+  std::error_code ec;
+  if (std::filesystem::file_size(path_, ec) != valid_bytes) {
+    std::filesystem::resize_file(path_, valid_bytes, ec);
+  }
+  log_.open(std::filesystem::path(path_), std::ios::binary | std::ios::app);
+  return log_.good();
+}
+
+void IgdbCache::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  log_.close();
+  entries_.clear();
+  dead_records_ = 0;
+  path_.clear();
+}
+
+bool IgdbCache::Find(std::wstring_view name, std::optional<IgdbGame>& game_out, int64_t now) const {
+  const std::wstring key = NormalizeName(name);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end() || it->second.expires <= now) {
+    return false;
+  }
+  game_out = it->second.game;
+  return true;
+}
+
+bool IgdbCache::Store(std::wstring_view name, const std::optional<IgdbGame>& game, int64_t now,
+                      int64_t ttl_seconds) {
+  std::wstring key = NormalizeName(name);
+  if (key.empty()) {
+    return false;
+  }
+  if (ttl_seconds <= 0) {
+    ttl_seconds = game ? kHitTtlSeconds : kMissTtlSeconds;
+  }
+  Entry entry;
+  entry.expires = now + ttl_seconds;
+  entry.game = game;
+  std::lock_guard<std::mutex> lock(mutex_);
+  const bool written = AppendLocked(key, entry);
+  auto [it, inserted] = entries_.try_emplace(std::move(key), std::move(entry));
+  if (!inserted) {
+    it->second = std::move(entry);
+    ++dead_records_;
+  }
+  // Long sessions re-store the same names; compact instead of waiting for
+  // the next Open.
+  if (written && TooManyDead(dead_records_, entries_.size()) && !RewriteLocked(now) && !log_.is_open()) {
+    log_.open(std::filesystem::path(path_), std::ios::binary | std::ios::app);  // keep appending to the old log
+  }
+  return written;
+}
+
+size_t IgdbCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t IgdbCache::deadRecords() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dead_records_;
+}
+
+// Drops entries expired at `now`, then writes one record per live entry.
+bool IgdbCache::RewriteLocked(int64_t now) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = it->second.expires <= now ? entries_.erase(it) : std::next(it);
+  }
+  log_.close();
+  const std::wstring temp_path = path_ + L".tmp";
+  {
+    std::ofstream out(std::filesystem::path(temp_path), std::ios::binary | std::ios::trunc);
+    out.write(kMagic, sizeof(kMagic));
+    log_.swap(out);
+    bool ok = log_.good();
+    for (const auto& [key, entry] : entries_) {
+      ok = ok && AppendLocked(key, entry);
+    }
+    log_.swap(out);
+    out.close();
+    if (!ok || !out) {
+      std::error_code ec;
+      std::filesystem::remove(temp_path, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path_, ec);
+  if (ec) {
+    return false;
+  }
+  dead_records_ = 0;
+  log_.open(std::filesystem::path(path_), std::ios::binary | std::ios::app);
+  return log_.good();
+}
+
+bool IgdbCache::AppendLocked(const std::wstring& key, const Entry& entry) {
+  if (!log_.is_open()) {
+    return false;
+  }
+  const std::string key_utf8 = Utf8FromWide(key);
+  const std::string name = entry.game ? Utf8FromWide(entry.game->name) : std::string();
+  const std::string image_id = entry.game ? Utf8FromWide(entry.game->imageId) : std::string();
+  if (key_utf8.size() > 0xFFFF || name.size() > 0xFFFF || image_id.size() > 0xFFFF) {
+    return false;
+  }
+  RecordHeader header = {};
+  header.bytes = static_cast<uint32_t>(sizeof(header) + key_utf8.size() + name.size() + image_id.size());
+  header.flags = entry.game ? kFlagFound : 0;
+  header.expires = entry.expires;
+  header.keyBytes = static_cast<uint16_t>(key_utf8.size());
+  header.nameBytes = static_cast<uint16_t>(name.size());
+  header.imageIdBytes = static_cast<uint16_t>(image_id.size());
+  log_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  log_.write(key_utf8.data(), static_cast<std::streamsize>(key_utf8.size()));
+  log_.write(name.data(), static_cast<std::streamsize>(name.size()));
+  log_.write(image_id.data(), static_cast<std::streamsize>(image_id.size()));
+  log_.flush();
+  return log_.good();
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "igdb.h"
+
+namespace optiscaler {
+
+// Persistent IGDB search results keyed by NormalizeName(search name). Names
+// IGDB had no match for are cached as negative entries with a shorter TTL.
+// The file is an append-only log of binary records; Open maps it, builds
+// the in-memory index (later records win) and rewrites it when expired or
+// superseded records outnumber live ones; Store does the same once enough
+// records it superseded pile up. Thread-safe.
+class IgdbCache {
+ public:
+  static constexpr int64_t kHitTtlSeconds = 30 * 24 * 60 * 60;
+  static constexpr int64_t kMissTtlSeconds = 3 * 24 * 60 * 60;
+
+  static std::wstring DefaultPath();
+  // Process-wide cache, opened at DefaultPath() on first use.
+  static IgdbCache& Default();
+  // Unix seconds.
+  static int64_t Now();
+  // Lowercase alphanumeric words separated by single spaces; a name with
+  // no alphanumerics at all is just lowercased.
+  static std::wstring NormalizeName(std::wstring_view name);
+
+  IgdbCache() = default;
+  IgdbCache(const IgdbCache&) = delete;
+  IgdbCache& operator=(const IgdbCache&) = delete;
+
+  bool Open(const std::wstring& path, int64_t now = Now());
+  void Close();
+
+  // True if `name` has an unexpired entry; `game_out` is empty for a
+  // negative one.
+  bool Find(std::wstring_view name, std::optional<IgdbGame>& game_out, int64_t now = Now()) const;
+  // `ttl_seconds` of 0 picks kHitTtlSeconds or kMissTtlSeconds.
+  bool Store(std::wstring_view name, const std::optional<IgdbGame>& game, int64_t now = Now(),
+             int64_t ttl_seconds = 0);
+
+  size_t size() const;
+  size_t deadRecords() const;
+
+ private:
+  struct Entry {
+    int64_t expires = 0;
+    std::optional<IgdbGame> game;
+  };
+
+  bool RewriteLocked(int64_t now);
+  bool AppendLocked(const std::wstring& key, const Entry& entry);
+
+  mutable std::mutex mutex_;
+  std::wstring path_;
+  std::unordered_map<std::wstring, Entry> entries_;
+  std::ofstream log_;
+  size_t dead_records_ = 0;
+};
+
+}  // namespace optiscaler
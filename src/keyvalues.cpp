@@ -0,0 +1,168 @@
+#include "keyvalues.h"
+
+#include "text_util.h"
+
+namespace optiscaler {
+
+namespace {
+
+bool IsSpace(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f' || ch == '\v';
+}
+
+char FoldAscii(char ch) {
+  return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+}  // namespace
+
+KeyValuesReader::KeyValuesReader(std::string_view text) : text_(text) {
+  // Skip a UTF-8 BOM if present.
+  if (text_.size() >= 3 && static_cast<unsigned char>(text_[0]) == 0xEF &&
+      static_cast<unsigned char>(text_[1]) == 0xBB && static_cast<unsigned char>(text_[2]) == 0xBF) {
+    pos_ = 3;
+  }
+}
+
+KeyValuesReader::Event KeyValuesReader::Next() {
+  std::string_view token;
+  switch (ReadToken(token)) {
+    case Token::kEnd:
+      return depth_ == 0 ? Event::kEnd : Event::kError;
+    case Token::kClose:
+      if (depth_ == 0) {
+        return Event::kError;
+      }
+      --depth_;
+      return Event::kEndObject;
+    case Token::kOpen:
+      return Event::kError;
+    case Token::kString:
+      key_ = token;
+      break;
+  }
+  switch (ReadToken(token)) {
+    case Token::kOpen:
+      ++depth_;
+      value_ = {};
+      return Event::kBeginObject;
+    case Token::kString:
+      value_ = token;
+      return Event::kValue;
+    default:
+      return Event::kError;
+  }
+}
+
+void KeyValuesReader::SkipWhitespaceAndComments() {
+  while (pos_ < text_.size()) {
+    if (IsSpace(text_[pos_])) {
+      ++pos_;
+    } else if (text_[pos_] == '/' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '/') {
+      const size_t newline = text_.find('\n', pos_);
+      pos_ = newline == std::string_view::npos ? text_.size() : newline + 1;
+    } else {
+      return;
+    }
+  }
+}
+
+KeyValuesReader::Token KeyValuesReader::ReadToken(std::string_view& text_out) {
+  for (;;) {
+    SkipWhitespaceAndComments();
+    if (pos_ >= text_.size()) {
+      return Token::kEnd;
+    }
+    const char ch = text_[pos_];
+    if (ch == '{') {
+      ++pos_;
+      return Token::kOpen;
+    }
+    if (ch == '}') {
+      ++pos_;
+      return Token::kClose;
+    }
+    if (ch == '"') {
+      const size_t begin = ++pos_;
+      while (pos_ < text_.size() && text_[pos_] != '"') {
+        pos_ += (text_[pos_] == '\\' && pos_ + 1 < text_.size()) ? 2 : 1;
+      }
+      if (pos_ >= text_.size()) {
+        return Token::kEnd;  // unterminated string
+      }
+      text_out = text_.substr(begin, pos_ - begin);
+      ++pos_;
+      return Token::kString;
+    }
+    const size_t begin = pos_;
+    while (pos_ < text_.size() && !IsSpace(text_[pos_]) && text_[pos_] != '"' && text_[pos_] != '{' &&
+           text_[pos_] != '}') {
+      ++pos_;
+    }
+    // Platform conditionals such as [$WIN32] trail a value; they are ignored.
+    if (text_[begin] == '[') {
+      continue;
+    }
+    text_out = text_.substr(begin, pos_ - begin);
+    return Token::kString;
+  }
+}
+
+bool KeyValuesEquals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (FoldAscii(a[i]) != FoldAscii(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool KeyValuesToUint32(std::string_view text, uint32_t& value_out) {
+  uint64_t value = 0;
+  if (!KeyValuesToUint64(text, value) || value > UINT32_MAX) {
+    return false;
+  }
+  value_out = static_cast<uint32_t>(value);
+  return true;
+}
+
+bool KeyValuesToUint64(std::string_view text, uint64_t& value_out) {
+  if (text.empty() || text.size() > 20) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (char ch : text) {
+    if (ch < '0' || ch > '9') {
+      return false;
+    }
+    const uint64_t digit = static_cast<uint64_t>(ch - '0');
+    if (value > (UINT64_MAX - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  value_out = value;
+  return true;
+}
+
+std::wstring KeyValuesToWide(std::string_view raw) {
+  std::wstring out;
+  out.reserve(raw.size());
+  size_t start = 0;
+  for (size_t i = 0; i < raw.size(); ++i) {
+    if (raw[i] != '\\' || i + 1 >= raw.size()) {
+      continue;
+    }
+    AppendWideFromUtf8(out, raw.substr(start, i - start));
+    const char escaped = raw[++i];
+    out += escaped == 'n' ? L'\n' : escaped == 't' ? L'\t' : static_cast<wchar_t>(escaped);
+    start = i + 1;
+  }
+  AppendWideFromUtf8(out, raw.substr(start));
+  return out;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace optiscaler {
+
+// Pull parser for Valve KeyValues text (libraryfolders.vdf, appmanifest_*.acf).
+// Keys and values are string_views into the caller's buffer with quotes
+// stripped but escapes left intact, so walking a file never allocates.
+// Use KeyValuesToWide() to materialize the few strings that are kept.
+class KeyValuesReader {
+ public:
+  enum class Event {
+    kValue,        // key() and value() are set
+    kBeginObject,  // key() names the object, depth() is now one deeper
+    kEndObject,
+    kEnd,
+    kError,
+  };
+
+  explicit KeyValuesReader(std::string_view text);
+
+  Event Next();
+  std::string_view key() const { return key_; }
+  std::string_view value() const { return value_; }
+  int depth() const { return depth_; }
+
+ private:
+  enum class Token { kString, kOpen, kClose, kEnd };
+
+  Token ReadToken(std::string_view& text_out);
+  void SkipWhitespaceAndComments();
+
+  std::string_view text_;
+  size_t pos_ = 0;
+  int depth_ = 0;
+  std::string_view key_;
+  std::string_view value_;
+};
+
+bool KeyValuesEquals(std::string_view a, std::string_view b);  // ASCII case-insensitive
+bool KeyValuesToUint32(std::string_view text, uint32_t& value_out);
+bool KeyValuesToUint64(std::string_view text, uint64_t& value_out);
+std::wstring KeyValuesToWide(std::string_view raw);  // UTF-8 decode + unescape
+
+}  // namespace optiscaler
@@ -1,7 +1,7 @@
 #include "launcher.h"
 
-#include <shellapi.h>
 #include <windows.h>
+#include <shellapi.h>
 
 namespace optiscaler {
 
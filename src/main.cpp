@@ -1,17 +1,40 @@
 #include <windows.h>
 #include <commctrl.h>
+#include <windowsx.h>
 
+#include <algorithm>
+#include <cwchar>
+#include <filesystem>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "cache.h"
+#include "cover_atlas.h"
 #include "cover_cache.h"
+#include "cover_mip_stage.h"
+#include "cover_mips.h"
+#include "decoded_cover_cache.h"
+#include "discovery.h"
+#include "game_catalog.h"
+#include "game_sort.h"
 #include "game_types.h"
+#include "grid_layout.h"
+#include "http_client.h"
+#include "http_scheduler.h"
 #include "igdb.h"
 #include "launcher.h"
+#include "perf_trace.h"
+#include "prefetch_scheduler.h"
 #include "renderer_factory.h"
 #include "resource.h"
+#include "scan_snapshot.h"
 #include "scanner.h"
+#include "search_index.h"
 #include "systeminfo.h"
 
 #pragma comment(lib, "comctl32.lib")
@@ -20,17 +43,88 @@ namespace optiscaler {
 namespace {
 
 constexpr wchar_t kWindowClass[] = L"OptiScalerMgrLiteWindow";
+constexpr UINT kMsgMipsReady = WM_APP + 1;
+constexpr UINT kMsgCoversReady = WM_APP + 2;  // lparam: new std::vector<size_t> of game indices
+constexpr UINT kMsgScanDone = WM_APP + 3;     // lparam: new std::vector<GameEntry>
+constexpr COLORREF kTileColor = RGB(48, 48, 48);
+constexpr COLORREF kLabelColor = RGB(32, 32, 32);
+constexpr COLORREF kSelectedColor = RGB(0, 120, 215);
+constexpr UINT_PTR kPerfTimerId = 1;
+constexpr UINT kPerfOverlayRefreshMs = 500;
+constexpr int kPerfOverlayWidth = 300;
+constexpr int kPerfOverlayLineHeight = 18;
+constexpr int kSearchBarHeight = 32;  // strip above the grid holding the search box
+constexpr size_t kMaxSearchResults = 500;  // ranked matches listed for a query
+constexpr int kSearchBoxWidth = 320;
 
 struct AppState {
-  std::vector<GameEntry> games;
+  GameCatalog catalog;
+  SearchIndex search{catalog};
+  std::vector<GameId> order;  // display order; grid indices point here
+  std::wstring query;  // search box text
+  GameFilter filter;
+  // Cover key and exe path by GameId, as of the last rescan; shared with
+  // prefetch workers.
+  std::shared_ptr<const std::vector<std::pair<uint64_t, std::wstring>>> cover_sources;
   size_t selected_index = 0;
   std::unique_ptr<IRenderer> renderer;
   HWND status_bar = nullptr;
+  HWND search_box = nullptr;
+  ScanSnapshot scan_snapshot;  // owned by scan_thread while scanning
+  bool scan_snapshot_loaded = false;
+  std::thread scan_thread;
+  bool scanning = false;
+  GameSortField sort_field = GameSortField::kName;
+  DecodedCoverCache covers;
+  std::vector<uint64_t> pinned_covers;  // sorted; keys this window holds one pin on
+  CoverAtlas atlas;
+  CoverMipStage mips;
+  std::unique_ptr<PrefetchScheduler> prefetch;
+  GridLayout grid;
+  DirtyRegion dirty;
+  ULONGLONG last_scroll_tick = 0;
+  bool perf_overlay = false;
+  // Every IGDB request goes through `http`, so searches and cover downloads
+  // share one set of per-host limits; members are destroyed bottom-up.
+  WinHttpClient http_transport;
+  HttpScheduler http_scheduler{http_transport};
+  ScheduledHttpClient http{http_scheduler, HttpPriority::kInteractive};
 };
 
+// settings.ini under the app data root:
+//   [Renderer]
+//   Preference=auto|d3d12|d3d11|software|gdi
+//   [Scan]
+//   SkipPatterns=launcher*;benchmark   ("name*" = file name prefix, else substring)
+// Missing keys read as empty.
+std::wstring ReadSetting(const wchar_t* section, const wchar_t* key) {
+  const std::wstring root = Cache::AppDataRoot();
+  if (root.empty()) {
+    return {};
+  }
+  const std::wstring path = (std::filesystem::path(root) / L"settings.ini").wstring();
+  wchar_t value[1024] = {};
+  const DWORD length =
+      GetPrivateProfileStringW(section, key, L"", value, static_cast<DWORD>(std::size(value)), path.c_str());
+  return std::wstring(value, length);
+}
+
+// An unknown or missing value keeps the software renderer.
 RendererPreference ParseRendererPreference() {
-  // TODO: Load renderer preference from persisted settings.
-  return RendererPreference::kGDI;
+  const std::wstring value = ReadSetting(L"Renderer", L"Preference");
+  static constexpr std::pair<const wchar_t*, RendererPreference> kNames[] = {
+      {L"auto", RendererPreference::kAuto},
+      {L"d3d12", RendererPreference::kD3D12},
+      {L"d3d11", RendererPreference::kD3D11},
+      {L"software", RendererPreference::kSoftware},
+      {L"gdi", RendererPreference::kGDI},
+  };
+  for (const auto& [name, preference] : kNames) {
+    if (_wcsicmp(value.c_str(), name) == 0) {
+      return preference;
+    }
+  }
+  return RendererPreference::kSoftware;
 }
 
 void UpdateStatusBar(AppState* state, const std::wstring& text) {
@@ -39,21 +133,155 @@ void UpdateStatusBar(AppState* state, const std::wstring& text) {
   }
 }
 
+RECT ToRect(const GridRect& rect) {
+  return {rect.left, rect.top, rect.right, rect.bottom};
+}
+
+GridRect ToGridRect(const RECT& rect) {
+  return {rect.left, rect.top, rect.right, rect.bottom};
+}
+
+// DecodedCoverCache key of the mip level drawn at the current tile size.
+uint64_t TileCoverKey(const AppState* state, GameId id) {
+  const GridMetrics& metrics = state->grid.metrics();
+  return CoverCache::DecodedKey(state->catalog.CoverKey(id), metrics.tileWidth, metrics.tileHeight);
+}
+
+void PaintGrid(IRenderer& renderer, AppState* state, const RECT& frame) {
+  if (state->order.empty()) {
+    const int top = state->grid.viewport().top + 16;
+    renderer.DrawText(state->catalog.empty() ? L"No games yet. Use File > Rescan." : L"No games match.", 16, top,
+                      RGB(255, 255, 255));
+  }
+  state->grid.ForEachTile(ToGridRect(frame), [&](size_t index, const GridRect&) {
+    const GameId id = state->order[index];
+    const bool selected = index == state->selected_index;
+    const GridRect cover = state->grid.CoverRect(index);
+    const GridRect label = state->grid.LabelRect(index);
+    renderer.FillSolid(ToRect(cover), kTileColor);
+    if (auto image = state->covers.Peek(TileCoverKey(state, id))) {
+      renderer.DrawImage(*image, cover.left + (cover.width() - image->width) / 2,
+                         cover.top + (cover.height() - image->height) / 2);
+    }
+    renderer.FillSolid(ToRect(label), selected ? kSelectedColor : kLabelColor);
+    renderer.DrawLabel(state->catalog.Name(id), label.left + 4, label.top + 4, label.width() - 8,
+                       RGB(255, 255, 255));
+    PerfTrace::Default().Add(PerfCounter::kTilesRedrawn, 1);
+  });
+}
+
+GridRect PerfOverlayRect(const AppState* state) {
+  const GridRect viewport = state->grid.viewport();
+  const int top = viewport.top + 8;
+  return GridRect{viewport.right - kPerfOverlayWidth - 8, top, viewport.right - 8,
+                  top + 2 * kPerfOverlayLineHeight + 8}
+      .Intersect(viewport);
+}
+
+void DrawPerfOverlay(IRenderer& renderer, const AppState* state) {
+  const FrameStats stats = PerfTrace::Default().Frames();
+  const GridRect rect = PerfOverlayRect(state);
+  wchar_t timing[128];
+  std::swprintf(timing, 128, L"frame %.2f ms   p50 %.2f   p99 %.2f", stats.lastMs, stats.p50Ms, stats.p99Ms);
+  auto counter = [&stats](PerfCounter which) {
+    return static_cast<unsigned long long>(stats.counters[static_cast<size_t>(which)]);
+  };
+  wchar_t counters[128];
+  std::swprintf(counters, 128, L"draws %llu   tiles %llu   blit %llu KB", counter(PerfCounter::kDrawCalls),
+                counter(PerfCounter::kTilesRedrawn), counter(PerfCounter::kBytesBlitted) / 1024);
+  renderer.FillSolid(ToRect(rect), RGB(0, 0, 0));
+  renderer.DrawLabel(timing, rect.left + 8, rect.top + 4, rect.width() - 16, RGB(0, 255, 128));
+  renderer.DrawLabel(counters, rect.left + 8, rect.top + 4 + kPerfOverlayLineHeight, rect.width() - 16,
+                     RGB(0, 255, 128));
+}
+
+// Repaints only the tiles intersecting the invalid region.
 void OnPaint(HWND hwnd, AppState* state) {
+  PerfTrace& trace = PerfTrace::Default();
+  trace.BeginFrame();
   PAINTSTRUCT ps;
   BeginPaint(hwnd, &ps);
-  RECT rc;
-  GetClientRect(hwnd, &rc);
-  if (!state->renderer) {
-    EndPaint(hwnd, &ps);
-    return;
+  if (state->renderer) {
+    PerfScope scope("OnPaint");
+    IRenderer& renderer = *state->renderer;
+    RECT frame;
+    {
+      PerfScope begin("IRenderer::Begin");
+      frame = renderer.Begin(ps.rcPaint);
+    }
+    PaintGrid(renderer, state, frame);
+    if (state->perf_overlay) {
+      DrawPerfOverlay(renderer, state);
+    }
+    PerfScope end("IRenderer::End");
+    renderer.End();
   }
-  state->renderer->Resize(rc.right - rc.left, rc.bottom - rc.top);
-  state->renderer->Begin();
-  std::wstring message = L"OptiScaler Manager Lite (skeleton UI)";
-  state->renderer->DrawText(message, 16, 16, RGB(255, 255, 255));
-  state->renderer->End();
   EndPaint(hwnd, &ps);
+  trace.EndFrame();
+}
+
+// Invalidates each merged dirty rect instead of the whole client area.
+void FlushDirty(HWND hwnd, AppState* state) {
+  for (const GridRect& rect : state->dirty.rects()) {
+    const RECT rc = ToRect(rect);
+    InvalidateRect(hwnd, &rc, FALSE);
+  }
+  state->dirty.Clear();
+}
+
+void InvalidateTile(AppState* state, size_t index) {
+  if (state->grid.IsVisible(index)) {
+    state->dirty.Add(state->grid.TileRect(index).Intersect(state->grid.viewport()));
+  }
+}
+
+// Keeps exactly one pin on each visible tile's cover, so prefetching ahead
+// of a scroll cannot evict what is on screen. Covers still being decoded
+// are pinned when kMsgCoversReady calls this again; covers prefetched but
+// evicted before they came into view are queued to load again.
+void UpdatePins(AppState* state) {
+  const auto [first, last] = state->grid.VisibleRange();
+  std::vector<uint64_t> visible;
+  visible.reserve(last - first);
+  for (size_t i = first; i < last && i < state->order.size(); ++i) {
+    visible.push_back(TileCoverKey(state, state->order[i]));
+  }
+  std::sort(visible.begin(), visible.end());
+  visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+
+  for (uint64_t key : state->pinned_covers) {
+    if (!std::binary_search(visible.begin(), visible.end(), key)) {
+      state->covers.Unpin(key);
+    }
+  }
+  std::vector<uint64_t> pinned;
+  pinned.reserve(visible.size());
+  for (uint64_t key : visible) {
+    if (std::binary_search(state->pinned_covers.begin(), state->pinned_covers.end(), key) ||
+        state->covers.Pin(key)) {
+      pinned.push_back(key);
+    }
+  }
+  state->pinned_covers = std::move(pinned);
+
+  if (state->prefetch) {
+    std::vector<size_t> missing;
+    for (size_t i = first; i < last && i < state->order.size(); ++i) {
+      const uint64_t key = TileCoverKey(state, state->order[i]);
+      if (!std::binary_search(state->pinned_covers.begin(), state->pinned_covers.end(), key)) {
+        missing.push_back(i);
+      }
+    }
+    state->prefetch->Requeue(missing);
+  }
+}
+
+void OnViewportChanged(AppState* state, double velocity) {
+  UpdatePins(state);
+  if (state->prefetch) {
+    const auto [first, last] = state->grid.VisibleRange();
+    state->prefetch->SetViewport(first, last, velocity);
+  }
 }
 
 void OnSize(HWND hwnd, AppState* state, UINT width, UINT height) {
@@ -66,6 +294,256 @@ void OnSize(HWND hwnd, AppState* state, UINT width, UINT height) {
   if (state && state->renderer) {
     state->renderer->Resize(width, height);
   }
+  if (state && state->search_box) {
+    const int box_width = std::min(kSearchBoxWidth, static_cast<int>(width) - 16);
+    MoveWindow(state->search_box, 8, 4, std::max(0, box_width), kSearchBarHeight - 8, TRUE);
+  }
+  if (state) {
+    const int grid_height = std::max(0, static_cast<int>(height) - kSearchBarHeight);
+    state->grid.SetViewport(static_cast<int>(width), grid_height, kSearchBarHeight);
+    OnViewportChanged(state, 0.0);
+  }
+}
+
+void OnMouseWheel(HWND hwnd, AppState* state, int wheel_delta) {
+  // The retained frame and the window must agree before both are shifted.
+  UpdateWindow(hwnd);
+  const int pixels = -wheel_delta * state->grid.rowPitch() / (2 * WHEEL_DELTA);
+  const int before = state->grid.scroll();
+  if (!state->grid.ScrollBy(pixels)) {
+    return;
+  }
+  // Items per second, for the prefetch look-ahead.
+  const ULONGLONG now = GetTickCount64();
+  const double seconds = std::clamp(static_cast<double>(now - state->last_scroll_tick), 16.0, 250.0) / 1000.0;
+  state->last_scroll_tick = now;
+  const double rows = static_cast<double>(state->grid.scroll() - before) / state->grid.rowPitch();
+  OnViewportChanged(state, rows * static_cast<double>(state->grid.columns()) / seconds);
+  // Only the uncovered band is repainted.
+  const RECT area = ToRect(state->grid.viewport());
+  const int dy = before - state->grid.scroll();
+  if (state->renderer && state->renderer->Scroll(area, dy)) {
+    ScrollWindowEx(hwnd, 0, dy, &area, &area, nullptr, nullptr, SW_INVALIDATE);
+  } else {
+    InvalidateRect(hwnd, &area, FALSE);
+  }
+}
+
+void OnClick(HWND hwnd, AppState* state, int x, int y) {
+  const std::optional<size_t> hit = state->grid.HitTest(x, y);
+  if (!hit || *hit == state->selected_index) {
+    return;
+  }
+  InvalidateTile(state, state->selected_index);
+  state->selected_index = *hit;
+  InvalidateTile(state, *hit);
+  FlushDirty(hwnd, state);
+}
+
+// Workers read cover keys and exe paths from this copy; the catalog stays
+// on the UI thread. Taken once per rescan so reordering stays cheap.
+void SnapshotCoverSources(AppState* state) {
+  auto sources = std::make_shared<std::vector<std::pair<uint64_t, std::wstring>>>();
+  for (GameId id : state->catalog.ids()) {
+    if (id >= sources->size()) {
+      sources->resize(static_cast<size_t>(id) + 1);
+    }
+    (*sources)[id] = {state->catalog.CoverKey(id), state->catalog.Exe(id)};
+  }
+  state->cover_sources = std::move(sources);
+}
+
+// Indices refer to `order`, so this runs whenever the order changes.
+void RestartPrefetch(AppState* state) {
+  if (!state->prefetch) {
+    return;
+  }
+  auto order = std::make_shared<const std::vector<GameId>>(state->order);
+  auto sources = state->cover_sources;
+  DecodedCoverCache* covers = &state->covers;
+  const CoverAtlas* atlas = &state->atlas;
+  const PrefetchScheduler* prefetch = state->prefetch.get();
+  const int tile_width = state->grid.metrics().tileWidth;
+  const int tile_height = state->grid.metrics().tileHeight;
+  state->prefetch->Reset(order->size(), [=](size_t index) {
+    // Picked before the user scrolled on; not worth a decode any more.
+    if (!prefetch->IsWanted(index)) {
+      return false;
+    }
+    const auto& [key, exe] = (*sources)[(*order)[index]];
+    return CoverCache::Acquire(*covers, atlas, key, exe, tile_width, tile_height) != nullptr;
+  });
+}
+
+// Ctrl+wheel steps the tiles through the cover mip sizes; each level is
+// read straight from the atlas.
+void OnZoom(HWND hwnd, AppState* state, int wheel_delta) {
+  GridMetrics metrics = state->grid.metrics();
+  const int current = CoverMips::LevelForTile(metrics.tileWidth, metrics.tileHeight);
+  const int level = std::clamp(current + (wheel_delta < 0 ? 1 : -1), 0, CoverMips::kLevels - 1);
+  if (CoverMips::LevelWidth(level) == metrics.tileWidth && CoverMips::LevelHeight(level) == metrics.tileHeight) {
+    return;
+  }
+  metrics.tileWidth = CoverMips::LevelWidth(level);
+  metrics.tileHeight = CoverMips::LevelHeight(level);
+  state->grid.SetMetrics(metrics);
+  OnViewportChanged(state, 0.0);
+  RestartPrefetch(state);
+  InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+// Rebuilds `order` from the search box and the filter menu: ranked matches
+// while the query has terms, otherwise every game passing the filter in
+// sort order.
+void RefreshOrder(HWND hwnd, AppState* state) {
+  if (!SearchIndex::HasTerms(state->query)) {
+    state->order = state->catalog.Filter(state->filter);
+    state->catalog.Sort(state->order, state->sort_field);
+  } else {
+    state->order = state->search.Search(state->query, state->filter, kMaxSearchResults);
+  }
+  state->selected_index = 0;
+  state->grid.SetItemCount(state->order.size());
+  state->grid.SetScroll(0);
+  OnViewportChanged(state, 0.0);
+  RestartPrefetch(state);
+  InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+void ShowMatchCount(AppState* state) {
+  UpdateStatusBar(state, std::to_wstring(state->order.size()) + L" of " + std::to_wstring(state->catalog.size()) +
+                             L" games shown.");
+}
+
+void OnSearchChanged(HWND hwnd, AppState* state) {
+  const int length = GetWindowTextLengthW(state->search_box);
+  std::wstring query(static_cast<size_t>(length) + 1, L'\0');
+  query.resize(static_cast<size_t>(GetWindowTextW(state->search_box, query.data(), length + 1)));
+  if (query == state->query) {
+    return;
+  }
+  state->query = std::move(query);
+  RefreshOrder(hwnd, state);
+  ShowMatchCount(state);
+}
+
+void ApplySort(HWND hwnd, AppState* state, int command) {
+  static constexpr GameSortField kFields[] = {GameSortField::kName, GameSortField::kSource,
+                                              GameSortField::kLastPlayed, GameSortField::kSize};
+  state->sort_field = kFields[command - IDM_VIEW_SORT_NAME];
+  // Search results keep their ranking; the sort applies once the box is
+  // cleared.
+  if (!SearchIndex::HasTerms(state->query)) {
+    state->catalog.Sort(state->order, state->sort_field);
+    RestartPrefetch(state);
+  }
+  CheckMenuRadioItem(GetMenu(hwnd), IDM_VIEW_SORT_NAME, IDM_VIEW_SORT_SIZE, command, MF_BYCOMMAND);
+  InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+void ApplyFilter(HWND hwnd, AppState* state, int command) {
+  static constexpr GameSource kSources[] = {GameSource::kSteam, GameSource::kEpic, GameSource::kXbox,
+                                            GameSource::kCustom};
+  HMENU menu = GetMenu(hwnd);
+  if (command <= IDM_FILTER_CUSTOM) {
+    const uint8_t bit = static_cast<uint8_t>(1u << static_cast<unsigned>(kSources[command - IDM_FILTER_STEAM]));
+    state->filter.sources ^= bit;
+    CheckMenuItem(menu, command, MF_BYCOMMAND | (state->filter.sources & bit ? MF_CHECKED : MF_UNCHECKED));
+  } else {
+    state->filter.required = command == IDM_FILTER_INJECT_ON ? kGameInjectEnabled : 0;
+    state->filter.excluded = command == IDM_FILTER_INJECT_OFF ? kGameInjectEnabled : 0;
+    CheckMenuRadioItem(menu, IDM_FILTER_INJECT_ANY, IDM_FILTER_INJECT_OFF, command, MF_BYCOMMAND);
+  }
+  RefreshOrder(hwnd, state);
+  ShowMatchCount(state);
+}
+
+// The overlay also turns tracing on; it refreshes on a timer rather than
+// every frame so it does not keep the window repainting.
+void TogglePerfOverlay(HWND hwnd, AppState* state) {
+  state->perf_overlay = !state->perf_overlay;
+  PerfTrace::Default().SetEnabled(state->perf_overlay);
+  CheckMenuItem(GetMenu(hwnd), IDM_VIEW_PERF_OVERLAY, MF_BYCOMMAND | (state->perf_overlay ? MF_CHECKED : MF_UNCHECKED));
+  if (state->perf_overlay) {
+    SetTimer(hwnd, kPerfTimerId, kPerfOverlayRefreshMs, nullptr);
+  } else {
+    KillTimer(hwnd, kPerfTimerId);
+  }
+  const RECT rc = ToRect(PerfOverlayRect(state));
+  InvalidateRect(hwnd, &rc, FALSE);
+}
+
+void ExportTrace(HWND hwnd, AppState* state) {
+  if (!PerfTrace::Default().enabled()) {
+    MessageBoxW(hwnd, L"Turn on View > Performance Overlay to record a trace first.", L"OptiScaler Manager Lite",
+                MB_ICONINFORMATION);
+    return;
+  }
+  const std::wstring root = Cache::AppDataRoot();
+  std::filesystem::path path(root);
+  path /= L"logs";
+  if (root.empty() || !Cache::EnsureDirectory(path.wstring())) {
+    UpdateStatusBar(state, L"Trace export failed: no log folder.");
+    return;
+  }
+  path /= L"paint_trace.json";
+  if (PerfTrace::Default().ExportChromeTrace(path.wstring())) {
+    UpdateStatusBar(state, L"Trace written to " + path.wstring());
+  } else {
+    UpdateStatusBar(state, L"Trace export failed.");
+  }
+}
+
+// Discovery and the snapshot I/O run on scan_thread; the catalog is only
+// touched on the UI thread, in OnScanDone.
+void StartRescan(HWND hwnd, AppState* state) {
+  if (state->scanning) {
+    return;
+  }
+  state->scanning = true;
+  UpdateStatusBar(state, L"Scanning for games...");
+  state->scan_thread = std::thread([hwnd, state] {
+    const std::wstring snapshot_path = ScanSnapshot::DefaultPath();
+    if (!state->scan_snapshot_loaded) {
+      state->scan_snapshot.Load(snapshot_path);
+      state->scan_snapshot_loaded = true;
+    }
+    DiscoveryOptions options;
+    options.scan.snapshot = &state->scan_snapshot;
+    options.scan.extraSkipPatterns = Scanner::SplitPatterns(ReadSetting(L"Scan", L"SkipPatterns"));
+    auto* games = new std::vector<GameEntry>(DiscoveryPipeline::Default({}).Run(options));
+    state->scan_snapshot.Save(snapshot_path);
+    if (!PostMessageW(hwnd, kMsgScanDone, 0, reinterpret_cast<LPARAM>(games))) {
+      delete games;
+    }
+  });
+}
+
+void OnScanDone(HWND hwnd, AppState* state, std::unique_ptr<std::vector<GameEntry>> games) {
+  state->scan_thread.join();
+  state->scanning = false;
+  const CatalogDelta delta = state->catalog.Sync(*games);
+  state->search.Apply(delta);
+  // Removed ids are gone from the catalog; the previous snapshot still has
+  // their cover keys, so their blobs can be released before collecting.
+  if (state->cover_sources) {
+    for (GameId id : delta.removed) {
+      if (id < state->cover_sources->size()) {
+        CoverCache::Blobs().Unlink((*state->cover_sources)[id].first);
+      }
+    }
+  }
+  SnapshotCoverSources(state);
+  CoverCache::Blobs().CollectGarbage();
+  CoverCache::Blobs().Save();
+  state->mips.Start(*games, state->atlas, [hwnd] { PostMessageW(hwnd, kMsgMipsReady, 0, 0); });
+  if (state->mips.pending() == 0) {
+    state->atlas.CompactInBackground();  // otherwise once kMsgMipsReady sees the stage drained
+  }
+  RefreshOrder(hwnd, state);
+  UpdateStatusBar(state, L"Found " + std::to_wstring(state->catalog.size()) + L" games (" +
+                             std::to_wstring(delta.added.size()) + L" new, " + std::to_wstring(delta.removed.size()) +
+                             L" removed).");
 }
 
 void OnCommand(HWND hwnd, AppState* state, WPARAM wparam) {
@@ -74,19 +552,41 @@ void OnCommand(HWND hwnd, AppState* state, WPARAM wparam) {
     case IDM_FILE_EXIT:
       PostMessageW(hwnd, WM_CLOSE, 0, 0);
       break;
-    case IDM_FILE_RESCAN: {
-      auto defaults = Scanner::DefaultFolders();
-      state->games = Scanner::ScanAll(defaults);
-      UpdateStatusBar(state, L"Rescan completed (placeholder).");
-      InvalidateRect(hwnd, nullptr, TRUE);
+    case IDM_FILE_RESCAN:
+      StartRescan(hwnd, state);
+      break;
+    case IDM_VIEW_SORT_NAME:
+    case IDM_VIEW_SORT_SOURCE:
+    case IDM_VIEW_SORT_LAST_PLAYED:
+    case IDM_VIEW_SORT_SIZE:
+      ApplySort(hwnd, state, command);
+      break;
+    case IDM_FILTER_STEAM:
+    case IDM_FILTER_EPIC:
+    case IDM_FILTER_XBOX:
+    case IDM_FILTER_CUSTOM:
+    case IDM_FILTER_INJECT_ANY:
+    case IDM_FILTER_INJECT_ON:
+    case IDM_FILTER_INJECT_OFF:
+      ApplyFilter(hwnd, state, command);
+      break;
+    case IDC_SEARCH_BOX:
+      if (HIWORD(wparam) == EN_CHANGE) {
+        OnSearchChanged(hwnd, state);
+      }
+      break;
+    case IDM_VIEW_PERF_OVERLAY:
+      TogglePerfOverlay(hwnd, state);
       break;
-    }
     case IDM_TOOLS_SETTINGS:
       MessageBoxW(hwnd, L"Settings dialog not yet implemented.", L"OptiScaler Manager Lite", MB_ICONINFORMATION);
       break;
     case IDM_HELP_LOGS:
       MessageBoxW(hwnd, L"Log folder opening not yet implemented.", L"OptiScaler Manager Lite", MB_ICONINFORMATION);
       break;
+    case IDM_HELP_EXPORT_TRACE:
+      ExportTrace(hwnd, state);
+      break;
     default:
       break;
   }
@@ -109,6 +609,20 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
       InitCommonControlsEx(&icc);
 
       state->status_bar = CreateStatusWindowW(WS_CHILD | WS_VISIBLE, L"Ready", hwnd, IDC_STATUS_BAR);
+      // Filters as you type; EN_CHANGE arrives through WM_COMMAND.
+      state->search_box = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL, 0, 0,
+                                          0, 0, hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_SEARCH_BOX)),
+                                          create->hInstance, nullptr);
+      SendMessageW(state->search_box, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT)), FALSE);
+      SendMessageW(state->search_box, EM_SETCUEBANNER, FALSE, reinterpret_cast<LPARAM>(L"Search games"));
+      state->atlas.Open(CoverAtlas::DefaultPath());
+      IGDB::ConfigureLimits(state->http_scheduler);
+      state->prefetch = std::make_unique<PrefetchScheduler>([hwnd](std::vector<size_t> ready) {
+        auto* batch = new std::vector<size_t>(std::move(ready));
+        if (!PostMessageW(hwnd, kMsgCoversReady, 0, reinterpret_cast<LPARAM>(batch))) {
+          delete batch;
+        }
+      });
       state->renderer = CreateRenderer(ParseRendererPreference(), hwnd);
       if (!state->renderer) {
         MessageBoxW(hwnd, L"Failed to initialize renderer.", L"OptiScaler Manager Lite", MB_ICONERROR);
@@ -126,7 +640,63 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     case WM_PAINT:
       OnPaint(hwnd, state);
       break;
+    case WM_ERASEBKGND:
+      return 1;  // Begin() clears the dirty rect
+    case WM_MOUSEWHEEL:
+      if (GET_KEYSTATE_WPARAM(wparam) & MK_CONTROL) {
+        OnZoom(hwnd, state, GET_WHEEL_DELTA_WPARAM(wparam));
+      } else {
+        OnMouseWheel(hwnd, state, GET_WHEEL_DELTA_WPARAM(wparam));
+      }
+      break;
+    case WM_LBUTTONDOWN:
+      OnClick(hwnd, state, GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam));
+      break;
+    case kMsgCoversReady: {
+      std::unique_ptr<std::vector<size_t>> ready(reinterpret_cast<std::vector<size_t>*>(lparam));
+      if (ready) {
+        UpdatePins(state);
+        for (size_t index : *ready) {
+          InvalidateTile(state, index);
+        }
+        FlushDirty(hwnd, state);
+      }
+      break;
+    }
+    case WM_TIMER:
+      if (wparam == kPerfTimerId) {
+        const RECT rc = ToRect(PerfOverlayRect(state));
+        InvalidateRect(hwnd, &rc, FALSE);
+      }
+      break;
+    case kMsgScanDone: {
+      std::unique_ptr<std::vector<GameEntry>> games(reinterpret_cast<std::vector<GameEntry>*>(lparam));
+      OnScanDone(hwnd, state, std::move(games));
+      break;
+    }
+    case kMsgMipsReady: {
+      // Read before draining: zero means every batch is already queued for
+      // this Drain, so no later append can invalidate the compaction.
+      const bool finished = state->mips.pending() == 0;
+      if (state->mips.Drain(state->atlas, &state->covers) > 0) {
+        // Drain evicted the rebuilt covers, pins included; load them again.
+        auto& pinned = state->pinned_covers;
+        pinned.erase(std::remove_if(pinned.begin(), pinned.end(),
+                                    [state](uint64_t key) { return !state->covers.Contains(key); }),
+                     pinned.end());
+        UpdatePins(state);
+        InvalidateRect(hwnd, nullptr, FALSE);
+      }
+      if (finished) {
+        state->atlas.CompactInBackground();
+      }
+      break;
+    }
     case WM_DESTROY:
+      if (state && state->scan_thread.joinable()) {
+        state->scan_thread.join();  // its kMsgScanDone is dropped with the queue
+      }
+      CoverCache::Blobs().Save();
       PostQuitMessage(0);
       break;
     default:
@@ -155,21 +725,30 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE, _In_ LPWSTR,
     menu = CreateMenu();
   }
 
-  AppState state;
-  HWND hwnd = CreateWindowExW(0, kWindowClass, L"OptiScaler Manager Lite", WS_OVERLAPPEDWINDOW,
-                              CW_USEDEFAULT, CW_USEDEFAULT, 1280, 720, nullptr, menu, instance, &state);
-  if (!hwnd) {
-    return 0;
-  }
-  ShowWindow(hwnd, cmd_show);
-  UpdateWindow(hwnd);
+  // WIC decoding and the renderers created in WM_CREATE need COM, and
+  // AppState still holds COM objects when it is destroyed.
+  const HRESULT com = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+  int exit_code = 0;
+  {
+    AppState state;
+    HWND hwnd = CreateWindowExW(0, kWindowClass, L"OptiScaler Manager Lite", WS_OVERLAPPEDWINDOW | WS_CLIPCHILDREN,
+                                CW_USEDEFAULT, CW_USEDEFAULT, 1280, 720, nullptr, menu, instance, &state);
+    if (hwnd) {
+      ShowWindow(hwnd, cmd_show);
+      UpdateWindow(hwnd);
 
-  MSG msg = {};
-  while (GetMessageW(&msg, nullptr, 0, 0)) {
-    TranslateMessage(&msg);
-    DispatchMessageW(&msg);
+      MSG msg = {};
+      while (GetMessageW(&msg, nullptr, 0, 0)) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+      }
+      exit_code = static_cast<int>(msg.wParam);
+    }
+  }
+  if (SUCCEEDED(com)) {
+    CoUninitialize();
   }
-  return static_cast<int>(msg.wParam);
+  return exit_code;
 }
 
 }  // namespace
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace optiscaler {
+
+// Read-only memory mapping of a whole file. Empty files open successfully
+// with an empty view. Other handles may keep writing to the file (CoverAtlas
+// appends in place); the view keeps the size it was opened with.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool Open(const std::wstring& path);
+  void Close();
+
+  std::string_view view() const { return std::string_view(data_, size_); }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace optiscaler
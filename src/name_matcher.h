@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace optiscaler {
+
+// Patterns and input are case-folded over a small ASCII alphabet. Any other
+// code unit breaks a match, so matching never needs a lowered copy. The
+// alphabet is ASCII-only by design: every built-in pattern is ASCII, and a
+// non-ASCII input character can never be part of an ASCII match. Patterns
+// with other characters are rejected by Add().
+constexpr size_t kMatcherSymbols = 40;  // a-z, 0-9, '_', '-', '.', ' '
+constexpr uint8_t kNoSymbol = 0xFF;
+constexpr uint8_t kNoMatch = 0xFF;
+
+constexpr uint8_t MatcherSymbol(wchar_t ch) {
+  if (ch >= L'a' && ch <= L'z') {
+    return static_cast<uint8_t>(ch - L'a');
+  }
+  if (ch >= L'A' && ch <= L'Z') {
+    return static_cast<uint8_t>(ch - L'A');
+  }
+  if (ch >= L'0' && ch <= L'9') {
+    return static_cast<uint8_t>(26 + (ch - L'0'));
+  }
+  switch (ch) {
+    case L'_':
+      return 36;
+    case L'-':
+      return 37;
+    case L'.':
+      return 38;
+    case L' ':
+      return 39;
+    default:
+      return kNoSymbol;
+  }
+}
+
+// Prefix trie plus Aho-Corasick automaton over the same pattern set. Every
+// member function is constexpr, so built-in lists are compiled into static
+// tables; the scanner's user skip patterns (settings.ini [Scan]
+// SkipPatterns) are built with the same code at runtime.
+template <size_t MaxStates>
+class PatternMatcher {
+  static_assert(MaxStates > 0 && MaxStates <= 0xFFFF, "state ids are 16-bit");
+
+ public:
+  constexpr PatternMatcher() {
+    for (auto& id : terminal_) {
+      id = kNoMatch;
+    }
+    for (auto& id : best_) {
+      id = kNoMatch;
+    }
+  }
+
+  // `id` orders patterns: FindFirst() reports the lowest id present.
+  constexpr bool Add(std::wstring_view pattern, uint8_t id) {
+    if (built_ || pattern.empty() || id == kNoMatch) {
+      return ok_ = false;
+    }
+    uint16_t state = 0;
+    for (wchar_t ch : pattern) {
+      const uint8_t symbol = MatcherSymbol(ch);
+      if (symbol == kNoSymbol) {
+        return ok_ = false;
+      }
+      if (trie_[state][symbol] == 0) {
+        if (count_ >= MaxStates) {
+          return ok_ = false;
+        }
+        trie_[state][symbol] = count_++;
+      }
+      state = trie_[state][symbol];
+    }
+    if (id < terminal_[state]) {
+      terminal_[state] = id;
+    }
+    return true;
+  }
+
+  // Breadth-first pass that fills failure links and the full goto table.
+  constexpr void Build() {
+    uint16_t queue[MaxStates] = {};
+    size_t head = 0;
+    size_t tail = 0;
+    for (size_t symbol = 0; symbol < kMatcherSymbols; ++symbol) {
+      const uint16_t child = trie_[0][symbol];
+      goto_[0][symbol] = child;
+      if (child != 0) {
+        fail_[child] = 0;
+        queue[tail++] = child;
+      }
+    }
+    while (head < tail) {
+      const uint16_t state = queue[head++];
+      const uint8_t inherited = best_[fail_[state]];
+      best_[state] = terminal_[state] < inherited ? terminal_[state] : inherited;
+      for (size_t symbol = 0; symbol < kMatcherSymbols; ++symbol) {
+        const uint16_t child = trie_[state][symbol];
+        if (child != 0) {
+          fail_[child] = goto_[fail_[state]][symbol];
+          goto_[state][symbol] = child;
+          queue[tail++] = child;
+        } else {
+          goto_[state][symbol] = goto_[fail_[state]][symbol];
+        }
+      }
+    }
+    built_ = true;
+  }
+
+  constexpr bool ok() const { return ok_ && built_; }
+  constexpr bool empty() const { return count_ == 1; }
+
+  constexpr bool MatchesPrefix(std::wstring_view text) const {
+    uint16_t state = 0;
+    for (wchar_t ch : text) {
+      if (terminal_[state] != kNoMatch) {
+        return true;
+      }
+      const uint8_t symbol = MatcherSymbol(ch);
+      if (symbol == kNoSymbol) {
+        return false;
+      }
+      state = trie_[state][symbol];
+      if (state == 0) {
+        return false;
+      }
+    }
+    return terminal_[state] != kNoMatch;
+  }
+
+  constexpr bool Contains(std::wstring_view text) const {
+    uint16_t state = 0;
+    for (wchar_t ch : text) {
+      const uint8_t symbol = MatcherSymbol(ch);
+      state = symbol == kNoSymbol ? 0 : goto_[state][symbol];
+      if (best_[state] != kNoMatch) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Lowest pattern id occurring anywhere in `text`, or kNoMatch.
+  constexpr uint8_t FindFirst(std::wstring_view text) const {
+    uint16_t state = 0;
+    uint8_t best = kNoMatch;
+    for (wchar_t ch : text) {
+      const uint8_t symbol = MatcherSymbol(ch);
+      state = symbol == kNoSymbol ? 0 : goto_[state][symbol];
+      if (best_[state] < best) {
+        best = best_[state];
+      }
+    }
+    return best;
+  }
+
+ private:
+  uint16_t trie_[MaxStates][kMatcherSymbols] = {};
+  uint16_t goto_[MaxStates][kMatcherSymbols] = {};
+  uint16_t fail_[MaxStates] = {};
+  uint8_t terminal_[MaxStates] = {};  // pattern ending exactly here
+  uint8_t best_[MaxStates] = {};      // lowest pattern ending here or at any suffix state
+  uint16_t count_ = 1;
+  bool ok_ = true;
+  bool built_ = false;
+};
+
+template <size_t MaxStates, size_t N>
+constexpr PatternMatcher<MaxStates> BuildMatcher(const std::wstring_view (&patterns)[N]) {
+  static_assert(N < kNoMatch, "pattern ids are 8-bit");
+  PatternMatcher<MaxStates> matcher;
+  for (size_t i = 0; i < N; ++i) {
+    matcher.Add(patterns[i], static_cast<uint8_t>(i));
+  }
+  matcher.Build();
+  return matcher;
+}
+
+}  // namespace optiscaler
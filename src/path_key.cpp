@@ -0,0 +1,261 @@
+#include "path_key.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr wchar_t kSeparator = std::filesystem::path::preferred_separator;
+constexpr size_t kMinSlots = 64;
+
+bool NeedsSeparator(std::wstring_view directory, std::wstring_view name) {
+  return !directory.empty() && !name.empty() && !IsPathSeparator(directory.back());
+}
+
+bool EqualsFolded(const wchar_t* stored, std::wstring_view text) {
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (std::towlower(stored[i]) != std::towlower(text[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+uint64_t HashJoinedPath(std::wstring_view directory, std::wstring_view name) {
+  return HashJoinedPath(HashPath(directory), directory, name);
+}
+
+uint64_t HashJoinedPath(uint64_t directory_hash, std::wstring_view directory, std::wstring_view name) {
+  uint64_t hash = directory_hash;
+  if (NeedsSeparator(directory, name)) {
+    hash = HashPathAppend(hash, std::wstring_view(&kSeparator, 1));
+  }
+  return HashPathAppend(hash, name);
+}
+
+std::wstring_view PathArena::Store(std::wstring_view directory, std::wstring_view name) {
+  const bool separator = NeedsSeparator(directory, name);
+  const size_t length = directory.size() + (separator ? 1 : 0) + name.size();
+  wchar_t* out = Reserve(length);
+  std::memcpy(out, directory.data(), directory.size() * sizeof(wchar_t));
+  size_t offset = directory.size();
+  if (separator) {
+    out[offset++] = kSeparator;
+  }
+  std::memcpy(out + offset, name.data(), name.size() * sizeof(wchar_t));
+  return std::wstring_view(out, length);
+}
+
+wchar_t* PathArena::Reserve(size_t count) {
+  if (count > kChunkChars) {
+    // Oversized paths get a dedicated chunk.
+    chunks_.emplace_back(std::make_unique<wchar_t[]>(count));
+    used_ = kChunkChars;
+    return chunks_.back().get();
+  }
+  if (chunks_.empty() || kChunkChars - used_ < count) {
+    chunks_.emplace_back(std::make_unique<wchar_t[]>(kChunkChars));
+    used_ = 0;
+  }
+  wchar_t* out = chunks_.back().get() + used_;
+  used_ += count;
+  return out;
+}
+
+PathKeySet::PathKeySet(size_t expected) {
+  size_t capacity = kMinSlots;
+  while (capacity < expected * 2) {
+    capacity *= 2;
+  }
+  slots_.resize(capacity);
+}
+
+bool PathKeySet::Insert(std::wstring_view path) {
+  return Insert(HashPath(path), path, {});
+}
+
+bool PathKeySet::Insert(uint64_t hash, std::wstring_view directory, std::wstring_view name) {
+  if ((size_ + 1) * 4 > slots_.size() * 3) {
+    Grow();
+  }
+  const size_t index = Find(hash, directory, name);
+  Slot& slot = slots_[index];
+  if (slot.data) {
+    return false;
+  }
+  const std::wstring_view stored = arena_.Store(directory, name);
+  slot.hash = hash;
+  slot.data = stored.data();
+  slot.length = stored.size();
+  ++size_;
+  return true;
+}
+
+bool PathKeySet::Contains(std::wstring_view path) const {
+  return slots_[Find(HashPath(path), path, {})].data != nullptr;
+}
+
+// Linear probe to the matching slot, or the first empty one.
+size_t PathKeySet::Find(uint64_t hash, std::wstring_view directory, std::wstring_view name) const {
+  const bool separator = NeedsSeparator(directory, name);
+  const size_t length = directory.size() + (separator ? 1 : 0) + name.size();
+  const size_t mask = slots_.size() - 1;
+  for (size_t index = static_cast<size_t>(hash) & mask;; index = (index + 1) & mask) {
+    const Slot& slot = slots_[index];
+    if (!slot.data) {
+      return index;
+    }
+    if (slot.hash != hash || slot.length != length) {
+      continue;
+    }
+    const wchar_t* stored = slot.data;
+    if (!EqualsFolded(stored, directory)) {
+      continue;
+    }
+    stored += directory.size();
+    if (separator) {
+      if (!IsPathSeparator(*stored)) {
+        continue;
+      }
+      ++stored;
+    }
+    if (EqualsFolded(stored, name)) {
+      return index;
+    }
+  }
+}
+
+void PathKeySet::Grow() {
+  std::vector<Slot> old(slots_.size() * 2);
+  old.swap(slots_);
+  const size_t mask = slots_.size() - 1;
+  for (const Slot& slot : old) {
+    if (!slot.data) {
+      continue;
+    }
+    size_t index = static_cast<size_t>(slot.hash) & mask;
+    while (slots_[index].data) {
+      index = (index + 1) & mask;
+    }
+    slots_[index] = slot;
+  }
+}
+
+PathTable::PathTable() : component_slots_(kMinSlots), child_slots_(kMinSlots) {
+  components_.emplace_back();
+  nodes_.emplace_back();  // kEmptyPath
+}
+
+// Empty components are kept, so leading, doubled and trailing separators
+// (UNC prefixes, drive roots) survive a round trip.
+PathId PathTable::Intern(std::wstring_view path) {
+  if (path.empty()) {
+    return kEmptyPath;
+  }
+  PathId node = kEmptyPath;
+  size_t begin = 0;
+  for (;;) {
+    size_t end = begin;
+    while (end < path.size() && !IsPathSeparator(path[end])) {
+      ++end;
+    }
+    const uint32_t component = InternComponent(path.substr(begin, end - begin));
+    if (nodes_.size() * 4 > child_slots_.size() * 3) {
+      GrowChildren();
+    }
+    PathId& slot = child_slots_[ChildSlot(node, component)];
+    if (slot == kEmptyPath) {
+      slot = static_cast<PathId>(nodes_.size());
+      nodes_.push_back({node, component});
+    }
+    node = slot;
+    if (end == path.size()) {
+      return node;
+    }
+    begin = end + 1;
+  }
+}
+
+std::wstring PathTable::Resolve(PathId id) const {
+  size_t length = 0;
+  for (PathId node = id; node != kEmptyPath; node = nodes_[node].parent) {
+    length += components_[nodes_[node].component].size() + 1;
+  }
+  if (length == 0) {
+    return {};
+  }
+  std::wstring path(length - 1, kSeparator);
+  size_t end = path.size();
+  for (PathId node = id; node != kEmptyPath; node = nodes_[node].parent) {
+    const std::wstring_view text = components_[nodes_[node].component];
+    end -= text.size();
+    std::memcpy(path.data() + end, text.data(), text.size() * sizeof(wchar_t));
+    if (end > 0) {
+      --end;
+    }
+  }
+  return path;
+}
+
+size_t PathTable::MemoryUsage() const {
+  return arena_.bytes() + components_.capacity() * sizeof(std::wstring_view) +
+         component_slots_.capacity() * sizeof(uint32_t) + nodes_.capacity() * sizeof(Node) +
+         child_slots_.capacity() * sizeof(PathId);
+}
+
+uint32_t PathTable::InternComponent(std::wstring_view text) {
+  if (text.empty()) {
+    return 0;
+  }
+  if (components_.size() * 4 > component_slots_.size() * 3) {
+    GrowComponents();
+  }
+  uint32_t& slot = component_slots_[ComponentSlot(HashPath(text), text)];
+  if (slot == 0) {
+    slot = static_cast<uint32_t>(components_.size());
+    components_.push_back(arena_.Store(text));
+  }
+  return slot;
+}
+
+size_t PathTable::ComponentSlot(uint64_t hash, std::wstring_view text) const {
+  const size_t mask = component_slots_.size() - 1;
+  for (size_t index = static_cast<size_t>(hash) & mask;; index = (index + 1) & mask) {
+    const uint32_t id = component_slots_[index];
+    if (id == 0 || components_[id] == text) {
+      return index;
+    }
+  }
+}
+
+size_t PathTable::ChildSlot(PathId parent, uint32_t component) const {
+  uint64_t hash = (static_cast<uint64_t>(parent) << 32 | component) * 0x9E3779B97F4A7C15ull;
+  hash ^= hash >> 32;
+  const size_t mask = child_slots_.size() - 1;
+  for (size_t index = static_cast<size_t>(hash) & mask;; index = (index + 1) & mask) {
+    const PathId id = child_slots_[index];
+    if (id == kEmptyPath || (nodes_[id].parent == parent && nodes_[id].component == component)) {
+      return index;
+    }
+  }
+}
+
+void PathTable::GrowComponents() {
+  component_slots_.assign(component_slots_.size() * 2, 0);
+  for (uint32_t id = 1; id < components_.size(); ++id) {
+    component_slots_[ComponentSlot(HashPath(components_[id]), components_[id])] = id;
+  }
+}
+
+void PathTable::GrowChildren() {
+  child_slots_.assign(child_slots_.size() * 2, kEmptyPath);
+  for (PathId id = 1; id < nodes_.size(); ++id) {
+    child_slots_[ChildSlot(nodes_[id].parent, nodes_[id].component)] = id;
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cwctype>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace optiscaler {
+
+constexpr uint64_t kPathHashOffset = 1469598103934665603ull;
+constexpr uint64_t kPathHashPrime = 1099511628211ull;
+
+// FNV-1a over towlower'd code units. This is the key CoverCache uses for
+// cover file names, so the scanner and the cache agree on identity.
+inline uint64_t HashPathAppend(uint64_t hash, std::wstring_view text) {
+  for (wchar_t ch : text) {
+    hash ^= static_cast<uint64_t>(std::towlower(ch));
+    hash *= kPathHashPrime;
+  }
+  return hash;
+}
+
+inline uint64_t HashPath(std::wstring_view path) {
+  return HashPathAppend(kPathHashOffset, path);
+}
+
+inline bool IsPathSeparator(wchar_t ch) {
+  return ch == L'\\' || ch == L'/';
+}
+
+// Hash of `directory` joined with `name` the way std::filesystem::path
+// joins them, computed without building the joined string. The second form
+// continues from a precomputed HashPath(directory).
+uint64_t HashJoinedPath(std::wstring_view directory, std::wstring_view name);
+uint64_t HashJoinedPath(uint64_t directory_hash, std::wstring_view directory, std::wstring_view name);
+
+// Append-only wide-string storage in large chunks. Views stay valid for the
+// arena's lifetime.
+class PathArena {
+ public:
+  std::wstring_view Store(std::wstring_view directory, std::wstring_view name);
+  std::wstring_view Store(std::wstring_view path) { return Store(path, {}); }
+  size_t bytes() const { return chunks_.size() * kChunkChars * sizeof(wchar_t); }
+
+ private:
+  static constexpr size_t kChunkChars = 64 * 1024;
+
+  wchar_t* Reserve(size_t count);
+
+  std::vector<std::unique_ptr<wchar_t[]>> chunks_;
+  size_t used_ = 0;
+};
+
+// Open-addressing set of case-folded paths keyed by HashPath. Accepted
+// paths are copied into an arena so hash collisions are resolved exactly
+// without a heap allocation per entry.
+class PathKeySet {
+ public:
+  explicit PathKeySet(size_t expected = 0);
+
+  // False if an equal path (ignoring case) is already present. The second
+  // form takes a precomputed HashJoinedPath(directory, name).
+  bool Insert(std::wstring_view path);
+  bool Insert(uint64_t hash, std::wstring_view directory, std::wstring_view name);
+  bool Contains(std::wstring_view path) const;
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    uint64_t hash = 0;
+    const wchar_t* data = nullptr;  // null = empty slot
+    size_t length = 0;
+  };
+
+  size_t Find(uint64_t hash, std::wstring_view directory, std::wstring_view name) const;
+  void Grow();
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  PathArena arena_;
+};
+
+using PathId = uint32_t;
+constexpr PathId kEmptyPath = 0;
+
+// Interned paths as a tree of components: each distinct (parent folder,
+// name) pair is stored once, so every game under one library folder shares
+// that folder's nodes, and component text is shared between folders. Ids
+// compare equal exactly when the paths do (case-sensitive). Resolve joins
+// with the preferred separator. Append-only; not thread-safe.
+class PathTable {
+ public:
+  PathTable();
+
+  PathId Intern(std::wstring_view path);
+  std::wstring Resolve(PathId id) const;
+  PathId Parent(PathId id) const { return nodes_[id].parent; }
+  std::wstring_view Leaf(PathId id) const { return components_[nodes_[id].component]; }
+
+  size_t size() const { return nodes_.size() - 1; }
+  size_t MemoryUsage() const;
+
+ private:
+  struct Node {
+    PathId parent = kEmptyPath;
+    uint32_t component = 0;
+  };
+
+  uint32_t InternComponent(std::wstring_view text);
+  size_t ComponentSlot(uint64_t hash, std::wstring_view text) const;
+  size_t ChildSlot(PathId parent, uint32_t component) const;
+  void GrowComponents();
+  void GrowChildren();
+
+  // Both tables are open-addressed over ids, 0 marking an empty slot:
+  // component 0 is the empty name and node 0 the empty path, and neither
+  // is ever looked up.
+  PathArena arena_;
+  std::vector<std::wstring_view> components_;
+  std::vector<uint32_t> component_slots_;
+  std::vector<Node> nodes_;
+  std::vector<PathId> child_slots_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,195 @@
+#include "perf_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr char kFrameEventName[] = "Frame";
+constexpr const char* kCounterNames[] = {"drawCalls", "bytesBlitted", "tilesRedrawn"};
+static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == static_cast<size_t>(PerfCounter::kCount),
+              "one name per counter");
+
+uint32_t CurrentThreadId() {
+  thread_local const uint32_t id = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  return id;
+}
+
+void AppendEscaped(std::string& out, const char* text) {
+  for (; *text; ++text) {
+    const char ch = *text;
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+      out += ch;
+    } else if (static_cast<unsigned char>(ch) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+      out += escaped;
+    } else {
+      out += ch;
+    }
+  }
+}
+
+void AppendMicros(std::string& out, uint64_t ns) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  out += buffer;
+}
+
+double Percentile(const std::vector<uint32_t>& sorted_us, double fraction) {
+  if (sorted_us.empty()) {
+    return 0.0;
+  }
+  const size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted_us.size()) + 0.999999);
+  return sorted_us[std::clamp<size_t>(rank, 1, sorted_us.size()) - 1] / 1000.0;
+}
+
+}  // namespace
+
+PerfTrace::PerfTrace() : origin_(std::chrono::steady_clock::now()) {}
+
+PerfTrace& PerfTrace::Default() {
+  // Never destroyed: worker threads may still record during shutdown.
+  static PerfTrace* trace = new PerfTrace();
+  return *trace;
+}
+
+void PerfTrace::SetEnabled(bool enabled) {
+  if (enabled) {
+    std::call_once(allocate_once_, [this] { events_ = std::make_unique<Event[]>(kEventCapacity); });
+  }
+  enabled_.store(enabled, std::memory_order_release);
+}
+
+uint64_t PerfTrace::NowNs() const {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin_).count());
+}
+
+void PerfTrace::Record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+  Write(name, start_ns, end_ns, nullptr);
+}
+
+void PerfTrace::Write(const char* name, uint64_t start_ns, uint64_t end_ns, const uint64_t* counters) {
+  // Acquire pairs with SetEnabled, so events_ is visible.
+  if (!enabled_.load(std::memory_order_acquire)) {
+    return;
+  }
+  const uint64_t index = next_event_.fetch_add(1, std::memory_order_relaxed);
+  Event& event = events_[index & (kEventCapacity - 1)];
+  event.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name.store(name, std::memory_order_relaxed);
+  event.start.store(start_ns, std::memory_order_relaxed);
+  event.duration.store(end_ns > start_ns ? end_ns - start_ns : 0, std::memory_order_relaxed);
+  event.thread.store(CurrentThreadId(), std::memory_order_relaxed);
+  for (size_t i = 0; i < kCounterCount; ++i) {
+    event.counters[i].store(counters ? counters[i] : 0, std::memory_order_relaxed);
+  }
+  event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void PerfTrace::BeginFrame() {
+  frame_start_ = NowNs();
+}
+
+void PerfTrace::EndFrame() {
+  if (!enabled()) {
+    return;
+  }
+  const uint64_t end = NowNs();
+  uint64_t counters[kCounterCount];
+  for (size_t i = 0; i < kCounterCount; ++i) {
+    counters[i] = counters_[i].exchange(0, std::memory_order_relaxed);
+    last_counters_[i].store(counters[i], std::memory_order_relaxed);
+  }
+  const uint64_t frame = frames_.load(std::memory_order_relaxed);
+  const uint64_t micros = (end - std::min(end, frame_start_)) / 1000;
+  frame_us_[frame % kFrameWindow].store(static_cast<uint32_t>(std::min<uint64_t>(micros, UINT32_MAX)),
+                                        std::memory_order_relaxed);
+  frames_.store(frame + 1, std::memory_order_release);
+  Write(kFrameEventName, frame_start_, end, counters);
+}
+
+FrameStats PerfTrace::Frames() const {
+  FrameStats stats;
+  stats.frames = frames_.load(std::memory_order_acquire);
+  if (stats.frames == 0) {
+    return stats;
+  }
+  const size_t count = static_cast<size_t>(std::min<uint64_t>(stats.frames, kFrameWindow));
+  std::vector<uint32_t> durations;
+  durations.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    durations.push_back(frame_us_[i].load(std::memory_order_relaxed));
+  }
+  stats.lastMs = frame_us_[(stats.frames - 1) % kFrameWindow].load(std::memory_order_relaxed) / 1000.0;
+  std::sort(durations.begin(), durations.end());
+  stats.p50Ms = Percentile(durations, 0.50);
+  stats.p99Ms = Percentile(durations, 0.99);
+  for (size_t i = 0; i < kCounterCount; ++i) {
+    stats.counters[i] = last_counters_[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+std::string PerfTrace::ChromeTraceJson() const {
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  const uint64_t end = next_event_.load(std::memory_order_acquire);
+  const uint64_t begin = end > kEventCapacity ? end - kEventCapacity : 0;
+  bool first = true;
+  for (uint64_t index = begin; events_ && index < end; ++index) {
+    const Event& event = events_[index & (kEventCapacity - 1)];
+    if (event.sequence.load(std::memory_order_acquire) != index + 1) {
+      continue;  // being written, or already overwritten
+    }
+    const char* name = event.name.load(std::memory_order_relaxed);
+    const uint64_t start = event.start.load(std::memory_order_relaxed);
+    const uint64_t duration = event.duration.load(std::memory_order_relaxed);
+    const uint32_t thread = event.thread.load(std::memory_order_relaxed);
+    uint64_t counters[kCounterCount];
+    for (size_t i = 0; i < kCounterCount; ++i) {
+      counters[i] = event.counters[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (event.sequence.load(std::memory_order_relaxed) != index + 1 || !name) {
+      continue;
+    }
+    out += first ? "\n" : ",\n";
+    first = false;
+    out += "{\"name\":\"";
+    AppendEscaped(out, name);
+    out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(thread) + ",\"ts\":";
+    AppendMicros(out, start);
+    out += ",\"dur\":";
+    AppendMicros(out, duration);
+    if (name == kFrameEventName) {
+      out += ",\"args\":{";
+      for (size_t i = 0; i < kCounterCount; ++i) {
+        out += std::string(i ? "," : "") + "\"" + kCounterNames[i] + "\":" + std::to_string(counters[i]);
+      }
+      out += "}";
+    }
+    out += "}";
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+bool PerfTrace::ExportChromeTrace(const std::wstring& path) const {
+  std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+  const std::string json = ChromeTraceJson();
+  out.write(json.data(), static_cast<std::streamsize>(json.size()));
+  return out.good();
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace optiscaler {
+
+enum class PerfCounter : uint8_t {
+  kDrawCalls,
+  kBytesBlitted,
+  kTilesRedrawn,
+  kCount,
+};
+
+struct FrameStats {
+  uint64_t frames = 0;  // since tracing was enabled
+  double lastMs = 0.0;
+  double p50Ms = 0.0;  // over the last kFrameWindow frames
+  double p99Ms = 0.0;
+  std::array<uint64_t, static_cast<size_t>(PerfCounter::kCount)> counters{};  // last frame
+};
+
+// Paint-path instrumentation. Off by default, and then every PerfScope and
+// Add costs one relaxed atomic load. When on, scopes are written to a
+// fixed ring of trace events from any thread without locking (a sequence
+// number per slot; the oldest events are overwritten), counters add up
+// until EndFrame, and the last kFrameWindow frame times give p50/p99.
+// BeginFrame/EndFrame are called from one thread, the UI thread.
+class PerfTrace {
+ public:
+  static constexpr size_t kEventCapacity = 1 << 15;  // power of two
+  static constexpr size_t kFrameWindow = 240;
+
+  PerfTrace();
+
+  PerfTrace(const PerfTrace&) = delete;
+  PerfTrace& operator=(const PerfTrace&) = delete;
+
+  static PerfTrace& Default();
+
+  void SetEnabled(bool enabled);
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  // Nanoseconds since construction.
+  uint64_t NowNs() const;
+
+  // `name` must outlive the trace (a string literal).
+  void Record(const char* name, uint64_t start_ns, uint64_t end_ns);
+  void Add(PerfCounter counter, uint64_t value) {
+    if (enabled()) {
+      counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+  }
+  void BeginFrame();
+  void EndFrame();
+  FrameStats Frames() const;
+
+  // Chrome trace-event JSON, for chrome://tracing or Perfetto. Frames carry
+  // their counters as args.
+  std::string ChromeTraceJson() const;
+  bool ExportChromeTrace(const std::wstring& path) const;
+
+ private:
+  static constexpr size_t kCounterCount = static_cast<size_t>(PerfCounter::kCount);
+
+  struct Event {
+    std::atomic<uint64_t> sequence{0};  // index + 1 once written, 0 while writing
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> duration{0};
+    std::atomic<uint32_t> thread{0};
+    std::array<std::atomic<uint64_t>, kCounterCount> counters{};  // frames only
+  };
+
+  void Write(const char* name, uint64_t start_ns, uint64_t end_ns, const uint64_t* counters);
+
+  const std::chrono::steady_clock::time_point origin_;
+  std::atomic<bool> enabled_{false};
+  std::once_flag allocate_once_;
+  std::unique_ptr<Event[]> events_;  // allocated on first enable
+  std::atomic<uint64_t> next_event_{0};
+  std::array<std::atomic<uint64_t>, kCounterCount> counters_{};
+  uint64_t frame_start_ = 0;
+  std::array<std::atomic<uint32_t>, kFrameWindow> frame_us_{};
+  std::array<std::atomic<uint64_t>, kCounterCount> last_counters_{};
+  std::atomic<uint64_t> frames_{0};
+};
+
+// Records the enclosing scope into `trace` when it is enabled.
+class PerfScope {
+ public:
+  explicit PerfScope(const char* name, PerfTrace& trace = PerfTrace::Default())
+      : trace_(trace), name_(trace.enabled() ? name : nullptr), start_(name_ ? trace.NowNs() : 0) {}
+  ~PerfScope() {
+    if (name_) {
+      trace_.Record(name_, start_, trace_.NowNs());
+    }
+  }
+
+  PerfScope(const PerfScope&) = delete;
+  PerfScope& operator=(const PerfScope&) = delete;
+
+ private:
+  PerfTrace& trace_;
+  const char* name_;
+  uint64_t start_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,218 @@
+#include "prefetch_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace optiscaler {
+
+PrefetchScheduler::PrefetchScheduler(Deliver deliver, PrefetchOptions options)
+    : deliver_(std::move(deliver)), options_(options) {
+  const size_t worker_count = std::max<size_t>(1, options_.workerCount);
+  threads_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    threads_.emplace_back([this] { Run(); });
+  }
+}
+
+PrefetchScheduler::~PrefetchScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_cv_.notify_all();
+  idle_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void PrefetchScheduler::Reset(size_t item_count, Work work) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Running items check the generation when they finish.
+  ++generation_;
+  states_.assign(item_count, ItemState::kIdle);
+  work_ = std::make_shared<const Work>(std::move(work));
+  ready_.clear();
+  background_cursor_ = 0;
+  UpdateWindowLocked(requested_first_, requested_last_, window_.velocity);
+  work_cv_.notify_all();
+}
+
+size_t PrefetchScheduler::Requeue(const std::vector<size_t>& indices) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t requeued = 0;
+  for (size_t index : indices) {
+    if (index < states_.size() && states_[index] == ItemState::kDone) {
+      states_[index] = ItemState::kIdle;
+      background_cursor_ = std::min(background_cursor_, index);
+      ++requeued;
+    }
+  }
+  if (requeued > 0) {
+    work_cv_.notify_all();
+  }
+  return requeued;
+}
+
+void PrefetchScheduler::SetViewport(size_t first, size_t last, double velocity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  UpdateWindowLocked(first, last, velocity);
+  work_cv_.notify_all();
+}
+
+bool PrefetchScheduler::IsWanted(size_t index) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return IsWantedLocked(index);
+}
+
+void PrefetchScheduler::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this] {
+    size_t next = 0;
+    return stopping_ || (running_ == 0 && (!work_ || !FindLocked(next)));
+  });
+}
+
+PrefetchStats PrefetchScheduler::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void PrefetchScheduler::UpdateWindowLocked(size_t first, size_t last, double velocity) {
+  requested_first_ = first;
+  requested_last_ = last;
+  const size_t count = states_.size();
+  Window window;
+  window.first = std::min(first, count);
+  window.last = std::clamp(last, window.first, count);
+  window.velocity = velocity;
+  const double screen = static_cast<double>(std::max<size_t>(1, window.last - window.first));
+  const auto ahead = static_cast<size_t>(screen * options_.aheadScreens + std::abs(velocity) * options_.leadSeconds);
+  const auto behind = static_cast<size_t>(screen * options_.behindScreens);
+  const auto margin = static_cast<size_t>(screen * options_.cancelScreens);
+  if (velocity >= 0.0) {
+    window.aheadBegin = window.last;
+    window.aheadEnd = window.last + std::min(ahead, count - window.last);
+    window.behindEnd = window.first;
+    window.behindBegin = window.first - std::min(behind, window.first);
+  } else {
+    window.aheadEnd = window.first;
+    window.aheadBegin = window.first - std::min(ahead, window.first);
+    window.behindBegin = window.last;
+    window.behindEnd = window.last + std::min(behind, count - window.last);
+  }
+  const size_t low = std::min(window.aheadBegin, window.behindBegin);
+  const size_t high = std::max(window.aheadEnd, window.behindEnd);
+  window.wantedBegin = low - std::min(margin, low);
+  window.wantedEnd = high + std::min(margin, count - high);
+  window_ = window;
+}
+
+bool PrefetchScheduler::FindLocked(size_t& index_out) {
+  auto idle = [this](size_t index) { return states_[index] == ItemState::kIdle; };
+  for (size_t i = window_.first; i < window_.last; ++i) {
+    if (idle(i)) {
+      index_out = i;
+      return true;
+    }
+  }
+  // Nearest first on both sides of the viewport.
+  const bool forward = window_.velocity >= 0.0;
+  for (size_t k = 0; k < window_.aheadEnd - window_.aheadBegin; ++k) {
+    const size_t i = forward ? window_.aheadBegin + k : window_.aheadEnd - 1 - k;
+    if (idle(i)) {
+      index_out = i;
+      return true;
+    }
+  }
+  for (size_t k = 0; k < window_.behindEnd - window_.behindBegin; ++k) {
+    const size_t i = forward ? window_.behindEnd - 1 - k : window_.behindBegin + k;
+    if (idle(i)) {
+      index_out = i;
+      return true;
+    }
+  }
+  if (!options_.background) {
+    return false;
+  }
+  while (background_cursor_ < states_.size() && !idle(background_cursor_)) {
+    ++background_cursor_;
+  }
+  if (background_cursor_ == states_.size()) {
+    return false;
+  }
+  index_out = background_cursor_;
+  return true;
+}
+
+bool PrefetchScheduler::VisibleCompleteLocked() const {
+  for (size_t i = window_.first; i < window_.last; ++i) {
+    if (states_[i] == ItemState::kIdle || states_[i] == ItemState::kRunning) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PrefetchScheduler::IsWantedLocked(size_t index) const {
+  return index < states_.size() &&
+         (options_.background || (index >= window_.wantedBegin && index < window_.wantedEnd));
+}
+
+void PrefetchScheduler::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    size_t index = 0;
+    work_cv_.wait(lock, [&] { return stopping_ || (work_ && FindLocked(index)); });
+    if (stopping_) {
+      return;
+    }
+    states_[index] = ItemState::kRunning;
+    ++running_;
+    ++stats_.started;
+    const uint64_t generation = generation_;
+    const std::shared_ptr<const Work> work = work_;
+    lock.unlock();
+    const bool ok = (*work)(index);
+    lock.lock();
+
+    std::vector<size_t> batch;
+    if (generation == generation_) {
+      if (ok) {
+        states_[index] = ItemState::kDone;
+        ++stats_.ready;
+        if (ready_.empty()) {
+          first_ready_ = std::chrono::steady_clock::now();
+        }
+        ready_.push_back(index);
+      } else if (!IsWantedLocked(index)) {
+        states_[index] = ItemState::kIdle;
+        background_cursor_ = std::min(background_cursor_, index);
+        ++stats_.cancelled;
+      } else {
+        states_[index] = ItemState::kFailed;
+        ++stats_.failed;
+      }
+      size_t next = 0;
+      const bool visible = index >= window_.first && index < window_.last;
+      const bool flush = !ready_.empty() &&
+                         (ready_.size() >= options_.batchSize || (visible && ok && VisibleCompleteLocked()) ||
+                          std::chrono::steady_clock::now() - first_ready_ >= options_.batchDelay ||
+                          (running_ == 1 && !FindLocked(next)));
+      if (flush) {
+        batch.swap(ready_);
+        ++stats_.batches;
+      }
+    }
+    if (!batch.empty() && deliver_) {
+      lock.unlock();
+      deliver_(std::move(batch));
+      lock.lock();
+    }
+    // Counted as running until delivered, so Wait() covers the callback.
+    --running_;
+    idle_cv_.notify_all();
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace optiscaler {
+
+struct PrefetchOptions {
+  size_t workerCount = 4;
+  size_t batchSize = 16;
+  std::chrono::milliseconds batchDelay{50};
+  double aheadScreens = 1.0;   // past the viewport in the scroll direction
+  double behindScreens = 0.5;  // the other way
+  double leadSeconds = 0.5;    // extra look-ahead at the current scroll speed
+  double cancelScreens = 1.0;  // margin past those ranges before work is stale
+  bool background = false;     // fetch the rest of the library when idle
+};
+
+struct PrefetchStats {
+  uint64_t started = 0;
+  uint64_t ready = 0;
+  uint64_t failed = 0;
+  uint64_t cancelled = 0;  // gave up after scrolling out of range
+  uint64_t batches = 0;
+};
+
+// Viewport-driven prefetch for grid tiles (covers, metadata). Nothing is
+// queued up front: a free worker picks the next item from the visible
+// range, then the range ahead of the scroll direction (longer when
+// scrolling fast), then a little behind, and only then the rest of the
+// library if `background` is set. Tiles that scroll away are never picked,
+// and work already running can poll IsWanted and give up; such items are
+// picked again if they come back into range.
+//
+// Ready indices are delivered in batches: when a batch fills, when the
+// visible range is complete, when `batchDelay` has passed since the first
+// undelivered result (checked as work completes), or when the scheduler
+// runs out of work. Deliver runs on a worker thread.
+class PrefetchScheduler {
+ public:
+  // Returns true if `index` is ready for display.
+  using Work = std::function<bool(size_t index)>;
+  using Deliver = std::function<void(std::vector<size_t> ready)>;
+
+  explicit PrefetchScheduler(Deliver deliver, PrefetchOptions options = {});
+  ~PrefetchScheduler();
+
+  PrefetchScheduler(const PrefetchScheduler&) = delete;
+  PrefetchScheduler& operator=(const PrefetchScheduler&) = delete;
+
+  // Starts over with `item_count` items without waiting: work still running
+  // for the old items finishes on its own and its results are dropped, so
+  // `work` should poll IsWanted to give up early.
+  void Reset(size_t item_count, Work work);
+  // Makes finished items pickable again, e.g. once their cover was evicted
+  // before it was drawn. Other states are left alone. Returns how many
+  // items were requeued.
+  size_t Requeue(const std::vector<size_t>& indices);
+  // Visible items are [first, last); `velocity` is in items per second,
+  // negative when scrolling towards index 0.
+  void SetViewport(size_t first, size_t last, double velocity = 0.0);
+  bool IsWanted(size_t index) const;
+  // Blocks until no work is running or could start (tests, shutdown).
+  void Wait();
+  PrefetchStats Stats() const;
+
+ private:
+  enum class ItemState : uint8_t { kIdle, kRunning, kDone, kFailed };
+
+  struct Window {
+    size_t first = 0;
+    size_t last = 0;
+    size_t aheadBegin = 0;  // half-open ranges, clamped to the item count
+    size_t aheadEnd = 0;
+    size_t behindBegin = 0;
+    size_t behindEnd = 0;
+    size_t wantedBegin = 0;
+    size_t wantedEnd = 0;
+    double velocity = 0.0;
+  };
+
+  void UpdateWindowLocked(size_t first, size_t last, double velocity);
+  // Advances the background cursor past finished items.
+  bool FindLocked(size_t& index_out);
+  bool VisibleCompleteLocked() const;
+  bool IsWantedLocked(size_t index) const;
+  void Run();
+
+  const Deliver deliver_;
+  const PrefetchOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::vector<ItemState> states_;
+  std::shared_ptr<const Work> work_;
+  size_t requested_first_ = 0;  // as passed to SetViewport, before clamping
+  size_t requested_last_ = 0;
+  Window window_;
+  size_t background_cursor_ = 0;  // no idle item below this index
+  size_t running_ = 0;
+  uint64_t generation_ = 0;
+  std::vector<size_t> ready_;
+  std::chrono::steady_clock::time_point first_ready_;
+  PrefetchStats stats_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace optiscaler
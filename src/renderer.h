@@ -1,9 +1,11 @@
 #pragma once
 
-#include <string>
+#include <string_view>
 
 #include <windows.h>
 
+#include "cover_image.h"
+
 namespace optiscaler {
 
 class IRenderer {
@@ -11,9 +13,21 @@ class IRenderer {
   virtual ~IRenderer() = default;
   virtual bool Init(HWND hwnd) = 0;
   virtual void Resize(UINT width, UINT height) = 0;
-  virtual void Begin() = 0;
+  // Starts a frame that redraws only `dirty` (client coordinates). Returns
+  // the area the caller must redraw, which a backend may grow to its own
+  // granularity; drawing outside it is clipped and the rest of the previous
+  // frame is kept.
+  virtual RECT Begin(const RECT& dirty) = 0;
+  virtual void FillSolid(const RECT& rect, COLORREF color) = 0;
   virtual void DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) = 0;
-  virtual void DrawText(const std::wstring& text, int x, int y, COLORREF color) = 0;
+  virtual void DrawImage(const CoverImage& image, int x, int y) = 0;
+  // Shifts the retained frame inside `area` by `dy` rows to match a
+  // ScrollWindowEx of the same area. False if the backend cannot, in which
+  // case the caller repaints the area.
+  virtual bool Scroll(const RECT& area, int dy) = 0;
+  virtual void DrawText(std::wstring_view text, int x, int y, COLORREF color) = 0;
+  // One line cut with an ellipsis when wider than `max_width` pixels.
+  virtual void DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) = 0;
   virtual void End() = 0;
 };
 
@@ -4,9 +4,14 @@ namespace optiscaler {
 
 bool RendererD3D12::Init(HWND /*hwnd*/) { return false; }
 void RendererD3D12::Resize(UINT /*width*/, UINT /*height*/) {}
-void RendererD3D12::Begin() {}
+RECT RendererD3D12::Begin(const RECT& dirty) { return dirty; }
+void RendererD3D12::FillSolid(const RECT& /*rect*/, COLORREF /*color*/) {}
 void RendererD3D12::DrawBitmap(HBITMAP /*bitmap*/, int /*x*/, int /*y*/, int /*width*/, int /*height*/) {}
-void RendererD3D12::DrawText(const std::wstring& /*text*/, int /*x*/, int /*y*/, COLORREF /*color*/) {}
+void RendererD3D12::DrawImage(const CoverImage& /*image*/, int /*x*/, int /*y*/) {}
+bool RendererD3D12::Scroll(const RECT& /*area*/, int /*dy*/) { return false; }
+void RendererD3D12::DrawText(std::wstring_view /*text*/, int /*x*/, int /*y*/, COLORREF /*color*/) {}
+void RendererD3D12::DrawLabel(std::wstring_view /*text*/, int /*x*/, int /*y*/, int /*max_width*/,
+                              COLORREF /*color*/) {}
 void RendererD3D12::End() {}
 
 }  // namespace optiscaler
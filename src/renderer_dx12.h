@@ -8,9 +8,13 @@ class RendererD3D12 : public IRenderer {
  public:
   bool Init(HWND hwnd) override;
   void Resize(UINT width, UINT height) override;
-  void Begin() override;
+  RECT Begin(const RECT& dirty) override;
+  void FillSolid(const RECT& rect, COLORREF color) override;
   void DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) override;
-  void DrawText(const std::wstring& text, int x, int y, COLORREF color) override;
+  void DrawImage(const CoverImage& image, int x, int y) override;
+  bool Scroll(const RECT& area, int dy) override;
+  void DrawText(std::wstring_view text, int x, int y, COLORREF color) override;
+  void DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) override;
   void End() override;
 };
 
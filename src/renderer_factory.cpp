@@ -5,6 +5,7 @@
 #include "renderer_dx11.h"
 #include "renderer_dx12.h"
 #include "renderer_gdi.h"
+#include "renderer_software.h"
 
 namespace optiscaler {
 
@@ -36,6 +37,11 @@ std::unique_ptr<IRenderer> CreateRenderer(RendererPreference preference, HWND hw
       return nullptr;
     }
   }
+  if (preference == RendererPreference::kAuto || preference == RendererPreference::kSoftware) {
+    if (auto renderer = TryCreate(std::make_unique<RendererSoftware>(), hwnd)) {
+      return renderer;
+    }
+  }
   auto gdi = std::make_unique<RendererGDI>();
   if (gdi->Init(hwnd)) {
     return gdi;
@@ -11,6 +11,7 @@ enum class RendererPreference {
   kAuto,
   kD3D12,
   kD3D11,
+  kSoftware,
   kGDI,
 };
 
@@ -2,6 +2,8 @@
 
 #include <windowsx.h>
 
+#include "perf_trace.h"
+
 namespace optiscaler {
 
 RendererGDI::RendererGDI() = default;
@@ -27,7 +29,7 @@ bool RendererGDI::Init(HWND hwnd) {
 }
 
 void RendererGDI::Resize(UINT width, UINT height) {
-  if (!back_dc_) {
+  if (!back_dc_ || (back_bitmap_ && width == width_ && height == height_)) {
     return;
   }
   if (back_bitmap_) {
@@ -43,19 +45,35 @@ void RendererGDI::Resize(UINT width, UINT height) {
   height_ = height;
 }
 
-void RendererGDI::Begin() {
+RECT RendererGDI::Begin(const RECT& dirty) {
+  if (!back_dc_) {
+    return dirty;
+  }
+  const RECT bounds = {0, 0, static_cast<LONG>(width_), static_cast<LONG>(height_)};
+  if (!IntersectRect(&dirty_, &dirty, &bounds)) {
+    SetRectEmpty(&dirty_);
+  }
+  SelectClipRgn(back_dc_, nullptr);
+  IntersectClipRect(back_dc_, dirty_.left, dirty_.top, dirty_.right, dirty_.bottom);
+  ::FillRect(back_dc_, &dirty_, static_cast<HBRUSH>(GetStockObject(GRAY_BRUSH)));
+  return dirty_;
+}
+
+void RendererGDI::FillSolid(const RECT& rect, COLORREF color) {
   if (!back_dc_) {
     return;
   }
-  RECT rc = {0, 0, static_cast<LONG>(width_), static_cast<LONG>(height_)};
-  HBRUSH brush = static_cast<HBRUSH>(GetStockObject(GRAY_BRUSH));
-  FillRect(back_dc_, &rc, brush);
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  // ETO_OPAQUE fills with the background color without creating a brush.
+  SetBkColor(back_dc_, color);
+  ExtTextOutW(back_dc_, 0, 0, ETO_OPAQUE, &rect, nullptr, 0, nullptr);
 }
 
 void RendererGDI::DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) {
   if (!bitmap || !back_dc_) {
     return;
   }
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
   HDC temp_dc = CreateCompatibleDC(back_dc_);
   HGDIOBJ old = SelectObject(temp_dc, bitmap);
   BitBlt(back_dc_, x, y, width, height, temp_dc, 0, 0, SRCCOPY);
@@ -63,22 +81,64 @@ void RendererGDI::DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height
   DeleteDC(temp_dc);
 }
 
-void RendererGDI::DrawText(const std::wstring& text, int x, int y, COLORREF color) {
+void RendererGDI::DrawImage(const CoverImage& image, int x, int y) {
+  if (!back_dc_ || image.empty()) {
+    return;
+  }
+  PerfScope scope("RendererGDI::DrawImage");
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  // Opaque copy: covers are opaque, and GDI has no premultiplied blend
+  // without msimg32.
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(info.bmiHeader);
+  info.bmiHeader.biWidth = image.width;
+  info.bmiHeader.biHeight = -image.height;  // top-down
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+  SetDIBitsToDevice(back_dc_, x, y, static_cast<DWORD>(image.width), static_cast<DWORD>(image.height), 0, 0, 0,
+                    static_cast<UINT>(image.height), image.data(), &info, DIB_RGB_COLORS);
+}
+
+bool RendererGDI::Scroll(const RECT& area, int dy) {
+  return back_dc_ && ScrollDC(back_dc_, 0, dy, &area, &area, nullptr, nullptr);
+}
+
+void RendererGDI::DrawText(std::wstring_view text, int x, int y, COLORREF color) {
   if (!back_dc_) {
     return;
   }
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
   SetBkMode(back_dc_, TRANSPARENT);
   SetTextColor(back_dc_, color);
-  TextOutW(back_dc_, x, y, text.c_str(), static_cast<int>(text.length()));
+  TextOutW(back_dc_, x, y, text.data(), static_cast<int>(text.length()));
+}
+
+void RendererGDI::DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) {
+  if (!back_dc_) {
+    return;
+  }
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  SetBkMode(back_dc_, TRANSPARENT);
+  SetTextColor(back_dc_, color);
+  RECT rc = {x, y, x + max_width, static_cast<LONG>(height_)};
+  ::DrawTextW(back_dc_, text.data(), static_cast<int>(text.length()), &rc,
+              DT_SINGLELINE | DT_NOPREFIX | DT_END_ELLIPSIS);
 }
 
 void RendererGDI::End() {
   if (!back_dc_) {
     return;
   }
-  HDC window_dc = GetDC(hwnd_);
-  BitBlt(window_dc, 0, 0, static_cast<int>(width_), static_cast<int>(height_), back_dc_, 0, 0, SRCCOPY);
-  ReleaseDC(hwnd_, window_dc);
+  if (!IsRectEmpty(&dirty_)) {
+    PerfTrace::Default().Add(PerfCounter::kBytesBlitted,
+                             static_cast<uint64_t>(dirty_.right - dirty_.left) * (dirty_.bottom - dirty_.top) * 4);
+    HDC window_dc = GetDC(hwnd_);
+    BitBlt(window_dc, dirty_.left, dirty_.top, dirty_.right - dirty_.left, dirty_.bottom - dirty_.top, back_dc_,
+           dirty_.left, dirty_.top, SRCCOPY);
+    ReleaseDC(hwnd_, window_dc);
+  }
+  SelectClipRgn(back_dc_, nullptr);
 }
 
 }  // namespace optiscaler
@@ -11,9 +11,13 @@ class RendererGDI : public IRenderer {
 
   bool Init(HWND hwnd) override;
   void Resize(UINT width, UINT height) override;
-  void Begin() override;
+  RECT Begin(const RECT& dirty) override;
+  void FillSolid(const RECT& rect, COLORREF color) override;
   void DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) override;
-  void DrawText(const std::wstring& text, int x, int y, COLORREF color) override;
+  void DrawImage(const CoverImage& image, int x, int y) override;
+  bool Scroll(const RECT& area, int dy) override;
+  void DrawText(std::wstring_view text, int x, int y, COLORREF color) override;
+  void DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) override;
   void End() override;
 
  private:
@@ -23,6 +27,7 @@ class RendererGDI : public IRenderer {
   HBITMAP old_bitmap_ = nullptr;
   UINT width_ = 0;
   UINT height_ = 0;
+  RECT dirty_ = {};
 };
 
 }  // namespace optiscaler
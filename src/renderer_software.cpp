@@ -0,0 +1,164 @@
+#include "renderer_software.h"
+
+#include <memory>
+#include <vector>
+
+#include "gdi_glyph_rasterizer.h"
+#include "perf_trace.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr uint32_t kBackground = OpaqueColor(0x808080);  // GRAY_BRUSH, as in RendererGDI
+constexpr wchar_t kFontFace[] = L"Segoe UI";
+constexpr int kFontPixelHeight = 15;
+
+GridRect ToGridRect(const RECT& rect) {
+  return {rect.left, rect.top, rect.right, rect.bottom};
+}
+
+RECT ToRect(const GridRect& rect) {
+  return {rect.left, rect.top, rect.right, rect.bottom};
+}
+
+uint32_t ToBgra(COLORREF color) {
+  return OpaqueColor(static_cast<uint32_t>(GetRValue(color)) << 16 | static_cast<uint32_t>(GetGValue(color)) << 8 |
+                     GetBValue(color));
+}
+
+}  // namespace
+
+RendererSoftware::RendererSoftware() = default;
+
+RendererSoftware::~RendererSoftware() {
+  if (dib_dc_) {
+    if (old_bitmap_) {
+      SelectObject(dib_dc_, old_bitmap_);
+    }
+    if (dib_) {
+      DeleteObject(dib_);
+    }
+    DeleteDC(dib_dc_);
+  }
+}
+
+bool RendererSoftware::Init(HWND hwnd) {
+  hwnd_ = hwnd;
+  auto font = std::make_unique<GdiGlyphRasterizer>(kFontFace, kFontPixelHeight);
+  if (font->valid()) {
+    font_ = glyphs_.AddFont(std::move(font));
+  } else {
+    font_ = glyphs_.AddFont(std::make_unique<BitmapFont>());
+  }
+  dib_dc_ = CreateCompatibleDC(nullptr);
+  return dib_dc_ != nullptr;
+}
+
+void RendererSoftware::Resize(UINT width, UINT height) {
+  if (!dib_dc_ || (dib_ && width == width_ && height == height_)) {
+    return;
+  }
+  if (dib_) {
+    SelectObject(dib_dc_, old_bitmap_);
+    DeleteObject(dib_);
+    dib_ = nullptr;
+  }
+  compositor_.Attach(nullptr, 0, 0, 0);
+  width_ = width;
+  height_ = height;
+  if (width == 0 || height == 0) {
+    return;
+  }
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(info.bmiHeader);
+  info.bmiHeader.biWidth = static_cast<LONG>(width);
+  info.bmiHeader.biHeight = -static_cast<LONG>(height);  // top-down, the CoverImage layout
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+  void* bits = nullptr;
+  dib_ = CreateDIBSection(dib_dc_, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+  if (!dib_) {
+    return;
+  }
+  old_bitmap_ = static_cast<HBITMAP>(SelectObject(dib_dc_, dib_));
+  compositor_.Attach(static_cast<uint32_t*>(bits), static_cast<int>(width), static_cast<int>(height),
+                     static_cast<int>(width));
+}
+
+RECT RendererSoftware::Begin(const RECT& dirty) {
+  // GDI may still be writing into the DIB from the last frame.
+  GdiFlush();
+  compositor_.Invalidate(ToGridRect(dirty));
+  const RECT frame = ToRect(compositor_.Begin(kBackground));
+  if (dib_) {
+    // Limit GDI drawing to the frame's tiles, which are all the caller
+    // will have redrawn.
+    HRGN clip = CreateRectRgn(0, 0, 0, 0);
+    for (const GridRect& rect : compositor_.frameRects()) {
+      HRGN part = CreateRectRgn(rect.left, rect.top, rect.right, rect.bottom);
+      CombineRgn(clip, clip, part, RGN_OR);
+      DeleteObject(part);
+    }
+    SelectClipRgn(dib_dc_, clip);
+    DeleteObject(clip);
+  }
+  return frame;
+}
+
+void RendererSoftware::FillSolid(const RECT& rect, COLORREF color) {
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  compositor_.Fill(ToGridRect(rect), ToBgra(color));
+}
+
+void RendererSoftware::DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) {
+  if (!bitmap || !dib_) {
+    return;
+  }
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  HDC temp_dc = CreateCompatibleDC(dib_dc_);
+  HGDIOBJ old = SelectObject(temp_dc, bitmap);
+  BitBlt(dib_dc_, x, y, width, height, temp_dc, 0, 0, SRCCOPY);
+  SelectObject(temp_dc, old);
+  DeleteDC(temp_dc);
+}
+
+void RendererSoftware::DrawImage(const CoverImage& image, int x, int y) {
+  PerfScope scope("RendererSoftware::DrawImage");
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  GdiFlush();
+  compositor_.Blend(image, x, y);
+}
+
+bool RendererSoftware::Scroll(const RECT& area, int dy) {
+  GdiFlush();
+  compositor_.Scroll(ToGridRect(area), dy);
+  return dib_ != nullptr;
+}
+
+void RendererSoftware::DrawText(std::wstring_view text, int x, int y, COLORREF color) {
+  DrawLabel(text, x, y, 0, color);
+}
+
+void RendererSoftware::DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) {
+  PerfTrace::Default().Add(PerfCounter::kDrawCalls, 1);
+  const auto layout = layouts_.Layout(font_, text, max_width);
+  DrawTextLayout(compositor_, glyphs_, *layout, x, y, ToBgra(color));
+}
+
+void RendererSoftware::End() {
+  GdiFlush();
+  const std::vector<GridRect>& rects = compositor_.End();
+  if (dib_ && !rects.empty()) {
+    HDC window_dc = GetDC(hwnd_);
+    for (const GridRect& rect : rects) {
+      PerfTrace::Default().Add(PerfCounter::kBytesBlitted, static_cast<uint64_t>(rect.width()) * rect.height() * 4);
+      BitBlt(window_dc, rect.left, rect.top, rect.width(), rect.height(), dib_dc_, rect.left, rect.top, SRCCOPY);
+    }
+    ReleaseDC(hwnd_, window_dc);
+  }
+  SelectClipRgn(dib_dc_, nullptr);
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "glyph_atlas.h"
+#include "renderer.h"
+#include "text_layout.h"
+#include "tile_compositor.h"
+
+namespace optiscaler {
+
+// IRenderer over TileCompositor: composes into a DIB section and presents
+// only the tiles a frame touched. Text is blitted from a glyph atlas with
+// cached layouts; HBITMAPs go through GDI on the same DIB, clipped to
+// those tiles.
+class RendererSoftware : public IRenderer {
+ public:
+  RendererSoftware();
+  ~RendererSoftware() override;
+
+  bool Init(HWND hwnd) override;
+  void Resize(UINT width, UINT height) override;
+  RECT Begin(const RECT& dirty) override;
+  void FillSolid(const RECT& rect, COLORREF color) override;
+  void DrawBitmap(HBITMAP bitmap, int x, int y, int width, int height) override;
+  void DrawImage(const CoverImage& image, int x, int y) override;
+  bool Scroll(const RECT& area, int dy) override;
+  void DrawText(std::wstring_view text, int x, int y, COLORREF color) override;
+  void DrawLabel(std::wstring_view text, int x, int y, int max_width, COLORREF color) override;
+  void End() override;
+
+ private:
+  HWND hwnd_ = nullptr;
+  HDC dib_dc_ = nullptr;
+  HBITMAP dib_ = nullptr;
+  HBITMAP old_bitmap_ = nullptr;
+  UINT width_ = 0;
+  UINT height_ = 0;
+  TileCompositor compositor_;
+  GlyphAtlas glyphs_;
+  TextLayoutCache layouts_{glyphs_};
+  FontId font_ = 0;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,377 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OPTISCALER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC lets any function use AVX2 intrinsics; GCC and Clang need the
+// target enabled per function so the rest of the file stays baseline.
+#if defined(OPTISCALER_X86) && !defined(_MSC_VER)
+#define OPTISCALER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OPTISCALER_TARGET_AVX2
+#endif
+
+namespace optiscaler {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Per output sample, `count` zero-padded weights starting at `start`, so
+// every kernel runs the same fixed-length loop.
+struct Taps {
+  int count = 0;
+  std::vector<int> start;
+  std::vector<float> weights;
+};
+
+double Support(ResampleFilter filter) {
+  switch (filter) {
+    case ResampleFilter::kBox:
+      return 0.5;
+    case ResampleFilter::kBilinear:
+      return 1.0;
+    case ResampleFilter::kLanczos3:
+      return 3.0;
+  }
+  return 1.0;
+}
+
+double Sinc(double x) {
+  return x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+}
+
+double Evaluate(ResampleFilter filter, double x) {
+  switch (filter) {
+    case ResampleFilter::kBox:
+      return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+    case ResampleFilter::kBilinear:
+      return std::max(0.0, 1.0 - std::abs(x));
+    case ResampleFilter::kLanczos3:
+      return std::abs(x) < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+  }
+  return 0.0;
+}
+
+// Downscaling stretches the filter over the source so every source pixel
+// contributes; taps past the image edge are dropped and the rest
+// renormalized.
+Taps BuildTaps(int in, int out, ResampleFilter filter) {
+  const double scale = static_cast<double>(in) / out;
+  const double stretch = std::max(scale, 1.0);
+  const double support = Support(filter) * stretch;
+  Taps taps;
+  taps.count = std::min(in, static_cast<int>(std::ceil(support * 2.0)) + 2);
+  taps.start.resize(out);
+  taps.weights.assign(static_cast<size_t>(out) * taps.count, 0.0f);
+  std::vector<double> values(taps.count);
+  for (int o = 0; o < out; ++o) {
+    const double center = (o + 0.5) * scale;
+    const int first = std::max(0, static_cast<int>(std::floor(center - support)));
+    const int last = std::min(in - 1, static_cast<int>(std::ceil(center + support)));
+    const int start = std::max(0, std::min(first, in - taps.count));
+    std::fill(values.begin(), values.end(), 0.0);
+    double sum = 0.0;
+    for (int i = first; i <= last && i - start < taps.count; ++i) {
+      const double value = Evaluate(filter, (i + 0.5 - center) / stretch);
+      values[i - start] = value;
+      sum += value;
+    }
+    if (sum == 0.0) {
+      const int nearest = std::min(in - 1, static_cast<int>(center));
+      values[nearest - start] = 1.0;
+      sum = 1.0;
+    }
+    taps.start[o] = start;
+    float* weights = &taps.weights[static_cast<size_t>(o) * taps.count];
+    for (int k = 0; k < taps.count; ++k) {
+      weights[k] = static_cast<float>(values[k] / sum);
+    }
+  }
+  return taps;
+}
+
+// Clamp to [0, 255], keep colour <= alpha so the result stays valid
+// premultiplied BGRA, then round half to even like cvtps2dq.
+void StoreScalar(const float* acc, uint8_t* out, size_t count) {
+  for (size_t i = 0; i < count; i += 4) {
+    float pixel[4];
+    for (int c = 0; c < 4; ++c) {
+      pixel[c] = std::min(std::max(acc[i + c], 0.0f), 255.0f);
+    }
+    for (int c = 0; c < 3; ++c) {
+      pixel[c] = std::min(pixel[c], pixel[3]);
+    }
+    for (int c = 0; c < 4; ++c) {
+      out[i + c] = static_cast<uint8_t>(std::nearbyint(pixel[c]));
+    }
+  }
+}
+
+void HorizontalScalar(const uint8_t* row, const Taps& taps, int width, float* out) {
+  for (int x = 0; x < width; ++x) {
+    const uint8_t* pixels = row + static_cast<size_t>(taps.start[x]) * 4;
+    const float* weights = &taps.weights[static_cast<size_t>(x) * taps.count];
+    float acc[4] = {};
+    for (int k = 0; k < taps.count; ++k) {
+      for (int c = 0; c < 4; ++c) {
+        acc[c] = acc[c] + weights[k] * static_cast<float>(pixels[k * 4 + c]);
+      }
+    }
+    std::memcpy(out + static_cast<size_t>(x) * 4, acc, sizeof(acc));
+  }
+}
+
+void AccumulateScalar(float* acc, const float* row, float weight, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    acc[i] = acc[i] + weight * row[i];
+  }
+}
+
+#ifdef OPTISCALER_X86
+
+__m128 LoadPixelSse2(const uint8_t* pixel) {
+  int32_t packed;
+  std::memcpy(&packed, pixel, sizeof(packed));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bytes = _mm_cvtsi32_si128(packed);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+void HorizontalSse2(const uint8_t* row, const Taps& taps, int width, float* out) {
+  for (int x = 0; x < width; ++x) {
+    const uint8_t* pixels = row + static_cast<size_t>(taps.start[x]) * 4;
+    const float* weights = &taps.weights[static_cast<size_t>(x) * taps.count];
+    __m128 acc = _mm_setzero_ps();
+    for (int k = 0; k < taps.count; ++k) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), LoadPixelSse2(pixels + k * 4)));
+    }
+    _mm_storeu_ps(out + static_cast<size_t>(x) * 4, acc);
+  }
+}
+
+void AccumulateSse2(float* acc, const float* row, float weight, size_t count) {
+  const __m128 w = _mm_set1_ps(weight);
+  for (size_t i = 0; i < count; i += 4) {
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(w, _mm_loadu_ps(row + i))));
+  }
+}
+
+void StoreSse2(const float* acc, uint8_t* out, size_t count) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 max = _mm_set1_ps(255.0f);
+  for (size_t i = 0; i < count; i += 4) {
+    __m128 pixel = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(acc + i), zero), max);
+    pixel = _mm_min_ps(pixel, _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3)));
+    const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(pixel), _mm_setzero_si128());
+    const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    std::memcpy(out + i, &packed, sizeof(packed));
+  }
+}
+
+// Two output pixels per iteration, one per 128-bit lane, each with its own
+// taps, so the per-pixel accumulation order is unchanged.
+OPTISCALER_TARGET_AVX2 void HorizontalAvx2(const uint8_t* row, const Taps& taps, int width, float* out) {
+  int x = 0;
+  for (; x + 1 < width; x += 2) {
+    const uint8_t* pixels0 = row + static_cast<size_t>(taps.start[x]) * 4;
+    const uint8_t* pixels1 = row + static_cast<size_t>(taps.start[x + 1]) * 4;
+    const float* weights0 = &taps.weights[static_cast<size_t>(x) * taps.count];
+    const float* weights1 = weights0 + taps.count;
+    __m256 acc = _mm256_setzero_ps();
+    for (int k = 0; k < taps.count; ++k) {
+      int32_t packed0;
+      int32_t packed1;
+      std::memcpy(&packed0, pixels0 + k * 4, sizeof(packed0));
+      std::memcpy(&packed1, pixels1 + k * 4, sizeof(packed1));
+      const __m128i pair = _mm_unpacklo_epi32(_mm_cvtsi32_si128(packed0), _mm_cvtsi32_si128(packed1));
+      const __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(pair));
+      const __m256 weights =
+          _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights0[k])), _mm_set1_ps(weights1[k]), 1);
+      acc = _mm256_add_ps(acc, _mm256_mul_ps(weights, values));
+    }
+    _mm256_storeu_ps(out + static_cast<size_t>(x) * 4, acc);
+  }
+  if (x < width) {
+    const uint8_t* pixels = row + static_cast<size_t>(taps.start[x]) * 4;
+    const float* weights = &taps.weights[static_cast<size_t>(x) * taps.count];
+    __m128 acc = _mm_setzero_ps();
+    for (int k = 0; k < taps.count; ++k) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), LoadPixelSse2(pixels + k * 4)));
+    }
+    _mm_storeu_ps(out + static_cast<size_t>(x) * 4, acc);
+  }
+}
+
+OPTISCALER_TARGET_AVX2 void AccumulateAvx2(float* acc, const float* row, float weight, size_t count) {
+  const __m256 w = _mm256_set1_ps(weight);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(w, _mm256_loadu_ps(row + i))));
+  }
+  AccumulateSse2(acc + i, row + i, weight, count - i);
+}
+
+OPTISCALER_TARGET_AVX2 void StoreAvx2(const float* acc, uint8_t* out, size_t count) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 max = _mm256_set1_ps(255.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 pixels = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(acc + i), zero), max);
+    pixels = _mm256_min_ps(pixels, _mm256_permute_ps(pixels, 0xFF));
+    const __m256i dwords = _mm256_cvtps_epi32(pixels);
+    const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(dwords), _mm256_extracti128_si256(dwords, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+  }
+  StoreSse2(acc + i, out + i, count - i);
+}
+
+void Cpuid(int regs[4], int leaf, int subleaf) {
+#ifdef _MSC_VER
+  __cpuidex(regs, leaf, subleaf);
+#else
+  unsigned int a = 0;
+  unsigned int b = 0;
+  unsigned int c = 0;
+  unsigned int d = 0;
+  __cpuid_count(leaf, subleaf, a, b, c, d);
+  regs[0] = static_cast<int>(a);
+  regs[1] = static_cast<int>(b);
+  regs[2] = static_cast<int>(c);
+  regs[3] = static_cast<int>(d);
+#endif
+}
+
+uint64_t ReadXcr0() {
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+#endif  // OPTISCALER_X86
+
+ResampleKernel DetectKernel() {
+#ifdef OPTISCALER_X86
+  int regs[4] = {};
+  Cpuid(regs, 0, 0);
+  const int max_leaf = regs[0];
+  Cpuid(regs, 1, 0);
+  const bool sse2 = (regs[3] & (1 << 26)) != 0;
+  const bool osxsave = (regs[2] & (1 << 27)) != 0;
+  const bool avx = (regs[2] & (1 << 28)) != 0;
+  // AVX state must also be enabled by the OS (XCR0 bits 1 and 2).
+  if (max_leaf >= 7 && osxsave && avx && (ReadXcr0() & 0x6) == 0x6) {
+    Cpuid(regs, 7, 0);
+    if ((regs[1] & (1 << 5)) != 0) {
+      return ResampleKernel::kAvx2;
+    }
+  }
+  if (sse2) {
+    return ResampleKernel::kSse2;
+  }
+#endif
+  return ResampleKernel::kScalar;
+}
+
+struct KernelOps {
+  void (*horizontal)(const uint8_t* row, const Taps& taps, int width, float* out);
+  void (*accumulate)(float* acc, const float* row, float weight, size_t count);
+  void (*store)(const float* acc, uint8_t* out, size_t count);
+};
+
+KernelOps OpsFor(ResampleKernel kernel) {
+#ifdef OPTISCALER_X86
+  if (kernel == ResampleKernel::kAvx2) {
+    return {HorizontalAvx2, AccumulateAvx2, StoreAvx2};
+  }
+  if (kernel == ResampleKernel::kSse2) {
+    return {HorizontalSse2, AccumulateSse2, StoreSse2};
+  }
+#endif
+  (void)kernel;
+  return {HorizontalScalar, AccumulateScalar, StoreScalar};
+}
+
+}  // namespace
+
+ResampleKernel Resampler::BestKernel() {
+  static const ResampleKernel kernel = DetectKernel();
+  return kernel;
+}
+
+bool Resampler::Resize(const CoverImage& source, int width, int height, ResampleFilter filter,
+                       CoverImage& image_out) {
+  return Resize(source, width, height, filter, BestKernel(), image_out);
+}
+
+bool Resampler::Resize(const CoverImage& source, int width, int height, ResampleFilter filter, ResampleKernel kernel,
+                       CoverImage& image_out) {
+  if (source.empty() || width <= 0 || height <= 0) {
+    return false;
+  }
+  if (static_cast<int>(kernel) > static_cast<int>(BestKernel())) {
+    kernel = BestKernel();
+  }
+  const KernelOps ops = OpsFor(kernel);
+  const Taps columns = BuildTaps(source.width, width, filter);
+  const Taps rows = BuildTaps(source.height, height, filter);
+
+  // Horizontal pass only for source rows some output row reads.
+  const size_t row_floats = static_cast<size_t>(width) * 4;
+  const int first_row = rows.start.front();
+  const int last_row = std::min(source.height, rows.start.back() + rows.count);
+  std::vector<float> horizontal(static_cast<size_t>(last_row - first_row) * row_floats);
+  for (int y = first_row; y < last_row; ++y) {
+    ops.horizontal(source.data() + source.stride() * y, columns, width,
+                   horizontal.data() + static_cast<size_t>(y - first_row) * row_floats);
+  }
+
+  CoverImage image;
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(image.stride() * height);
+  std::vector<float> acc(row_floats);
+  for (int y = 0; y < height; ++y) {
+    std::fill(acc.begin(), acc.end(), 0.0f);
+    const float* weights = &rows.weights[static_cast<size_t>(y) * rows.count];
+    for (int k = 0; k < rows.count; ++k) {
+      const size_t source_row = static_cast<size_t>(rows.start[y] + k - first_row);
+      ops.accumulate(acc.data(), horizontal.data() + source_row * row_floats, weights[k], row_floats);
+    }
+    ops.store(acc.data(), image.pixels.data() + image.stride() * y, row_floats);
+  }
+  image_out = std::move(image);
+  return true;
+}
+
+std::vector<CoverImage> Resampler::ResizeForScales(const CoverImage& source, int width, int height,
+                                                   const std::vector<float>& scales, ResampleFilter filter) {
+  std::vector<CoverImage> images;
+  images.reserve(scales.size());
+  for (float scale : scales) {
+    CoverImage image;
+    Resize(source, static_cast<int>(std::lround(width * scale)), static_cast<int>(std::lround(height * scale)), filter,
+           image);
+    images.emplace_back(std::move(image));
+  }
+  return images;
+}
+
+}  // namespace optiscaler
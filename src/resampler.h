@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "cover_image.h"
+
+namespace optiscaler {
+
+enum class ResampleFilter {
+  kBox,       // area average; cheapest, fine for large downscales
+  kBilinear,  // tent
+  kLanczos3,  // sharpest; default for cover tiles
+};
+
+enum class ResampleKernel {
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// Separable BGRA resampling for cover normalization. Both passes run in
+// float over premultiplied pixels, and every code path accumulates taps in
+// the same order with separate multiplies and adds, so SIMD output is
+// bit-identical to the scalar path (the build keeps the compiler from
+// fusing them into FMAs). The kernel is picked once from CPUID; forcing one
+// the CPU lacks falls back to the best supported path.
+class Resampler {
+ public:
+  static ResampleKernel BestKernel();
+  static bool Resize(const CoverImage& source, int width, int height, ResampleFilter filter, CoverImage& image_out);
+  static bool Resize(const CoverImage& source, int width, int height, ResampleFilter filter, ResampleKernel kernel,
+                     CoverImage& image_out);
+  // One image per display scale, e.g. {1.0f, 1.5f, 2.0f} for high-DPI tiles
+  // of a width x height base size.
+  static std::vector<CoverImage> ResizeForScales(const CoverImage& source, int width, int height,
+                                                 const std::vector<float>& scales,
+                                                 ResampleFilter filter = ResampleFilter::kLanczos3);
+};
+
+}  // namespace optiscaler
@@ -6,5 +6,19 @@
 #define IDM_FILE_EXIT 2002
 #define IDM_TOOLS_SETTINGS 2003
 #define IDM_HELP_LOGS 2004
+#define IDM_VIEW_SORT_NAME 2005
+#define IDM_VIEW_SORT_SOURCE 2006
+#define IDM_VIEW_SORT_LAST_PLAYED 2007
+#define IDM_VIEW_SORT_SIZE 2008
+#define IDM_VIEW_PERF_OVERLAY 2009
+#define IDM_HELP_EXPORT_TRACE 2010
+#define IDM_FILTER_STEAM 2011
+#define IDM_FILTER_EPIC 2012
+#define IDM_FILTER_XBOX 2013
+#define IDM_FILTER_CUSTOM 2014
+#define IDM_FILTER_INJECT_ANY 2015
+#define IDM_FILTER_INJECT_ON 2016
+#define IDM_FILTER_INJECT_OFF 2017
 
 #define IDC_STATUS_BAR 3001
+#define IDC_SEARCH_BOX 3002
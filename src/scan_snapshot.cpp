@@ -0,0 +1,112 @@
+#include "scan_snapshot.h"
+
+#include <cwchar>
+#include <filesystem>
+
+#include "cache.h"
+
+namespace optiscaler {
+
+namespace {
+
+// One record per line, tab separated (Windows paths cannot contain tabs):
+//   D <mtime> <directory key>
+//   S <subdirectory name>
+//   E <executable name>
+constexpr wchar_t kHeader[] = L"OSMSNAP 2";
+
+}  // namespace
+
+std::wstring ScanSnapshot::DefaultPath() {
+  const std::wstring root = Cache::AppDataRoot();
+  if (root.empty()) {
+    return {};
+  }
+  std::filesystem::path path(root);
+  path /= L"cache";
+  Cache::EnsureDirectory(path.wstring());
+  path /= L"scan_snapshot.txt";
+  return path.wstring();
+}
+
+bool ScanSnapshot::Load(const std::wstring& path) {
+  directories_.clear();
+  std::wstring text;
+  if (!Cache::ReadText(path, text)) {
+    return false;
+  }
+  size_t pos = text.find(L'\n');
+  if (text.compare(0, pos, kHeader) != 0) {
+    return false;
+  }
+  DirectorySnapshot* current = nullptr;
+  while (pos != std::wstring::npos && pos + 1 < text.size()) {
+    const size_t begin = pos + 1;
+    pos = text.find(L'\n', begin);
+    const size_t end = pos == std::wstring::npos ? text.size() : pos;
+    if (end - begin < 2 || text[begin + 1] != L'\t') {
+      continue;
+    }
+    const wchar_t kind = text[begin];
+    std::wstring value = text.substr(begin + 2, end - begin - 2);
+    if (kind == L'D') {
+      wchar_t* cursor = nullptr;
+      DirectorySnapshot snapshot;
+      snapshot.mtime = std::wcstoll(value.c_str(), &cursor, 10);
+      if (*cursor != L'\t') {
+        current = nullptr;
+        continue;
+      }
+      current = &(directories_[std::wstring(cursor + 1)] = std::move(snapshot));
+    } else if (current && kind == L'S') {
+      current->subdirs.emplace_back(std::move(value));
+    } else if (current && kind == L'E') {
+      current->executables.emplace_back(std::move(value));
+    }
+  }
+  return true;
+}
+
+bool ScanSnapshot::Save(const std::wstring& path) const {
+  std::wstring text(kHeader);
+  text += L'\n';
+  for (const auto& [key, snapshot] : directories_) {
+    text += L"D\t";
+    text += std::to_wstring(snapshot.mtime);
+    text += L'\t';
+    text += key;
+    text += L'\n';
+    for (const auto& name : snapshot.subdirs) {
+      text += L"S\t";
+      text += name;
+      text += L'\n';
+    }
+    for (const auto& name : snapshot.executables) {
+      text += L"E\t";
+      text += name;
+      text += L'\n';
+    }
+  }
+  const std::wstring temp_path = path + L".tmp";
+  std::error_code ec;
+  if (!Cache::WriteText(temp_path, text)) {
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+const DirectorySnapshot* ScanSnapshot::Find(const std::wstring& directory_key) const {
+  auto it = directories_.find(directory_key);
+  if (it == directories_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace optiscaler {
+
+struct DirectorySnapshot {
+  int64_t mtime = 0;
+  std::vector<std::wstring> subdirs;      // child directory names
+  std::vector<std::wstring> executables;  // *.exe names before the skip filter
+};
+
+// Persistent record of the last scan, keyed by lowered absolute directory
+// path. A directory whose mtime is unchanged has the same direct children,
+// so a rescan can reuse its listing after a single stat.
+// Save writes a temp file and renames it over the old one, so a crash
+// leaves either snapshot intact. Not thread-safe; the scanner builds a
+// fresh map and swaps it in at the end.
+class ScanSnapshot {
+ public:
+  using DirectoryMap = std::unordered_map<std::wstring, DirectorySnapshot>;
+
+  static std::wstring DefaultPath();
+
+  bool Load(const std::wstring& path);
+  bool Save(const std::wstring& path) const;
+
+  const DirectorySnapshot* Find(const std::wstring& directory_key) const;
+  void Assign(DirectoryMap directories) { directories_ = std::move(directories); }
+  size_t size() const { return directories_.size(); }
+
+ private:
+  DirectoryMap directories_;
+};
+
+}  // namespace optiscaler
@@ -3,9 +3,23 @@
 #include <algorithm>
 #include <cwctype>
 #include <filesystem>
-#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <cstdlib>
+#endif
+
+#include "game_sort.h"
+#include "name_matcher.h"
+#include "path_key.h"
+#include "steam_library.h"
+#include "text_util.h"
+#include "thread_pool.h"
 
 namespace optiscaler {
 
@@ -21,39 +35,92 @@ std::wstring ToLower(const std::wstring& value) {
   return lower;
 }
 
-bool ShouldSkipExecutable(const std::wstring& filename_lower) {
-  constexpr const wchar_t* kPrefixes[] = {
-      L"unins",      L"uninstall",  L"setup",        L"dxsetup",   L"vc_redist",
-      L"vcredist",   L"helper",     L"crashreport",  L"readme",    L"support",
-      L"patch",      L"update",     L"redistributable"};
-  for (const auto* prefix : kPrefixes) {
-    if (filename_lower.rfind(prefix, 0) == 0) {
-      return true;
+// path::native() is already wide on Windows; other platforms convert, which
+// only the portable test build pays for.
+#ifdef _WIN32
+const std::wstring& WideOf(const std::filesystem::path& path) {
+  return path.native();
+}
+#else
+std::wstring WideOf(const std::filesystem::path& path) {
+  return path.wstring();
+}
+#endif
+
+constexpr std::wstring_view kSkipPrefixList[] = {
+    L"unins",      L"uninstall",  L"setup",        L"dxsetup",   L"vc_redist",
+    L"vcredist",   L"helper",     L"crashreport",  L"readme",    L"support",
+    L"patch",      L"update",     L"redistributable"};
+constexpr std::wstring_view kSkipSubstringList[] = {
+    L"crashhandler", L"crashreporter", L"unitycrash", L"eac_launcher", L"unrealcefsubprocess"};
+// Pattern order is priority: the earliest match anywhere in the path wins.
+constexpr std::wstring_view kSourceList[] = {L"steam", L"epic", L"xbox", L"microsoft"};
+constexpr const wchar_t* kSourceNames[] = {L"steam", L"epic", L"xbox", L"xbox"};
+
+constexpr auto kSkipPrefixes = BuildMatcher<128>(kSkipPrefixList);
+constexpr auto kSkipSubstrings = BuildMatcher<128>(kSkipSubstringList);
+constexpr auto kSources = BuildMatcher<32>(kSourceList);
+static_assert(kSkipPrefixes.ok() && kSkipSubstrings.ok() && kSources.ok(), "matcher capacity too small");
+
+constexpr size_t kUserPatternStates = 1024;
+using UserPatternMatcher = PatternMatcher<kUserPatternStates>;
+
+// Built-in skip lists plus patterns from settings. A user pattern ending in
+// '*' matches as a file name prefix, anything else as a substring; patterns
+// outside the matcher alphabet are ignored. Filtering never allocates.
+class SkipFilter {
+ public:
+  explicit SkipFilter(const std::vector<std::wstring>& user_patterns) {
+    for (const auto& pattern : user_patterns) {
+      std::wstring_view view(pattern);
+      const bool is_prefix = !view.empty() && view.back() == L'*';
+      if (is_prefix) {
+        view.remove_suffix(1);
+      }
+      auto& matcher = is_prefix ? user_prefixes_ : user_substrings_;
+      if (!matcher) {
+        matcher = std::make_unique<UserPatternMatcher>();
+      }
+      matcher->Add(view, 0);
+    }
+    if (user_prefixes_) {
+      user_prefixes_->Build();
+    }
+    if (user_substrings_) {
+      user_substrings_->Build();
     }
   }
 
-  constexpr const wchar_t* kSubstrings[] = {
-      L"crashhandler", L"crashreporter", L"unitycrash", L"eac_launcher", L"unrealcefsubprocess"};
-  for (const auto* substring : kSubstrings) {
-    if (filename_lower.find(substring) != std::wstring::npos) {
+  bool ShouldSkip(std::wstring_view filename) const {
+    if (kSkipPrefixes.MatchesPrefix(filename) || kSkipSubstrings.Contains(filename)) {
       return true;
     }
+    return (user_prefixes_ && user_prefixes_->MatchesPrefix(filename)) ||
+           (user_substrings_ && user_substrings_->Contains(filename));
   }
-  return false;
-}
 
-std::wstring GuessSource(const std::wstring& root) {
-  const std::wstring lower = ToLower(root);
-  if (lower.find(L"steam") != std::wstring::npos) {
-    return L"steam";
-  }
-  if (lower.find(L"epic") != std::wstring::npos) {
-    return L"epic";
+ private:
+  std::unique_ptr<UserPatternMatcher> user_prefixes_;
+  std::unique_ptr<UserPatternMatcher> user_substrings_;
+};
+
+bool HasExeExtension(std::wstring_view filename) {
+  constexpr std::wstring_view kExtension = L".exe";
+  if (filename.size() <= kExtension.size()) {
+    return false;
   }
-  if (lower.find(L"xbox") != std::wstring::npos || lower.find(L"microsoft") != std::wstring::npos) {
-    return L"xbox";
+  filename.remove_prefix(filename.size() - kExtension.size());
+  for (size_t i = 0; i < kExtension.size(); ++i) {
+    if (MatcherSymbol(filename[i]) != MatcherSymbol(kExtension[i])) {
+      return false;
+    }
   }
-  return L"custom";
+  return true;
+}
+
+std::wstring_view StemOf(std::wstring_view filename) {
+  const size_t dot = filename.find_last_of(L'.');
+  return dot == 0 || dot == std::wstring_view::npos ? filename : filename.substr(0, dot);
 }
 
 std::wstring DisplayNameFromStem(std::wstring stem) {
@@ -76,6 +143,7 @@ void AppendIfExists(std::vector<std::wstring>& roots, std::wstring path) {
   }
 }
 
+#ifdef _WIN32
 std::wstring GetEnvVar(const wchar_t* name) {
   const DWORD needed = GetEnvironmentVariableW(name, nullptr, 0);
   if (needed <= 1) {
@@ -90,113 +158,307 @@ std::wstring GetEnvVar(const wchar_t* name) {
   value.resize(written);
   return value;
 }
+#else
+std::wstring GetEnvVar(const wchar_t* name) {
+  const char* value = std::getenv(Utf8FromWide(name).c_str());
+  return value ? WideFromUtf8(value) : std::wstring();
+}
+#endif
 
-}  // namespace
+struct DirectoryTask {
+  size_t root = 0;
+  size_t depth = 0;
+  std::filesystem::path path;
+  std::filesystem::path gameRoot;  // empty while still at a multi-game root's top level
+};
 
-std::vector<GameEntry> Scanner::ScanAll(const std::vector<std::wstring>& roots) {
-  std::vector<GameEntry> games;
-  std::unordered_set<std::wstring> seen_paths;
-  std::error_code ec;
-  for (const auto& root : roots) {
-    if (root.empty()) {
-      continue;
-    }
-    std::filesystem::path root_path(root);
-    if (!std::filesystem::exists(root_path, ec)) {
-      ec.clear();
-      continue;
-    }
-    ec.clear();
-    const std::wstring source = GuessSource(root);
-    std::filesystem::recursive_directory_iterator it(
-        root_path, std::filesystem::directory_options::skip_permission_denied, ec);
-    if (ec) {
-      ec.clear();
-      continue;
+// Executables accepted in one directory. Only hashes are computed while
+// crawling; GameEntry strings are built for exes that survive de-dup.
+struct DirectoryHits {
+  size_t root = 0;
+  std::filesystem::path directory;
+  std::filesystem::path gameRoot;
+  std::vector<std::wstring> names;
+  std::vector<uint64_t> keys;  // HashJoinedPath(directory, name)
+};
+
+// Splits every root into one task per directory and runs them on a
+// work-stealing pool. Each root may only have `maxConcurrencyPerRoot`
+// directories in flight; the rest wait in a per-root backlog so one slow
+// share cannot occupy every worker. With a snapshot attached, directories
+// whose mtime matches the previous scan are expanded from the snapshot
+// instead of being listed again.
+class ParallelScan {
+ public:
+  ParallelScan(const std::vector<ScanRoot>& roots, const ScanOptions& options)
+      : roots_(roots.size()),
+        limit_(options.maxConcurrencyPerRoot),
+        snapshot_(options.snapshot),
+        skip_filter_(options.extraSkipPatterns),
+        pool_(options.workerCount) {
+    for (size_t i = 0; i < roots.size(); ++i) {
+      roots_[i].path = roots[i].path;
+      roots_[i].source = roots[i].source.empty() ? Scanner::GuessSource(roots[i].path) : roots[i].source;
+      roots_[i].steamAppId = roots[i].steamAppId;
+      roots_[i].name = roots[i].name;
+      roots_[i].isGameRoot = roots[i].isGameRoot;
+      roots_[i].installSize = roots[i].installSize;
+      roots_[i].lastPlayed = roots[i].lastPlayed;
     }
-    std::filesystem::recursive_directory_iterator end;
-    while (it != end) {
-      if (ec) {
-        ec.clear();
-        it.increment(ec);
+  }
+
+  std::vector<GameEntry> Run() {
+    std::error_code ec;
+    for (size_t i = 0; i < roots_.size(); ++i) {
+      RootState& root = roots_[i];
+      if (root.path.empty()) {
         continue;
       }
-      if (static_cast<size_t>(it.depth()) > kMaxScanDepth) {
-        it.disable_recursion_pending();
-        it.increment(ec);
+      std::filesystem::path root_path(root.path);
+      if (!std::filesystem::is_directory(root_path, ec)) {
+        ec.clear();
         continue;
       }
-      const auto& entry = *it;
-      if (!entry.is_regular_file(ec)) {
-        if (ec) {
-          ec.clear();
-        }
-        it.increment(ec);
+      root_path = std::filesystem::absolute(root_path, ec).lexically_normal();
+      if (ec) {
+        ec.clear();
         continue;
       }
+      std::filesystem::path game_root = root.isGameRoot ? root_path : std::filesystem::path();
+      Schedule(DirectoryTask{i, 0, std::move(root_path), std::move(game_root)});
+    }
+    pool_.Wait();
+    if (snapshot_) {
+      snapshot_->Assign(std::move(next_snapshot_));
+    }
+    return Merge();
+  }
 
-      const std::filesystem::path& file_path = entry.path();
-      std::wstring extension = ToLower(file_path.extension().wstring());
-      if (extension != L".exe") {
-        it.increment(ec);
-        continue;
+ private:
+  struct RootState {
+    std::wstring path;
+    std::wstring source;
+    std::optional<uint32_t> steamAppId;
+    std::wstring name;
+    bool isGameRoot = false;
+    uint64_t installSize = 0;
+    int64_t lastPlayed = 0;
+    std::mutex mutex;
+    size_t active = 0;
+    std::vector<DirectoryTask> backlog;
+  };
+
+  void Schedule(DirectoryTask task) {
+    RootState& root = roots_[task.root];
+    {
+      std::lock_guard<std::mutex> lock(root.mutex);
+      if (limit_ != 0 && root.active >= limit_) {
+        root.backlog.emplace_back(std::move(task));
+        return;
       }
+      ++root.active;
+    }
+    Dispatch(std::move(task));
+  }
 
-      std::wstring filename_lower = ToLower(file_path.filename().wstring());
-      if (ShouldSkipExecutable(filename_lower)) {
-        it.increment(ec);
-        continue;
+  void Dispatch(DirectoryTask task) {
+    pool_.Submit([this, task = std::move(task)] {
+      Visit(task);
+      Release(task.root);
+    });
+  }
+
+  void Release(size_t root_index) {
+    RootState& root = roots_[root_index];
+    DirectoryTask next;
+    {
+      std::lock_guard<std::mutex> lock(root.mutex);
+      if (root.backlog.empty()) {
+        --root.active;
+        return;
       }
+      next = std::move(root.backlog.back());
+      root.backlog.pop_back();
+    }
+    Dispatch(std::move(next));
+  }
 
-      std::filesystem::path absolute = std::filesystem::absolute(file_path, ec);
-      if (ec) {
-        ec.clear();
-        it.increment(ec);
-        continue;
+  void Visit(const DirectoryTask& task) {
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(task.path, ec);
+    if (ec) {
+      return;
+    }
+    const std::wstring key = ToLower(WideOf(task.path));
+    const DirectorySnapshot* cached = snapshot_ ? snapshot_->Find(key) : nullptr;
+    DirectorySnapshot listing;
+    bool complete = true;
+    if (cached && cached->mtime == mtime.time_since_epoch().count()) {
+      listing = *cached;
+    } else {
+      listing.mtime = mtime.time_since_epoch().count();
+      complete = List(task.path, listing);
+    }
+
+    if (task.depth < kMaxScanDepth) {
+      for (const auto& name : listing.subdirs) {
+        std::filesystem::path child = task.path / name;
+        std::filesystem::path game_root = task.gameRoot.empty() ? child : task.gameRoot;
+        Schedule(DirectoryTask{task.root, task.depth + 1, std::move(child), std::move(game_root)});
+      }
+    }
+    // The directory prefix is hashed once; each exe only extends it.
+    DirectoryHits hits;
+    const std::wstring& directory = WideOf(task.path);
+    const uint64_t directory_hash = listing.executables.empty() ? 0 : HashPath(directory);
+    for (const auto& name : listing.executables) {
+      if (!skip_filter_.ShouldSkip(name)) {
+        hits.keys.push_back(HashJoinedPath(directory_hash, directory, name));
+        hits.names.push_back(name);
       }
-      absolute = absolute.lexically_normal();
-      std::wstring normalized_lower = ToLower(absolute.native());
-      if (!seen_paths.insert(normalized_lower).second) {
-        it.increment(ec);
+    }
+
+    if (snapshot_ && complete) {
+      std::lock_guard<std::mutex> lock(next_snapshot_mutex_);
+      next_snapshot_.emplace(key, std::move(listing));
+    }
+    if (hits.names.empty()) {
+      return;
+    }
+    hits.root = task.root;
+    hits.directory = task.path;
+    hits.gameRoot = task.gameRoot;
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    results_.emplace_back(std::move(hits));
+  }
+
+  // Reads one directory level. Returns false if the listing was cut short,
+  // in which case the partial result is used but not remembered.
+  static bool List(const std::filesystem::path& directory, DirectorySnapshot& listing) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(
+        directory, std::filesystem::directory_options::skip_permission_denied, ec);
+    const std::filesystem::directory_iterator end;
+    for (; !ec && it != end; it.increment(ec)) {
+      const auto& entry = *it;
+      const std::wstring& native = WideOf(entry.path());
+      const std::wstring_view name = std::wstring_view(native).substr(native.find_last_of(L"\\/") + 1);
+      std::error_code entry_ec;
+      if (entry.is_directory(entry_ec) && !entry.is_symlink(entry_ec)) {
+        listing.subdirs.emplace_back(name);
         continue;
       }
+      if (entry.is_regular_file(entry_ec) && HasExeExtension(name)) {
+        listing.executables.emplace_back(name);
+      }
+    }
+    return !ec;
+  }
 
-      GameEntry game;
-      game.exe = absolute.wstring();
-      game.folder = absolute.parent_path().wstring();
-      game.name = DisplayNameFromStem(file_path.stem().wstring());
-      game.source = source;
-      games.emplace_back(std::move(game));
-      it.increment(ec);
+  // Workers finish in arbitrary order, so the merge re-imposes the serial
+  // walker's rules: an exe reachable from several roots belongs to the
+  // earliest root, and the final list is ordered by name then path.
+  std::vector<GameEntry> Merge() {
+    std::sort(results_.begin(), results_.end(),
+              [](const DirectoryHits& a, const DirectoryHits& b) { return a.root < b.root; });
+    size_t total = 0;
+    for (const auto& hits : results_) {
+      total += hits.names.size();
     }
+    PathKeySet seen(total);
+    std::vector<GameEntry> games;
+    games.reserve(total);
+    for (const auto& hits : results_) {
+      const std::wstring& directory = WideOf(hits.directory);
+      for (size_t i = 0; i < hits.names.size(); ++i) {
+        if (seen.Insert(hits.keys[i], directory, hits.names[i])) {
+          games.emplace_back(MakeEntry(hits, hits.names[i]));
+          games.back().coverKey = hits.keys[i];
+        }
+      }
+    }
+
+    SortGames(games);
+    return games;
   }
 
-  std::sort(games.begin(), games.end(), [](const GameEntry& a, const GameEntry& b) {
-    const std::wstring lower_a = ToLower(a.name);
-    const std::wstring lower_b = ToLower(b.name);
-    if (lower_a == lower_b) {
-      return a.exe < b.exe;
+  GameEntry MakeEntry(const DirectoryHits& hits, const std::wstring& filename) const {
+    const RootState& root = roots_[hits.root];
+    GameEntry game;
+    game.exe = (hits.directory / filename).wstring();
+    game.folder = hits.gameRoot.empty() ? hits.directory.wstring() : hits.gameRoot.wstring();
+    if (!root.name.empty()) {
+      game.name = root.name;
+    } else if (!root.isGameRoot && !hits.gameRoot.empty()) {
+      game.name = DisplayNameFromStem(hits.gameRoot.filename().wstring());
+    } else {
+      game.name = DisplayNameFromStem(std::wstring(StemOf(filename)));
     }
-    return lower_a < lower_b;
-  });
+    game.source = root.source;
+    game.steamAppId = root.steamAppId;
+    game.installSize = root.installSize;
+    game.lastPlayed = root.lastPlayed;
+    return game;
+  }
+
+  std::vector<RootState> roots_;
+  const size_t limit_;
+  ScanSnapshot* snapshot_;
+  const SkipFilter skip_filter_;
+  std::mutex next_snapshot_mutex_;
+  ScanSnapshot::DirectoryMap next_snapshot_;
+  std::mutex results_mutex_;
+  std::vector<DirectoryHits> results_;
+  WorkStealingPool pool_;
+};
+
+#ifdef _WIN32
+std::wstring ReadRegistryString(HKEY root, const wchar_t* subkey, const wchar_t* value) {
+  DWORD size = 0;
+  if (RegGetValueW(root, subkey, value, RRF_RT_REG_SZ, nullptr, nullptr, &size) != ERROR_SUCCESS || size == 0) {
+    return {};
+  }
+  std::wstring result(size / sizeof(wchar_t), L'\0');
+  if (RegGetValueW(root, subkey, value, RRF_RT_REG_SZ, nullptr, result.data(), &size) != ERROR_SUCCESS) {
+    return {};
+  }
+  result.resize(wcsnlen(result.c_str(), result.size()));
+  return result;
+}
+#endif
+
+}  // namespace
 
-  return games;
+std::vector<GameEntry> Scanner::ScanAll(const std::vector<std::wstring>& roots) {
+  return ScanAll(roots, ScanOptions{});
+}
+
+std::vector<GameEntry> Scanner::ScanAll(const std::vector<std::wstring>& roots, const ScanOptions& options) {
+  std::vector<ScanRoot> scan_roots;
+  scan_roots.reserve(roots.size());
+  for (const auto& root : roots) {
+    scan_roots.push_back(ScanRoot{root, {}, std::nullopt, {}, false, 0, 0});
+  }
+  return ScanAll(scan_roots, options);
+}
+
+std::vector<GameEntry> Scanner::ScanAll(const std::vector<ScanRoot>& roots, const ScanOptions& options) {
+  ParallelScan scan(roots, options);
+  return scan.Run();
 }
 
 std::vector<std::wstring> Scanner::DefaultFolders() {
   std::vector<std::wstring> roots;
-  const std::wstring program_files_x86 = GetEnvVar(L"ProgramFiles(x86)");
   std::wstring program_files = GetEnvVar(L"ProgramW6432");
   if (program_files.empty()) {
     program_files = GetEnvVar(L"ProgramFiles");
   }
   const std::wstring program_data = GetEnvVar(L"ProgramData");
 
-  if (!program_files_x86.empty()) {
-    AppendIfExists(roots, program_files_x86 + L"\\Steam\\steamapps\\common");
+  for (const auto& library : SteamLibrary::LibraryFolders(SteamRoot())) {
+    AppendIfExists(roots, library + L"\\steamapps\\common");
   }
   if (!program_files.empty()) {
-    AppendIfExists(roots, program_files + L"\\Steam\\steamapps\\common");
     AppendIfExists(roots, program_files + L"\\Epic Games");
     AppendIfExists(roots, program_files + L"\\ModifiableWindowsApps");
   }
@@ -209,4 +471,58 @@ std::vector<std::wstring> Scanner::DefaultFolders() {
   return roots;
 }
 
+std::wstring Scanner::SteamRoot() {
+  std::wstring path;
+#ifdef _WIN32
+  path = ReadRegistryString(HKEY_CURRENT_USER, L"Software\\Valve\\Steam", L"SteamPath");
+  if (path.empty()) {
+    path = ReadRegistryString(HKEY_LOCAL_MACHINE, L"SOFTWARE\\WOW6432Node\\Valve\\Steam", L"InstallPath");
+  }
+#endif
+  if (path.empty()) {
+    const std::wstring program_files_x86 = GetEnvVar(L"ProgramFiles(x86)");
+    if (!program_files_x86.empty()) {
+      path = program_files_x86 + L"\\Steam";
+    }
+  }
+  std::error_code ec;
+  if (path.empty() || !std::filesystem::is_directory(path, ec)) {
+    return {};
+  }
+  return std::filesystem::path(path).lexically_normal().wstring();
+}
+
+std::wstring Scanner::EpicManifestDir() {
+  const std::wstring program_data = GetEnvVar(L"ProgramData");
+  if (program_data.empty()) {
+    return {};
+  }
+  return program_data + L"\\Epic\\EpicGamesLauncher\\Data\\Manifests";
+}
+
+std::wstring Scanner::GuessSource(const std::wstring& path) {
+  const uint8_t match = kSources.FindFirst(path);
+  return match == kNoMatch ? L"custom" : kSourceNames[match];
+}
+
+std::vector<std::wstring> Scanner::SplitPatterns(std::wstring_view list) {
+  std::vector<std::wstring> patterns;
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    const size_t end = std::min(list.find(L';', begin), list.size());
+    std::wstring_view pattern = list.substr(begin, end - begin);
+    while (!pattern.empty() && std::iswspace(pattern.front())) {
+      pattern.remove_prefix(1);
+    }
+    while (!pattern.empty() && std::iswspace(pattern.back())) {
+      pattern.remove_suffix(1);
+    }
+    if (!pattern.empty()) {
+      patterns.emplace_back(pattern);
+    }
+    begin = end + 1;
+  }
+  return patterns;
+}
+
 }  // namespace optiscaler
@@ -1,16 +1,45 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "game_types.h"
+#include "scan_snapshot.h"
 
 namespace optiscaler {
 
+struct ScanRoot {
+  std::wstring path;
+  std::wstring source;                 // empty = guessed from the path
+  std::optional<uint32_t> steamAppId;  // attached to every exe found under path
+  std::wstring name;                   // store title; empty = derived from the folder or exe
+  bool isGameRoot = false;             // path is one game's install dir, not a library of games
+  uint64_t installSize = 0;            // from the store manifest, copied to every exe found
+  int64_t lastPlayed = 0;
+};
+
+struct ScanOptions {
+  size_t workerCount = 0;                       // 0 = one worker per hardware thread
+  size_t maxConcurrencyPerRoot = 4;             // 0 = unlimited; throttles slow disks and shares
+  ScanSnapshot* snapshot = nullptr;             // reused for unchanged directories, then replaced
+  std::vector<std::wstring> extraSkipPatterns;  // "name*" = file name prefix, else substring
+};
+
 class Scanner {
  public:
   static std::vector<GameEntry> ScanAll(const std::vector<std::wstring>& roots);
+  static std::vector<GameEntry> ScanAll(const std::vector<std::wstring>& roots, const ScanOptions& options);
+  static std::vector<GameEntry> ScanAll(const std::vector<ScanRoot>& roots, const ScanOptions& options);
   static std::vector<std::wstring> DefaultFolders();
+  static std::wstring SteamRoot();
+  static std::wstring EpicManifestDir();
+  static std::wstring GuessSource(const std::wstring& path);
+  // Splits a ';'-separated settings value into trimmed, non-empty patterns
+  // for ScanOptions::extraSkipPatterns.
+  static std::vector<std::wstring> SplitPatterns(std::wstring_view list);
 };
 
 }  // namespace optiscaler
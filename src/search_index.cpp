@@ -0,0 +1,471 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <cwctype>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr uint64_t kPathField = 1ull << 63;
+constexpr size_t kMaxQueryGrams = 64;  // keeps per-document hit counts in a byte
+constexpr size_t kMinRebuildDocuments = 1024;
+constexpr uint16_t kNameHit = 1;
+constexpr uint16_t kPathHit = 1 << 8;
+// Posting entries a linear merge may read per candidate before probing
+// each candidate with a binary search is cheaper.
+constexpr size_t kProbeCost = 16;
+// Ranking: gram coverage of the name counts twice as much as of the paths,
+// and a name that reads like the query beats one that merely shares grams.
+constexpr int kNameWeight = 64;
+constexpr int kPathWeight = 32;
+constexpr int kPrefixBonus = 96;
+constexpr int kWordPrefixBonus = 64;
+constexpr int kSubstringBonus = 32;
+constexpr uint32_t kMaxLengthRank = 63;
+constexpr size_t kRankKeys = (kNameWeight + kPathWeight + kPrefixBonus + 1) * (kMaxLengthRank + 1);
+// Marks a ranked document whose name bonus is still an upper bound.
+constexpr uint32_t kUnread = 1u << 31;
+// Names sharing a query's head are checked against a longer query for at
+// most this many per wanted result before the full search takes over.
+constexpr size_t kPrefixProbesPerResult = 2;
+
+// Stable; keys are below kRankKeys.
+void SortByKeyDescending(std::vector<std::pair<uint32_t, uint32_t>>& items) {
+  std::vector<uint32_t> starts(kRankKeys + 1);
+  for (const auto& item : items) {
+    ++starts[kRankKeys - item.first];
+  }
+  uint32_t next = 0;
+  for (uint32_t& start : starts) {
+    const uint32_t count = start;
+    start = next;
+    next += count;
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> sorted(items.size());
+  for (const auto& item : items) {
+    sorted[starts[kRankKeys - item.first]++] = item;
+  }
+  items = std::move(sorted);
+}
+
+// Lowercase alphanumeric words separated by single spaces.
+std::wstring Fold(std::wstring_view text) {
+  std::wstring folded;
+  folded.reserve(text.size());
+  bool separate = false;
+  for (wchar_t ch : text) {
+    if (!std::iswalnum(ch)) {
+      separate = !folded.empty();
+      continue;
+    }
+    if (separate) {
+      folded.push_back(L' ');
+      separate = false;
+    }
+    folded.push_back(static_cast<wchar_t>(std::towlower(ch)));
+  }
+  return folded;
+}
+
+std::wstring_view Stem(std::wstring_view file_name) {
+  const size_t dot = file_name.rfind(L'.');
+  return dot == std::wstring_view::npos || dot == 0 ? file_name : file_name.substr(0, dot);
+}
+
+uint64_t Gram(wchar_t a, wchar_t b, wchar_t c) {
+  constexpr uint64_t kMask = 0x1FFFFF;  // any code point
+  return (static_cast<uint64_t>(a) & kMask) << 42 | (static_cast<uint64_t>(b) & kMask) << 21 |
+         (static_cast<uint64_t>(c) & kMask);
+}
+
+// Calls fn(gram) for each word of folded text: the word-start grams
+// (padded with 0) and every inner trigram. For a query, words of three or
+// more letters only contribute inner trigrams so they also match inside
+// longer words.
+template <typename Fn>
+void ForEachGram(std::wstring_view folded, bool query, Fn&& fn) {
+  size_t begin = 0;
+  while (begin < folded.size()) {
+    const size_t end = std::min(folded.find(L' ', begin), folded.size());
+    const std::wstring_view word = folded.substr(begin, end - begin);
+    if (!query || word.size() == 1) {
+      fn(Gram(0, 0, word[0]));
+    }
+    if (word.size() >= 2 && (!query || word.size() == 2)) {
+      fn(Gram(0, word[0], word[1]));
+    }
+    for (size_t i = 0; i + 3 <= word.size(); ++i) {
+      fn(Gram(word[i], word[i + 1], word[i + 2]));
+    }
+    begin = end + 1;
+  }
+}
+
+// True if every word of `query` starts some word of `name`.
+bool WordsStartName(std::wstring_view name, std::wstring_view query) {
+  size_t begin = 0;
+  while (begin < query.size()) {
+    const size_t end = std::min(query.find(L' ', begin), query.size());
+    const std::wstring_view word = query.substr(begin, end - begin);
+    // A plain loop: names are short, and find() costs a library call per
+    // attempt.
+    bool found = false;
+    for (size_t at = 0; at + word.size() <= name.size() && !found; ++at) {
+      found = (at == 0 || name[at - 1] == L' ') && name[at] == word[0] &&
+              std::equal(word.begin(), word.end(), name.begin() + static_cast<ptrdiff_t>(at));
+    }
+    if (!found) {
+      return false;
+    }
+    begin = end + 1;
+  }
+  return true;
+}
+
+// A typo costs a word up to three trigrams. Queries of one or two grams
+// must match exactly; longer ones tolerate one typo, and two past eight
+// grams, but always need half their grams.
+int RequiredHits(int total) {
+  const int typos = total <= 2 ? 0 : (total <= 8 ? 1 : 2);
+  return std::max((total + 1) / 2, total - 3 * typos);
+}
+
+// The first three code units as one Gram, 0 past the end.
+uint64_t Head(std::wstring_view text) {
+  return Gram(text.size() > 0 ? text[0] : 0, text.size() > 1 ? text[1] : 0, text.size() > 2 ? text[2] : 0);
+}
+
+// Keeps the code units of Head that a query of `length` sets.
+uint64_t HeadMask(size_t length) {
+  return length < 3 ? ~uint64_t{0} << (21 * (3 - length)) : ~uint64_t{0};
+}
+
+}  // namespace
+
+SearchIndex::SearchIndex(const GameCatalog& catalog) : catalog_(catalog) {}
+
+void SearchIndex::Apply(const CatalogDelta& delta) {
+  for (GameId id : delta.removed) {
+    Remove(id);
+  }
+  for (GameId id : delta.changed) {
+    Add(id);
+  }
+  for (GameId id : delta.added) {
+    Add(id);
+  }
+  MaybeRebuild();
+  SortHeads();
+}
+
+void SearchIndex::Add(GameId id) {
+  Remove(id);
+  if (!catalog_.Contains(id)) {
+    return;
+  }
+  const uint32_t doc = static_cast<uint32_t>(docs_.size());
+  const std::wstring name = Fold(catalog_.Name(id));
+  std::vector<uint64_t> grams;
+  ForEachGram(name, false, [&grams](uint64_t gram) { grams.push_back(gram); });
+  // Library roots are shared by every game under them, so only the game's
+  // own folder and exe name are indexed; source filters cover the rest.
+  const PathTable& paths = catalog_.paths();
+  for (const PathId path : {catalog_.FolderPath(id), catalog_.ExePath(id)}) {
+    if (path != kEmptyPath) {
+      const std::wstring leaf = Fold(Stem(paths.Leaf(path)));
+      ForEachGram(leaf, false, [&grams](uint64_t gram) { grams.push_back(gram | kPathField); });
+    }
+  }
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+  for (uint64_t gram : grams) {
+    postings_[gram].push_back(doc);
+  }
+  heads_sorted_ = false;
+
+  docs_.push_back({Head(name), id, static_cast<uint32_t>(names_.size()), static_cast<uint32_t>(name.size()),
+                   catalog_.Source(id), catalog_.Flags(id)});
+  names_ += name;
+  if (id >= documents_.size()) {
+    documents_.resize(static_cast<size_t>(id) + 1, kNoDocument);
+  }
+  documents_[id] = doc;
+}
+
+void SearchIndex::Remove(GameId id) {
+  if (id >= documents_.size() || documents_[id] == kNoDocument) {
+    return;
+  }
+  docs_[documents_[id]].id = kInvalidGameId;
+  documents_[id] = kNoDocument;
+  ++dead_;
+  heads_sorted_ = false;
+}
+
+void SearchIndex::Rebuild() {
+  postings_.clear();
+  docs_.clear();
+  names_.clear();
+  documents_.clear();
+  by_head_.clear();
+  heads_sorted_ = false;
+  dead_ = 0;
+  for (GameId id : catalog_.ids()) {
+    Add(id);
+  }
+  SortHeads();
+}
+
+bool SearchIndex::HasTerms(std::wstring_view query) {
+  return std::any_of(query.begin(), query.end(), [](wchar_t ch) { return std::iswalnum(ch) != 0; });
+}
+
+std::vector<GameId> SearchIndex::Search(std::wstring_view query, const GameFilter& filter, size_t limit) const {
+  const std::wstring folded = Fold(query);
+  std::vector<uint64_t> grams;
+  ForEachGram(folded, true, [&grams](uint64_t gram) { grams.push_back(gram); });
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+  grams.resize(std::min(grams.size(), kMaxQueryGrams));
+  if (grams.empty() || limit == 0) {
+    return {};
+  }
+  // Names starting with the query outrank the rest, so when there are
+  // enough of those the postings are never read. That is what makes broad
+  // queries, one or two letters or a common word, cheap.
+  if (heads_sorted_ && limit < docs_.size()) {
+    std::vector<GameId> ids = PrefixMatches(folded, filter, limit);
+    if (ids.size() == limit) {
+      return ids;
+    }
+  }
+
+  // A document sharing `required` of the query's grams in one field must
+  // be in at least one of that field's `total - required + 1` shortest
+  // lists. Only those produce candidates; the longer lists, shortest
+  // first, just add to candidates' counts (merged when short enough,
+  // otherwise probed), and candidates that can no longer qualify are
+  // dropped after each. hits_ is all zero between searches.
+  const int total = static_cast<int>(grams.size());
+  const int required = RequiredHits(total);
+  const size_t scanned = static_cast<size_t>(total - required + 1);
+  static const std::vector<uint32_t> kNoPostings;
+  std::vector<const std::vector<uint32_t>*> lists[2];
+  for (int field = 0; field < 2; ++field) {
+    for (uint64_t gram : grams) {
+      const auto found = postings_.find(field == 0 ? gram : gram | kPathField);
+      lists[field].push_back(found == postings_.end() ? &kNoPostings : &found->second);
+    }
+    std::sort(lists[field].begin(), lists[field].end(),
+              [](const auto* a, const auto* b) { return a->size() < b->size(); });
+  }
+  hits_.resize(docs_.size());
+  touched_.clear();
+  for (int field = 0; field < 2; ++field) {
+    const uint16_t hit = field == 0 ? kNameHit : kPathHit;
+    for (size_t i = 0; i < scanned; ++i) {
+      for (uint32_t doc : *lists[field][i]) {
+        if (hits_[doc] == 0) {
+          touched_.push_back(doc);
+        }
+        hits_[doc] += hit;
+      }
+    }
+  }
+  for (size_t i = scanned; i < grams.size() && !touched_.empty(); ++i) {
+    for (int field = 0; field < 2; ++field) {
+      const uint16_t hit = field == 0 ? kNameHit : kPathHit;
+      const std::vector<uint32_t>& docs = *lists[field][i];
+      if (docs.size() <= touched_.size() * kProbeCost) {
+        for (uint32_t doc : docs) {
+          // Branch-free: whether a posting is a candidate is a coin flip.
+          hits_[doc] += hits_[doc] != 0 ? hit : 0;
+        }
+        continue;
+      }
+      for (uint32_t doc : touched_) {
+        if (std::binary_search(docs.begin(), docs.end(), doc)) {
+          hits_[doc] += hit;
+        }
+      }
+    }
+    // Drop candidates that can no longer reach `required` in either field,
+    // which only pays off when the next lists are probed per candidate; the
+    // ranking below skips the rest anyway.
+    const size_t next = i + 1;
+    if (next == grams.size() ||
+        std::max(lists[0][next]->size(), lists[1][next]->size()) <= touched_.size() * kProbeCost) {
+      continue;
+    }
+    const int remaining = total - static_cast<int>(i) - 1;
+    size_t kept = 0;
+    for (uint32_t doc : touched_) {
+      if (std::max(hits_[doc] & 0xFF, hits_[doc] >> 8) + remaining >= required) {
+        touched_[kept++] = doc;
+      } else {
+        hits_[doc] = 0;
+      }
+    }
+    touched_.resize(kept);
+  }
+
+  // Rank by score, then shorter names, with counting sorts over the
+  // combined key. Only names holding every query gram can read like the
+  // query. Queries of up to three letters check the prefix against the
+  // name's Head, so broad short queries never touch the names, and a
+  // one-word query under three letters only matched word-start grams,
+  // which already means it starts a name word. Other names have to be
+  // read; until then their key assumes the best bonus their Head allows.
+  const uint64_t query_head = Head(folded);
+  const uint64_t head_mask = HeadMask(folded.size());
+  auto bonus_bound = [&](const Document& doc) {
+    return (doc.head & head_mask) == query_head ? kPrefixBonus : kWordPrefixBonus;
+  };
+  auto name_bonus = [&](const Document& doc) {
+    const std::wstring_view name(names_.data() + doc.nameBegin, doc.nameLength);
+    if (folded.size() > 3 && name.substr(0, folded.size()) == folded) {
+      return kPrefixBonus;
+    }
+    if (WordsStartName(name, folded)) {
+      return kWordPrefixBonus;
+    }
+    return name.find(folded) != std::wstring_view::npos ? kSubstringBonus : 0;
+  };
+  const bool exact_bonus = folded.size() <= 2;
+  std::vector<std::pair<uint32_t, uint32_t>> matches;  // key, document (kUnread until the name is read)
+  matches.reserve(touched_.size());
+  for (uint32_t doc : touched_) {
+    const int name_hits = hits_[doc] & 0xFF;
+    const int path_hits = hits_[doc] >> 8;
+    hits_[doc] = 0;
+    const Document& document = docs_[doc];
+    if (document.id == kInvalidGameId || std::max(name_hits, path_hits) < required ||
+        !filter.Matches(document.source, document.flags)) {
+      continue;
+    }
+    int score = kNameWeight * name_hits / total + kPathWeight * path_hits / total;
+    uint32_t unread = 0;
+    if (name_hits == total) {
+      score += bonus_bound(document);
+      unread = exact_bonus || (folded.size() == 3 && bonus_bound(document) == kPrefixBonus) ? 0 : kUnread;
+    }
+    const uint32_t shortness = kMaxLengthRank - std::min(document.nameLength, kMaxLengthRank);
+    matches.emplace_back(static_cast<uint32_t>(score) * (kMaxLengthRank + 1) + shortness, doc | unread);
+  }
+  auto read = [&](std::pair<uint32_t, uint32_t>& match) {
+    if (match.second & kUnread) {
+      match.second &= ~kUnread;
+      const Document& document = docs_[match.second];
+      match.first -= static_cast<uint32_t>(bonus_bound(document) - name_bonus(document)) * (kMaxLengthRank + 1);
+    }
+  };
+  if (matches.size() <= limit) {
+    for (auto& match : matches) {
+      read(match);
+    }
+  } else {
+    // Only the best `limit` are wanted: read names best bound first and
+    // stop once `limit` exact keys are at least the next bound.
+    SortByKeyDescending(matches);
+    std::vector<uint32_t> read_keys(kRankKeys);  // exact keys seen, by key
+    uint32_t floor = static_cast<uint32_t>(kRankKeys);
+    size_t ready = 0;  // exact keys at or above `floor`
+    size_t count = 0;
+    for (; count < matches.size(); ++count) {
+      auto& match = matches[count];
+      for (; floor > match.first; --floor) {
+        ready += read_keys[floor - 1];
+      }
+      if (ready >= limit) {
+        break;
+      }
+      read(match);
+      ++read_keys[match.first];
+      ready += match.first >= floor ? 1 : 0;
+    }
+    matches.resize(count);
+  }
+  SortByKeyDescending(matches);
+  std::vector<GameId> ids(std::min(matches.size(), limit));
+  for (size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = docs_[matches[i].second].id;
+  }
+  return ids;
+}
+
+std::vector<GameId> SearchIndex::PrefixMatches(std::wstring_view folded, const GameFilter& filter,
+                                               size_t limit) const {
+  // Under three letters the query spans several heads, each a run of its
+  // own, so the whole range is gathered and cut; otherwise the run is
+  // already shortest first and the walk stops once `limit` names match.
+  const uint64_t low = Head(folded);
+  const uint64_t high = low | ~HeadMask(folded.size());
+  const auto first = std::lower_bound(by_head_.begin(), by_head_.end(), low,
+                                      [](const HeadEntry& entry, uint64_t head) { return entry.head < head; });
+  const auto last = std::upper_bound(first, by_head_.end(), high,
+                                     [](uint64_t head, const HeadEntry& entry) { return head < entry.head; });
+  if (static_cast<size_t>(last - first) < limit) {
+    return {};
+  }
+  const bool one_run = folded.size() >= 3;
+  const size_t max_probes = folded.size() > 3 ? limit * kPrefixProbesPerResult : SIZE_MAX;
+  std::vector<std::pair<uint16_t, uint32_t>> found;  // name length, document
+  size_t probes = 0;
+  for (auto it = first; it != last && probes < max_probes && !(one_run && found.size() == limit); ++it, ++probes) {
+    if (!filter.Matches(it->source, it->flags)) {
+      continue;
+    }
+    // Past the head only a longer query needs the name itself.
+    if (folded.size() > 3 && (it->nameLength < folded.size() ||
+                              std::wstring_view(names_.data() + docs_[it->doc].nameBegin, folded.size()) != folded)) {
+      continue;
+    }
+    found.emplace_back(it->nameLength, it->doc);
+  }
+  if (found.size() < limit) {
+    return {};
+  }
+  std::partial_sort(found.begin(), found.begin() + static_cast<ptrdiff_t>(limit), found.end());
+  std::vector<GameId> ids(limit);
+  for (size_t i = 0; i < limit; ++i) {
+    ids[i] = docs_[found[i].second].id;
+  }
+  return ids;
+}
+
+SearchIndexStats SearchIndex::Stats() const {
+  SearchIndexStats stats;
+  stats.documents = docs_.size() - dead_;
+  stats.deadDocuments = dead_;
+  stats.grams = postings_.size();
+  for (const auto& [gram, docs] : postings_) {
+    stats.postings += docs.size();
+  }
+  return stats;
+}
+
+void SearchIndex::SortHeads() {
+  if (heads_sorted_) {
+    return;
+  }
+  by_head_.clear();
+  by_head_.reserve(docs_.size() - dead_);
+  for (uint32_t doc = 0; doc < docs_.size(); ++doc) {
+    const Document& document = docs_[doc];
+    if (document.id != kInvalidGameId) {
+      const uint16_t length = static_cast<uint16_t>(std::min<uint32_t>(document.nameLength, UINT16_MAX));
+      by_head_.push_back({document.head, doc, length, document.source, document.flags});
+    }
+  }
+  std::sort(by_head_.begin(), by_head_.end());
+  heads_sorted_ = true;
+}
+
+void SearchIndex::MaybeRebuild() {
+  if (dead_ >= kMinRebuildDocuments && dead_ * 2 > docs_.size()) {
+    Rebuild();
+  }
+}
+
+}  // namespace optiscaler
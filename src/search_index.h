@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "game_catalog.h"
+
+namespace optiscaler {
+
+struct SearchIndexStats {
+  size_t documents = 0;  // live games
+  size_t deadDocuments = 0;
+  size_t grams = 0;
+  size_t postings = 0;
+};
+
+// Trigram index over the case-folded names of a GameCatalog and the last
+// component of each game's folder and exe path. Every word contributes two
+// word-start grams (so one- and two-letter queries work) and its inner
+// trigrams. A game matches when it shares all but the grams one or two
+// typos could break (never less than half of them). Results are ranked
+// by how many grams match, with bonuses when the name starts with the query
+// or when every query word starts a name word.
+//
+// Postings are append-only: a changed game is indexed again under a new
+// document, and dead documents are skipped until they outnumber the live
+// ones and the index is rebuilt from the catalog. The catalog must outlive
+// the index. Not thread-safe, Search included: it reuses scratch buffers,
+// so the app only calls it from the UI thread.
+class SearchIndex {
+ public:
+  explicit SearchIndex(const GameCatalog& catalog);
+
+  SearchIndex(const SearchIndex&) = delete;
+  SearchIndex& operator=(const SearchIndex&) = delete;
+
+  // Call after every catalog change, with what GameCatalog::Sync returned.
+  void Apply(const CatalogDelta& delta);
+  // Indexes `id` as the catalog holds it now, replacing an earlier version.
+  void Add(GameId id);
+  void Remove(GameId id);
+  void Rebuild();
+
+  // False for queries with no letters or digits, which Search can't match
+  // on; callers should show the unsearched list instead.
+  static bool HasTerms(std::wstring_view query);
+  // Best match first, at most `limit` of them; games failing `filter` are
+  // left out. A query without terms matches nothing. When at least `limit`
+  // names start with a query of one or two grams, the shortest of those are
+  // returned without reading any postings.
+  std::vector<GameId> Search(std::wstring_view query, const GameFilter& filter = {},
+                             size_t limit = SIZE_MAX) const;
+
+  SearchIndexStats Stats() const;
+
+ private:
+  static constexpr uint32_t kNoDocument = UINT32_MAX;
+
+  // What ranking reads per candidate, kept together so scoring one costs a
+  // single cache line besides its name.
+  struct Document {
+    uint64_t head = 0;  // first three code units of the folded name
+    GameId id = kInvalidGameId;  // kInvalidGameId once dead
+    uint32_t nameBegin = 0;  // folded name in names_
+    uint32_t nameLength = 0;
+    GameSource source = GameSource::kCustom;  // copied so filtering stays local
+    uint8_t flags = 0;
+  };
+  // A live document in by_head_, with what PrefixMatches reads inline.
+  struct HeadEntry {
+    uint64_t head = 0;  // first three code units of the folded name
+    uint32_t doc = 0;
+    uint16_t nameLength = 0;  // saturated
+    GameSource source = GameSource::kCustom;
+    uint8_t flags = 0;
+
+    bool operator<(const HeadEntry& other) const {
+      if (head != other.head) {
+        return head < other.head;
+      }
+      return nameLength != other.nameLength ? nameLength < other.nameLength : doc < other.doc;
+    }
+  };
+
+  void MaybeRebuild();
+  void SortHeads();
+  // Up to `limit` live documents passing `filter` whose name starts with
+  // `folded`, shortest first; fewer when the bucket runs out or too many
+  // are skipped.
+  std::vector<GameId> PrefixMatches(std::wstring_view folded, const GameFilter& filter, size_t limit) const;
+
+  const GameCatalog& catalog_;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> postings_;  // gram -> documents, ascending
+  // By document.
+  std::vector<Document> docs_;
+  std::wstring names_;
+  std::vector<uint32_t> documents_;  // by GameId
+  // Sorted after each Apply or Rebuild, so the names sharing a head are a
+  // run, shortest first. Search ignores it after a direct Add or Remove.
+  std::vector<HeadEntry> by_head_;
+  bool heads_sorted_ = false;
+  size_t dead_ = 0;
+  // Search scratch, by document: name hits in the low byte, path hits in
+  // the high byte. Kept across calls so a keystroke doesn't allocate.
+  mutable std::vector<uint16_t> hits_;
+  mutable std::vector<uint32_t> touched_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace optiscaler {
+
+struct SingleFlightStats {
+  uint64_t calls = 0;
+  uint64_t executions = 0;  // calls that ran the work themselves
+};
+
+// Coalesces concurrent calls per key: the first caller runs the work on its
+// own thread and every caller that arrives before it finishes gets the same
+// shared_future. Nothing is cached; once the work returns, the next call
+// for the key runs it again. If the work throws, waiters see
+// std::future_error (broken_promise).
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class SingleFlight {
+ public:
+  using Future = std::shared_future<Value>;
+
+  SingleFlight() = default;
+  SingleFlight(const SingleFlight&) = delete;
+  SingleFlight& operator=(const SingleFlight&) = delete;
+
+  // Blocks the leader for the duration of `work`; other callers return at
+  // once. `leader_out`, if given, tells which one this caller was.
+  template <typename Work>
+  Future Do(const Key& key, Work&& work, bool* leader_out = nullptr) {
+    std::promise<Value> promise;
+    Future future = promise.get_future().share();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.calls;
+      auto it = calls_.find(key);
+      if (it != calls_.end()) {
+        if (leader_out) {
+          *leader_out = false;
+        }
+        return it->second;
+      }
+      ++stats_.executions;
+      calls_.emplace(key, future);
+    }
+    if (leader_out) {
+      *leader_out = true;
+    }
+    // Forget the key even if `work` throws, so the next call retries.
+    struct Forget {
+      SingleFlight* self;
+      const Key& key;
+      ~Forget() {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        self->calls_.erase(key);
+      }
+    } forget{this, key};
+    promise.set_value(std::forward<Work>(work)());
+    return future;
+  }
+
+  // Same as Do(key, work).get().
+  template <typename Work>
+  Value Run(const Key& key, Work&& work) {
+    return Do(key, std::forward<Work>(work)).get();
+  }
+
+  size_t inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return calls_.size();
+  }
+
+  SingleFlightStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<Key, Future, Hash> calls_;
+  SingleFlightStats stats_;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,161 @@
+#include "steam_library.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "keyvalues.h"
+#include "mapped_file.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr std::string_view kManifestPrefix = "appmanifest_";
+constexpr std::string_view kManifestSuffix = ".acf";
+
+}  // namespace
+
+bool SteamLibrary::IsAppManifestName(const std::wstring& filename) {
+  if (filename.size() <= kManifestPrefix.size() + kManifestSuffix.size()) {
+    return false;
+  }
+  auto matches = [](const wchar_t* text, std::string_view pattern) {
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      wchar_t ch = text[i];
+      if (ch >= L'A' && ch <= L'Z') {
+        ch = static_cast<wchar_t>(ch - L'A' + L'a');
+      }
+      if (ch != static_cast<wchar_t>(pattern[i])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  return matches(filename.c_str(), kManifestPrefix) &&
+         matches(filename.c_str() + filename.size() - kManifestSuffix.size(), kManifestSuffix);
+}
+
+std::vector<std::wstring> SteamLibrary::LibraryFolders(const std::wstring& steam_root) {
+  std::vector<std::wstring> libraries;
+  if (steam_root.empty()) {
+    return libraries;
+  }
+  std::filesystem::path root = std::filesystem::path(steam_root).lexically_normal();
+  libraries.emplace_back(root.wstring());
+
+  MappedFile file;
+  if (file.Open((root / L"steamapps" / L"libraryfolders.vdf").wstring())) {
+    for (auto& library : ParseLibraryFolders(file.view())) {
+      libraries.emplace_back(std::filesystem::path(library).lexically_normal().wstring());
+    }
+  }
+
+  // The Steam root is listed inside the file as well; keep first occurrence.
+  std::vector<std::wstring> unique;
+  for (auto& library : libraries) {
+    const bool seen = std::any_of(unique.begin(), unique.end(), [&](const std::wstring& existing) {
+      return std::filesystem::path(existing) == std::filesystem::path(library);
+    });
+    if (!seen) {
+      unique.emplace_back(std::move(library));
+    }
+  }
+  return unique;
+}
+
+std::vector<std::wstring> SteamLibrary::ParseLibraryFolders(std::string_view vdf) {
+  // Current format:  "libraryfolders" { "0" { "path" "D:\\SteamLibrary" ... } }
+  // Legacy format:   "LibraryFolders" { "1" "D:\\SteamLibrary" }
+  std::vector<std::wstring> libraries;
+  KeyValuesReader reader(vdf);
+  bool in_numbered_entry = false;
+  uint32_t index = 0;
+  for (;;) {
+    const auto event = reader.Next();
+    if (event == KeyValuesReader::Event::kEnd || event == KeyValuesReader::Event::kError) {
+      break;
+    }
+    if (event == KeyValuesReader::Event::kBeginObject) {
+      if (reader.depth() == 2) {
+        in_numbered_entry = KeyValuesToUint32(reader.key(), index);
+      }
+      continue;
+    }
+    if (event == KeyValuesReader::Event::kEndObject) {
+      if (reader.depth() < 2) {
+        in_numbered_entry = false;
+      }
+      continue;
+    }
+    if (reader.depth() == 1 && KeyValuesToUint32(reader.key(), index)) {
+      libraries.emplace_back(KeyValuesToWide(reader.value()));
+    } else if (reader.depth() == 2 && in_numbered_entry && KeyValuesEquals(reader.key(), "path")) {
+      libraries.emplace_back(KeyValuesToWide(reader.value()));
+    }
+  }
+  return libraries;
+}
+
+bool SteamLibrary::ParseAppManifest(std::string_view acf, const std::wstring& library, SteamApp& app_out) {
+  app_out = SteamApp{};
+  std::string_view install_dir;
+  std::string_view name;
+  KeyValuesReader reader(acf);
+  for (;;) {
+    const auto event = reader.Next();
+    if (event == KeyValuesReader::Event::kEnd || event == KeyValuesReader::Event::kError) {
+      break;
+    }
+    if (event != KeyValuesReader::Event::kValue || reader.depth() != 1) {
+      continue;
+    }
+    if (KeyValuesEquals(reader.key(), "appid")) {
+      KeyValuesToUint32(reader.value(), app_out.appId);
+    } else if (KeyValuesEquals(reader.key(), "installdir")) {
+      install_dir = reader.value();
+    } else if (KeyValuesEquals(reader.key(), "name")) {
+      name = reader.value();
+    } else if (KeyValuesEquals(reader.key(), "SizeOnDisk")) {
+      KeyValuesToUint64(reader.value(), app_out.sizeOnDisk);
+    } else if (KeyValuesEquals(reader.key(), "LastPlayed")) {
+      uint64_t last_played = 0;
+      if (KeyValuesToUint64(reader.value(), last_played)) {
+        app_out.lastPlayed = static_cast<int64_t>(last_played);
+      }
+    }
+  }
+  if (app_out.appId == 0 || install_dir.empty()) {
+    return false;
+  }
+  std::filesystem::path path(library);
+  path /= L"steamapps";
+  path /= L"common";
+  path /= KeyValuesToWide(install_dir);
+  app_out.installDir = path.wstring();
+  app_out.name = KeyValuesToWide(name);
+  return true;
+}
+
+std::vector<SteamApp> SteamLibrary::InstalledApps(const std::wstring& library) {
+  std::vector<SteamApp> apps;
+  std::error_code ec;
+  std::filesystem::path steamapps = std::filesystem::path(library) / L"steamapps";
+  std::filesystem::directory_iterator it(steamapps, std::filesystem::directory_options::skip_permission_denied, ec);
+  const std::filesystem::directory_iterator end;
+  MappedFile file;
+  for (; !ec && it != end; it.increment(ec)) {
+    const std::wstring filename = it->path().filename().wstring();
+    if (!IsAppManifestName(filename) || !file.Open(it->path().wstring())) {
+      continue;
+    }
+    SteamApp app;
+    if (ParseAppManifest(file.view(), library, app)) {
+      apps.emplace_back(std::move(app));
+    }
+    file.Close();
+  }
+  std::sort(apps.begin(), apps.end(), [](const SteamApp& a, const SteamApp& b) { return a.appId < b.appId; });
+  return apps;
+}
+
+}  // namespace optiscaler
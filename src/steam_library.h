@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace optiscaler {
+
+struct SteamApp {
+  uint32_t appId = 0;
+  std::wstring name;
+  std::wstring installDir;  // full path: <library>\steamapps\common\<installdir>
+  uint64_t sizeOnDisk = 0;
+  int64_t lastPlayed = 0;  // Unix seconds, 0 = never
+};
+
+// Steam library discovery from libraryfolders.vdf and appmanifest_*.acf.
+// Files are memory-mapped and walked with KeyValuesReader, so only the
+// fields that are kept get copied out of the mapping.
+class SteamLibrary {
+ public:
+  static std::vector<std::wstring> LibraryFolders(const std::wstring& steam_root);
+  static std::vector<std::wstring> ParseLibraryFolders(std::string_view vdf);
+  static bool ParseAppManifest(std::string_view acf, const std::wstring& library, SteamApp& app_out);
+  static std::vector<SteamApp> InstalledApps(const std::wstring& library);
+  static bool IsAppManifestName(const std::wstring& filename);
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,160 @@
+#include "streaming_download.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "text_util.h"
+
+namespace optiscaler {
+
+namespace {
+
+constexpr size_t kRehashChunkBytes = 64 * 1024;
+
+// Re-hashes the bytes kept from an earlier attempt; false if unreadable.
+bool HashPartial(const std::wstring& path, uint64_t size, Sha256& hasher) {
+  std::ifstream in(std::filesystem::path(path), std::ios::binary);
+  std::vector<char> buffer(kRehashChunkBytes);
+  uint64_t remaining = size;
+  while (in && remaining > 0) {
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+    in.read(buffer.data(), static_cast<std::streamsize>(count));
+    if (static_cast<size_t>(in.gcount()) != count) {
+      return false;
+    }
+    hasher.Update(buffer.data(), count);
+    remaining -= count;
+  }
+  return remaining == 0;
+}
+
+// If-Range only accepts strong validators, so weak ETags are skipped.
+std::wstring ValidatorOf(const HttpResponse& response) {
+  if (!response.etag.empty() && response.etag.compare(0, 2, L"W/") != 0) {
+    return response.etag;
+  }
+  return response.lastModified;
+}
+
+std::wstring ReadValidator(const std::wstring& path) {
+  std::ifstream in(std::filesystem::path(path), std::ios::binary);
+  return WideFromUtf8(std::string(std::istreambuf_iterator<char>(in), {}));
+}
+
+// Removes the file when there is no validator to keep.
+bool WriteValidator(const std::wstring& path, const std::wstring& validator) {
+  std::error_code ec;
+  if (validator.empty()) {
+    std::filesystem::remove(path, ec);
+    return true;
+  }
+  std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+  out << Utf8FromWide(validator);
+  return static_cast<bool>(out);
+}
+
+}  // namespace
+
+std::wstring StreamingDownload::PartialPath(const std::wstring& target) {
+  return target + L".part";
+}
+
+std::wstring StreamingDownload::ValidatorPath(const std::wstring& target) {
+  return PartialPath(target) + L".validator";
+}
+
+bool StreamingDownload::Fetch(IHttpClient& http, const std::wstring& url, const std::wstring& target,
+                              DownloadResult& result_out) {
+  result_out = DownloadResult{};
+  HttpRequest request;
+  if (target.empty() || !HttpRequest::FromUrl(url, request)) {
+    result_out.error = L"Invalid download target";
+    return false;
+  }
+  const std::wstring part_path = PartialPath(target);
+  const std::wstring validator_path = ValidatorPath(target);
+  Sha256 hasher;
+  std::error_code ec;
+  uint64_t kept = std::filesystem::file_size(part_path, ec);
+  const std::wstring validator = ec || kept == 0 ? std::wstring() : ReadValidator(validator_path);
+  if (ec || validator.empty() || !HashPartial(part_path, kept, hasher)) {
+    kept = 0;
+    hasher.Finish();
+  }
+  if (kept > 0) {
+    request.headers.emplace_back(L"Range", L"bytes=" + std::to_wstring(kept) + L"-");
+    request.headers.emplace_back(L"If-Range", validator);
+  }
+
+  std::ofstream out;
+  uint64_t written = kept;
+  HttpResponse response;
+  // Runs once the status is known: append to the kept bytes on a matching
+  // 206, start over on a 200 (recording the new body's validator first),
+  // and refuse anything else.
+  bool opened = false;
+  auto open_output = [&]() {
+    if (opened) {
+      return out.is_open();
+    }
+    opened = true;
+    const bool resume = kept > 0 && response.status == 206 && response.rangeStart == static_cast<int64_t>(kept);
+    if (!resume && response.status != 200) {
+      return false;
+    }
+    if (!resume && kept > 0) {
+      kept = 0;
+      written = 0;
+      hasher.Finish();
+    }
+    if (!resume && !WriteValidator(validator_path, ValidatorOf(response))) {
+      return false;
+    }
+    out.open(std::filesystem::path(part_path), std::ios::binary | (resume ? std::ios::app : std::ios::trunc));
+    return out.is_open();
+  };
+  const bool complete = http.SendStreaming(request, response, [&](const char* data, size_t size) {
+    if (!open_output()) {
+      return false;
+    }
+    out.write(data, static_cast<std::streamsize>(size));
+    hasher.Update(data, size);
+    written += size;
+    return out.good();
+  });
+  const bool output_ready = open_output();
+  out.close();
+
+  if (response.status == 416) {
+    // The kept bytes no longer match what the server has.
+    std::filesystem::remove(part_path, ec);
+    std::filesystem::remove(validator_path, ec);
+    result_out.error = L"Stale partial download";
+    return false;
+  }
+  if (!complete || !output_ready || out.fail()) {
+    result_out.error = response.error.empty() ? L"Download interrupted" : response.error;
+    return false;
+  }
+  const uint64_t expected =
+      response.contentLength < 0 ? written : static_cast<uint64_t>(response.contentLength) + kept;
+  if (written == 0 || written != expected) {
+    result_out.error = L"Download incomplete";
+    return false;
+  }
+  std::filesystem::rename(part_path, target, ec);
+  if (ec) {
+    result_out.error = L"Could not move download into place";
+    return false;
+  }
+  std::filesystem::remove(validator_path, ec);
+  result_out.bytes = written;
+  result_out.resumedFrom = kept;
+  result_out.hash = hasher.Finish();
+  return true;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "content_hash.h"
+#include "http_client.h"
+
+namespace optiscaler {
+
+struct DownloadResult {
+  uint64_t bytes = 0;        // final file size
+  uint64_t resumedFrom = 0;  // bytes kept from an earlier attempt
+  ContentHash hash;          // SHA-256 of the whole file
+  std::wstring error;
+};
+
+// Downloads straight to disk. The body goes to `target`.part chunk by
+// chunk and is hashed on the way, so memory per download stays at one
+// transport chunk; the file is renamed to `target` only once complete. The
+// response's validator (a strong ETag, else Last-Modified) is kept next to
+// the .part file, and a later attempt resumes with Range plus If-Range, so
+// a server whose file changed answers with the full body and the download
+// restarts. A .part file without a validator cannot be trusted and is
+// restarted as well.
+class StreamingDownload {
+ public:
+  static std::wstring PartialPath(const std::wstring& target);
+  static std::wstring ValidatorPath(const std::wstring& target);
+  static bool Fetch(IHttpClient& http, const std::wstring& url, const std::wstring& target,
+                    DownloadResult& result_out);
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,139 @@
+#include "text_layout.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace optiscaler {
+
+namespace {
+
+constexpr char32_t kEllipsis = 0x2026;
+
+std::u32string DecodeUtf16(std::wstring_view text) {
+  std::u32string out;
+  out.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    const char32_t unit = static_cast<char32_t>(text[i]);
+    if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < text.size()) {
+      const char32_t low = static_cast<char32_t>(text[i + 1]);
+      if (low >= 0xDC00 && low < 0xE000) {
+        out.push_back(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+        ++i;
+        continue;
+      }
+    }
+    out.push_back(unit);
+  }
+  return out;
+}
+
+void Place(const AtlasGlyph& glyph, int pen, TextLayout& layout) {
+  if (glyph.width > 0 && glyph.height > 0) {
+    layout.blits.push_back({glyph.x, glyph.y, glyph.width, glyph.height, pen + glyph.offsetX, glyph.offsetY});
+  }
+}
+
+}  // namespace
+
+size_t TextLayoutCache::KeyHasher::operator()(const Key& key) const {
+  const size_t text_hash = std::hash<std::wstring_view>()(key.text);
+  return text_hash ^ ((static_cast<size_t>(key.font) << 20 | static_cast<size_t>(key.maxWidth)) *
+                      static_cast<size_t>(0x9E3779B97F4A7C15ull));
+}
+
+TextLayoutCache::TextLayoutCache(GlyphAtlas& atlas, size_t capacity)
+    : atlas_(atlas), capacity_(std::max<size_t>(1, capacity)) {}
+
+std::shared_ptr<const TextLayout> TextLayoutCache::Layout(FontId font, std::wstring_view text, int max_width) {
+  const Key key{font, std::max(0, max_width), text};
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second->layout->generation == atlas_.generation()) {
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->layout;
+  }
+  ++stats_.misses;
+  auto layout = std::make_shared<TextLayout>(Build(font, text, key.maxWidth));
+  if (layout->generation != atlas_.generation()) {
+    // The atlas filled up part way through; lay out again against the new one.
+    *layout = Build(font, text, key.maxWidth);
+  }
+  if (it != entries_.end()) {
+    it->second->layout = layout;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return layout;
+  }
+  lru_.push_front(Entry{font, key.maxWidth, std::wstring(text), layout});
+  const Entry& entry = lru_.front();
+  entries_.emplace(Key{entry.font, entry.maxWidth, entry.text}, lru_.begin());
+  while (entries_.size() > capacity_) {
+    const Entry& oldest = lru_.back();
+    entries_.erase(Key{oldest.font, oldest.maxWidth, oldest.text});
+    lru_.pop_back();
+    ++stats_.evictions;
+  }
+  return layout;
+}
+
+void TextLayoutCache::Clear() {
+  entries_.clear();
+  lru_.clear();
+}
+
+TextLayoutStats TextLayoutCache::Stats() const {
+  TextLayoutStats stats = stats_;
+  stats.entries = entries_.size();
+  return stats;
+}
+
+TextLayout TextLayoutCache::Build(FontId font, std::wstring_view text, int max_width) {
+  TextLayout layout;
+  layout.generation = atlas_.generation();
+  layout.height = atlas_.Metrics(font).lineHeight;
+  const std::u32string codes = DecodeUtf16(text);
+  std::vector<AtlasGlyph> glyphs;
+  glyphs.reserve(codes.size());
+  int width = 0;
+  for (char32_t code : codes) {
+    const AtlasGlyph* glyph = atlas_.Find(font, code);
+    if (!glyph) {
+      return layout;
+    }
+    glyphs.push_back(*glyph);
+    width += glyph->advance;
+  }
+  int pen = 0;
+  if (max_width > 0 && width > max_width) {
+    const AtlasGlyph* ellipsis = atlas_.Find(font, kEllipsis);
+    const int ellipsis_advance = ellipsis ? ellipsis->advance : 0;
+    for (const AtlasGlyph& glyph : glyphs) {
+      if (pen + glyph.advance + ellipsis_advance > max_width) {
+        break;
+      }
+      Place(glyph, pen, layout);
+      pen += glyph.advance;
+    }
+    if (ellipsis) {
+      Place(*ellipsis, pen, layout);
+      pen += ellipsis_advance;
+    }
+    layout.truncated = true;
+  } else {
+    for (const AtlasGlyph& glyph : glyphs) {
+      Place(glyph, pen, layout);
+      pen += glyph.advance;
+    }
+  }
+  layout.width = pen;
+  return layout;
+}
+
+void DrawTextLayout(TileCompositor& compositor, const GlyphAtlas& atlas, const TextLayout& layout, int x, int y,
+                    uint32_t color) {
+  if (layout.generation != atlas.generation()) {
+    return;
+  }
+  compositor.BlendMasks(atlas.pixels(), atlas.width(), layout.blits.data(), layout.blits.size(), x, y, color);
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "glyph_atlas.h"
+#include "tile_compositor.h"
+
+namespace optiscaler {
+
+// One line of text as atlas blits relative to its top-left corner.
+struct TextLayout {
+  std::vector<MaskBlit> blits;
+  int width = 0;
+  int height = 0;
+  bool truncated = false;
+  uint64_t generation = 0;  // GlyphAtlas::generation the blits point into
+};
+
+struct TextLayoutStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  size_t entries = 0;
+};
+
+// Shaped single-line runs keyed by (font, max width, text), so a title is
+// decoded, measured and truncated once and later frames only blit it.
+// Least recently used runs are dropped past `capacity`, and runs laid out
+// against an older atlas generation are redone on lookup. Not thread-safe.
+class TextLayoutCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit TextLayoutCache(GlyphAtlas& atlas, size_t capacity = kDefaultCapacity);
+
+  TextLayoutCache(const TextLayoutCache&) = delete;
+  TextLayoutCache& operator=(const TextLayoutCache&) = delete;
+
+  // With `max_width` > 0, text wider than that is cut at a glyph boundary
+  // and ends in an ellipsis.
+  std::shared_ptr<const TextLayout> Layout(FontId font, std::wstring_view text, int max_width = 0);
+  void Clear();
+  TextLayoutStats Stats() const;
+
+ private:
+  // Looked up by view so a hit allocates nothing; the text points into the
+  // owning Entry on the LRU list.
+  struct Key {
+    FontId font = 0;
+    int maxWidth = 0;
+    std::wstring_view text;
+
+    bool operator==(const Key& other) const {
+      return font == other.font && maxWidth == other.maxWidth && text == other.text;
+    }
+  };
+  struct KeyHasher {
+    size_t operator()(const Key& key) const;
+  };
+  struct Entry {
+    FontId font = 0;
+    int maxWidth = 0;
+    std::wstring text;
+    std::shared_ptr<const TextLayout> layout;
+  };
+
+  TextLayout Build(FontId font, std::wstring_view text, int max_width);
+
+  GlyphAtlas& atlas_;
+  size_t capacity_ = 0;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> entries_;
+  std::list<Entry> lru_;  // front = most recently used
+  TextLayoutStats stats_;
+};
+
+// Draws `layout` with its top-left corner at (x, y) as one batch.
+void DrawTextLayout(TileCompositor& compositor, const GlyphAtlas& atlas, const TextLayout& layout, int x, int y,
+                    uint32_t color);
+
+}  // namespace optiscaler
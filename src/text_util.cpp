@@ -0,0 +1,100 @@
+#include "text_util.h"
+
+#include <cstdint>
+
+namespace optiscaler {
+
+namespace {
+
+void AppendCodePoint(std::wstring& out, uint32_t code_point) {
+  if constexpr (sizeof(wchar_t) == 2) {
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      out += static_cast<wchar_t>(0xD800 + (code_point >> 10));
+      out += static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+      return;
+    }
+  }
+  out += static_cast<wchar_t>(code_point);
+}
+
+}  // namespace
+
+void AppendWideFromUtf8(std::wstring& out, std::string_view utf8) {
+  size_t i = 0;
+  while (i < utf8.size()) {
+    const unsigned char ch = static_cast<unsigned char>(utf8[i]);
+    if (ch < 0x80) {
+      out += static_cast<wchar_t>(ch);
+      ++i;
+      continue;
+    }
+    size_t length = 0;
+    uint32_t code_point = 0;
+    if ((ch & 0xE0) == 0xC0) {
+      length = 2;
+      code_point = ch & 0x1F;
+    } else if ((ch & 0xF0) == 0xE0) {
+      length = 3;
+      code_point = ch & 0x0F;
+    } else if ((ch & 0xF8) == 0xF0) {
+      length = 4;
+      code_point = ch & 0x07;
+    }
+    bool valid = length != 0 && i + length <= utf8.size();
+    for (size_t k = 1; valid && k < length; ++k) {
+      const unsigned char next = static_cast<unsigned char>(utf8[i + k]);
+      valid = (next & 0xC0) == 0x80;
+      code_point = (code_point << 6) | (next & 0x3F);
+    }
+    if (!valid || code_point > 0x10FFFF) {
+      out += L'\xFFFD';
+      ++i;
+      continue;
+    }
+    AppendCodePoint(out, code_point);
+    i += length;
+  }
+}
+
+std::wstring WideFromUtf8(std::string_view utf8) {
+  std::wstring out;
+  out.reserve(utf8.size());
+  AppendWideFromUtf8(out, utf8);
+  return out;
+}
+
+std::string Utf8FromWide(std::wstring_view wide) {
+  std::string out;
+  out.reserve(wide.size());
+  for (size_t i = 0; i < wide.size(); ++i) {
+    uint32_t code_point = static_cast<uint32_t>(wide[i]);
+    if constexpr (sizeof(wchar_t) == 2) {
+      if (code_point >= 0xD800 && code_point <= 0xDBFF && i + 1 < wide.size()) {
+        const uint32_t low = static_cast<uint32_t>(wide[i + 1]);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          ++i;
+        }
+      }
+    }
+    if (code_point < 0x80) {
+      out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      out += static_cast<char>(0xC0 | (code_point >> 6));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out += static_cast<char>(0xE0 | (code_point >> 12));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code_point >> 18));
+      out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+  return out;
+}
+
+}  // namespace optiscaler
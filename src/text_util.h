@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace optiscaler {
+
+// Platform-neutral UTF-8 <-> wide conversion (UTF-16 on Windows). Invalid
+// sequences decode to U+FFFD.
+void AppendWideFromUtf8(std::wstring& out, std::string_view utf8);
+std::wstring WideFromUtf8(std::string_view utf8);
+std::string Utf8FromWide(std::wstring_view wide);
+
+}  // namespace optiscaler
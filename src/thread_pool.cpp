@@ -0,0 +1,112 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace optiscaler {
+
+namespace {
+
+thread_local const WorkStealingPool* t_current_pool = nullptr;
+thread_local size_t t_current_index = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(std::make_unique<Worker>());
+  }
+  threads_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    threads_.emplace_back([this, i] { Run(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Submit(Task task) {
+  size_t index = 0;
+  if (t_current_pool == this) {
+    index = t_current_index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  }
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  {
+    // Counted before the push so a worker that pops early never sees the
+    // counter dip below zero; it just spins once until the task is visible.
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->tasks.emplace_back(std::move(task));
+  }
+  wake_cv_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  idle_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingPool::TryPopLocal(size_t index, Task& task_out) {
+  Worker& worker = *workers_[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tasks.empty()) {
+    return false;
+  }
+  task_out = std::move(worker.tasks.back());
+  worker.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingPool::TrySteal(size_t thief, Task& task_out) {
+  const size_t count = workers_.size();
+  for (size_t offset = 1; offset < count; ++offset) {
+    Worker& victim = *workers_[(thief + offset) % count];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task_out = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::Run(size_t index) {
+  t_current_pool = this;
+  t_current_index = index;
+  for (;;) {
+    Task task;
+    if (TryPopLocal(index, task) || TrySteal(index, task)) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      task();
+      if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        idle_cv_.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_relaxed) > 0; });
+    if (stopping_) {
+      return;
+    }
+  }
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace optiscaler {
+
+// Fixed-size pool where every worker owns a deque. Workers pop their own
+// newest task first and steal the oldest task from a sibling when idle, so
+// recursive fan-out (e.g. one task per directory) stays cache-friendly.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(size_t worker_count = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  void Submit(Task task);
+  void Wait();
+  size_t WorkerCount() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool TryPopLocal(size_t index, Task& task_out);
+  bool TrySteal(size_t thief, Task& task_out);
+  void Run(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable idle_cv_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> next_queue_{0};
+  bool stopping_ = false;
+};
+
+}  // namespace optiscaler
@@ -0,0 +1,306 @@
+#include "tile_compositor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OPTISCALER_X86 1
+#include <emmintrin.h>
+#endif
+
+namespace optiscaler {
+
+namespace {
+
+// dst = src + dst * (255 - src.a) / 255 per channel, rounded; the SSE2 path
+// uses the same arithmetic, so both kernels produce identical pixels.
+uint32_t BlendPixel(uint32_t src, uint32_t dst) {
+  const uint32_t inverse = 255 - (src >> 24);
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t t = ((dst >> shift) & 0xFF) * inverse + 128;
+    t = (t + (t >> 8)) >> 8;
+    out |= std::min<uint32_t>(255, t + ((src >> shift) & 0xFF)) << shift;
+  }
+  return out;
+}
+
+// color * coverage / 255 per channel, with the rounding BlendPixel uses.
+uint32_t ScalePixel(uint32_t color, uint32_t coverage) {
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    uint32_t t = ((color >> shift) & 0xFF) * coverage + 128;
+    out |= ((t + (t >> 8)) >> 8) << shift;
+  }
+  return out;
+}
+
+void BlendRowScalar(uint32_t* dst, const uint8_t* src, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t pixel;
+    std::memcpy(&pixel, src + i * 4, sizeof(pixel));
+    if ((pixel >> 24) == 255) {
+      dst[i] = pixel;
+    } else if (pixel != 0) {
+      dst[i] = BlendPixel(pixel, dst[i]);
+    }
+  }
+}
+
+#ifdef OPTISCALER_X86
+
+void BlendRowSse2(uint32_t* dst, const uint8_t* src, size_t count) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m128i c255 = _mm_set1_epi16(255);
+  const __m128i c128 = _mm_set1_epi16(128);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xFFFF) {
+      _mm_storeu_si128(out, s);
+      continue;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xFFFF) {
+      continue;
+    }
+    const __m128i d = _mm_loadu_si128(out);
+    const __m128i s_lo = _mm_unpacklo_epi8(s, zero);
+    const __m128i s_hi = _mm_unpackhi_epi8(s, zero);
+    // Broadcast each pixel's alpha to its four 16-bit channels.
+    const __m128i inv_lo = _mm_sub_epi16(c255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xFF), 0xFF));
+    const __m128i inv_hi = _mm_sub_epi16(c255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xFF), 0xFF));
+    __m128i t_lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv_lo), c128);
+    __m128i t_hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv_hi), c128);
+    t_lo = _mm_srli_epi16(_mm_add_epi16(t_lo, _mm_srli_epi16(t_lo, 8)), 8);
+    t_hi = _mm_srli_epi16(_mm_add_epi16(t_hi, _mm_srli_epi16(t_hi, 8)), 8);
+    _mm_storeu_si128(out, _mm_adds_epu8(_mm_packus_epi16(t_lo, t_hi), s));
+  }
+  BlendRowScalar(dst + i, src + i * 4, count - i);
+}
+
+#endif  // OPTISCALER_X86
+
+using BlendRowFn = void (*)(uint32_t* dst, const uint8_t* src, size_t count);
+
+BlendRowFn BlendRowFor(BlendKernel kernel) {
+#ifdef OPTISCALER_X86
+  if (kernel == BlendKernel::kSse2) {
+    return BlendRowSse2;
+  }
+#endif
+  (void)kernel;
+  return BlendRowScalar;
+}
+
+}  // namespace
+
+BlendKernel TileCompositor::BestKernel() {
+#ifdef OPTISCALER_X86
+  return BlendKernel::kSse2;  // baseline on every x64 CPU and every Windows-capable x86
+#else
+  return BlendKernel::kScalar;
+#endif
+}
+
+TileCompositor::TileCompositor(BlendKernel kernel) : kernel_(kernel) {}
+
+void TileCompositor::Attach(uint32_t* pixels, int width, int height, int stride) {
+  pixels_ = pixels;
+  width_ = pixels ? std::max(0, width) : 0;
+  height_ = pixels ? std::max(0, height) : 0;
+  stride_ = stride;
+  tiles_x_ = (width_ + kTileSize - 1) / kTileSize;
+  tiles_y_ = (height_ + kTileSize - 1) / kTileSize;
+  pending_.assign(static_cast<size_t>(tiles_x_) * static_cast<size_t>(tiles_y_), 1);
+  frame_.assign(pending_.size(), 0);
+  frame_rects_.clear();
+}
+
+GridRect TileCompositor::TileRange(const GridRect& rect) const {
+  const GridRect clipped = rect.Intersect(Bounds());
+  if (clipped.empty()) {
+    return {};
+  }
+  return {clipped.left / kTileSize, clipped.top / kTileSize, (clipped.right + kTileSize - 1) / kTileSize,
+          (clipped.bottom + kTileSize - 1) / kTileSize};
+}
+
+void TileCompositor::Invalidate(const GridRect& rect) {
+  const GridRect tiles = TileRange(rect);
+  for (int ty = tiles.top; ty < tiles.bottom; ++ty) {
+    std::fill_n(pending_.begin() + ty * tiles_x_ + tiles.left, tiles.width(), uint8_t{1});
+  }
+}
+
+void TileCompositor::Scroll(const GridRect& area, int dy) {
+  const GridRect clipped = area.Intersect(Bounds());
+  if (clipped.empty() || dy == 0) {
+    return;
+  }
+  // Pending tiles would carry stale pixels into clean ones.
+  const GridRect tiles = TileRange(clipped);
+  bool stale = std::abs(dy) >= clipped.height();
+  for (int ty = tiles.top; ty < tiles.bottom && !stale; ++ty) {
+    const auto row = pending_.begin() + ty * tiles_x_;
+    stale = std::find(row + tiles.left, row + tiles.right, uint8_t{1}) != row + tiles.right;
+  }
+  if (stale) {
+    Invalidate(clipped);
+    return;
+  }
+  const size_t bytes = static_cast<size_t>(clipped.width()) * sizeof(uint32_t);
+  if (dy < 0) {
+    for (int y = clipped.top; y < clipped.bottom + dy; ++y) {
+      std::memmove(Row(y) + clipped.left, Row(y - dy) + clipped.left, bytes);
+    }
+    Invalidate({clipped.left, clipped.bottom + dy, clipped.right, clipped.bottom});
+  } else {
+    for (int y = clipped.bottom - 1; y >= clipped.top + dy; --y) {
+      std::memmove(Row(y) + clipped.left, Row(y - dy) + clipped.left, bytes);
+    }
+    Invalidate({clipped.left, clipped.top, clipped.right, clipped.top + dy});
+  }
+}
+
+bool TileCompositor::dirty() const {
+  return std::find(pending_.begin(), pending_.end(), uint8_t{1}) != pending_.end();
+}
+
+GridRect TileCompositor::Begin(uint32_t background) {
+  frame_.swap(pending_);
+  std::fill(pending_.begin(), pending_.end(), uint8_t{0});
+  frame_rects_.clear();
+  ++stats_.frames;
+  GridRect bounds;
+  for (int ty = 0; ty < tiles_y_; ++ty) {
+    for (int tx = 0; tx < tiles_x_;) {
+      if (!frame_[ty * tiles_x_ + tx]) {
+        ++tx;
+        continue;
+      }
+      const int start = tx;
+      while (tx < tiles_x_ && frame_[ty * tiles_x_ + tx]) {
+        ++tx;
+      }
+      stats_.tilesComposed += static_cast<uint64_t>(tx - start);
+      const GridRect run =
+          GridRect{start * kTileSize, ty * kTileSize, tx * kTileSize, (ty + 1) * kTileSize}.Intersect(Bounds());
+      bounds = bounds.empty() ? run : bounds.Union(run);
+      // Extend the same span from the row above when there is one.
+      auto above = std::find_if(frame_rects_.begin(), frame_rects_.end(), [&](const GridRect& rect) {
+        return rect.left == run.left && rect.right == run.right && rect.bottom == run.top;
+      });
+      if (above != frame_rects_.end()) {
+        above->bottom = run.bottom;
+      } else {
+        frame_rects_.push_back(run);
+      }
+    }
+  }
+  for (const GridRect& rect : frame_rects_) {
+    for (int y = rect.top; y < rect.bottom; ++y) {
+      std::fill_n(Row(y) + rect.left, rect.width(), background);
+    }
+  }
+  return bounds;
+}
+
+template <typename Fn>
+void TileCompositor::ForEachFrameSpan(const GridRect& rect, Fn&& fn) const {
+  const GridRect clipped = rect.Intersect(Bounds());
+  const GridRect tiles = TileRange(clipped);
+  for (int ty = tiles.top; ty < tiles.bottom; ++ty) {
+    for (int tx = tiles.left; tx < tiles.right;) {
+      if (!frame_[ty * tiles_x_ + tx]) {
+        ++tx;
+        continue;
+      }
+      const int start = tx;
+      while (tx < tiles.right && frame_[ty * tiles_x_ + tx]) {
+        ++tx;
+      }
+      fn(GridRect{start * kTileSize, ty * kTileSize, tx * kTileSize, (ty + 1) * kTileSize}.Intersect(clipped));
+    }
+  }
+}
+
+void TileCompositor::Fill(const GridRect& rect, uint32_t color) {
+  ForEachFrameSpan(rect, [&](const GridRect& part) {
+    for (int y = part.top; y < part.bottom; ++y) {
+      std::fill_n(Row(y) + part.left, part.width(), color);
+    }
+  });
+}
+
+void TileCompositor::Blend(const CoverImage& image, int x, int y) {
+  if (image.empty()) {
+    return;
+  }
+  const BlendRowFn blend_row = BlendRowFor(kernel_);
+  ForEachFrameSpan({x, y, x + image.width, y + image.height}, [&](const GridRect& part) {
+    for (int row = part.top; row < part.bottom; ++row) {
+      const uint8_t* src = image.data() + static_cast<size_t>(row - y) * image.stride() +
+                           static_cast<size_t>(part.left - x) * 4;
+      blend_row(Row(row) + part.left, src, static_cast<size_t>(part.width()));
+    }
+    stats_.pixelsBlended += static_cast<uint64_t>(part.width()) * static_cast<uint64_t>(part.height());
+  });
+}
+
+bool TileCompositor::TouchesFrame(const GridRect& rect) const {
+  const GridRect tiles = TileRange(rect);
+  for (int ty = tiles.top; ty < tiles.bottom; ++ty) {
+    const auto row = frame_.begin() + ty * tiles_x_;
+    if (std::find(row + tiles.left, row + tiles.right, uint8_t{1}) != row + tiles.right) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TileCompositor::BlendMasks(const uint8_t* mask, int mask_stride, const MaskBlit* blits, size_t count, int x,
+                                int y, uint32_t color) {
+  if (!mask || count == 0) {
+    return;
+  }
+  GridRect bounds;
+  for (size_t i = 0; i < count; ++i) {
+    const GridRect rect{x + blits[i].x, y + blits[i].y, x + blits[i].x + blits[i].width,
+                        y + blits[i].y + blits[i].height};
+    bounds = bounds.empty() ? rect : bounds.Union(rect);
+  }
+  if (!TouchesFrame(bounds)) {
+    return;
+  }
+  const bool opaque = (color >> 24) == 255;
+  for (size_t i = 0; i < count; ++i) {
+    const MaskBlit& blit = blits[i];
+    const int left = x + blit.x;
+    const int top = y + blit.y;
+    ForEachFrameSpan({left, top, left + blit.width, top + blit.height}, [&](const GridRect& part) {
+      for (int row = part.top; row < part.bottom; ++row) {
+        const uint8_t* coverage = mask + static_cast<size_t>(blit.srcY + row - top) * static_cast<size_t>(mask_stride) +
+                                  static_cast<size_t>(blit.srcX + part.left - left);
+        uint32_t* dst = Row(row) + part.left;
+        for (int col = 0; col < part.width(); ++col) {
+          if (coverage[col] == 255 && opaque) {
+            dst[col] = color;
+          } else if (coverage[col] != 0) {
+            dst[col] = BlendPixel(ScalePixel(color, coverage[col]), dst[col]);
+          }
+        }
+      }
+    });
+    ++stats_.maskBlits;
+  }
+}
+
+const std::vector<GridRect>& TileCompositor::End() {
+  std::fill(frame_.begin(), frame_.end(), uint8_t{0});
+  return frame_rects_;
+}
+
+}  // namespace optiscaler
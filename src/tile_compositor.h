@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cover_image.h"
+#include "grid_layout.h"
+
+namespace optiscaler {
+
+enum class BlendKernel {
+  kScalar,
+  kSse2,
+};
+
+// One rectangle of an 8-bit coverage mask (e.g. a glyph in GlyphAtlas)
+// and where it lands, relative to the origin passed to BlendMasks.
+struct MaskBlit {
+  int srcX = 0;
+  int srcY = 0;
+  int width = 0;
+  int height = 0;
+  int x = 0;
+  int y = 0;
+};
+
+struct CompositorStats {
+  uint64_t frames = 0;
+  uint64_t tilesComposed = 0;
+  uint64_t pixelsBlended = 0;
+  uint64_t maskBlits = 0;
+};
+
+// Software compositor over a caller-owned, top-down BGRA framebuffer in the
+// CoverImage layout (premultiplied alpha). The buffer is split into
+// kTileSize squares. Invalidate and Scroll mark tiles dirty, and a frame
+// only touches those: Begin clears them, every draw call is clipped to
+// them, and End returns them merged into rectangles for presenting.
+// Everything else keeps the pixels of earlier frames. Not thread-safe.
+class TileCompositor {
+ public:
+  static constexpr int kTileSize = 64;
+
+  static BlendKernel BestKernel();
+  explicit TileCompositor(BlendKernel kernel = BestKernel());
+
+  // `stride` is in pixels. Marks every tile dirty.
+  void Attach(uint32_t* pixels, int width, int height, int stride);
+  int width() const { return width_; }
+  int height() const { return height_; }
+  BlendKernel kernel() const { return kernel_; }
+
+  void Invalidate(const GridRect& rect);
+  // Moves the pixels inside `area` down by `dy` rows (up when negative)
+  // and invalidates the band that uncovers.
+  void Scroll(const GridRect& area, int dy);
+  bool dirty() const;
+
+  // Starts a frame over the dirty tiles and fills them with `background`.
+  // Returns their bounds: the caller must redraw everything intersecting
+  // it, since any dirty tile inside starts from the background.
+  GridRect Begin(uint32_t background);
+  void Fill(const GridRect& rect, uint32_t color);
+  // Source-over blend of premultiplied pixels; fully opaque runs are copied.
+  void Blend(const CoverImage& image, int x, int y);
+  // Blends `color` through each coverage rectangle, offset by (x, y). A
+  // batch entirely outside the frame's tiles costs one bounds check.
+  void BlendMasks(const uint8_t* mask, int mask_stride, const MaskBlit* blits, size_t count, int x, int y,
+                  uint32_t color);
+  // The tiles composed since Begin, merged into rectangles. Valid until the
+  // next Begin.
+  const std::vector<GridRect>& frameRects() const { return frame_rects_; }
+  const std::vector<GridRect>& End();
+
+  CompositorStats Stats() const { return stats_; }
+
+ private:
+  GridRect Bounds() const { return {0, 0, width_, height_}; }
+  GridRect TileRange(const GridRect& rect) const;  // in tile units, clipped
+  bool TouchesFrame(const GridRect& rect) const;
+  // Calls fn(part) for each run of frame tiles in a tile row, clipped to `rect`.
+  template <typename Fn>
+  void ForEachFrameSpan(const GridRect& rect, Fn&& fn) const;
+  uint32_t* Row(int y) const { return pixels_ + static_cast<size_t>(y) * static_cast<size_t>(stride_); }
+
+  const BlendKernel kernel_;
+  uint32_t* pixels_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int stride_ = 0;
+  int tiles_x_ = 0;
+  int tiles_y_ = 0;
+  std::vector<uint8_t> pending_;  // per tile, invalidated since the last Begin
+  std::vector<uint8_t> frame_;    // per tile, being composed
+  std::vector<GridRect> frame_rects_;
+  CompositorStats stats_;
+};
+
+// BGRA, opaque alpha, from 0xRRGGBB.
+constexpr uint32_t OpaqueColor(uint32_t rgb) {
+  return 0xFF000000u | rgb;
+}
+
+}  // namespace optiscaler
@@ -0,0 +1,61 @@
+#include "content_hash.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <string>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+std::wstring HexOf(const std::string& text) {
+  return Sha256::Of(text.data(), text.size()).Hex();
+}
+
+}  // namespace
+
+TEST(MatchesFipsVectors) {
+  CHECK_EQ(HexOf(""), L"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  CHECK_EQ(HexOf("abc"), L"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  CHECK_EQ(HexOf("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+           L"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+  CHECK_EQ(HexOf(std::string(1000000, 'a')), L"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST(ChunkedUpdatesMatchOneShot) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += static_cast<char>(i * 31);
+  }
+  const ContentHash expected = Sha256::Of(data.data(), data.size());
+  for (size_t chunk : {size_t{1}, size_t{7}, size_t{63}, size_t{64}, size_t{65}, size_t{500}}) {
+    Sha256 hasher;
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+      hasher.Update(data.data() + offset, std::min(chunk, data.size() - offset));
+    }
+    CHECK(hasher.Finish() == expected);
+  }
+}
+
+TEST(FinishStartsOver) {
+  Sha256 hasher;
+  hasher.Update("junk", 4);
+  hasher.Finish();
+  hasher.Update("abc", 3);
+  CHECK(hasher.Finish() == Sha256::Of("abc", 3));
+}
+
+TEST(HexRoundTrips) {
+  const ContentHash hash = Sha256::Of("cover", 5);
+  const auto parsed = ContentHash::FromHex(hash.Hex());
+  CHECK(parsed && *parsed == hash);
+  std::wstring upper = hash.Hex();
+  for (wchar_t& c : upper) {
+    c = static_cast<wchar_t>(std::towupper(c));
+  }
+  CHECK(ContentHash::FromHex(upper) == hash);
+  CHECK(!ContentHash::FromHex(L"abc"));
+  CHECK(!ContentHash::FromHex(std::wstring(64, L'g')));
+}
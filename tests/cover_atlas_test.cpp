@@ -0,0 +1,191 @@
+#include "cover_atlas.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "resampler.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+CoverImage Solid(int width, int height, uint8_t value) {
+  CoverImage image;
+  image.width = width;
+  image.height = height;
+  image.pixels.assign(static_cast<size_t>(width) * height * 4, value);
+  return image;
+}
+
+bool TileIs(const AtlasTile& tile, int width, int height, uint8_t value) {
+  if (!tile.pixels || tile.width != width || tile.height != height) {
+    return false;
+  }
+  for (size_t i = 0; i < tile.stride() * tile.height; ++i) {
+    if (tile.pixels[i] != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(AppendsFindsAndReplacesTiles) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "atlas.bin").wstring();
+  CoverAtlas atlas;
+  CHECK(atlas.Open(path));
+  CHECK_EQ(atlas.size(), size_t{0});
+
+  const CoverImage a = Solid(4, 6, 1);
+  const CoverImage b = Solid(2, 3, 2);
+  CHECK(atlas.Append({{10, &a}, {5, &b}}));
+  CHECK_EQ(atlas.size(), size_t{2});
+  AtlasTile tile;
+  CHECK(atlas.Find(10, tile) && TileIs(tile, 4, 6, 1));
+  CHECK(atlas.Find(5, tile) && TileIs(tile, 2, 3, 2));
+  CHECK(!atlas.Find(7, tile));
+
+  const CoverImage replacement = Solid(4, 6, 9);
+  CHECK(atlas.Append({{10, &replacement}}));
+  CHECK_EQ(atlas.size(), size_t{2});
+  CoverImage loaded;
+  CHECK(atlas.Load(10, loaded) && loaded.width == 4 && loaded.pixels[0] == 9);
+  CHECK(atlas.deadBytes() >= a.bytes());
+
+  CoverAtlas reopened;
+  CHECK(reopened.Open(path));
+  CHECK(reopened.Find(10, tile) && TileIs(tile, 4, 6, 9));
+  CHECK(reopened.Find(5, tile) && TileIs(tile, 2, 3, 2));
+}
+
+TEST(TilesOutliveLaterAppends) {
+  TempDir dir;
+  CoverAtlas atlas;
+  CHECK(atlas.Open((dir.path() / "atlas.bin").wstring()));
+  const CoverImage a = Solid(8, 8, 3);
+  CHECK(atlas.Append({{1, &a}}));
+  AtlasTile held;
+  CHECK(atlas.Find(1, held));
+  for (uint8_t i = 0; i < 20; ++i) {
+    const CoverImage next = Solid(8, 8, i);
+    CHECK(atlas.Append({{100u + i, &next}}));
+  }
+  CHECK(TileIs(held, 8, 8, 3));  // still mapped by the tile itself
+}
+
+TEST(TagsSurviveReopenAndCompaction) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "atlas.bin").wstring();
+  {
+    CoverAtlas atlas;
+    CHECK(atlas.Open(path));
+    const CoverImage a = Solid(2, 2, 1);
+    const CoverImage b = Solid(2, 2, 2);
+    CHECK(atlas.Append({{1, &a, 0xABCD}, {2, &b}}));
+    CHECK(atlas.Append({{1, &b, 0x1234}}));
+  }
+  const std::wstring compact = path + L".copy";
+  CHECK(CoverAtlas::Compact(path, compact));
+  for (const std::wstring& file : {path, compact}) {
+    CoverAtlas atlas;
+    CHECK(atlas.Open(file));
+    AtlasTile tile;
+    CHECK(atlas.Find(1, tile) && tile.tag == 0x1234u && TileIs(tile, 2, 2, 2));
+    CHECK(atlas.Find(2, tile) && tile.tag == 0u);
+  }
+}
+
+TEST(TileViewsReadInPlaceAndPinTheMapping) {
+  TempDir dir;
+  CoverImage view;
+  {
+    CoverAtlas atlas;
+    CHECK(atlas.Open((dir.path() / "atlas.bin").wstring()));
+    const CoverImage a = Solid(6, 4, 7);
+    CHECK(atlas.Append({{1, &a}}));
+    AtlasTile tile;
+    CHECK(atlas.Find(1, tile));
+    view = tile.AsImage();
+    CHECK(view.isView() && view.data() == tile.pixels);
+    CHECK(view.pixels.empty());
+    CHECK_EQ(view.bytes(), size_t{6 * 4 * 4});
+  }
+  CHECK(!view.empty());
+  for (size_t i = 0; i < view.bytes(); ++i) {
+    CHECK_EQ(view.data()[i], uint8_t{7});
+  }
+
+  CoverImage copy;
+  copy.width = view.width;
+  copy.height = view.height;
+  copy.pixels.assign(view.data(), view.data() + view.bytes());
+  CoverImage from_view;
+  CoverImage from_copy;
+  CHECK(Resampler::Resize(view, 3, 2, ResampleFilter::kBox, from_view));
+  CHECK(Resampler::Resize(copy, 3, 2, ResampleFilter::kBox, from_copy));
+  CHECK(!from_view.isView() && from_view.pixels == from_copy.pixels);
+}
+
+TEST(ReadersRunWhileTheOwnerAppends) {
+  TempDir dir;
+  CoverAtlas atlas;
+  CHECK(atlas.Open((dir.path() / "atlas.bin").wstring()));
+  const CoverImage base = Solid(16, 16, 7);
+  CHECK(atlas.Append({{1, &base}}));
+
+  std::atomic<bool> done{false};
+  std::atomic<int> bad{0};
+  std::thread reader([&] {
+    while (!done) {
+      CoverImage image;
+      if (!atlas.Load(1, image) || image.pixels.size() != base.bytes() || image.pixels[0] != 7) {
+        ++bad;
+      }
+    }
+  });
+  for (uint64_t key = 2; key < 60; ++key) {
+    const CoverImage image = Solid(16, 16, static_cast<uint8_t>(key));
+    atlas.Append({{key, &image}});
+  }
+  done = true;
+  reader.join();
+  CHECK_EQ(bad.load(), 0);
+  CHECK_EQ(atlas.size(), size_t{59});
+}
+
+TEST(CompactionAppliesOnlyToTheGenerationItCopied) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "atlas.bin").wstring();
+  {
+    CoverAtlas atlas;
+    CHECK(atlas.Open(path));
+    for (uint8_t round = 0; round < 4; ++round) {
+      const CoverImage image = Solid(32, 32, round);
+      CHECK(atlas.Append({{1, &image}, {2, &image}}));
+    }
+  }
+  const auto before = std::filesystem::file_size(path);
+  CHECK(CoverAtlas::Compact(path, path + L".compact"));
+  {
+    CoverAtlas atlas;
+    CHECK(atlas.Open(path));  // swaps the copy in
+    CHECK(!std::filesystem::exists(path + L".compact"));
+    CHECK(std::filesystem::file_size(path) < before);
+    AtlasTile tile;
+    CHECK(atlas.Find(2, tile) && TileIs(tile, 32, 32, 3));
+    CHECK(atlas.deadBytes() < 2 * 64);  // alignment padding only
+
+    // An append after the copy was taken makes the copy stale.
+    CHECK(CoverAtlas::Compact(path, path + L".compact"));
+    const CoverImage later = Solid(32, 32, 42);
+    CHECK(atlas.Append({{3, &later}}));
+    CHECK(!atlas.ApplyCompaction());
+    CHECK(!std::filesystem::exists(path + L".compact"));
+    CHECK(atlas.Find(3, tile) && TileIs(tile, 32, 32, 42));
+  }
+}
@@ -0,0 +1,136 @@
+#include "cover_blob_store.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+constexpr wchar_t kUrl[] = L"https://images.example.com/a.jpg";
+
+size_t BlobFiles(const std::filesystem::path& root) {
+  size_t count = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(root)) {
+    count += entry.path().extension() == ".blob" ? 1 : 0;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(DeduplicatesIdenticalCovers) {
+  TempDir dir;
+  CoverBlobStore store;
+  CHECK(store.Open(dir.path().wstring()));
+  const std::string image = "same image bytes";
+  const auto a = store.Put(1, image.data(), image.size());
+  const auto b = store.Put(2, image.data(), image.size());
+  CHECK(a && b && *a == *b);
+  CHECK(*a == Sha256::Of(image.data(), image.size()));
+  CHECK_EQ(BlobFiles(dir.path()), size_t{1});
+  const CoverBlobStats stats = store.Stats();
+  CHECK_EQ(stats.links, size_t{2});
+  CHECK_EQ(stats.blobs, size_t{1});
+  CHECK_EQ(stats.savedBytes, uint64_t{image.size()});
+  CHECK_EQ(store.PathFor(1), store.BlobPath(*a));
+}
+
+TEST(CollectsUnlinkedBlobsOnly) {
+  TempDir dir;
+  CoverBlobStore store;
+  CHECK(store.Open(dir.path().wstring()));
+  const std::string first = "first";
+  const std::string second = "second";
+  store.Put(1, first.data(), first.size(), kUrl);
+  store.Put(2, first.data(), first.size());
+  store.Put(3, second.data(), second.size());
+  dir.Write("stray.tmp", "left by a crash");
+
+  store.Unlink(1);
+  store.Unlink(3);
+  CHECK_EQ(store.CollectGarbage(), size_t{2});  // the second blob and the stray temp
+  CHECK_EQ(BlobFiles(dir.path()), size_t{1});
+  CHECK(store.Lookup(2).has_value());
+  CHECK(!store.Lookup(3).has_value());
+  // The first blob is still referenced, so its URL still resolves.
+  CHECK(store.LinkSource(4, kUrl));
+
+  store.Unlink(2);
+  store.Unlink(4);
+  CHECK_EQ(store.CollectGarbage(), size_t{1});
+  CHECK_EQ(BlobFiles(dir.path()), size_t{0});
+  CHECK(!store.LinkSource(5, kUrl));
+}
+
+TEST(AdoptsDownloadedFileUnderKnownHash) {
+  TempDir dir;
+  CoverBlobStore store;
+  CHECK(store.Open(dir.path().wstring()));
+  const std::string image = "downloaded image";
+  const std::wstring staging = store.StagingPath(kUrl);
+  CHECK(!staging.empty());
+  TempDir scratch;
+  std::filesystem::copy_file(scratch.Write("a.jpg", image), staging);
+
+  const ContentHash hash = Sha256::Of(image.data(), image.size());
+  const auto adopted = store.Adopt(7, staging, hash, image.size(), kUrl);
+  CHECK(adopted && *adopted == hash);
+  CHECK(!std::filesystem::exists(staging));
+  CHECK_EQ(std::filesystem::file_size(store.PathFor(7)), uintmax_t{image.size()});
+  // A second exe finds the same URL without downloading.
+  CHECK(store.LinkSource(8, kUrl));
+  CHECK(store.Lookup(8) == hash);
+}
+
+TEST(IndexSurvivesReopen) {
+  TempDir dir;
+  const std::string image = "persisted";
+  ContentHash hash;
+  {
+    CoverBlobStore store;
+    CHECK(store.Open(dir.path().wstring()));
+    hash = *store.Put(9, image.data(), image.size(), kUrl);
+    CHECK(store.Save());
+  }
+  CoverBlobStore store;
+  CHECK(store.Open(dir.path().wstring()));
+  CHECK(store.Lookup(9) == hash);
+  CHECK(store.LinkSource(10, kUrl));
+  CHECK_EQ(store.CollectGarbage(), size_t{0});
+}
+
+TEST(ConcurrentPutsAndCollection) {
+  TempDir dir;
+  CoverBlobStore store;
+  CHECK(store.Open(dir.path().wstring()));
+  std::vector<std::thread> writers;
+  for (uint64_t t = 0; t < 4; ++t) {
+    writers.emplace_back([&store, t] {
+      for (uint64_t i = 0; i < 50; ++i) {
+        const std::string image = "cover " + std::to_string(i % 10);
+        store.Put(t * 100 + i, image.data(), image.size());
+      }
+    });
+  }
+  for (int i = 0; i < 20; ++i) {
+    store.CollectGarbage();
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  // Every link still points at a file: collection never removed a blob or
+  // temp that a Put was publishing.
+  CHECK_EQ(store.Stats().links, size_t{200});
+  for (uint64_t t = 0; t < 4; ++t) {
+    for (uint64_t i = 0; i < 50; ++i) {
+      CHECK(std::filesystem::exists(store.PathFor(t * 100 + i)));
+    }
+  }
+  CHECK_EQ(BlobFiles(dir.path()), size_t{10});
+}
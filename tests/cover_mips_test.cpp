@@ -0,0 +1,96 @@
+#include "cover_mips.h"
+
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+CoverImage Solid(int width, int height, uint8_t value) {
+  CoverImage image;
+  image.width = width;
+  image.height = height;
+  image.pixels.assign(static_cast<size_t>(width) * height * 4, value);
+  return image;
+}
+
+}  // namespace
+
+TEST(PicksTheSmallestLevelThatIsNotUpscaled) {
+  CHECK_EQ(CoverMips::LevelForTile(200, 300), 0);
+  CHECK_EQ(CoverMips::LevelForTile(400, 600), 0);
+  CHECK_EQ(CoverMips::LevelForTile(101, 150), 0);
+  CHECK_EQ(CoverMips::LevelForTile(100, 150), 1);
+  CHECK_EQ(CoverMips::LevelForTile(60, 75), 1);
+  CHECK_EQ(CoverMips::LevelForTile(50, 75), 2);
+  CHECK_EQ(CoverMips::LevelForTile(10, 10), 2);
+}
+
+TEST(BuildsEveryLevelFromAnySource) {
+  const auto levels = CoverMips::Build(Solid(264, 352, 200));
+  CHECK_EQ(levels.size(), size_t{CoverMips::kLevels});
+  for (int level = 0; level < static_cast<int>(levels.size()); ++level) {
+    CHECK_EQ(levels[level].width, CoverMips::LevelWidth(level));
+    CHECK_EQ(levels[level].height, CoverMips::LevelHeight(level));
+    CHECK_EQ(levels[level].pixels[0], uint8_t{200});
+  }
+  CHECK(CoverMips::Build(CoverImage{}).empty());
+}
+
+TEST(FindTileFallsBackToNeighbouringLevels) {
+  TempDir dir;
+  CoverAtlas atlas;
+  CHECK(atlas.Open((dir.path() / "atlas.bin").wstring()));
+  const uint32_t tag = 7;
+  const CoverImage base = Solid(200, 300, 1);
+  const CoverImage smallest = Solid(50, 75, 3);
+  CHECK(atlas.Append({{CoverMips::LevelKey(42, 0), &base, tag}, {CoverMips::LevelKey(42, 2), &smallest, tag}}));
+  CHECK(!CoverMips::HasChain(atlas, 42, tag));
+
+  AtlasTile tile;
+  // Level 1 is missing: the finer level 0 wins over the coarser level 2.
+  CHECK(CoverMips::FindTile(atlas, 42, tag, 100, 150, tile));
+  CHECK_EQ(tile.width, 200);
+  CHECK(CoverMips::FindTile(atlas, 42, tag, 50, 75, tile));
+  CHECK_EQ(tile.width, 50);
+  CHECK(!CoverMips::FindTile(atlas, 43, tag, 50, 75, tile));
+  CHECK(tile.pixels == nullptr);
+}
+
+TEST(LevelsFromAnotherSourceAreStale) {
+  TempDir dir;
+  CoverAtlas atlas;
+  CHECK(atlas.Open((dir.path() / "atlas.bin").wstring()));
+  ContentHash first;
+  first.bytes[0] = 1;
+  ContentHash second;
+  second.bytes[0] = 2;
+  const uint32_t old_tag = CoverMips::SourceTag(first);
+  const uint32_t new_tag = CoverMips::SourceTag(second);
+  CHECK(old_tag != new_tag);
+  CHECK(CoverMips::SourceTag(ContentHash{}) != 0);
+
+  const auto levels = CoverMips::Build(Solid(200, 300, 9));
+  std::vector<AtlasWrite> tiles;
+  for (int level = 0; level < CoverMips::kLevels; ++level) {
+    tiles.push_back({CoverMips::LevelKey(42, level), &levels[level], old_tag});
+  }
+  CHECK(atlas.Append(tiles));
+  CHECK(CoverMips::HasChain(atlas, 42, old_tag));
+
+  // The cover was relinked to another blob: nothing old may be served.
+  AtlasTile tile;
+  CHECK(!CoverMips::HasChain(atlas, 42, new_tag));
+  CHECK(!CoverMips::FindTile(atlas, 42, new_tag, 100, 150, tile));
+
+  const auto rebuilt = CoverMips::Build(Solid(200, 300, 5));
+  tiles.clear();
+  for (int level = 0; level < CoverMips::kLevels; ++level) {
+    tiles.push_back({CoverMips::LevelKey(42, level), &rebuilt[level], new_tag});
+  }
+  CHECK(atlas.Append(tiles));
+  CHECK(CoverMips::HasChain(atlas, 42, new_tag));
+  CHECK(CoverMips::FindTile(atlas, 42, new_tag, 100, 150, tile));
+  CHECK(tile.tag == new_tag && tile.pixels[0] == 5);
+}
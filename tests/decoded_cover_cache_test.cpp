@@ -0,0 +1,79 @@
+#include "decoded_cover_cache.h"
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// 1 KiB per image keeps budgets readable.
+CoverImage Image() {
+  CoverImage image;
+  image.width = 16;
+  image.height = 16;
+  image.pixels.assign(16 * 16 * 4, 0x80);
+  return image;
+}
+
+}  // namespace
+
+TEST(EvictsLeastRecentlyUsedFirst) {
+  DecodedCoverCache cache(3 * 1024);
+  cache.Insert(1, Image());
+  cache.Insert(2, Image());
+  cache.Insert(3, Image());
+  CHECK(cache.Find(1) != nullptr);  // 2 is now the coldest
+  cache.Insert(4, Image());
+  CHECK(cache.Contains(1) && !cache.Contains(2) && cache.Contains(3) && cache.Contains(4));
+  const CoverCacheStats stats = cache.Stats();
+  CHECK_EQ(stats.evictions, uint64_t{1});
+  CHECK_EQ(stats.entries, size_t{3});
+  CHECK_EQ(stats.bytes, size_t{3 * 1024});
+}
+
+TEST(PeekNeitherCountsNorRefreshes) {
+  DecodedCoverCache cache(2 * 1024);
+  cache.Insert(1, Image());
+  cache.Insert(2, Image());
+  CHECK(cache.Peek(1) != nullptr);
+  CHECK(cache.Peek(9) == nullptr);
+  CHECK_EQ(cache.Stats().hits, uint64_t{0});
+  CHECK_EQ(cache.Stats().misses, uint64_t{0});
+  cache.Insert(3, Image());  // 1 stays coldest despite the peek
+  CHECK(!cache.Contains(1) && cache.Contains(2));
+
+  CHECK(cache.Find(9) == nullptr);
+  CHECK(cache.Find(2) != nullptr);
+  CHECK_EQ(cache.Stats().hits, uint64_t{1});
+  CHECK_EQ(cache.Stats().misses, uint64_t{1});
+}
+
+TEST(PinnedEntriesSurviveUntilUnpinned) {
+  DecodedCoverCache cache(2 * 1024);
+  CHECK(!cache.Pin(1));
+  cache.Insert(1, Image());
+  CHECK(cache.Pin(1));
+  CHECK(cache.Pin(1));
+  cache.Insert(2, Image());
+  cache.Insert(3, Image());
+  cache.Insert(4, Image());
+  CHECK(cache.Contains(1));
+  CHECK_EQ(cache.Stats().pinned, size_t{1});
+
+  cache.Unpin(1);
+  CHECK(cache.Contains(1));  // pins nest
+  cache.Unpin(1);
+  CHECK_EQ(cache.Stats().pinned, size_t{0});
+  cache.Insert(5, Image());  // 1 is the coldest unpinned entry now
+  CHECK(!cache.Contains(1) && cache.Contains(4) && cache.Contains(5));
+}
+
+TEST(HandedOutImagesOutliveEviction) {
+  DecodedCoverCache cache(1024);
+  auto image = cache.Insert(1, Image());
+  cache.Insert(2, Image());
+  CHECK(!cache.Contains(1));
+  CHECK(image && image->bytes() == 1024 && image->pixels[0] == 0x80);
+  cache.SetBudget(0);
+  CHECK_EQ(cache.Stats().entries, size_t{0});
+}
@@ -0,0 +1,82 @@
+#include "discovery.h"
+
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+std::string JsonPath(const std::filesystem::path& path) {
+  std::string text = path.generic_string();
+  std::string escaped;
+  for (char ch : text) {
+    if (ch == '\\' || ch == '"') {
+      escaped += '\\';
+    }
+    escaped += ch;
+  }
+  return escaped;
+}
+
+std::string EpicItem(const std::filesystem::path& install, const std::string& exe, const std::string& app,
+                     const std::string& main_app, const std::string& display_name) {
+  return "{\"InstallLocation\": \"" + JsonPath(install) + "\", \"LaunchExecutable\": \"" + exe +
+         "\", \"AppName\": \"" + app + "\", \"MainGameAppName\": \"" + main_app + "\", \"DisplayName\": \"" +
+         display_name + "\", \"InstallSize\": 1234, \"bIsIncompleteInstall\": false}";
+}
+
+const GameEntry* FindByName(const std::vector<GameEntry>& games, const std::wstring& name) {
+  for (const auto& game : games) {
+    if (game.name == name) {
+      return &game;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(ResolvesFixtureManifestsBeforeCrawling) {
+  TempDir dir;
+  const auto steam = dir.path() / "steam";
+  dir.Write("steam/steamapps/appmanifest_620.acf",
+            R"("AppState" { "appid" "620" "name" "Portal 2" "installdir" "Portal 2" "SizeOnDisk" "100" })");
+  dir.Write("steam/steamapps/appmanifest_999.acf",
+            R"("AppState" { "appid" "999" "name" "Not Installed" "installdir" "Missing" })");
+  dir.Write("steam/steamapps/common/Portal 2/portal2.exe");
+  dir.Write("steam/steamapps/common/Portal 2/bin/unins000.exe");
+
+  const auto epic_install = dir.path() / "epic/Hades";
+  dir.Write("epic/Hades/x64/Hades.exe");
+  dir.Write("manifests/hades.item", EpicItem(epic_install, "x64/Hades.exe", "Min", "Min", "Hades"));
+  dir.Write("manifests/hades_dlc.item", EpicItem(epic_install, "x64/Hades.exe", "MinDlc", "Min", "Hades DLC"));
+  dir.Write("manifests/broken.item", "{ not json");
+
+  dir.Write("custom/Indie/indie.exe");
+
+  DiscoveryPipeline pipeline;
+  pipeline.AddProvider(std::make_unique<SteamManifestProvider>(std::vector<std::wstring>{steam.wstring()}));
+  pipeline.AddProvider(std::make_unique<EpicManifestProvider>((dir.path() / "manifests").wstring()));
+  // The Epic install dir is crawled too; the manifest's entry must win.
+  pipeline.AddProvider(std::make_unique<CustomFolderProvider>(
+      std::vector<std::wstring>{(dir.path() / "custom").wstring(), (dir.path() / "epic").wstring()}));
+  DiscoveryOptions options;
+  options.manifestWorkers = 2;
+  const auto games = pipeline.Run(options);
+  CHECK_EQ(games.size(), size_t{3});
+
+  const GameEntry* portal = FindByName(games, L"Portal 2");
+  CHECK(portal != nullptr);
+  if (portal) {
+    CHECK(portal->source == L"steam");
+    CHECK(portal->steamAppId == 620u);
+    CHECK_EQ(portal->installSize, uint64_t{100});
+    CHECK(std::filesystem::path(portal->exe).filename() == L"portal2.exe");
+  }
+  const GameEntry* hades = FindByName(games, L"Hades");
+  CHECK(hades != nullptr && hades->source == L"epic" && hades->installSize == 1234);
+  const GameEntry* indie = FindByName(games, L"Indie");
+  CHECK(indie != nullptr && indie->source == L"custom");
+  CHECK(FindByName(games, L"Hades DLC") == nullptr);
+}
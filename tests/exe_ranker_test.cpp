@@ -0,0 +1,123 @@
+#include "exe_ranker.h"
+
+#include "scanner.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+constexpr uint16_t kMachineAmd64 = 0x8664;
+constexpr uint16_t kMachineI386 = 0x014C;
+constexpr uint16_t kSubsystemGui = 2;
+constexpr uint16_t kSubsystemConsole = 3;
+
+// Just enough of a PE image for ReadPeHeader: DOS stub, "PE\0\0", the file
+// header and the optional header up to Subsystem.
+std::string PeImage(uint16_t machine, uint16_t subsystem, bool dll = false) {
+  constexpr size_t kNt = 0x80;
+  std::string image(kNt + 24 + 96, '\0');
+  image[0] = 'M';
+  image[1] = 'Z';
+  image[0x3C] = static_cast<char>(kNt);
+  image.replace(kNt, 4, std::string("PE\0\0", 4));
+  auto put16 = [&image](size_t offset, uint16_t value) {
+    image[offset] = static_cast<char>(value & 0xFF);
+    image[offset + 1] = static_cast<char>(value >> 8);
+  };
+  put16(kNt + 4, machine);
+  put16(kNt + 22, dll ? 0x2000 : 0x0022);
+  put16(kNt + 24 + 68, subsystem);
+  return image;
+}
+
+GameEntry Candidate(const std::filesystem::path& folder, const std::filesystem::path& exe) {
+  GameEntry game;
+  game.folder = folder.wstring();
+  game.exe = exe.wstring();
+  game.name = folder.filename().wstring();
+  return game;
+}
+
+}  // namespace
+
+TEST(ReadsPeHeaderFields) {
+  TempDir dir;
+  const auto gui_path = dir.Write("gui.exe", PeImage(kMachineAmd64, kSubsystemGui));
+  const PeHeaderInfo gui = ExeRanker::ReadPeHeader(gui_path.wstring());
+  CHECK(gui.valid && !gui.isDll && gui.machine == kMachineAmd64 && gui.subsystem == kSubsystemGui);
+  const PeHeaderInfo dll = ExeRanker::ReadPeHeader(dir.Write("lib.exe", PeImage(kMachineI386, 2, true)).wstring());
+  CHECK(dll.valid && dll.isDll && dll.machine == kMachineI386);
+  CHECK(!ExeRanker::ReadPeHeader(dir.Write("text.exe", "not a PE file").wstring()).valid);
+  CHECK(!ExeRanker::ReadPeHeader((dir.path() / "missing.exe").wstring()).valid);
+}
+
+TEST(PicksTheShippingGameBinary) {
+  TempDir dir;
+  const auto game = dir.path() / "Stellar Blade";
+  const std::string gui = PeImage(kMachineAmd64, kSubsystemGui);
+  std::vector<GameEntry> candidates = {
+      Candidate(game, dir.Write("Stellar Blade/Launcher.exe", gui)),
+      Candidate(game, dir.Write("Stellar Blade/Engine/Binaries/Win64/CrashReportClient.exe", gui)),
+      Candidate(game, dir.Write("Stellar Blade/SB/Binaries/Win64/SB-Win64-Shipping.exe", gui)),
+      Candidate(game, dir.Write("Stellar Blade/tools/StellarBlade.exe", PeImage(kMachineAmd64, kSubsystemConsole))),
+      Candidate(dir.path() / "Solo", dir.Write("Solo/solo.exe", "MZ")),
+  };
+  const auto selected = ExeRanker::SelectPrimary(candidates, 2);
+  CHECK_EQ(selected.size(), size_t{2});
+  size_t found = 0;
+  for (const auto& entry : selected) {
+    if (entry.folder == game.wstring()) {
+      CHECK(std::filesystem::path(entry.exe).filename() == L"SB-Win64-Shipping.exe");
+      ++found;
+    } else {
+      // A lone candidate is kept without being scored.
+      CHECK(std::filesystem::path(entry.exe).filename() == L"solo.exe");
+      ++found;
+    }
+  }
+  CHECK_EQ(found, size_t{2});
+}
+
+TEST(NameMatchingTheFolderBeatsHelpers) {
+  TempDir dir;
+  const auto folder = dir.path() / "Hollow Knight";
+  const std::string gui = PeImage(kMachineAmd64, kSubsystemGui);
+  const int main_score = ExeRanker::Score(Candidate(folder, dir.Write("Hollow Knight/hollow_knight.exe", gui)));
+  const int config_score = ExeRanker::Score(Candidate(folder, dir.Write("Hollow Knight/config_tool.exe", gui)));
+  const int server_score = ExeRanker::Score(Candidate(folder, dir.Write("Hollow Knight/server.exe", gui)));
+  CHECK(main_score > config_score);
+  CHECK(main_score > server_score);
+}
+
+TEST(LooseExesInARootStaySeparate) {
+  TempDir dir;
+  const auto root = dir.path() / "Portable";
+  const std::string gui = PeImage(kMachineAmd64, kSubsystemGui);
+  std::vector<GameEntry> candidates = {
+      Candidate(root, dir.Write("Portable/Quake.exe", gui)),
+      Candidate(root, dir.Write("Portable/Doom.exe", gui)),
+      Candidate(root, dir.Write("Portable/Heretic.exe", gui)),
+  };
+  candidates[0].name = L"Quake";
+  candidates[1].name = L"Doom";
+  candidates[2].name = L"Heretic";
+  CHECK_EQ(ExeRanker::SelectPrimary(candidates, 2).size(), size_t{3});
+}
+
+TEST(ScannedRootKeepsLooseExesAndOneExePerGame) {
+  TempDir dir;
+  const std::string gui = PeImage(kMachineAmd64, kSubsystemGui);
+  dir.Write("library/Quake.exe", gui);
+  dir.Write("library/Doom.exe", gui);
+  dir.Write("library/Stellar Blade/Launcher.exe", gui);
+  dir.Write("library/Stellar Blade/SB/Binaries/Win64/SB-Win64-Shipping.exe", gui);
+  const auto games = ExeRanker::SelectPrimary(Scanner::ScanAll({(dir.path() / "library").wstring()}), 1);
+  CHECK_EQ(games.size(), size_t{3});
+  size_t stellar = 0;
+  for (const auto& game : games) {
+    stellar += game.name == L"Stellar Blade" ? 1 : 0;
+  }
+  CHECK_EQ(stellar, size_t{1});
+}
@@ -0,0 +1,153 @@
+#include "game_catalog.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// PathTable::Resolve joins with the native separator.
+const std::wstring kSep(1, std::filesystem::path::preferred_separator);
+
+GameEntry Game(const std::wstring& name, const std::wstring& source = L"steam") {
+  GameEntry game;
+  game.name = name;
+  game.folder = L"C:" + kSep + L"Games" + kSep + name;
+  game.exe = game.folder + kSep + name + L".exe";
+  game.source = source;
+  return game;
+}
+
+bool Has(const std::vector<GameId>& ids, GameId id) {
+  return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+}  // namespace
+
+TEST(FirstSyncAddsEveryGame) {
+  GameCatalog catalog;
+  GameEntry alpha = Game(L"Alpha");
+  alpha.steamAppId = 570;
+  alpha.injectEnabled = true;
+  alpha.plannedFiles = {alpha.folder + kSep + L"dxgi.dll", alpha.folder + kSep + L"OptiScaler.ini"};
+  const CatalogDelta delta = catalog.Sync({alpha, Game(L"Beta", L"epic"), Game(L"Gamma", L"unknown")});
+  CHECK_EQ(delta.added.size(), size_t{3});
+  CHECK(delta.removed.empty() && delta.changed.empty());
+  CHECK_EQ(catalog.size(), size_t{3});
+  CHECK(!Has(delta.added, kInvalidGameId));
+
+  const GameEntry entry = catalog.Entry(delta.added[0]);
+  CHECK(entry.name == L"Alpha" && entry.exe == alpha.exe && entry.folder == alpha.folder);
+  CHECK(entry.steamAppId && *entry.steamAppId == 570u);
+  CHECK(entry.injectEnabled);
+  CHECK_EQ(entry.plannedFiles, alpha.plannedFiles);
+  CHECK(catalog.Source(delta.added[1]) == GameSource::kEpic);
+  CHECK(catalog.Source(delta.added[2]) == GameSource::kCustom);
+  CHECK_EQ(catalog.Flags(delta.added[0]), uint8_t{kGameInjectEnabled | kGameHasSteamAppId});
+}
+
+TEST(UnchangedResyncIsEmpty) {
+  GameCatalog catalog;
+  const std::vector<GameEntry> games = {Game(L"Alpha"), Game(L"Beta")};
+  catalog.Sync(games);
+  const CatalogDelta delta = catalog.Sync(games);
+  CHECK(delta.added.empty() && delta.removed.empty() && delta.changed.empty());
+}
+
+TEST(MatchedGamesKeepIdsAndReportChanges) {
+  GameCatalog catalog;
+  std::vector<GameEntry> games = {Game(L"Alpha"), Game(L"Beta"), Game(L"Gamma")};
+  const std::vector<GameId> ids = catalog.Sync(games).added;
+  games[0].name = L"Alpha Remastered";
+  games[0].sortKey.clear();
+  games[2].injectEnabled = true;
+  games[2].plannedFiles = {games[2].folder + kSep + L"dxgi.dll"};
+  const CatalogDelta delta = catalog.Sync(games);
+  CHECK(delta.added.empty() && delta.removed.empty());
+  CHECK_EQ(delta.changed.size(), size_t{2});
+  CHECK(Has(delta.changed, ids[0]) && Has(delta.changed, ids[2]));
+  CHECK(catalog.Name(ids[0]) == L"Alpha Remastered");
+  CHECK(catalog.Flags(ids[2]) & kGameInjectEnabled);
+  CHECK_EQ(catalog.Entry(ids[2]).plannedFiles, games[2].plannedFiles);
+}
+
+TEST(RemovedGamesAreReportedAndIdsNotReused) {
+  GameCatalog catalog;
+  const std::vector<GameId> ids = catalog.Sync({Game(L"Alpha"), Game(L"Beta"), Game(L"Gamma")}).added;
+  const CatalogDelta delta = catalog.Sync({Game(L"Gamma"), Game(L"Alpha"), Game(L"Delta")});
+  CHECK_EQ(delta.removed, (std::vector<GameId>{ids[1]}));
+  CHECK_EQ(delta.added.size(), size_t{1});
+  CHECK(delta.changed.empty());
+  CHECK(delta.added[0] > *std::max_element(ids.begin(), ids.end()));
+  CHECK(!catalog.Contains(ids[1]));
+  // Gamma's row moved into Beta's slot; its id still resolves.
+  CHECK(catalog.Name(ids[2]) == L"Gamma");
+  CHECK(catalog.Name(ids[0]) == L"Alpha");
+  CHECK(catalog.Name(delta.added[0]) == L"Delta");
+
+  // A game that comes back is new.
+  const CatalogDelta back = catalog.Sync({Game(L"Alpha"), Game(L"Beta"), Game(L"Gamma"), Game(L"Delta")});
+  CHECK_EQ(back.added.size(), size_t{1});
+  CHECK(back.added[0] != ids[1]);
+}
+
+TEST(SyncToEmptyRemovesEverything) {
+  GameCatalog catalog;
+  catalog.Sync({Game(L"Alpha"), Game(L"Beta")});
+  const CatalogDelta delta = catalog.Sync({});
+  CHECK_EQ(delta.removed.size(), size_t{2});
+  CHECK(catalog.empty());
+}
+
+TEST(DuplicateExesKeepOneRow) {
+  GameCatalog catalog;
+  GameEntry renamed = Game(L"Alpha");
+  renamed.name = L"Alpha (copy)";
+  const CatalogDelta first = catalog.Sync({Game(L"Alpha"), renamed});
+  CHECK_EQ(first.added.size(), size_t{1});
+  CHECK(first.changed.empty());
+  CHECK_EQ(catalog.size(), size_t{1});
+  CHECK(catalog.Name(first.added[0]) == L"Alpha (copy)");  // the last entry wins
+
+  const CatalogDelta again = catalog.Sync({Game(L"Alpha"), Game(L"Alpha")});
+  CHECK(again.added.empty() && again.removed.empty());
+  CHECK_EQ(again.changed, (std::vector<GameId>{first.added[0]}));
+}
+
+TEST(RepeatedRenamesSurviveCompaction) {
+  GameCatalog catalog;
+  std::vector<GameEntry> games = {Game(L"Alpha"), Game(L"Beta")};
+  const std::vector<GameId> ids = catalog.Sync(games).added;
+  for (int i = 0; i < 200; ++i) {
+    games[0].name = L"Alpha " + std::to_wstring(i);
+    games[0].sortKey.clear();
+    CHECK_EQ(catalog.Sync(games).changed, (std::vector<GameId>{ids[0]}));
+  }
+  CHECK(catalog.Name(ids[0]) == L"Alpha 199");
+  CHECK(catalog.Name(ids[1]) == L"Beta");
+  CHECK(catalog.Exe(ids[1]) == games[1].exe);
+  CHECK(catalog.Sync(games).changed.empty());
+}
+
+TEST(FilterAndSortReadTheColumns) {
+  GameCatalog catalog;
+  GameEntry beta = Game(L"beta", L"epic");
+  beta.injectEnabled = true;
+  const std::vector<GameId> ids = catalog.Sync({Game(L"Charlie"), beta, Game(L"Alpha")}).added;
+  GameFilter steam_only;
+  steam_only.sources = 1 << static_cast<unsigned>(GameSource::kSteam);
+  std::vector<GameId> steam = catalog.Filter(steam_only);
+  catalog.Sort(steam);
+  CHECK_EQ(steam, (std::vector<GameId>{ids[2], ids[0]}));
+  GameFilter injected;
+  injected.required = kGameInjectEnabled;
+  CHECK_EQ(catalog.Filter(injected), (std::vector<GameId>{ids[1]}));
+  std::vector<GameId> all = catalog.ids();
+  catalog.Sort(all);
+  CHECK_EQ(all, (std::vector<GameId>{ids[2], ids[1], ids[0]}));
+}
@@ -0,0 +1,93 @@
+#include "game_sort.h"
+
+#include <random>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+GameEntry Game(const std::wstring& name, const std::wstring& exe, const std::wstring& source = L"steam",
+               int64_t last_played = 0, uint64_t size = 0) {
+  GameEntry game;
+  game.name = name;
+  game.exe = exe;
+  game.source = source;
+  game.lastPlayed = last_played;
+  game.installSize = size;
+  return game;
+}
+
+std::vector<std::wstring> Names(const std::vector<GameEntry>& games) {
+  std::vector<std::wstring> names;
+  for (const auto& game : games) {
+    names.push_back(game.name);
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST(CollationKeyOrdersNumbersByValue) {
+  CHECK(CollationKey(L"Part 2") < CollationKey(L"Part 10"));
+  CHECK(CollationKey(L"Part 9") < CollationKey(L"Part 10"));
+  CHECK(CollationKey(L"Part 10") < CollationKey(L"Part 11"));
+  CHECK(CollationKey(L"Agent 007") == CollationKey(L"agent 7"));
+  CHECK(CollationKey(L"Half-Life 2") < CollationKey(L"Half-Life Alyx"));
+  CHECK(CollationKey(L"DOOM") == CollationKey(L"doom"));
+  CHECK(CollationKey(L"Doom") < CollationKey(L"Doom 2"));
+  CHECK(CollationKey(L"Version 0") < CollationKey(L"Version 00001"));
+}
+
+TEST(SortsByEachField) {
+  std::vector<GameEntry> games = {
+      Game(L"Zeta 10", L"z10.exe", L"epic", 300, 10),
+      Game(L"zeta 9", L"z9.exe", L"steam", 100, 30),
+      Game(L"Alpha", L"a.exe", L"steam", 200, 20),
+      Game(L"alpha", L"a2.exe", L"custom", 0, 20),
+  };
+  SortGames(games);
+  CHECK(Names(games) == (std::vector<std::wstring>{L"Alpha", L"alpha", L"zeta 9", L"Zeta 10"}));
+  CHECK(!games[0].sortKey.empty());
+
+  SortGames(games, GameSortField::kSource);
+  CHECK(Names(games) == (std::vector<std::wstring>{L"alpha", L"Zeta 10", L"Alpha", L"zeta 9"}));
+  SortGames(games, GameSortField::kLastPlayed);
+  CHECK(Names(games) == (std::vector<std::wstring>{L"Zeta 10", L"Alpha", L"zeta 9", L"alpha"}));
+  SortGames(games, GameSortField::kSize);
+  CHECK(Names(games) == (std::vector<std::wstring>{L"zeta 9", L"Alpha", L"alpha", L"Zeta 10"}));
+}
+
+TEST(ParallelSortMatchesSerialOrder) {
+  std::mt19937 random(7);
+  std::vector<GameEntry> games;
+  const size_t count = kParallelSortThreshold + 1500;
+  for (size_t i = 0; i < count; ++i) {
+    const std::wstring name = L"Game " + std::to_wstring(random() % 5000);
+    games.push_back(Game(name, L"g" + std::to_wstring(i) + L".exe", L"steam", random() % 10, random() % 7));
+  }
+  for (GameSortField field : {GameSortField::kName, GameSortField::kLastPlayed, GameSortField::kSize}) {
+    std::vector<GameEntry> parallel = games;
+    SortGames(parallel, field, 3);
+    // Reference order: one std::sort over the same comparison.
+    std::vector<GameEntry> serial = games;
+    for (auto& game : serial) {
+      game.sortKey = CollationKey(game.name);
+    }
+    std::sort(serial.begin(), serial.end(), [field](const GameEntry& a, const GameEntry& b) {
+      if (field == GameSortField::kLastPlayed && a.lastPlayed != b.lastPlayed) {
+        return a.lastPlayed > b.lastPlayed;
+      }
+      if (field == GameSortField::kSize && a.installSize != b.installSize) {
+        return a.installSize > b.installSize;
+      }
+      return a.sortKey != b.sortKey ? a.sortKey < b.sortKey : a.exe < b.exe;
+    });
+    bool same = parallel.size() == serial.size();
+    for (size_t i = 0; same && i < serial.size(); ++i) {
+      same = parallel[i].exe == serial[i].exe;
+    }
+    CHECK(same);
+  }
+}
@@ -0,0 +1,138 @@
+#include "glyph_atlas.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "headless_surface.h"
+#include "test.h"
+#include "text_layout.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr int kAdvance = 7;  // BitmapFont at scale 1
+constexpr uint32_t kBackground = OpaqueColor(0x000000);
+constexpr uint32_t kWhite = OpaqueColor(0xFFFFFF);
+
+}  // namespace
+
+TEST(LabelsWiderThanMaxWidthEndInAnEllipsis) {
+  GlyphAtlas atlas;
+  const FontId font = atlas.AddFont(std::make_unique<BitmapFont>());
+  TextLayoutCache layouts(atlas);
+
+  const auto full = layouts.Layout(font, L"Half-Life 2");
+  CHECK(!full->truncated);
+  CHECK_EQ(full->width, 11 * kAdvance);
+  CHECK_EQ(full->height, 15);
+
+  const auto cut = layouts.Layout(font, L"Half-Life 2", 5 * kAdvance);
+  CHECK(cut->truncated);
+  CHECK(cut->width <= 5 * kAdvance);
+  CHECK_EQ(cut->width, 5 * kAdvance);  // four glyphs and the ellipsis
+  const AtlasGlyph* ellipsis = atlas.Find(font, 0x2026);
+  CHECK(ellipsis != nullptr);
+  CHECK_EQ(cut->blits.back().srcX, static_cast<int>(ellipsis->x));
+  CHECK_EQ(cut->blits.back().srcY, static_cast<int>(ellipsis->y));
+  CHECK_EQ(cut->blits.back().x, 4 * kAdvance);
+
+  const auto fits = layouts.Layout(font, L"Portal", 6 * kAdvance);
+  CHECK(!fits->truncated);
+}
+
+TEST(LayoutIsRedoneWhenTheAtlasResetsWhileBuilding) {
+  // Room for four 8x13 glyphs on one shelf and no second shelf.
+  GlyphAtlas atlas(36, 16);
+  const FontId font = atlas.AddFont(std::make_unique<BitmapFont>());
+  TextLayoutCache layouts(atlas);
+
+  const auto first = layouts.Layout(font, L"ABCD");
+  CHECK_EQ(first->generation, atlas.generation());
+  CHECK_EQ(atlas.Stats().resets, 0u);
+
+  // 'E' does not fit, so the atlas is cleared part way through the build
+  // and the glyphs placed before it would point at cleared pixels.
+  const auto second = layouts.Layout(font, L"EF");
+  CHECK_EQ(atlas.Stats().resets, 1u);
+  CHECK_EQ(second->generation, atlas.generation());
+  CHECK_EQ(second->blits.size(), 2u);
+  CHECK_EQ(second->blits[0].srcX, static_cast<int>(atlas.Find(font, U'E')->x));
+  CHECK_EQ(second->blits[1].srcX, static_cast<int>(atlas.Find(font, U'F')->x));
+
+  // The older run is stale now and is laid out again on lookup.
+  const uint64_t misses = layouts.Stats().misses;
+  const auto again = layouts.Layout(font, L"ABCD");
+  CHECK_EQ(layouts.Stats().misses, misses + 1);
+  CHECK_EQ(again->generation, atlas.generation());
+}
+
+TEST(LeastRecentlyUsedLayoutsAreEvicted) {
+  GlyphAtlas atlas;
+  const FontId font = atlas.AddFont(std::make_unique<BitmapFont>());
+  TextLayoutCache layouts(atlas, 2);
+
+  const auto doom = layouts.Layout(font, L"Doom");
+  layouts.Layout(font, L"Quake");
+  CHECK(layouts.Layout(font, L"Doom") == doom);  // now most recently used
+  layouts.Layout(font, L"Hexen");                // evicts "Quake"
+
+  TextLayoutStats stats = layouts.Stats();
+  CHECK_EQ(stats.entries, 2u);
+  CHECK_EQ(stats.evictions, 1u);
+  CHECK_EQ(stats.hits, 1u);
+  CHECK_EQ(stats.misses, 3u);
+
+  CHECK(layouts.Layout(font, L"Doom") == doom);
+  layouts.Layout(font, L"Quake");
+  stats = layouts.Stats();
+  CHECK_EQ(stats.hits, 2u);
+  CHECK_EQ(stats.misses, 4u);
+  CHECK_EQ(stats.evictions, 2u);
+
+  // The key is the text, not the buffer it came from.
+  const std::wstring quake = L"Quake";
+  layouts.Layout(font, quake);
+  CHECK_EQ(layouts.Stats().hits, 3u);
+}
+
+TEST(DrawTextLayoutBlitsGlyphsIntoTheFrame) {
+  GlyphAtlas atlas;
+  const FontId font = atlas.AddFont(std::make_unique<BitmapFont>());
+  TextLayoutCache layouts(atlas);
+  HeadlessSurface surface(128, 64);
+  TileCompositor& compositor = surface.compositor();
+
+  const auto layout = layouts.Layout(font, L"I");
+  compositor.Begin(kBackground);
+  DrawTextLayout(compositor, atlas, *layout, 10, 20, kWhite);
+  surface.Present();
+
+  int lit = 0;
+  for (int y = 0; y < surface.height(); ++y) {
+    for (int x = 0; x < surface.width(); ++x) {
+      if (surface.Pixel(x, y) == kWhite) {
+        ++lit;
+        CHECK(x >= 10 && x < 10 + layout->width);
+        CHECK(y >= 20 && y < 20 + layout->height);
+      } else {
+        CHECK_EQ(surface.Pixel(x, y), kBackground);
+      }
+    }
+  }
+  CHECK(lit > 0);
+
+  // A layout from an older atlas generation draws nothing.
+  TextLayout stale = *layout;
+  stale.generation = atlas.generation() + 1;
+  compositor.Invalidate({0, 0, surface.width(), surface.height()});
+  compositor.Begin(kBackground);
+  DrawTextLayout(compositor, atlas, stale, 10, 20, kWhite);
+  surface.Present();
+  for (int y = 0; y < surface.height(); ++y) {
+    for (int x = 0; x < surface.width(); ++x) {
+      CHECK_EQ(surface.Pixel(x, y), kBackground);
+    }
+  }
+}
@@ -0,0 +1,135 @@
+#include "grid_layout.h"
+
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// Default metrics: 200x300 covers, 24px labels, 16px gaps and margins, so
+// rows are 340px apart and a 1000px wide viewport fits four columns.
+GridLayout MakeGrid(size_t count) {
+  GridLayout grid;
+  grid.SetMetrics(GridMetrics{});
+  grid.SetViewport(1000, 700);
+  grid.SetItemCount(count);
+  return grid;
+}
+
+}  // namespace
+
+TEST(LaysOutCenteredColumns) {
+  const GridLayout grid = MakeGrid(100);
+  CHECK_EQ(grid.columns(), size_t{4});
+  CHECK_EQ(grid.rows(), size_t{25});
+  CHECK_EQ(grid.rowPitch(), 340);
+  CHECK_EQ(grid.contentHeight(), 32 + 25 * 340 - 16);
+  CHECK_EQ(grid.maxScroll(), grid.contentHeight() - 700);
+  const GridRect first = grid.TileRect(0);
+  CHECK_EQ(first.left, 76);
+  CHECK_EQ(first.top, 16);
+  CHECK_EQ(first.height(), 324);
+  CHECK_EQ(grid.CoverRect(5).top, 16 + 340);
+  CHECK_EQ(grid.LabelRect(5).top, 16 + 340 + 300);
+  CHECK_EQ(grid.TileRect(5).left, 76 + 216);
+}
+
+TEST(VisibleRangeFollowsScroll) {
+  GridLayout grid = MakeGrid(100);
+  CHECK(grid.VisibleRange() == std::make_pair(size_t{0}, size_t{12}));
+  CHECK(grid.SetScroll(340));
+  CHECK(grid.VisibleRange() == std::make_pair(size_t{4}, size_t{16}));
+  CHECK(!grid.IsVisible(0));
+  CHECK(grid.IsVisible(4));
+  // Only the gap below row 0 remains on screen.
+  CHECK(grid.SetScroll(344));
+  CHECK_EQ(grid.VisibleRange().first, size_t{4});
+  CHECK(MakeGrid(0).VisibleRange() == std::make_pair(size_t{0}, size_t{0}));
+  CHECK(MakeGrid(6).VisibleRange() == std::make_pair(size_t{0}, size_t{6}));
+}
+
+TEST(ScrollIsClamped) {
+  GridLayout grid = MakeGrid(100);
+  CHECK(!grid.ScrollBy(-50));
+  CHECK(grid.SetScroll(1000000));
+  CHECK_EQ(grid.scroll(), grid.maxScroll());
+  CHECK(!grid.ScrollBy(10));
+  // Shrinking the list pulls the offset back into range.
+  grid.SetItemCount(4);
+  CHECK_EQ(grid.maxScroll(), 0);
+  CHECK_EQ(grid.scroll(), 0);
+}
+
+TEST(HitTestSkipsGapsAndMargins) {
+  GridLayout grid = MakeGrid(10);
+  CHECK(grid.HitTest(76, 16) == size_t{0});
+  CHECK(!grid.HitTest(76 + 200, 16));  // column gap
+  CHECK(!grid.HitTest(10, 100));       // left margin
+  CHECK(!grid.HitTest(76, 16 + 330));  // row gap
+  CHECK(grid.HitTest(76 + 217, 16 + 341) == size_t{5});
+  CHECK(!grid.HitTest(76 + 2 * 216, 16 + 681));  // past the last item
+  CHECK(!grid.HitTest(76, 800));                 // outside the viewport
+  CHECK(grid.SetScroll(336));  // maxScroll
+  CHECK(grid.HitTest(76, 20) == size_t{4});
+}
+
+TEST(ViewportOffsetShiftsRects) {
+  GridLayout grid;
+  grid.SetViewport(1000, 700, 40);
+  grid.SetItemCount(8);
+  CHECK_EQ(grid.TileRect(0).top, 40 + 16);
+  CHECK(!grid.HitTest(76, 20));
+  CHECK(grid.HitTest(76, 40 + 16) == size_t{0});
+}
+
+TEST(MetricsChangeRelayouts) {
+  GridLayout grid = MakeGrid(100);
+  GridMetrics small;
+  small.tileWidth = 100;
+  small.tileHeight = 150;
+  grid.SetMetrics(small);
+  CHECK_EQ(grid.columns(), size_t{8});
+  CHECK_EQ(grid.rowPitch(), 150 + 24 + 16);
+}
+
+TEST(ForEachTileVisitsOnlyClippedTiles) {
+  const GridLayout grid = MakeGrid(100);
+  std::vector<size_t> visited;
+  grid.ForEachTile({76, 16, 100, 50}, [&](size_t index, const GridRect&) { visited.push_back(index); });
+  CHECK_EQ(visited, (std::vector<size_t>{0}));
+  visited.clear();
+  grid.ForEachTile(grid.viewport(), [&](size_t index, const GridRect&) { visited.push_back(index); });
+  CHECK_EQ(visited.size(), size_t{12});
+  CHECK_EQ(visited.front(), size_t{0});
+  CHECK_EQ(visited.back(), size_t{11});
+}
+
+TEST(DirtyRegionMergesTouchingRects) {
+  DirtyRegion dirty;
+  dirty.Add({});
+  CHECK(dirty.empty());
+  dirty.Add({0, 0, 10, 10});
+  dirty.Add({10, 0, 20, 10});
+  CHECK_EQ(dirty.rects().size(), size_t{1});
+  CHECK_EQ(dirty.rects()[0].right, 20);
+  dirty.Add({100, 100, 110, 110});
+  CHECK_EQ(dirty.rects().size(), size_t{2});
+  // Bridging both pulls everything into one rectangle.
+  dirty.Add({15, 5, 105, 105});
+  CHECK_EQ(dirty.rects().size(), size_t{1});
+  const GridRect bounds = dirty.Bounds();
+  CHECK(bounds.left == 0 && bounds.top == 0 && bounds.right == 110 && bounds.bottom == 110);
+  dirty.Clear();
+  CHECK(dirty.empty());
+}
+
+TEST(DirtyRegionCollapsesPastTheLimit) {
+  DirtyRegion dirty;
+  for (int i = 0; i <= static_cast<int>(DirtyRegion::kMaxRects); ++i) {
+    dirty.Add({i * 20, 0, i * 20 + 10, 10});
+  }
+  CHECK_EQ(dirty.rects().size(), size_t{1});
+  CHECK_EQ(dirty.rects()[0].right, static_cast<int>(DirtyRegion::kMaxRects) * 20 + 10);
+}
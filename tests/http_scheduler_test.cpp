@@ -0,0 +1,263 @@
+#include "http_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Answers every request with `status`, recording when each one arrived and
+// its path. While held, requests block after arriving until Release().
+class FakeTransport : public IHttpClient {
+ public:
+  std::atomic<int> status{200};
+  std::atomic<int> failures_left{0};  // `failure_status` answers before `status`
+  std::atomic<int> failure_status{503};
+  std::string body = "ok";
+
+  bool Send(const HttpRequest& request, HttpResponse& response_out) override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      arrivals_.push_back(Clock::now());
+      paths_.push_back(request.path);
+      arrived_.notify_all();
+      released_.wait(lock, [this] { return !held_; });
+    }
+    response_out = HttpResponse{};
+    response_out.status = failures_left.fetch_sub(1) > 0 ? failure_status.load() : status.load();
+    response_out.body = response_out.status == 200 ? body : "error page";
+    return true;
+  }
+
+  void Hold() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_ = true;
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    held_ = false;
+    released_.notify_all();
+  }
+
+  void WaitForArrivals(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    arrived_.wait(lock, [&] { return arrivals_.size() >= count; });
+  }
+
+  std::vector<Clock::time_point> arrivals() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arrivals_;
+  }
+
+  std::vector<std::wstring> paths() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paths_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable arrived_;
+  std::condition_variable released_;
+  bool held_ = false;
+  std::vector<Clock::time_point> arrivals_;
+  std::vector<std::wstring> paths_;
+};
+
+HttpRequest RequestTo(const std::wstring& host, const std::wstring& path = L"/") {
+  HttpRequest request;
+  request.host = host;
+  request.path = path;
+  return request;
+}
+
+// One request in flight at a time, so everything else queues behind it.
+HostLimits OneAtATime() {
+  HostLimits limits;
+  limits.requestsPerSecond = 1000.0;
+  limits.burst = 1000.0;
+  limits.maxInFlight = 1;
+  return limits;
+}
+
+HttpSchedulerOptions FastRetries() {
+  HttpSchedulerOptions options;
+  options.workerCount = 4;
+  options.baseBackoff = std::chrono::milliseconds(1);
+  options.maxBackoff = std::chrono::milliseconds(2);
+  return options;
+}
+
+}  // namespace
+
+TEST(TokenBucketPacesRequestsAfterBurst) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  HostLimits limits;
+  limits.requestsPerSecond = 20.0;
+  limits.burst = 2.0;
+  limits.maxInFlight = 4;
+  scheduler.SetHostLimits(L"api.example.com", limits);
+
+  const auto start = Clock::now();
+  for (int i = 0; i < 6; ++i) {
+    scheduler.Submit(RequestTo(L"api.example.com"), HttpPriority::kBackground, nullptr);
+  }
+  scheduler.Wait();
+  const auto arrivals = transport.arrivals();
+  CHECK_EQ(arrivals.size(), size_t{6});
+  // Two go out at once from the burst; the other four wait for refills at
+  // 50 ms each, so the last leaves no earlier than ~200 ms in.
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(arrivals.back() - start);
+  CHECK(elapsed.count() >= 180);
+  CHECK_EQ(scheduler.Stats().completed, uint64_t{6});
+}
+
+TEST(HostsHaveIndependentBuckets) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  HostLimits slow;
+  slow.requestsPerSecond = 1.0;
+  slow.burst = 1.0;
+  scheduler.SetHostLimits(L"slow.example.com", slow);
+
+  std::atomic<int> fast_done{0};
+  scheduler.Submit(RequestTo(L"slow.example.com"), HttpPriority::kBackground, nullptr);
+  const uint64_t held = scheduler.Submit(RequestTo(L"slow.example.com"), HttpPriority::kBackground, nullptr);
+  for (int i = 0; i < 5; ++i) {
+    scheduler.Submit(RequestTo(L"fast.example.com"), HttpPriority::kBackground,
+                     [&](const HttpResponse&) { ++fast_done; });
+  }
+  const auto deadline = Clock::now() + std::chrono::milliseconds(500);
+  while (fast_done < 5 && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK_EQ(fast_done.load(), 5);
+  // The second slow request is still waiting for its token.
+  CHECK(scheduler.Cancel(held));
+  scheduler.Wait();
+}
+
+TEST(RetriesServerErrorsWithBackoff) {
+  FakeTransport transport;
+  transport.failures_left = 2;
+  HttpScheduler scheduler(transport, FastRetries());
+  int status = 0;
+  scheduler.Submit(RequestTo(L"api.example.com"), HttpPriority::kInteractive,
+                   [&](const HttpResponse& response) { status = response.status; });
+  scheduler.Wait();
+  CHECK_EQ(status, 200);
+  CHECK_EQ(scheduler.Stats().retried, uint64_t{2});
+}
+
+TEST(ScheduledClientBlocksForTheResponse) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  ScheduledHttpClient client(scheduler, HttpPriority::kInteractive);
+  HttpResponse response;
+  CHECK(client.Send(RequestTo(L"api.example.com"), response));
+  CHECK_EQ(response.status, 200);
+  CHECK_EQ(response.body, std::string("ok"));
+
+  std::string streamed;
+  transport.failures_left = 1;  // the error page is dropped, the retry is streamed
+  CHECK(client.SendStreaming(RequestTo(L"api.example.com"), response, [&](const char* data, size_t size) {
+    streamed.append(data, size);
+    return true;
+  }));
+  CHECK_EQ(streamed, std::string("ok"));
+}
+
+TEST(ScheduledClientFailsInsideCallback) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  ScheduledHttpClient client(scheduler, HttpPriority::kInteractive);
+  bool nested_ok = true;
+  std::wstring nested_error;
+  scheduler.Submit(RequestTo(L"api.example.com"), HttpPriority::kInteractive, [&](const HttpResponse&) {
+    HttpResponse nested;
+    nested_ok = client.Send(RequestTo(L"api.example.com"), nested);
+    nested_error = nested.error;
+  });
+  scheduler.Wait();  // would hang if the nested call waited on its own worker
+  CHECK(!nested_ok);
+  CHECK(!nested_error.empty());
+}
+
+TEST(InteractiveJobsOvertakeQueuedBackgroundJobs) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  scheduler.SetHostLimits(L"api.example.com", OneAtATime());
+  transport.Hold();
+  scheduler.Submit(RequestTo(L"api.example.com", L"/running"), HttpPriority::kBackground, nullptr);
+  transport.WaitForArrivals(1);
+  for (int i = 0; i < 3; ++i) {
+    scheduler.Submit(RequestTo(L"api.example.com", L"/background"), HttpPriority::kBackground, nullptr);
+  }
+  scheduler.Submit(RequestTo(L"api.example.com", L"/visible"), HttpPriority::kVisible, nullptr);
+  scheduler.Submit(RequestTo(L"api.example.com", L"/click"), HttpPriority::kInteractive, nullptr);
+  transport.Release();
+  scheduler.Wait();
+  const std::vector<std::wstring> expected = {L"/running", L"/click", L"/visible", L"/background", L"/background",
+                                              L"/background"};
+  CHECK(transport.paths() == expected);
+}
+
+TEST(ReprioritizeMovesQueuedJobsBetweenLanes) {
+  FakeTransport transport;
+  HttpScheduler scheduler(transport, FastRetries());
+  scheduler.SetHostLimits(L"api.example.com", OneAtATime());
+  transport.Hold();
+  const uint64_t running = scheduler.Submit(RequestTo(L"api.example.com", L"/running"), HttpPriority::kBackground,
+                                            nullptr);
+  transport.WaitForArrivals(1);
+  scheduler.Submit(RequestTo(L"api.example.com", L"/a"), HttpPriority::kBackground, nullptr);
+  const uint64_t b = scheduler.Submit(RequestTo(L"api.example.com", L"/b"), HttpPriority::kBackground, nullptr);
+  const uint64_t c = scheduler.Submit(RequestTo(L"api.example.com", L"/c"), HttpPriority::kVisible, nullptr);
+  // The tile for /b came into view; the one for /c scrolled away.
+  CHECK(scheduler.Reprioritize(b, HttpPriority::kInteractive));
+  CHECK(scheduler.Reprioritize(c, HttpPriority::kBackground));
+  CHECK(!scheduler.Reprioritize(running, HttpPriority::kInteractive));  // already sent
+  CHECK(!scheduler.Reprioritize(9999, HttpPriority::kInteractive));
+  transport.Release();
+  scheduler.Wait();
+  const std::vector<std::wstring> expected = {L"/running", L"/b", L"/a", L"/c"};
+  CHECK(transport.paths() == expected);
+}
+
+TEST(TooManyRequestsDrainsTheBucketBeforeTheRetry) {
+  HostLimits limits;
+  limits.requestsPerSecond = 10.0;  // a token every 100 ms
+  limits.burst = 5.0;
+  limits.maxInFlight = 4;
+  for (int failure : {503, 429}) {
+    FakeTransport transport;
+    transport.failure_status = failure;
+    transport.failures_left = 1;
+    HttpScheduler scheduler(transport, FastRetries());
+    scheduler.SetHostLimits(L"api.example.com", limits);
+    int status = 0;
+    scheduler.Submit(RequestTo(L"api.example.com"), HttpPriority::kInteractive,
+                     [&](const HttpResponse& response) { status = response.status; });
+    scheduler.Wait();
+    CHECK_EQ(status, 200);
+    CHECK_EQ(scheduler.Stats().retried, uint64_t{1});
+    const auto arrivals = transport.arrivals();
+    CHECK_EQ(arrivals.size(), size_t{2});
+    const auto gap = std::chrono::duration_cast<std::chrono::milliseconds>(arrivals[1] - arrivals[0]).count();
+    if (failure == 429) {
+      CHECK(gap >= 90);  // the burst is gone; the retry waits for a refill
+    } else {
+      CHECK(gap < 90);  // only the 1-2 ms backoff; tokens were left
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#include "igdb_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+constexpr int64_t kNow = 1700000000;
+
+IgdbGame Game(const std::wstring& name, const std::wstring& image_id) {
+  IgdbGame game;
+  game.name = name;
+  game.imageId = image_id;
+  return game;
+}
+
+}  // namespace
+
+TEST(NormalizesNames) {
+  CHECK_EQ(IgdbCache::NormalizeName(L"  The Witcher 3: Wild-Hunt! "), std::wstring(L"the witcher 3 wild hunt"));
+  CHECK_EQ(IgdbCache::NormalizeName(L"DOOM"), IgdbCache::NormalizeName(L"doom"));
+  // Symbol-only titles fall back to the lowercased raw text instead of
+  // colliding on the empty key.
+  CHECK_EQ(IgdbCache::NormalizeName(L"!!!"), std::wstring(L"!!!"));
+  CHECK(IgdbCache::NormalizeName(L"!!!") != IgdbCache::NormalizeName(L"???"));
+  CHECK(IgdbCache::NormalizeName(L"").empty());
+}
+
+TEST(SymbolOnlyTitlesAreCachedSeparately) {
+  TempDir dir;
+  IgdbCache cache;
+  CHECK(cache.Open((dir.path() / "igdb.bin").wstring(), kNow));
+  CHECK(cache.Store(L"!!!", Game(L"!!!", L"co1"), kNow));
+  CHECK(cache.Store(L"???", std::nullopt, kNow));
+  std::optional<IgdbGame> found;
+  CHECK(cache.Find(L"!!!", found, kNow) && found && found->imageId == L"co1");
+  CHECK(cache.Find(L"???", found, kNow) && !found);
+  CHECK(!cache.Find(L"---", found, kNow));
+}
+
+TEST(ReplaysLogWithLaterRecordsWinning) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "igdb.bin").wstring();
+  {
+    IgdbCache cache;
+    CHECK(cache.Open(path, kNow));
+    CHECK(cache.Store(L"Alpha", Game(L"Alpha", L"old"), kNow));
+    CHECK(cache.Store(L"Alpha", Game(L"Alpha", L"new"), kNow));
+    CHECK(cache.Store(L"Beta", std::nullopt, kNow));
+  }
+  IgdbCache cache;
+  CHECK(cache.Open(path, kNow + 1));
+  CHECK_EQ(cache.size(), size_t{2});
+  CHECK_EQ(cache.deadRecords(), size_t{1});
+  std::optional<IgdbGame> found;
+  CHECK(cache.Find(L"alpha", found, kNow + 1) && found && found->imageId == L"new");
+  CHECK(cache.Find(L"Beta", found, kNow + 1) && !found);
+}
+
+TEST(ExpiresHitsAndMissesOnTheirOwnTtl) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "igdb.bin").wstring();
+  IgdbCache cache;
+  CHECK(cache.Open(path, kNow));
+  CHECK(cache.Store(L"Hit", Game(L"Hit", L"co"), kNow));
+  CHECK(cache.Store(L"Miss", std::nullopt, kNow));
+  std::optional<IgdbGame> found;
+  const int64_t after_miss = kNow + IgdbCache::kMissTtlSeconds;
+  CHECK(cache.Find(L"Hit", found, after_miss));
+  CHECK(!cache.Find(L"Miss", found, after_miss));
+
+  cache.Close();
+  CHECK(cache.Open(path, after_miss));
+  CHECK_EQ(cache.size(), size_t{1});
+  CHECK(!cache.Find(L"Hit", found, kNow + IgdbCache::kHitTtlSeconds));
+}
+
+TEST(TruncatesTornTail) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "igdb.bin").wstring();
+  {
+    IgdbCache cache;
+    CHECK(cache.Open(path, kNow));
+    CHECK(cache.Store(L"Alpha", Game(L"Alpha", L"co1"), kNow));
+  }
+  const auto intact = std::filesystem::file_size(path);
+  {
+    std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::app);
+    out.write("\x40\x00\x00\x00partial", 11);
+  }
+  IgdbCache cache;
+  CHECK(cache.Open(path, kNow));
+  CHECK_EQ(std::filesystem::file_size(path), intact);
+  CHECK(cache.Store(L"Beta", std::nullopt, kNow));
+  cache.Close();
+  CHECK(cache.Open(path, kNow));
+  CHECK_EQ(cache.size(), size_t{2});
+}
+
+TEST(CompactsWhileRunning) {
+  TempDir dir;
+  const std::wstring path = (dir.path() / "igdb.bin").wstring();
+  IgdbCache cache;
+  CHECK(cache.Open(path, kNow));
+  CHECK(cache.Store(L"Alpha", Game(L"Alpha", L"co1"), kNow));
+  const auto single = std::filesystem::file_size(path);
+  // Re-storing one name supersedes a record each time; the log is rewritten
+  // once the dead records pile up, without a reopen.
+  for (int i = 0; i < 3000; ++i) {
+    CHECK(cache.Store(L"Alpha", Game(L"Alpha", L"co" + std::to_wstring(i % 10)), kNow));
+  }
+  CHECK(cache.deadRecords() < 2048);
+  CHECK(std::filesystem::file_size(path) < single * 2100);
+  std::optional<IgdbGame> found;
+  CHECK(cache.Find(L"Alpha", found, kNow) && found && found->imageId == L"co9");
+
+  cache.Close();
+  CHECK(cache.Open(path, kNow));
+  CHECK_EQ(cache.size(), size_t{1});
+  CHECK(cache.Find(L"Alpha", found, kNow) && found && found->imageId == L"co9");
+}
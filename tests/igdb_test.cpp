@@ -0,0 +1,104 @@
+#include "igdb.h"
+
+#include <string>
+#include <vector>
+
+#include "igdb_cache.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+// Returns `body` for every request and keeps the request bodies.
+class FakeIgdb : public IHttpClient {
+ public:
+  std::string body;
+  int status = 200;
+  std::vector<std::string> requests;
+
+  bool Send(const HttpRequest& request, HttpResponse& response_out) override {
+    requests.push_back(request.body);
+    response_out = HttpResponse{};
+    response_out.status = status;
+    response_out.body = body;
+    return true;
+  }
+};
+
+}  // namespace
+
+TEST(BuildsOneNamedQueryPerTitle) {
+  const std::string body = IGDB::BuildMultiquery({L"Alpha", L"Say \"Hi\""}, 0, 2);
+  CHECK(body.find("query games \"0\"") != std::string::npos);
+  CHECK(body.find("search \"Alpha\"") != std::string::npos);
+  CHECK(body.find("query games \"1\"") != std::string::npos);
+  CHECK(body.find("search \"Say \\\"Hi\\\"\"") != std::string::npos);
+}
+
+TEST(ParseMarksAnsweredQueries) {
+  const std::string body =
+      R"([{"name":"0","result":[{"name":"Alpha","cover":{"image_id":"co1"}}]},)"
+      R"({"name":"2","result":[]}])";
+  std::vector<std::optional<IgdbGame>> results(3);
+  std::vector<uint8_t> answered;
+  CHECK(IGDB::ParseMultiquery(body, results, &answered));
+  CHECK(results[0] && results[0]->name == L"Alpha" && results[0]->imageId == L"co1");
+  CHECK(!results[1]);
+  CHECK(!results[2]);
+  CHECK_EQ(answered, (std::vector<uint8_t>{1, 0, 1}));
+  CHECK(!IGDB::ParseMultiquery("not json", results, &answered));
+}
+
+TEST(CachesOnlyAnsweredQueries) {
+  TempDir dir;
+  IgdbCache cache;
+  CHECK(cache.Open((dir.path() / "igdb.bin").wstring()));
+  FakeIgdb http;
+  // Query 1 is missing from the response, e.g. dropped by the server.
+  http.body =
+      R"([{"name":"0","result":[{"name":"Alpha","cover":{"image_id":"co1"}}]},)"
+      R"({"name":"2","result":[]}])";
+  const std::vector<std::wstring> names = {L"Alpha", L"Beta", L"Gamma"};
+  const auto results = IGDB::SearchMany(http, L"id", L"token", names, &cache);
+  CHECK(results[0] && results[0]->name == L"Alpha");
+  CHECK(!results[1]);
+  CHECK(!results[2]);
+
+  std::optional<IgdbGame> found;
+  CHECK(cache.Find(L"Alpha", found) && found && found->imageId == L"co1");
+  CHECK(cache.Find(L"Gamma", found) && !found);  // answered, no match: negative
+  CHECK(!cache.Find(L"Beta", found));             // unanswered: asked again next time
+
+  http.body = R"([{"name":"0","result":[{"name":"Beta"}]}])";
+  const auto retry = IGDB::SearchMany(http, L"id", L"token", names, &cache);
+  CHECK_EQ(http.requests.size(), size_t{2});
+  CHECK(http.requests.back().find("Beta") != std::string::npos);
+  CHECK(http.requests.back().find("Alpha") == std::string::npos);
+  CHECK(retry[1] && retry[1]->name == L"Beta");
+}
+
+TEST(FailedRequestsCacheNothing) {
+  TempDir dir;
+  IgdbCache cache;
+  CHECK(cache.Open((dir.path() / "igdb.bin").wstring()));
+  FakeIgdb http;
+  http.status = 500;
+  http.body = "[]";
+  const auto results = IGDB::SearchMany(http, L"id", L"token", {L"Alpha"}, &cache);
+  CHECK(!results[0]);
+  std::optional<IgdbGame> found;
+  CHECK(!cache.Find(L"Alpha", found));
+}
+
+TEST(BatchesAtTheMultiqueryLimit) {
+  FakeIgdb http;
+  http.body = "[]";
+  std::vector<std::wstring> names;
+  for (int i = 0; i < 25; ++i) {
+    names.push_back(L"Game " + std::to_wstring(i));
+  }
+  IGDB::SearchMany(http, L"id", L"token", names);
+  CHECK_EQ(http.requests.size(), size_t{3});
+}
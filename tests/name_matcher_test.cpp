@@ -0,0 +1,68 @@
+#include "name_matcher.h"
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr std::wstring_view kPrefixes[] = {L"unins", L"setup", L"vc_redist"};
+constexpr std::wstring_view kStores[] = {L"steam", L"epic", L"xbox"};
+
+constexpr auto kPrefixMatcher = BuildMatcher<64>(kPrefixes);
+constexpr auto kStoreMatcher = BuildMatcher<32>(kStores);
+
+// Built at compile time, so the tables really are constant data.
+static_assert(kPrefixMatcher.ok() && kStoreMatcher.ok());
+static_assert(kPrefixMatcher.MatchesPrefix(L"Unins000.exe"));
+static_assert(!kPrefixMatcher.MatchesPrefix(L"game_setup.exe"));
+static_assert(kStoreMatcher.FindFirst(L"C:\\Epic\\Steam") == 0);
+
+}  // namespace
+
+TEST(MatchesPrefixesCaseInsensitively) {
+  CHECK(kPrefixMatcher.MatchesPrefix(L"unins000.exe"));
+  CHECK(kPrefixMatcher.MatchesPrefix(L"SETUP.EXE"));
+  CHECK(kPrefixMatcher.MatchesPrefix(L"VC_Redist.x64.exe"));
+  CHECK(kPrefixMatcher.MatchesPrefix(L"setup"));
+  CHECK(!kPrefixMatcher.MatchesPrefix(L"setu"));
+  CHECK(!kPrefixMatcher.MatchesPrefix(L"mysetup.exe"));
+  CHECK(!kPrefixMatcher.MatchesPrefix(L""));
+}
+
+TEST(ContainsUsesFailureLinks) {
+  constexpr std::wstring_view kPatterns[] = {L"crashhandler", L"handle"};
+  constexpr auto matcher = BuildMatcher<64>(kPatterns);
+  // "crashhandl" leaves the trie deep in the first pattern; the failure link
+  // must still find "handle" starting inside it.
+  CHECK(matcher.Contains(L"crashhandle.exe"));
+  CHECK(matcher.Contains(L"UnityCrashHandler64.exe"));
+  CHECK(!matcher.Contains(L"crashhandl.exe"));
+}
+
+TEST(FindFirstReportsLowestPatternId) {
+  CHECK_EQ(kStoreMatcher.FindFirst(L"D:\\XboxGames\\Epic Games\\Steam"), uint8_t{0});
+  CHECK_EQ(kStoreMatcher.FindFirst(L"D:\\XboxGames\\Epic Games"), uint8_t{1});
+  CHECK_EQ(kStoreMatcher.FindFirst(L"D:\\XboxGames"), uint8_t{2});
+  CHECK_EQ(kStoreMatcher.FindFirst(L"D:\\Games"), kNoMatch);
+}
+
+TEST(CharactersOutsideTheAlphabetBreakMatches) {
+  CHECK_EQ(MatcherSymbol(L'\u00E9'), kNoSymbol);
+  CHECK_EQ(MatcherSymbol(L'\\'), kNoSymbol);
+  CHECK(!kStoreMatcher.Contains(L"st\u00E9am"));
+  CHECK(kStoreMatcher.Contains(L"\u30B2\u30FC\u30E0 steam"));  // non-ASCII elsewhere is fine
+
+  PatternMatcher<16> matcher;
+  CHECK(!matcher.Add(L"caf\u00E9", 0));
+  matcher.Build();
+  CHECK(!matcher.ok());
+}
+
+TEST(RejectsPatternsBeyondCapacity) {
+  PatternMatcher<4> matcher;
+  CHECK(matcher.Add(L"abc", 0));
+  CHECK(!matcher.Add(L"xyz", 1));
+  matcher.Build();
+  CHECK(!matcher.ok());
+}
@@ -0,0 +1,71 @@
+#include "path_key.h"
+
+#include <filesystem>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+const std::wstring kSep(1, std::filesystem::path::preferred_separator);
+
+}  // namespace
+
+TEST(JoinedHashMatchesHashOfJoinedPath) {
+  const std::wstring directory = L"C:" + kSep + L"Games" + kSep + L"Alpha";
+  CHECK_EQ(HashJoinedPath(directory, L"alpha.exe"), HashPath(directory + kSep + L"alpha.exe"));
+  CHECK_EQ(HashJoinedPath(directory + kSep, L"alpha.exe"), HashPath(directory + kSep + L"alpha.exe"));
+  CHECK_EQ(HashJoinedPath(HashPath(directory), directory, L"ALPHA.EXE"), HashPath(directory + kSep + L"alpha.exe"));
+  CHECK_EQ(HashJoinedPath(directory, L""), HashPath(directory));
+  CHECK_EQ(HashPath(L"C:\\GAMES"), HashPath(L"c:\\games"));
+}
+
+TEST(SetIgnoresCaseAndAcceptsBothForms) {
+  PathKeySet set;
+  const std::wstring directory = L"D:" + kSep + L"Library";
+  CHECK(set.Insert(directory + kSep + L"Game.exe"));
+  CHECK(!set.Insert(directory + kSep + L"GAME.EXE"));
+  CHECK(!set.Insert(HashJoinedPath(directory, L"game.exe"), directory, L"game.exe"));
+  CHECK(set.Insert(HashJoinedPath(directory, L"other.exe"), directory, L"other.exe"));
+  CHECK(set.Contains(directory + kSep + L"OTHER.exe"));
+  CHECK(!set.Contains(directory + kSep + L"third.exe"));
+  CHECK_EQ(set.size(), size_t{2});
+}
+
+TEST(SetResolvesHashCollisionsExactly) {
+  PathKeySet set;
+  // Same hash on purpose: entries are told apart by their text.
+  CHECK(set.Insert(42, L"a", L"x.exe"));
+  CHECK(set.Insert(42, L"b", L"x.exe"));
+  CHECK(set.Insert(42, L"a", L"xx.exe"));
+  CHECK(!set.Insert(42, L"A", L"X.EXE"));
+  CHECK_EQ(set.size(), size_t{3});
+}
+
+TEST(SetGrowsPastItsInitialCapacity) {
+  PathKeySet set(4);
+  for (int i = 0; i < 5000; ++i) {
+    CHECK(set.Insert(L"dir" + kSep + L"file" + std::to_wstring(i) + L".exe"));
+  }
+  CHECK_EQ(set.size(), size_t{5000});
+  for (int i = 0; i < 5000; i += 499) {
+    CHECK(set.Contains(L"DIR" + kSep + L"FILE" + std::to_wstring(i) + L".EXE"));
+  }
+  CHECK(!set.Insert(L"dir" + kSep + L"file4999.exe"));
+}
+
+TEST(TableInternsSharedComponents) {
+  PathTable table;
+  const std::wstring root = kSep + L"games" + kSep + L"steam";
+  const PathId a = table.Intern(root + kSep + L"A" + kSep + L"a.exe");
+  const PathId b = table.Intern(root + kSep + L"B" + kSep + L"b.exe");
+  CHECK(a != kEmptyPath && b != kEmptyPath && a != b);
+  CHECK_EQ(table.Intern(root + kSep + L"A" + kSep + L"a.exe"), a);
+  CHECK(table.Resolve(a) == root + kSep + L"A" + kSep + L"a.exe");
+  CHECK(table.Leaf(a) == L"a.exe");
+  CHECK(table.Leaf(table.Parent(a)) == L"A");
+  CHECK_EQ(table.Parent(table.Parent(a)), table.Parent(table.Parent(b)));
+  CHECK(table.Intern(root + kSep + L"a" + kSep + L"a.exe") != a);  // ids are case-sensitive
+  CHECK_EQ(table.Intern(L""), kEmptyPath);
+}
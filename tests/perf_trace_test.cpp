@@ -0,0 +1,109 @@
+#include "perf_trace.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+nlohmann::json Events(const PerfTrace& trace) {
+  return nlohmann::json::parse(trace.ChromeTraceJson())["traceEvents"];
+}
+
+size_t CountNamed(const nlohmann::json& events, const std::string& name) {
+  size_t count = 0;
+  for (const auto& event : events) {
+    count += event["name"] == name ? 1 : 0;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(DisabledTraceRecordsNothing) {
+  PerfTrace trace;
+  CHECK(!trace.enabled());
+  { PerfScope scope("Paint", trace); }
+  trace.Add(PerfCounter::kDrawCalls, 5);
+  trace.BeginFrame();
+  trace.EndFrame();
+  CHECK_EQ(trace.Frames().frames, uint64_t{0});
+  CHECK(Events(trace).empty());
+}
+
+TEST(FramesCarryTheirCounters) {
+  PerfTrace trace;
+  trace.SetEnabled(true);
+  trace.BeginFrame();
+  { PerfScope scope("Paint", trace); }
+  trace.Add(PerfCounter::kDrawCalls, 3);
+  trace.Add(PerfCounter::kDrawCalls, 2);
+  trace.Add(PerfCounter::kTilesRedrawn, 7);
+  trace.EndFrame();
+  trace.BeginFrame();
+  trace.Add(PerfCounter::kBytesBlitted, 64);
+  trace.EndFrame();
+
+  const FrameStats stats = trace.Frames();
+  CHECK_EQ(stats.frames, uint64_t{2});
+  CHECK_EQ(stats.counters[static_cast<size_t>(PerfCounter::kDrawCalls)], uint64_t{0});
+  CHECK_EQ(stats.counters[static_cast<size_t>(PerfCounter::kBytesBlitted)], uint64_t{64});
+  CHECK(stats.p50Ms <= stats.p99Ms);
+
+  const nlohmann::json events = Events(trace);
+  CHECK_EQ(events.size(), size_t{3});
+  CHECK_EQ(events[0]["name"], "Paint");
+  CHECK_EQ(events[0]["ph"], "X");
+  CHECK(!events[0].contains("args"));
+  CHECK_EQ(events[1]["name"], "Frame");
+  CHECK_EQ(events[1]["args"]["drawCalls"], 5);
+  CHECK_EQ(events[1]["args"]["tilesRedrawn"], 7);
+  CHECK_EQ(events[2]["args"]["bytesBlitted"], 64);
+  // The paint scope nests inside its frame.
+  CHECK(events[0]["ts"].get<double>() >= events[1]["ts"].get<double>());
+}
+
+TEST(RingKeepsTheNewestEvents) {
+  PerfTrace trace;
+  trace.SetEnabled(true);
+  trace.Record("Old", 0, 1);
+  for (size_t i = 0; i < PerfTrace::kEventCapacity; ++i) {
+    trace.Record("New", i, i + 1);
+  }
+  const nlohmann::json events = Events(trace);
+  CHECK_EQ(events.size(), PerfTrace::kEventCapacity);
+  CHECK_EQ(CountNamed(events, "Old"), size_t{0});
+}
+
+TEST(ThreadsRecordConcurrently) {
+  PerfTrace trace;
+  trace.SetEnabled(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&trace] {
+      for (int i = 0; i < 1000; ++i) {
+        PerfScope scope("Decode", trace);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK_EQ(CountNamed(Events(trace), "Decode"), size_t{4000});
+}
+
+TEST(NamesAreEscaped) {
+  PerfTrace trace;
+  trace.SetEnabled(true);
+  trace.Record("say \"hi\"\\\n", 1500, 2750);
+  const nlohmann::json events = Events(trace);
+  CHECK_EQ(events[0]["name"], "say \"hi\"\\\n");
+  CHECK_EQ(events[0]["ts"].get<double>(), 1.5);
+  CHECK_EQ(events[0]["dur"].get<double>(), 1.25);
+}
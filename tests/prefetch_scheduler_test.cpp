@@ -0,0 +1,162 @@
+#include "prefetch_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+// Records delivered indices and the order work was started in.
+struct Recorder {
+  std::mutex mutex;
+  std::vector<size_t> started;
+  std::set<size_t> delivered;
+
+  PrefetchScheduler::Deliver Deliver() {
+    return [this](std::vector<size_t> ready) {
+      std::lock_guard<std::mutex> lock(mutex);
+      delivered.insert(ready.begin(), ready.end());
+    };
+  }
+  void Start(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    started.push_back(index);
+  }
+};
+
+PrefetchOptions SingleWorker() {
+  PrefetchOptions options;
+  options.workerCount = 1;
+  options.batchSize = 4;
+  return options;
+}
+
+}  // namespace
+
+TEST(VisibleRangeLoadsFirstThenAhead) {
+  Recorder recorder;
+  PrefetchScheduler scheduler(recorder.Deliver(), SingleWorker());
+  scheduler.SetViewport(20, 30);
+  scheduler.Reset(100, [&](size_t index) {
+    recorder.Start(index);
+    return true;
+  });
+  scheduler.Wait();
+  CHECK(recorder.started.size() >= 10);
+  for (size_t i = 0; i < 10; ++i) {
+    CHECK(recorder.started[i] >= 20 && recorder.started[i] < 30);
+  }
+  // One screen ahead, half a screen behind; nothing beyond without
+  // background prefetch.
+  CHECK_EQ(recorder.started.size(), size_t{25});
+  CHECK(std::all_of(recorder.started.begin(), recorder.started.end(), [](size_t i) { return i >= 15 && i < 40; }));
+  CHECK_EQ(recorder.delivered.size(), size_t{25});
+}
+
+TEST(ScrollingMovesTheWindow) {
+  Recorder recorder;
+  PrefetchScheduler scheduler(recorder.Deliver(), SingleWorker());
+  scheduler.SetViewport(0, 10);
+  scheduler.Reset(200, [&](size_t index) {
+    recorder.Start(index);
+    return true;
+  });
+  scheduler.Wait();
+  // Scroll down a screen at a time, as the wheel handler does.
+  for (size_t first = 10; first <= 100; first += 10) {
+    scheduler.SetViewport(first, first + 10, 40.0);
+    scheduler.Wait();
+    for (size_t i = first; i < first + 10; ++i) {
+      CHECK(recorder.delivered.count(i));
+    }
+  }
+  CHECK(!scheduler.IsWanted(0));
+  CHECK(scheduler.IsWanted(105));
+  // Each item is fetched once while it stays loaded.
+  std::vector<size_t> sorted = recorder.started;
+  std::sort(sorted.begin(), sorted.end());
+  CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+}
+
+TEST(ResetDoesNotWaitForRunningWork) {
+  Recorder recorder;
+  PrefetchScheduler scheduler(recorder.Deliver(), SingleWorker());
+  std::promise<void> release;
+  std::shared_future<void> gate = release.get_future().share();
+  std::atomic<bool> blocked{false};
+  scheduler.SetViewport(0, 4);
+  scheduler.Reset(10, [&](size_t) {
+    blocked = true;
+    gate.wait();
+    return true;
+  });
+  while (!blocked) {
+    std::this_thread::yield();
+  }
+  // Would deadlock if Reset waited for the blocked item.
+  const auto start = std::chrono::steady_clock::now();
+  scheduler.Reset(10, [&](size_t index) {
+    recorder.Start(index);
+    return true;
+  });
+  CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+  release.set_value();
+  scheduler.Wait();
+  // The stale result was dropped; the new work covered the window.
+  for (size_t i = 0; i < 4; ++i) {
+    CHECK(recorder.delivered.count(i));
+  }
+  CHECK_EQ(recorder.started.size(), size_t{8});  // the window and one screen ahead
+}
+
+TEST(UnwantedWorkIsCancelledAndRetried) {
+  Recorder recorder;
+  PrefetchScheduler scheduler(recorder.Deliver(), SingleWorker());
+  scheduler.SetViewport(0, 10);
+  std::atomic<bool> scrolled{false};
+  scheduler.Reset(200, [&](size_t index) {
+    if (index == 0 && !scrolled.exchange(true)) {
+      scheduler.SetViewport(100, 110);  // the user scrolls away mid-decode
+    }
+    if (!scheduler.IsWanted(index)) {
+      return false;
+    }
+    recorder.Start(index);
+    return true;
+  });
+  scheduler.Wait();
+  CHECK(scheduler.Stats().cancelled >= 1);
+  CHECK(!recorder.delivered.count(0));
+  for (size_t i = 100; i < 110; ++i) {
+    CHECK(recorder.delivered.count(i));
+  }
+  scheduler.SetViewport(0, 10);
+  scheduler.Wait();
+  CHECK(recorder.delivered.count(0));
+}
+
+TEST(RequeueRefetchesFinishedItems) {
+  Recorder recorder;
+  PrefetchScheduler scheduler(recorder.Deliver(), SingleWorker());
+  scheduler.SetViewport(0, 4);
+  scheduler.Reset(8, [&](size_t index) {
+    recorder.Start(index);
+    return index != 3;  // no cover
+  });
+  scheduler.Wait();
+  const size_t first_pass = recorder.started.size();
+  // 1 and 2 were evicted; 3 failed and 50 is out of range, so neither counts.
+  CHECK_EQ(scheduler.Requeue({1, 2, 3, 50}), size_t{2});
+  scheduler.Wait();
+  CHECK_EQ(recorder.started.size(), first_pass + 2);
+  CHECK_EQ(scheduler.Requeue({}), size_t{0});
+}
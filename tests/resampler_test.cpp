@@ -0,0 +1,88 @@
+#include "resampler.h"
+
+#include <cstdlib>
+#include <random>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+CoverImage Noise(int width, int height, unsigned seed) {
+  std::mt19937 random(seed);
+  CoverImage image;
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < image.pixels.size(); i += 4) {
+    const uint8_t alpha = static_cast<uint8_t>(random());
+    for (size_t c = 0; c < 3; ++c) {
+      image.pixels[i + c] = static_cast<uint8_t>(random() % (alpha + 1u));  // premultiplied
+    }
+    image.pixels[i + 3] = alpha;
+  }
+  return image;
+}
+
+int MaxDifference(const CoverImage& a, const CoverImage& b) {
+  if (a.width != b.width || a.height != b.height || a.pixels.size() != b.pixels.size()) {
+    return 256;
+  }
+  int worst = 0;
+  for (size_t i = 0; i < a.pixels.size(); ++i) {
+    worst = std::max(worst, std::abs(static_cast<int>(a.pixels[i]) - static_cast<int>(b.pixels[i])));
+  }
+  return worst;
+}
+
+}  // namespace
+
+TEST(SimdKernelsMatchScalar) {
+  const CoverImage source = Noise(123, 187, 1);
+  const ResampleFilter filters[] = {ResampleFilter::kBox, ResampleFilter::kBilinear, ResampleFilter::kLanczos3};
+  const std::pair<int, int> sizes[] = {{200, 300}, {100, 150}, {37, 51}, {240, 360}};
+  for (ResampleFilter filter : filters) {
+    for (const auto& [width, height] : sizes) {
+      CoverImage scalar;
+      CHECK(Resampler::Resize(source, width, height, filter, ResampleKernel::kScalar, scalar));
+      for (ResampleKernel kernel : {ResampleKernel::kSse2, ResampleKernel::kAvx2}) {
+        CoverImage simd;
+        CHECK(Resampler::Resize(source, width, height, filter, kernel, simd));
+        CHECK_EQ(MaxDifference(scalar, simd), 0);
+      }
+    }
+  }
+}
+
+TEST(SolidColorsStaySolid) {
+  CoverImage source;
+  source.width = 64;
+  source.height = 64;
+  source.pixels.assign(64 * 64 * 4, 0);
+  for (size_t i = 0; i < source.pixels.size(); i += 4) {
+    source.pixels[i] = 40;
+    source.pixels[i + 1] = 80;
+    source.pixels[i + 2] = 120;
+    source.pixels[i + 3] = 255;
+  }
+  for (ResampleFilter filter : {ResampleFilter::kBox, ResampleFilter::kBilinear, ResampleFilter::kLanczos3}) {
+    CoverImage out;
+    CHECK(Resampler::Resize(source, 25, 90, filter, out));
+    bool solid = out.width == 25 && out.height == 90;
+    for (size_t i = 0; solid && i < out.pixels.size(); i += 4) {
+      solid = std::abs(out.pixels[i] - 40) <= 1 && std::abs(out.pixels[i + 1] - 80) <= 1 &&
+              std::abs(out.pixels[i + 2] - 120) <= 1 && out.pixels[i + 3] == 255;
+    }
+    CHECK(solid);
+  }
+}
+
+TEST(RejectsEmptyInputAndSizes) {
+  CoverImage out;
+  CHECK(!Resampler::Resize(CoverImage{}, 10, 10, ResampleFilter::kBox, out));
+  CHECK(!Resampler::Resize(Noise(4, 4, 2), 0, 10, ResampleFilter::kBox, out));
+  const auto scaled = Resampler::ResizeForScales(Noise(50, 75, 3), 20, 30, {1.0f, 1.5f, 2.0f});
+  CHECK_EQ(scaled.size(), size_t{3});
+  CHECK(scaled.size() == 3 && scaled[1].width == 30 && scaled[1].height == 45 && scaled[2].width == 40);
+}
@@ -0,0 +1,140 @@
+#include "scan_snapshot.h"
+
+#include <chrono>
+#include <cwctype>
+
+#include "scanner.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+bool SameGames(const std::vector<GameEntry>& a, const std::vector<GameEntry>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].exe != b[i].exe || a[i].folder != b[i].folder) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Backdates every directory so later edits get a distinct mtime even on
+// filesystems with coarse timestamps.
+void AgeTree(const std::filesystem::path& root) {
+  const auto old = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+  std::filesystem::last_write_time(root, old);
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+    if (entry.is_directory()) {
+      std::filesystem::last_write_time(entry.path(), old);
+    }
+  }
+}
+
+std::vector<GameEntry> Scan(const TempDir& dir, ScanSnapshot* snapshot) {
+  ScanOptions options;
+  options.snapshot = snapshot;
+  return Scanner::ScanAll({(dir.path() / "library").wstring()}, options);
+}
+
+}  // namespace
+
+TEST(RescanAfterEditsMatchesFullScan) {
+  TempDir dir;
+  dir.Write("library/Alpha/alpha.exe");
+  dir.Write("library/Beta/bin/beta.exe");
+  dir.Write("library/Gamma/gamma.exe");
+  dir.Write("library/Delta/delta.exe");
+  AgeTree(dir.path() / "library");
+
+  ScanSnapshot snapshot;
+  CHECK_EQ(Scan(dir, &snapshot).size(), size_t{4});
+  CHECK(snapshot.size() > 0);
+
+  dir.Write("library/Alpha/alpha_dx12.exe");     // new exe in a known directory
+  dir.Write("library/Epsilon/epsilon.exe");      // new game
+  dir.Write("library/Beta/bin/x64/beta64.exe");  // new subdirectory two levels down
+  std::filesystem::remove_all(dir.path() / "library/Gamma");
+  std::filesystem::rename(dir.path() / "library/Delta", dir.path() / "library/Delta Remastered");
+
+  const auto incremental = Scan(dir, &snapshot);
+  const auto full = Scan(dir, nullptr);
+  CHECK(SameGames(incremental, full));
+  CHECK_EQ(full.size(), size_t{6});
+
+  // Nothing changed since: a second pass over the fresh snapshot agrees too.
+  CHECK(SameGames(Scan(dir, &snapshot), full));
+}
+
+TEST(UnchangedDirectoriesComeFromTheSnapshot) {
+  TempDir dir;
+  dir.Write("library/Alpha/alpha.exe");
+  AgeTree(dir.path() / "library");
+  ScanSnapshot snapshot;
+  CHECK_EQ(Scan(dir, &snapshot).size(), size_t{1});
+
+  // Hide an edit from the scanner by restoring the directory mtime: the
+  // listing must be reused rather than read again.
+  const auto alpha = dir.path() / "library/Alpha";
+  const auto mtime = std::filesystem::last_write_time(alpha);
+  dir.Write("library/Alpha/hidden.exe");
+  std::filesystem::last_write_time(alpha, mtime);
+  CHECK_EQ(Scan(dir, &snapshot).size(), size_t{1});
+  CHECK_EQ(Scan(dir, nullptr).size(), size_t{2});
+}
+
+TEST(SnapshotSurvivesSaveAndLoad) {
+  TempDir dir;
+  dir.Write("library/Alpha/alpha.exe");
+  dir.Write("library/Beta Game/beta.exe");
+  AgeTree(dir.path() / "library");
+  ScanSnapshot snapshot;
+  const auto first = Scan(dir, &snapshot);
+
+  const std::wstring path = (dir.path() / "snapshot.txt").wstring();
+  CHECK(snapshot.Save(path));
+  ScanSnapshot loaded;
+  CHECK(loaded.Load(path));
+  CHECK_EQ(loaded.size(), snapshot.size());
+  const std::wstring key = (dir.path() / "library" / "Beta Game").wstring();
+  std::wstring lowered = key;
+  for (auto& ch : lowered) {
+    ch = static_cast<wchar_t>(std::towlower(ch));
+  }
+  const DirectorySnapshot* beta = loaded.Find(lowered);
+  CHECK(beta != nullptr && beta->executables.size() == 1 && beta->executables[0] == L"beta.exe");
+  CHECK(SameGames(Scan(dir, &loaded), first));
+}
+
+TEST(SaveReplacesTheOldSnapshotAtomically) {
+  TempDir dir;
+  dir.Write("library/Alpha/alpha.exe");
+  AgeTree(dir.path() / "library");
+  ScanSnapshot snapshot;
+  Scan(dir, &snapshot);
+  const std::wstring path = (dir.path() / "snapshot.txt").wstring();
+  dir.Write("snapshot.txt", "OSMSNAP 2\nD\t1\tstale\n");
+  CHECK(snapshot.Save(path));
+  CHECK(!std::filesystem::exists(path + L".tmp"));
+  ScanSnapshot loaded;
+  CHECK(loaded.Load(path));
+  CHECK_EQ(loaded.size(), snapshot.size());
+  CHECK(loaded.Find(L"stale") == nullptr);
+
+  // A failed write leaves the previous file in place.
+  const std::wstring missing = (dir.path() / "no_such_dir" / "snapshot.txt").wstring();
+  CHECK(!snapshot.Save(missing));
+  CHECK(!std::filesystem::exists(missing));
+}
+
+TEST(OlderFormatsAreIgnored) {
+  TempDir dir;
+  const auto path = dir.Write("snapshot.txt", "OSMSNAP 1\nD\t1\t0\tkey\n");
+  ScanSnapshot loaded;
+  CHECK(!loaded.Load(path.wstring()));
+  CHECK_EQ(loaded.size(), size_t{0});
+}
@@ -0,0 +1,122 @@
+#include "scanner.h"
+
+#include "path_key.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+void WriteLibrary(const TempDir& dir) {
+  dir.Write("library/Alpha/alpha.exe");
+  dir.Write("library/Alpha/bin/unins000.exe");
+  dir.Write("library/Alpha/bin/AlphaCrashReporter.exe");
+  dir.Write("library/Beta_Game/Beta.EXE");
+  dir.Write("library/Beta_Game/readme.txt");
+  dir.Write("library/Gamma/a/b/c/gamma.exe");
+  dir.Write("library/Gamma/a/b/c/d/too_deep.exe");
+  for (int i = 0; i < 20; ++i) {
+    dir.Write("library/Many/dir" + std::to_string(i) + "/tool" + std::to_string(i) + ".exe");
+  }
+  dir.Write("other/Delta/delta.exe");
+}
+
+std::vector<std::wstring> Roots(const TempDir& dir) {
+  return {(dir.path() / "library").wstring(), (dir.path() / "other").wstring()};
+}
+
+bool SameGames(const std::vector<GameEntry>& a, const std::vector<GameEntry>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].exe != b[i].exe || a[i].folder != b[i].folder ||
+        a[i].source != b[i].source || a[i].coverKey != b[i].coverKey) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const GameEntry* FindByExeName(const std::vector<GameEntry>& games, const std::wstring& file_name) {
+  for (const auto& game : games) {
+    if (std::filesystem::path(game.exe).filename() == file_name) {
+      return &game;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(ParallelScanMatchesSingleWorker) {
+  TempDir dir;
+  WriteLibrary(dir);
+  ScanOptions serial;
+  serial.workerCount = 1;
+  serial.maxConcurrencyPerRoot = 1;
+  const auto expected = Scanner::ScanAll(Roots(dir), serial);
+
+  ScanOptions parallel;
+  parallel.workerCount = 4;
+  parallel.maxConcurrencyPerRoot = 0;
+  CHECK(SameGames(Scanner::ScanAll(Roots(dir), parallel), expected));
+  parallel.maxConcurrencyPerRoot = 2;
+  CHECK(SameGames(Scanner::ScanAll(Roots(dir), parallel), expected));
+}
+
+TEST(ScanAppliesSkipListsDepthAndNames) {
+  TempDir dir;
+  WriteLibrary(dir);
+  const auto games = Scanner::ScanAll(Roots(dir));
+  CHECK_EQ(games.size(), size_t{24});
+  CHECK(FindByExeName(games, L"unins000.exe") == nullptr);
+  CHECK(FindByExeName(games, L"AlphaCrashReporter.exe") == nullptr);
+  CHECK(FindByExeName(games, L"too_deep.exe") == nullptr);
+
+  const GameEntry* beta = FindByExeName(games, L"Beta.EXE");
+  CHECK(beta != nullptr);
+  if (beta) {
+    CHECK(beta->name == L"Beta Game");
+    CHECK(beta->folder == (dir.path() / "library" / "Beta_Game").wstring());
+    CHECK_EQ(beta->coverKey, HashPath(beta->exe));
+  }
+  const GameEntry* gamma = FindByExeName(games, L"gamma.exe");
+  CHECK(gamma != nullptr && gamma->name == L"Gamma");
+}
+
+TEST(OverlappingRootsKeepEachExeOnce) {
+  TempDir dir;
+  WriteLibrary(dir);
+  // The nested root reaches Alpha again; the earlier root keeps it.
+  const auto games = Scanner::ScanAll({(dir.path() / "library").wstring(), (dir.path() / "library/Alpha").wstring()});
+  size_t alpha_count = 0;
+  for (const auto& game : games) {
+    alpha_count += std::filesystem::path(game.exe).filename() == L"alpha.exe" ? 1 : 0;
+  }
+  CHECK_EQ(alpha_count, size_t{1});
+  const GameEntry* alpha = FindByExeName(games, L"alpha.exe");
+  CHECK(alpha != nullptr && alpha->name == L"Alpha");
+}
+
+TEST(UserSkipPatternsExtendTheBuiltInLists) {
+  TempDir dir;
+  WriteLibrary(dir);
+  ScanOptions options;
+  options.extraSkipPatterns = {L"tool1*", L"ELTA", L"badé*"};
+  const auto games = Scanner::ScanAll(Roots(dir), options);
+  CHECK(FindByExeName(games, L"tool1.exe") == nullptr);
+  CHECK(FindByExeName(games, L"tool12.exe") == nullptr);
+  CHECK(FindByExeName(games, L"tool2.exe") != nullptr);
+  CHECK(FindByExeName(games, L"delta.exe") == nullptr);  // substrings ignore case
+  CHECK(FindByExeName(games, L"alpha.exe") != nullptr);
+  CHECK(FindByExeName(games, L"unins000.exe") == nullptr);
+}
+
+TEST(SplitsPatternLists) {
+  CHECK_EQ(Scanner::SplitPatterns(L" launcher* ; benchmark;;\t"),
+           (std::vector<std::wstring>{L"launcher*", L"benchmark"}));
+  CHECK(Scanner::SplitPatterns(L"").empty());
+  CHECK_EQ(Scanner::SplitPatterns(L"one"), (std::vector<std::wstring>{L"one"}));
+}
@@ -0,0 +1,169 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+const std::wstring kSep(1, std::filesystem::path::preferred_separator);
+
+GameEntry Game(const std::wstring& name, const std::wstring& exe_stem = {}, const std::wstring& source = L"steam") {
+  GameEntry game;
+  game.name = name;
+  game.folder = L"C:" + kSep + L"Games" + kSep + name;
+  game.exe = game.folder + kSep + (exe_stem.empty() ? name : exe_stem) + L".exe";
+  game.source = source;
+  return game;
+}
+
+// A catalog plus an index kept in step with it.
+struct Library {
+  GameCatalog catalog;
+  SearchIndex index{catalog};
+  std::vector<GameId> ids;
+
+  explicit Library(const std::vector<GameEntry>& games) {
+    ids = catalog.Sync(games).added;
+    index.Apply({ids, {}, {}});
+  }
+
+  std::vector<std::wstring> Names(std::wstring_view query, const GameFilter& filter = {},
+                                  size_t limit = SIZE_MAX) const {
+    std::vector<std::wstring> names;
+    for (GameId id : index.Search(query, filter, limit)) {
+      names.emplace_back(catalog.Name(id));
+    }
+    return names;
+  }
+};
+
+bool Has(const std::vector<std::wstring>& names, const std::wstring& name) {
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+}  // namespace
+
+TEST(PrefixMatchesRankFirst) {
+  const Library library({Game(L"Shadows of Hades"), Game(L"Hades"), Game(L"Hadesville Racing")});
+  CHECK_EQ(library.Names(L"hades"),
+           (std::vector<std::wstring>{L"Hades", L"Hadesville Racing", L"Shadows of Hades"}));
+  CHECK_EQ(library.Names(L"HADES").front(), std::wstring(L"Hades"));
+}
+
+TEST(ShortQueriesMatchWordStarts) {
+  const Library library({Game(L"Hollow Knight"), Game(L"Cyberpunk 2077"), Game(L"Shadows of Hades"),
+                         Game(L"Half-Life 2")});
+  const std::vector<std::wstring> names = library.Names(L"h");
+  CHECK_EQ(names.size(), size_t{3});
+  CHECK(!Has(names, L"Cyberpunk 2077"));
+  // Names starting with the query beat later words.
+  CHECK_EQ(names.back(), std::wstring(L"Shadows of Hades"));
+  CHECK_EQ(library.Names(L"kn"), (std::vector<std::wstring>{L"Hollow Knight"}));
+  CHECK(library.Names(L"ol").empty());  // inside a word, not a word start
+}
+
+TEST(MultiWordQueriesMatchWordPrefixes) {
+  const Library library({Game(L"The Witcher 3: Wild Hunt"), Game(L"Wild Hearts"), Game(L"Hunt: Showdown")});
+  CHECK_EQ(library.Names(L"wild hunt").front(), std::wstring(L"The Witcher 3: Wild Hunt"));
+  CHECK_EQ(library.Names(L"witcher 3"), (std::vector<std::wstring>{L"The Witcher 3: Wild Hunt"}));
+}
+
+TEST(ToleratesTypos) {
+  const Library library({Game(L"The Witcher 3: Wild Hunt"), Game(L"Hollow Knight"), Game(L"Cyberpunk 2077")});
+  CHECK_EQ(library.Names(L"witcer"), (std::vector<std::wstring>{L"The Witcher 3: Wild Hunt"}));
+  CHECK_EQ(library.Names(L"hollow knigt"), (std::vector<std::wstring>{L"Hollow Knight"}));
+  CHECK_EQ(library.Names(L"cyberpnuk"), (std::vector<std::wstring>{L"Cyberpunk 2077"}));
+  CHECK(library.Names(L"xyzzy").empty());
+  // Half the grams must still match.
+  CHECK(library.Names(L"wixxxxer").empty());
+}
+
+TEST(ExactMatchesOutrankTypoMatches) {
+  const Library library({Game(L"Portal"), Game(L"Postal")});
+  const std::vector<std::wstring> names = library.Names(L"portal");
+  CHECK(!names.empty());
+  CHECK_EQ(names.front(), std::wstring(L"Portal"));
+}
+
+TEST(MatchesFolderAndExeNames) {
+  const Library library({Game(L"Grand Theft Auto V", L"GTA5"), Game(L"Alpha")});
+  CHECK_EQ(library.Names(L"gta5"), (std::vector<std::wstring>{L"Grand Theft Auto V"}));
+}
+
+TEST(FilterLeavesOutOtherSources) {
+  const Library library({Game(L"Hades", {}, L"steam"), Game(L"Hades II", {}, L"epic")});
+  GameFilter epic_only;
+  epic_only.sources = 1 << static_cast<unsigned>(GameSource::kEpic);
+  CHECK_EQ(library.Names(L"hades", epic_only), (std::vector<std::wstring>{L"Hades II"}));
+  CHECK_EQ(library.Names(L"hades").size(), size_t{2});
+}
+
+TEST(QueriesWithoutTermsMatchNothing) {
+  const Library library({Game(L"Hades")});
+  CHECK(!SearchIndex::HasTerms(L""));
+  CHECK(!SearchIndex::HasTerms(L"  -!? "));
+  CHECK(SearchIndex::HasTerms(L" h "));
+  CHECK(library.index.Search(L"!!!").empty());
+  // Punctuation and spacing don't change a query with terms.
+  CHECK_EQ(library.Names(L"  ha-des "), library.Names(L"ha des"));
+}
+
+TEST(ApplyTracksCatalogChanges) {
+  std::vector<GameEntry> games = {Game(L"Hades"), Game(L"Portal")};
+  Library library(games);
+  games[0].name = L"Celeste";
+  games.pop_back();
+  games.push_back(Game(L"Hollow Knight"));
+  library.index.Apply(library.catalog.Sync(games));
+  CHECK(library.Names(L"portal").empty());
+  // The renamed game still lives in its Hades folder.
+  CHECK_EQ(library.Names(L"hades"), (std::vector<std::wstring>{L"Celeste"}));
+  CHECK_EQ(library.Names(L"celeste"), (std::vector<std::wstring>{L"Celeste"}));
+  CHECK_EQ(library.Names(L"hollow"), (std::vector<std::wstring>{L"Hollow Knight"}));
+  const SearchIndexStats stats = library.index.Stats();
+  CHECK_EQ(stats.documents, size_t{2});
+  CHECK_EQ(stats.deadDocuments, size_t{2});
+
+  library.index.Rebuild();
+  CHECK_EQ(library.index.Stats().deadDocuments, size_t{0});
+  CHECK_EQ(library.Names(L"celeste"), (std::vector<std::wstring>{L"Celeste"}));
+}
+
+TEST(RepeatedSearchesGiveTheSameResults) {
+  const Library library({Game(L"Hades"), Game(L"Shadows of Hades"), Game(L"Hollow Knight")});
+  const std::vector<std::wstring> first = library.Names(L"hades");
+  library.Names(L"h");
+  library.Names(L"xyzzy");
+  CHECK_EQ(library.Names(L"hades"), first);
+}
+
+TEST(LimitKeepsTheBestMatches) {
+  std::vector<GameEntry> games = {Game(L"Hades"), Game(L"Hades II"), Game(L"Shadows of Hades"),
+                                  Game(L"Hadesville Racing"), Game(L"Portal")};
+  Library library(games);
+  // "hades" has enough names starting with it for small limits; "of hades"
+  // has none and ranks a few candidates by reading their names.
+  for (const wchar_t* query : {L"hades", L"of hades", L"h"}) {
+    const std::vector<std::wstring> all = library.Names(query);
+    for (size_t limit = 0; limit <= all.size(); ++limit) {
+      CHECK_EQ(library.Names(query, {}, limit), std::vector<std::wstring>(all.begin(), all.begin() + limit));
+    }
+  }
+  CHECK_EQ(library.Names(L"of hades", {}, 1), (std::vector<std::wstring>{L"Shadows of Hades"}));
+  CHECK_EQ(library.Names(L"hades", {}, 2), (std::vector<std::wstring>{L"Hades", L"Hades II"}));
+
+  GameFilter epic_only;
+  epic_only.sources = 1 << static_cast<unsigned>(GameSource::kEpic);
+  CHECK(library.Names(L"hades", epic_only, 2).empty());
+
+  games.erase(games.begin());
+  library.index.Apply(library.catalog.Sync(games));
+  CHECK_EQ(library.Names(L"hades", {}, 2), (std::vector<std::wstring>{L"Hades II", L"Hadesville Racing"}));
+}
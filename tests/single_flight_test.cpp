@@ -0,0 +1,80 @@
+#include "single_flight.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace optiscaler;
+
+TEST(ConcurrentCallersShareOneExecution) {
+  SingleFlight<std::string, int> flight;
+  std::promise<void> release;
+  std::shared_future<void> gate = release.get_future().share();
+  std::atomic<int> runs{0};
+
+  bool leader = false;
+  std::thread first([&] {
+    flight.Do("key", [&] {
+      ++runs;
+      gate.wait();
+      return 42;
+    }, &leader);
+  });
+  while (flight.inFlight() == 0) {
+    std::this_thread::yield();
+  }
+  std::vector<SingleFlight<std::string, int>::Future> followers;
+  for (int i = 0; i < 4; ++i) {
+    bool follower_leader = true;
+    followers.push_back(flight.Do("key", [&] {
+      ++runs;
+      return -1;
+    }, &follower_leader));
+    CHECK(!follower_leader);
+  }
+  release.set_value();
+  first.join();
+  CHECK(leader);
+  for (auto& future : followers) {
+    CHECK_EQ(future.get(), 42);
+  }
+  CHECK_EQ(runs.load(), 1);
+  const SingleFlightStats stats = flight.Stats();
+  CHECK_EQ(stats.calls, uint64_t{5});
+  CHECK_EQ(stats.executions, uint64_t{1});
+  CHECK_EQ(flight.inFlight(), size_t{0});
+}
+
+TEST(DistinctKeysRunIndependently) {
+  SingleFlight<std::string, std::string> flight;
+  CHECK_EQ(flight.Run("a", [] { return std::string("A"); }), std::string("A"));
+  CHECK_EQ(flight.Run("b", [] { return std::string("B"); }), std::string("B"));
+  CHECK_EQ(flight.Stats().executions, uint64_t{2});
+}
+
+TEST(NothingIsCachedAfterCompletion) {
+  SingleFlight<int, int> flight;
+  int runs = 0;
+  CHECK_EQ(flight.Run(1, [&] { return ++runs; }), 1);
+  CHECK_EQ(flight.Run(1, [&] { return ++runs; }), 2);
+  CHECK_EQ(flight.inFlight(), size_t{0});
+}
+
+TEST(ThrowingWorkReleasesTheKey) {
+  SingleFlight<int, int> flight;
+  bool threw = false;
+  try {
+    flight.Run(7, []() -> int { throw std::runtime_error("network down"); });
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  CHECK(threw);
+  CHECK_EQ(flight.inFlight(), size_t{0});
+  CHECK_EQ(flight.Run(7, [] { return 3; }), 3);
+}
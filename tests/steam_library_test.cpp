@@ -0,0 +1,113 @@
+#include "steam_library.h"
+
+#include "keyvalues.h"
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+constexpr char kLibraryFolders[] = R"("libraryfolders"
+{
+	"0"
+	{
+		"path"		"C:\\Program Files (x86)\\Steam"
+		"label"		""
+		"apps"
+		{
+			"228980"		"392540337"
+		}
+	}
+	// second drive
+	"1"
+	{
+		"path"		"D:\\SteamLibrary"
+	}
+	"contentstatsid"		"-123"
+}
+)";
+
+constexpr char kLegacyLibraryFolders[] = R"("LibraryFolders"
+{
+	"TimeNextStatsReport"		"1600000000"
+	"1"		"E:\\Games\\Steam"
+}
+)";
+
+constexpr char kAppManifest[] = "\xEF\xBB\xBF" R"("AppState"
+{
+	"appid"		"1091500"
+	"name"		"Cyberpunk 2077"
+	"installdir"		"Cyberpunk 2077"
+	"LastPlayed"		"1700000000"
+	"SizeOnDisk"		"70000000000"
+	"UserConfig"
+	{
+		"name"		"ignored nested name"
+	}
+}
+)";
+
+}  // namespace
+
+TEST(ReaderWalksNestedObjects) {
+  KeyValuesReader reader(R"("a" { "b" "1" "c" { } } "d" "2")");
+  CHECK(reader.Next() == KeyValuesReader::Event::kBeginObject && reader.key() == "a" && reader.depth() == 1);
+  CHECK(reader.Next() == KeyValuesReader::Event::kValue && reader.key() == "b" && reader.value() == "1");
+  CHECK(reader.Next() == KeyValuesReader::Event::kBeginObject && reader.depth() == 2);
+  CHECK(reader.Next() == KeyValuesReader::Event::kEndObject && reader.depth() == 1);
+  CHECK(reader.Next() == KeyValuesReader::Event::kEndObject && reader.depth() == 0);
+  CHECK(reader.Next() == KeyValuesReader::Event::kValue && reader.key() == "d");
+  CHECK(reader.Next() == KeyValuesReader::Event::kEnd);
+
+  KeyValuesReader unbalanced(R"("a" { "b" "1")");
+  CHECK(unbalanced.Next() == KeyValuesReader::Event::kBeginObject);
+  CHECK(unbalanced.Next() == KeyValuesReader::Event::kValue);
+  CHECK(unbalanced.Next() == KeyValuesReader::Event::kError);
+}
+
+TEST(ValueHelpers) {
+  CHECK(KeyValuesEquals("SizeOnDisk", "sizeondisk"));
+  CHECK(!KeyValuesEquals("SizeOnDisk", "SizeOnDisc"));
+  uint32_t small = 0;
+  CHECK(KeyValuesToUint32("4294967295", small) && small == 4294967295u);
+  CHECK(!KeyValuesToUint32("4294967296", small));
+  CHECK(!KeyValuesToUint32("12a", small));
+  uint64_t large = 0;
+  CHECK(KeyValuesToUint64("70000000000", large) && large == 70000000000ull);
+  CHECK(KeyValuesToWide(R"(D:\\Games \"Quoted\")") == L"D:\\Games \"Quoted\"");
+  CHECK(KeyValuesToWide("Caf\xC3\xA9") == L"Caf\u00E9");
+}
+
+TEST(ParsesCurrentAndLegacyLibraryFolders) {
+  const auto current = SteamLibrary::ParseLibraryFolders(kLibraryFolders);
+  CHECK_EQ(current.size(), size_t{2});
+  CHECK(current.size() == 2 && current[0] == L"C:\\Program Files (x86)\\Steam" && current[1] == L"D:\\SteamLibrary");
+  const auto legacy = SteamLibrary::ParseLibraryFolders(kLegacyLibraryFolders);
+  CHECK(legacy.size() == 1 && legacy[0] == L"E:\\Games\\Steam");
+}
+
+TEST(ParsesAppManifest) {
+  SteamApp app;
+  CHECK(SteamLibrary::ParseAppManifest(kAppManifest, L"lib", app));
+  CHECK_EQ(app.appId, 1091500u);
+  CHECK(app.name == L"Cyberpunk 2077");
+  CHECK(app.installDir == (std::filesystem::path(L"lib") / L"steamapps" / L"common" / L"Cyberpunk 2077").wstring());
+  CHECK_EQ(app.sizeOnDisk, 70000000000ull);
+  CHECK_EQ(app.lastPlayed, int64_t{1700000000});
+  CHECK(!SteamLibrary::ParseAppManifest(R"("AppState" { "appid" "10" })", L"lib", app));
+}
+
+TEST(InstalledAppsReadsManifestFiles) {
+  TempDir dir;
+  dir.Write("steamapps/appmanifest_1091500.acf", kAppManifest);
+  dir.Write("steamapps/appmanifest_10.acf", R"("AppState" { "appid" "10" "installdir" "Counter-Strike" })");
+  dir.Write("steamapps/appmanifest_broken.acf", R"("AppState" { "appid" )");
+  dir.Write("steamapps/libraryfolders.vdf", kLibraryFolders);
+  const auto apps = SteamLibrary::InstalledApps(dir.path().wstring());
+  CHECK_EQ(apps.size(), size_t{2});
+  CHECK(apps.size() == 2 && apps[0].appId == 10 && apps[1].appId == 1091500);
+  CHECK(SteamLibrary::IsAppManifestName(L"AppManifest_10.ACF"));
+  CHECK(!SteamLibrary::IsAppManifestName(L"appmanifest_.acf"));
+}
@@ -0,0 +1,209 @@
+#include "streaming_download.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "test.h"
+
+using namespace optiscaler;
+using optiscaler::test::TempDir;
+
+namespace {
+
+constexpr wchar_t kUrl[] = L"https://images.example.com/cover.jpg";
+
+// Serves `body` in `chunk`-byte pieces, honouring "Range: bytes=N-" unless
+// told to ignore it or If-Range names another version, and cutting the
+// transfer after `cut_after` bytes.
+class FakeServer : public IHttpClient {
+ public:
+  explicit FakeServer(std::string body) : body_(std::move(body)) {}
+
+  std::string body_;
+  size_t chunk = 100;
+  size_t cut_after = std::string::npos;
+  bool honour_range = true;
+  std::wstring etag = L"\"v1\"";
+  std::wstring last_modified;
+  std::wstring last_range;
+  std::wstring last_if_range;
+
+  bool Send(const HttpRequest&, HttpResponse&) override { return false; }
+
+  bool SendStreaming(const HttpRequest& request, HttpResponse& response_out, const BodySink& sink) override {
+    response_out = HttpResponse{};
+    last_range.clear();
+    last_if_range.clear();
+    size_t start = 0;
+    for (const auto& [name, value] : request.headers) {
+      if (name == L"Range") {
+        last_range = value;
+        start = std::stoul(value.substr(6));
+      } else if (name == L"If-Range") {
+        last_if_range = value;
+      }
+    }
+    response_out.etag = etag;
+    response_out.lastModified = last_modified;
+    const bool same_version = last_if_range.empty() || last_if_range == etag || last_if_range == last_modified;
+    if (start > 0 && honour_range && same_version) {
+      if (start >= body_.size()) {
+        response_out.status = 416;
+        return true;
+      }
+      response_out.status = 206;
+      response_out.rangeStart = static_cast<int64_t>(start);
+    } else {
+      start = 0;
+      response_out.status = 200;
+    }
+    response_out.contentLength = static_cast<int64_t>(body_.size() - start);
+    size_t sent = 0;
+    for (size_t offset = start; offset < body_.size(); offset += chunk) {
+      const size_t count = std::min(chunk, body_.size() - offset);
+      if (sent + count > cut_after) {
+        response_out.error = L"Connection reset";
+        return false;
+      }
+      if (!sink(body_.data() + offset, count)) {
+        return false;
+      }
+      sent += count;
+    }
+    return true;
+  }
+};
+
+std::string Body(size_t size) {
+  std::string body;
+  for (size_t i = 0; i < size; ++i) {
+    body += static_cast<char>('a' + i % 23);
+  }
+  return body;
+}
+
+std::string ReadAll(const std::wstring& path) {
+  std::ifstream in(std::filesystem::path(path), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+}  // namespace
+
+TEST(DownloadsAndHashesWholeBody) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  DownloadResult result;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(ReadAll(target), server.body_);
+  CHECK_EQ(result.bytes, uint64_t{1000});
+  CHECK_EQ(result.resumedFrom, uint64_t{0});
+  CHECK(result.hash == Sha256::Of(server.body_.data(), server.body_.size()));
+  CHECK(!std::filesystem::exists(StreamingDownload::PartialPath(target)));
+}
+
+TEST(ResumesInterruptedDownload) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  server.cut_after = 300;
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK(!std::filesystem::exists(target));
+  CHECK_EQ(std::filesystem::file_size(StreamingDownload::PartialPath(target)), uintmax_t{300});
+
+  server.cut_after = std::string::npos;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(server.last_range, std::wstring(L"bytes=300-"));
+  CHECK_EQ(server.last_if_range, server.etag);
+  CHECK_EQ(result.resumedFrom, uint64_t{300});
+  CHECK_EQ(result.bytes, uint64_t{1000});
+  CHECK_EQ(ReadAll(target), server.body_);
+  // The kept prefix is re-hashed, so the digest covers the whole file.
+  CHECK(result.hash == Sha256::Of(server.body_.data(), server.body_.size()));
+}
+
+TEST(RestartsWhenServerIgnoresRange) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  server.cut_after = 400;
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+
+  server.cut_after = std::string::npos;
+  server.honour_range = false;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(result.resumedFrom, uint64_t{0});
+  CHECK_EQ(ReadAll(target), server.body_);
+  CHECK(result.hash == Sha256::Of(server.body_.data(), server.body_.size()));
+}
+
+TEST(DropsStalePartial) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  dir.Write("cover.jpg.part", Body(2000));
+  dir.Write("cover.jpg.part.validator", "\"v1\"");
+  FakeServer server(Body(1000));
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK(!std::filesystem::exists(StreamingDownload::PartialPath(target)));
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(ReadAll(target), server.body_);
+}
+
+TEST(RestartsWhenTheFileChangedOnTheServer) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  server.cut_after = 300;
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+
+  // A new cover went up under the same URL: If-Range makes the server send
+  // all of it instead of splicing its tail onto the old prefix.
+  server.body_ = std::string(1200, 'z');
+  server.etag = L"\"v2\"";
+  server.cut_after = std::string::npos;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(server.last_if_range, std::wstring(L"\"v1\""));
+  CHECK_EQ(result.resumedFrom, uint64_t{0});
+  CHECK_EQ(ReadAll(target), server.body_);
+  CHECK(result.hash == Sha256::Of(server.body_.data(), server.body_.size()));
+  CHECK(!std::filesystem::exists(StreamingDownload::ValidatorPath(target)));
+}
+
+TEST(ResumesOnLastModifiedWhenTheETagIsWeak) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  server.etag = L"W/\"v1\"";
+  server.last_modified = L"Tue, 01 Sep 2026 10:00:00 GMT";
+  server.cut_after = 500;
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+  server.cut_after = std::string::npos;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK_EQ(server.last_if_range, server.last_modified);
+  CHECK_EQ(result.resumedFrom, uint64_t{500});
+  CHECK_EQ(ReadAll(target), server.body_);
+}
+
+TEST(RestartsPartialsWithoutAValidator) {
+  TempDir dir;
+  const std::wstring target = (dir.path() / "cover.jpg").wstring();
+  FakeServer server(Body(1000));
+  server.etag.clear();
+  server.cut_after = 300;
+  DownloadResult result;
+  CHECK(!StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK(!std::filesystem::exists(StreamingDownload::ValidatorPath(target)));
+
+  server.cut_after = std::string::npos;
+  CHECK(StreamingDownload::Fetch(server, kUrl, target, result));
+  CHECK(server.last_range.empty());
+  CHECK_EQ(result.resumedFrom, uint64_t{0});
+  CHECK_EQ(ReadAll(target), server.body_);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal self-registering test harness. TEST() bodies run in declaration
+// order; CHECK failures are reported and counted but do not stop the test.
+
+namespace optiscaler::test {
+
+struct TestCase {
+  const char* name;
+  std::function<void()> body;
+};
+
+std::vector<TestCase>& Registry();
+void ReportFailure(const char* file, int line, const std::string& what);
+
+struct Registrar {
+  Registrar(const char* name, std::function<void()> body) { Registry().push_back({name, std::move(body)}); }
+};
+
+// Fresh directory under the system temp path, removed with its contents.
+class TempDir {
+ public:
+  TempDir();
+  ~TempDir();
+  TempDir(const TempDir&) = delete;
+  TempDir& operator=(const TempDir&) = delete;
+
+  const std::filesystem::path& path() const { return path_; }
+  // Creates `relative` (and its parents) with `contents`; returns the full path.
+  std::filesystem::path Write(const std::filesystem::path& relative, const std::string& contents = {}) const;
+
+ private:
+  std::filesystem::path path_;
+};
+
+}  // namespace optiscaler::test
+
+#define OPTISCALER_TEST_CONCAT2(a, b) a##b
+#define OPTISCALER_TEST_CONCAT(a, b) OPTISCALER_TEST_CONCAT2(a, b)
+
+#define TEST(name)                                                                                    \
+  static void name();                                                                                 \
+  static const ::optiscaler::test::Registrar OPTISCALER_TEST_CONCAT(name, _registrar)(#name, &name); \
+  static void name()
+
+#define CHECK(condition)                                                     \
+  do {                                                                       \
+    if (!(condition)) {                                                      \
+      ::optiscaler::test::ReportFailure(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+    }                                                                        \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                \
+  do {                                                                                            \
+    if (!((actual) == (expected))) {                                                              \
+      ::optiscaler::test::ReportFailure(__FILE__, __LINE__, "CHECK_EQ(" #actual ", " #expected ")"); \
+    }                                                                                             \
+  } while (0)
@@ -0,0 +1,54 @@
+#include "test.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+namespace optiscaler::test {
+namespace {
+
+int g_failures = 0;
+
+}  // namespace
+
+std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+void ReportFailure(const char* file, int line, const std::string& what) {
+  ++g_failures;
+  std::cerr << file << ":" << line << ": " << what << " failed\n";
+}
+
+TempDir::TempDir() {
+  static std::atomic<unsigned> counter{0};
+  const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+  path_ = std::filesystem::temp_directory_path() /
+          ("optiscaler_test_" + std::to_string(stamp) + "_" + std::to_string(counter++));
+  std::filesystem::create_directories(path_);
+}
+
+TempDir::~TempDir() {
+  std::error_code ec;
+  std::filesystem::remove_all(path_, ec);
+}
+
+std::filesystem::path TempDir::Write(const std::filesystem::path& relative, const std::string& contents) const {
+  const std::filesystem::path full = path_ / relative;
+  std::filesystem::create_directories(full.parent_path());
+  std::ofstream(full, std::ios::binary) << contents;
+  return full;
+}
+
+}  // namespace optiscaler::test
+
+int main() {
+  using optiscaler::test::Registry;
+  for (const auto& test : Registry()) {
+    const int before = optiscaler::test::g_failures;
+    test.body();
+    std::cout << (optiscaler::test::g_failures == before ? "[  OK  ] " : "[ FAIL ] ") << test.name << "\n";
+  }
+  return optiscaler::test::g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+#include "tile_compositor.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "headless_surface.h"
+#include "test.h"
+
+using namespace optiscaler;
+
+namespace {
+
+constexpr uint32_t kBackground = OpaqueColor(0x202020);
+constexpr uint32_t kRed = OpaqueColor(0xFF0000);
+constexpr uint32_t kBlue = OpaqueColor(0x0000FF);
+
+CoverImage SolidImage(int width, int height, uint32_t color) {
+  CoverImage image;
+  image.width = width;
+  image.height = height;
+  image.pixels.resize(image.stride() * static_cast<size_t>(height));
+  for (size_t i = 0; i < image.pixels.size(); i += 4) {
+    std::memcpy(image.pixels.data() + i, &color, sizeof(color));
+  }
+  return image;
+}
+
+// Premultiplied pixels over the full alpha range, with opaque and fully
+// transparent runs long enough to hit the SSE2 shortcuts.
+CoverImage PatternImage(int width, int height) {
+  CoverImage image = SolidImage(width, height, 0);
+  uint32_t seed = 12345;
+  for (int i = 0; i < width * height; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint32_t alpha = (seed >> 16) & 0xFF;
+    if (i / 8 % 4 == 1) {
+      alpha = 255;
+    } else if (i / 8 % 4 == 2) {
+      alpha = 0;
+    }
+    uint32_t pixel = alpha << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+      pixel |= ((seed >> shift) % (alpha + 1)) << shift;
+    }
+    std::memcpy(image.pixels.data() + static_cast<size_t>(i) * 4, &pixel, sizeof(pixel));
+  }
+  return image;
+}
+
+// Composes a full first frame so later frames start from known pixels.
+void PresentFilled(HeadlessSurface& surface, uint32_t color) {
+  surface.compositor().Begin(kBackground);
+  surface.compositor().Fill({0, 0, surface.width(), surface.height()}, color);
+  surface.Present();
+}
+
+}  // namespace
+
+TEST(FirstFrameComposesEverything) {
+  HeadlessSurface surface(130, 70);
+  TileCompositor& compositor = surface.compositor();
+  CHECK(compositor.dirty());
+  const GridRect bounds = compositor.Begin(kBackground);
+  CHECK(bounds.left == 0 && bounds.top == 0 && bounds.right == 130 && bounds.bottom == 70);
+  CHECK_EQ(surface.Pixel(129, 69), kBackground);
+  surface.Present();
+  CHECK(!compositor.dirty());
+  CHECK_EQ(compositor.frameRects().size(), size_t{1});  // rows of equal spans merge
+  CHECK_EQ(surface.Stats().pixels, uint64_t{130 * 70});
+  CHECK_EQ(compositor.Stats().tilesComposed, uint64_t{6});
+}
+
+TEST(OnlyInvalidatedTilesAreRedrawn) {
+  HeadlessSurface surface(192, 128);
+  TileCompositor& compositor = surface.compositor();
+  PresentFilled(surface, kRed);
+  compositor.Invalidate({70, 10, 80, 20});
+  const GridRect bounds = compositor.Begin(kBackground);
+  CHECK(bounds.left == 64 && bounds.top == 0 && bounds.right == 128 && bounds.bottom == 64);
+  compositor.Fill({0, 0, 192, 128}, kBlue);
+  surface.Present();
+  CHECK_EQ(surface.Pixel(70, 10), kBlue);
+  CHECK_EQ(surface.Pixel(64, 63), kBlue);
+  CHECK_EQ(surface.Pixel(63, 10), kRed);
+  CHECK_EQ(surface.Pixel(70, 64), kRed);
+  CHECK_EQ(surface.Stats().presents, uint64_t{2});
+  CHECK_EQ(surface.Stats().pixels, uint64_t{192 * 128 + 64 * 64});
+  // An empty frame presents nothing.
+  CHECK(compositor.Begin(kBackground).empty());
+  CHECK(compositor.End().empty());
+}
+
+TEST(ScrollMovesPixelsAndInvalidatesTheBand) {
+  HeadlessSurface surface(64, 128);
+  TileCompositor& compositor = surface.compositor();
+  compositor.Begin(kBackground);
+  for (int y = 0; y < 128; ++y) {
+    compositor.Fill({0, y, 64, y + 1}, OpaqueColor(static_cast<uint32_t>(y)));
+  }
+  surface.Present();
+
+  compositor.Scroll({0, 0, 64, 128}, -10);
+  CHECK(compositor.dirty());
+  const GridRect bounds = compositor.Begin(kBackground);
+  CHECK(bounds.top == 64 && bounds.bottom == 128);
+  surface.Present();
+  CHECK_EQ(surface.Pixel(0, 0), OpaqueColor(10));
+  CHECK_EQ(surface.Pixel(0, 63), OpaqueColor(73));
+
+  compositor.Scroll({0, 0, 64, 128}, 5);
+  CHECK_EQ(surface.Pixel(0, 5), OpaqueColor(10));
+  // The uncovered band dirties its whole tile row, which the caller redraws.
+  const GridRect band = compositor.Begin(kBackground);
+  CHECK(band.top == 0 && band.bottom == 64);
+  CHECK_EQ(surface.Pixel(0, 68), OpaqueColor(73));
+}
+
+TEST(ScrollOverPendingTilesInvalidatesTheArea) {
+  HeadlessSurface surface(64, 128);
+  TileCompositor& compositor = surface.compositor();
+  PresentFilled(surface, kRed);
+  compositor.Invalidate({0, 100, 1, 101});
+  // The pending tile still holds last frame's pixels; moving them into the
+  // clean tile above would show stale content.
+  compositor.Scroll({0, 0, 64, 128}, -10);
+  const GridRect bounds = compositor.Begin(kBackground);
+  CHECK(bounds.top == 0 && bounds.bottom == 128);
+}
+
+TEST(DrawsAreClippedToFrameTiles) {
+  HeadlessSurface surface(128, 64);
+  TileCompositor& compositor = surface.compositor();
+  PresentFilled(surface, kRed);
+  compositor.Invalidate({0, 0, 1, 1});
+  compositor.Begin(kBackground);
+  const uint64_t blended = compositor.Stats().pixelsBlended;
+  compositor.Blend(SolidImage(40, 10, kBlue), 40, 0);  // straddles tiles 0 and 1
+  surface.Present();
+  CHECK_EQ(surface.Pixel(63, 0), kBlue);
+  CHECK_EQ(surface.Pixel(64, 0), kRed);
+  CHECK_EQ(compositor.Stats().pixelsBlended - blended, uint64_t{24 * 10});
+}
+
+TEST(BlendIsSourceOverPremultiplied) {
+  HeadlessSurface surface(8, 1);
+  TileCompositor& compositor = surface.compositor();
+  compositor.Begin(OpaqueColor(0xFFFFFF));
+  CoverImage image = SolidImage(3, 1, 0x80404040u);
+  const uint32_t opaque = kBlue;
+  const uint32_t clear = 0;
+  std::memcpy(image.pixels.data() + 4, &opaque, 4);
+  std::memcpy(image.pixels.data() + 8, &clear, 4);
+  compositor.Blend(image, 0, 0);
+  surface.Present();
+  CHECK_EQ(surface.Pixel(0, 0), 0xFFBFBFBFu);
+  CHECK_EQ(surface.Pixel(1, 0), kBlue);
+  CHECK_EQ(surface.Pixel(2, 0), OpaqueColor(0xFFFFFF));
+}
+
+TEST(KernelsProduceIdenticalPixels) {
+  const CoverImage image = PatternImage(77, 33);
+  std::vector<uint32_t> results[2];
+  const BlendKernel kernels[2] = {BlendKernel::kScalar, TileCompositor::BestKernel()};
+  for (int k = 0; k < 2; ++k) {
+    HeadlessSurface surface(100, 50, kernels[k]);
+    surface.compositor().Begin(kBackground);
+    surface.compositor().Fill({0, 0, 50, 50}, OpaqueColor(0x80C0F0));
+    surface.compositor().Blend(image, 3, 5);
+    surface.Present();
+    results[k].assign(surface.pixels(), surface.pixels() + 100 * 50);
+  }
+  CHECK(results[0] == results[1]);
+}
+
+TEST(MasksBlendColorThroughCoverage) {
+  HeadlessSurface surface(128, 64);
+  TileCompositor& compositor = surface.compositor();
+  compositor.Begin(kBackground);
+  const uint8_t mask[] = {255, 0, 128};
+  const MaskBlit blit{0, 0, 3, 1, 5, 5};
+  compositor.BlendMasks(mask, 3, &blit, 1, 0, 0, kRed);
+  surface.Present();
+  CHECK_EQ(surface.Pixel(5, 5), kRed);
+  CHECK_EQ(surface.Pixel(6, 5), kBackground);
+  const uint32_t partial = surface.Pixel(7, 5);
+  CHECK(partial != kRed && partial != kBackground && (partial >> 24) == 255);
+  CHECK_EQ(compositor.Stats().maskBlits, uint64_t{1});
+
+  // A batch outside the frame's tiles is rejected as a whole.
+  compositor.Invalidate({0, 0, 1, 1});
+  compositor.Begin(kBackground);
+  compositor.BlendMasks(mask, 3, &blit, 1, 100, 0, kRed);
+  surface.Present();
+  CHECK_EQ(compositor.Stats().maskBlits, uint64_t{1});
+}
+
+TEST(ResizeMarksEverythingDirty) {
+  HeadlessSurface surface(64, 64);
+  PresentFilled(surface, kRed);
+  surface.Resize(100, 30);
+  CHECK(surface.compositor().dirty());
+  const GridRect bounds = surface.compositor().Begin(kBackground);
+  CHECK(bounds.right == 100 && bounds.bottom == 30);
+}